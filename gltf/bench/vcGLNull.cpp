@@ -0,0 +1,367 @@
+// Null vcGL backend for headless benchmarking of vcGLTF. Implements the vcMesh, vcShader, vcTexture, vcGLState and
+// texture cache calls vcGLTF makes; resources are tracked so upload volume and residency can be reported but nothing
+// touches a GPU. Link it in place of the real vcGL renderer sources (vcLayout.cpp is still needed)
+
+#include "vcGLNull.h"
+
+#include "vcGL/gl/vcMesh.h"
+#include "vcGL/gl/vcShader.h"
+#include "vcGL/gl/vcTexture.h"
+#include "vcGL/gl/vcGLState.h"
+#include "vcGL/gl/vcLayout.h"
+
+#include "caching/ttTextureCache.h"
+
+#include "udPlatform.h"
+#include "udStringUtil.h"
+
+struct vcMesh
+{
+  int64_t bytes;
+};
+
+struct vcTexture
+{
+  uint32_t width;
+  uint32_t height;
+  int64_t bytes;
+};
+
+struct vcShader
+{
+  int id;
+};
+
+struct vcShaderConstantBuffer
+{
+  size_t bufferSize;
+};
+
+struct vcShaderSampler
+{
+  int id;
+};
+
+static vcGLNullStats s_nullStats = {};
+static vcShaderSampler s_nullSampler = {};
+
+const vcGLNullStats &vcGLNull_GetStats()
+{
+  return s_nullStats;
+}
+
+void vcGLNull_ResetFrameStats()
+{
+  s_nullStats.shaderBinds = 0;
+  s_nullStats.constantBufferBinds = 0;
+  s_nullStats.constantBufferBytes = 0;
+  s_nullStats.textureBinds = 0;
+  s_nullStats.stateChanges = 0;
+  s_nullStats.drawCalls = 0;
+  s_nullStats.trianglesDrawn = 0;
+}
+
+// Meshes
+
+udResult vcMesh_Create(vcMesh **ppMesh, const vcVertexLayoutTypes *pMeshLayout, int totalTypes, const void *pVerts, uint32_t currentVerts, const void *pIndices, uint32_t currentIndices, vcMeshFlags flags /*= vcMF_None*/)
+{
+  if (ppMesh == nullptr || pMeshLayout == nullptr || totalTypes <= 0)
+    return udR_InvalidParameter_;
+
+  vcMesh *pMesh = udAllocType(vcMesh, 1, udAF_Zero);
+  if (pMesh == nullptr)
+    return udR_MemoryAllocationFailure;
+
+  pMesh->bytes = (int64_t)vcLayout_GetSize(pMeshLayout, totalTypes) * currentVerts;
+  if (pIndices != nullptr && (flags & vcMF_NoIndexBuffer) == 0)
+    pMesh->bytes += (int64_t)currentIndices * ((flags & vcMF_IndexShort) ? sizeof(uint16_t) : sizeof(uint32_t));
+
+  ++s_nullStats.meshesCreated;
+  ++s_nullStats.meshesAlive;
+  s_nullStats.meshBytesUploaded += pMesh->bytes;
+  s_nullStats.meshBytesAlive += pMesh->bytes;
+  s_nullStats.meshBytesPeak = udMax(s_nullStats.meshBytesPeak, s_nullStats.meshBytesAlive);
+
+  udUnused(pVerts);
+
+  *ppMesh = pMesh;
+  return udR_Success;
+}
+
+void vcMesh_Destroy(vcMesh **ppMesh)
+{
+  if (ppMesh == nullptr || *ppMesh == nullptr)
+    return;
+
+  --s_nullStats.meshesAlive;
+  s_nullStats.meshBytesAlive -= (*ppMesh)->bytes;
+
+  udFree(*ppMesh);
+}
+
+udResult vcMesh_UploadData(vcMesh *pMesh, const vcVertexLayoutTypes *pLayout, int totalTypes, const void *pVerts, int totalVerts, const void *pIndices, int totalIndices)
+{
+  if (pMesh == nullptr || pLayout == nullptr)
+    return udR_InvalidParameter_;
+
+  int64_t bytes = (int64_t)vcLayout_GetSize(pLayout, totalTypes) * totalVerts + (int64_t)totalIndices * sizeof(uint32_t);
+
+  udUnused(pVerts);
+  udUnused(pIndices);
+
+  s_nullStats.meshBytesUploaded += bytes;
+  s_nullStats.meshBytesAlive += bytes - pMesh->bytes;
+  s_nullStats.meshBytesPeak = udMax(s_nullStats.meshBytesPeak, s_nullStats.meshBytesAlive);
+  pMesh->bytes = bytes;
+
+  return udR_Success;
+}
+
+bool vcMesh_Render(vcMesh *pMesh, uint32_t elementCount /*= 0*/, uint32_t startElement /*= 0*/, vcMeshRenderMode renderMode /*= vcMRM_Triangles*/)
+{
+  if (pMesh == nullptr)
+    return false;
+
+  udUnused(startElement);
+  udUnused(renderMode);
+
+  ++s_nullStats.drawCalls;
+  s_nullStats.trianglesDrawn += elementCount;
+
+  return true;
+}
+
+// Shaders
+
+bool vcShader_CreateFromText(vcShader **ppShader, const char *pVertexShader, const char *pFragmentShader, const vcVertexLayoutTypes *pInputTypes, uint32_t totalInputs, const char *pVertexName, const char *pFragName, const char **ppDefines, int defineCount)
+{
+  if (ppShader == nullptr || pVertexShader == nullptr || pFragmentShader == nullptr)
+    return false;
+
+  udUnused(pInputTypes);
+  udUnused(totalInputs);
+  udUnused(pVertexName);
+  udUnused(pFragName);
+  udUnused(ppDefines);
+  udUnused(defineCount);
+
+  *ppShader = udAllocType(vcShader, 1, udAF_Zero);
+  if (*ppShader == nullptr)
+    return false;
+
+  (*ppShader)->id = (int)++s_nullStats.shadersCompiled;
+  return true;
+}
+
+bool vcShader_LoadTextFromFile(const char *pFilename, const char **ppSource, vcGLSamplerShaderStage stage)
+{
+  udUnused(pFilename);
+  udUnused(stage);
+
+  // The sources are never compiled so an empty string is enough for vcGLTF to create its variants
+  *ppSource = udStrdup("");
+  return (*ppSource != nullptr);
+}
+
+void vcShader_DestroyShader(vcShader **ppShader)
+{
+  if (ppShader == nullptr)
+    return;
+
+  udFree(*ppShader);
+}
+
+bool vcShader_Bind(vcShader *pShader)
+{
+  udUnused(pShader);
+
+  ++s_nullStats.shaderBinds;
+  return true;
+}
+
+bool vcShader_BindTexture(vcShader *pShader, vcTexture *pTexture, uint16_t samplerIndex, vcShaderSampler *pSampler /*= nullptr*/)
+{
+  udUnused(pShader);
+  udUnused(pTexture);
+  udUnused(samplerIndex);
+  udUnused(pSampler);
+
+  ++s_nullStats.textureBinds;
+  return true;
+}
+
+bool vcShader_GetConstantBuffer(vcShaderConstantBuffer **ppBuffer, vcShader *pShader, const char *pBufferName, const size_t bufferSize)
+{
+  if (ppBuffer == nullptr || pShader == nullptr)
+    return false;
+
+  udUnused(pBufferName);
+
+  *ppBuffer = udAllocType(vcShaderConstantBuffer, 1, udAF_Zero);
+  if (*ppBuffer == nullptr)
+    return false;
+
+  (*ppBuffer)->bufferSize = bufferSize;
+  return true;
+}
+
+bool vcShader_BindConstantBuffer(vcShader *pShader, vcShaderConstantBuffer *pBuffer, const void *pData, const size_t bufferSize)
+{
+  udUnused(pShader);
+  udUnused(pBuffer);
+  udUnused(pData);
+
+  ++s_nullStats.constantBufferBinds;
+  s_nullStats.constantBufferBytes += bufferSize;
+  return true;
+}
+
+bool vcShader_ReleaseConstantBuffer(vcShader *pShader, vcShaderConstantBuffer *pBuffer)
+{
+  udUnused(pShader);
+
+  udFree(pBuffer);
+  return true;
+}
+
+bool vcShader_GetSamplerIndex(vcShaderSampler **ppSampler, vcShader *pShader, const char *pSamplerName)
+{
+  udUnused(pShader);
+  udUnused(pSamplerName);
+
+  *ppSampler = &s_nullSampler;
+  return true;
+}
+
+// Textures
+
+static int64_t vcGLNull_TextureBytes(uint32_t width, uint32_t height, vcTextureFormat format)
+{
+  int64_t texelSize = 4;
+
+  if (format == vcTextureFormat_RGBA16F)
+    texelSize = 8;
+  else if (format == vcTextureFormat_RGBA32F)
+    texelSize = 16;
+
+  return texelSize * width * height;
+}
+
+udResult vcTexture_Create(vcTexture **ppTexture, uint32_t width, uint32_t height, const void *pPixels, vcTextureFormat format /*= vcTextureFormat_RGBA8*/, vcTextureFilterMode filterMode /*= vcTFM_Nearest*/, vcTextureCreationFlags flags /*= vcTCF_None*/, int32_t aniFilter /*= 0*/)
+{
+  if (ppTexture == nullptr)
+    return udR_InvalidParameter_;
+
+  udUnused(pPixels);
+  udUnused(filterMode);
+  udUnused(flags);
+  udUnused(aniFilter);
+
+  vcTexture *pTexture = udAllocType(vcTexture, 1, udAF_Zero);
+  if (pTexture == nullptr)
+    return udR_MemoryAllocationFailure;
+
+  pTexture->width = width;
+  pTexture->height = height;
+  pTexture->bytes = vcGLNull_TextureBytes(width, height, format);
+
+  ++s_nullStats.texturesCreated;
+  ++s_nullStats.texturesAlive;
+  s_nullStats.textureBytesUploaded += pTexture->bytes;
+
+  *ppTexture = pTexture;
+  return udR_Success;
+}
+
+bool vcTexture_CreateFromFilename(vcTexture **ppTexture, const char *pFilename, uint32_t *pWidth /*= nullptr*/, uint32_t *pHeight /*= nullptr*/, vcTextureFilterMode filterMode /*= vcTFM_Linear*/, bool hasMipmaps /*= false*/, vcTextureWrapMode wrapMode /*= vcTWM_Repeat*/)
+{
+  udUnused(pFilename);
+  udUnused(hasMipmaps);
+  udUnused(wrapMode);
+
+  // Images aren't decoded; the benchmark measures vcGLTF, not the image loaders
+  if (pWidth != nullptr)
+    *pWidth = 1;
+  if (pHeight != nullptr)
+    *pHeight = 1;
+
+  return (vcTexture_Create(ppTexture, 1, 1, nullptr, vcTextureFormat_RGBA8, filterMode) == udR_Success);
+}
+
+udResult vcTexture_UploadPixels(vcTexture *pTexture, const void *pPixels, int width, int height)
+{
+  if (pTexture == nullptr)
+    return udR_InvalidParameter_;
+
+  udUnused(pPixels);
+
+  s_nullStats.textureBytesUploaded += pTexture->bytes * width * height / udMax(1u, pTexture->width * pTexture->height);
+  return udR_Success;
+}
+
+udResult vcTexture_GetSize(vcTexture *pTexture, int *pWidth, int *pHeight)
+{
+  if (pTexture == nullptr)
+    return udR_InvalidParameter_;
+
+  if (pWidth != nullptr)
+    *pWidth = (int)pTexture->width;
+  if (pHeight != nullptr)
+    *pHeight = (int)pTexture->height;
+
+  return udR_Success;
+}
+
+void vcTexture_Destroy(vcTexture **ppTexture)
+{
+  if (ppTexture == nullptr || *ppTexture == nullptr)
+    return;
+
+  --s_nullStats.texturesAlive;
+  udFree(*ppTexture);
+}
+
+vcTexture* ttTextureCache_Get(const char *pFilename, vcTextureFilterMode filterMode, bool hasMipmaps, vcTextureWrapMode wrapMode)
+{
+  vcTexture *pTexture = nullptr;
+  vcTexture_CreateFromFilename(&pTexture, pFilename, nullptr, nullptr, filterMode, hasMipmaps, wrapMode);
+  return pTexture;
+}
+
+void ttTextureCache_Release(vcTexture **ppTexture)
+{
+  vcTexture_Destroy(ppTexture);
+}
+
+// State
+
+bool vcGLState_SetFaceMode(vcGLStateFillMode fillMode, vcGLStateCullMode cullMode, bool isFrontCCW /*= true*/, bool force /*= false*/)
+{
+  udUnused(fillMode);
+  udUnused(cullMode);
+  udUnused(isFrontCCW);
+  udUnused(force);
+
+  ++s_nullStats.stateChanges;
+  return true;
+}
+
+bool vcGLState_SetBlendMode(vcGLStateBlendMode blendMode, bool force /*= false*/)
+{
+  udUnused(blendMode);
+  udUnused(force);
+
+  ++s_nullStats.stateChanges;
+  return true;
+}
+
+bool vcGLState_SetDepthStencilMode(vcGLStateDepthMode depthReadMode, bool doDepthWrite, vcGLStencilSettings *pStencil /*= nullptr*/, bool force /*= false*/)
+{
+  udUnused(depthReadMode);
+  udUnused(doDepthWrite);
+  udUnused(pStencil);
+  udUnused(force);
+
+  ++s_nullStats.stateChanges;
+  return true;
+}
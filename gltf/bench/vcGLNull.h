@@ -0,0 +1,33 @@
+#ifndef vcGLNull_h__
+#define vcGLNull_h__
+
+#include <stdint.h>
+
+// Counters kept by the null vcGL backend (vcGLNull.cpp); it records calls and uploads but does no GPU work
+struct vcGLNullStats
+{
+  int64_t meshesCreated;
+  int64_t meshesAlive;
+  int64_t meshBytesUploaded;
+  int64_t meshBytesAlive;
+  int64_t meshBytesPeak;
+
+  int64_t texturesCreated;
+  int64_t texturesAlive;
+  int64_t textureBytesUploaded;
+
+  int64_t shadersCompiled;
+  int64_t shaderBinds;
+  int64_t constantBufferBinds;
+  int64_t constantBufferBytes;
+  int64_t textureBinds;
+  int64_t stateChanges;
+
+  int64_t drawCalls;
+  int64_t trianglesDrawn;
+};
+
+const vcGLNullStats &vcGLNull_GetStats();
+void vcGLNull_ResetFrameStats(); // Clears the per-call counters (binds, draws), keeps the resource counters
+
+#endif //vcGLNull_h__
@@ -0,0 +1,244 @@
+// Headless vcGLTF benchmark; links against the null vcGL backend in vcGLNull.cpp
+// Usage: vcGLTFBench <model directory> [frames] [trace.json]
+// Every .gltf below the directory is loaded, updated and rendered; one JSON object is written to stdout per model
+
+#include "vcGLTF.h"
+#include "vcGLNull.h"
+
+#include "udPlatform.h"
+#include "udPlatformUtil.h"
+#include "udStringUtil.h"
+#include "udWorkerPool.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#if UDPLATFORM_WINDOWS
+# include <windows.h>
+# include <psapi.h>
+#else
+# include <sys/resource.h>
+#endif
+
+static const char *g_vcGLTFBenchPassNames[] = { "opaque", "transparent", "shadows" };
+UDCOMPILEASSERT(udLengthOf(g_vcGLTFBenchPassNames) == vcGLTFRP_Count, "Pass names don't match vcGLTFRenderPass");
+
+static const char *g_vcGLTFBenchPhaseNames[] = { "parse", "bufferIO", "materials", "nodes", "meshDecode", "normalGeneration", "tangentGeneration", "meshProcessing", "upload", "animations", "skins", "finalize" };
+UDCOMPILEASSERT(udLengthOf(g_vcGLTFBenchPhaseNames) == vcGLTFLP_Count, "Phase names don't match vcGLTFLoadPhase");
+
+struct vcGLTFBenchTiming
+{
+  double totalMilliseconds;
+  double maxMilliseconds;
+};
+
+// Peak resident set size of the process; this only ever grows so it covers every model loaded so far
+static int64_t vcGLTFBench_PeakResidentBytes()
+{
+#if UDPLATFORM_WINDOWS
+  PROCESS_MEMORY_COUNTERS counters = {};
+  if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+    return (int64_t)counters.PeakWorkingSetSize;
+  return 0;
+#else
+  struct rusage usage = {};
+  if (getrusage(RUSAGE_SELF, &usage) != 0)
+    return 0;
+# if UDPLATFORM_OSX || UDPLATFORM_IOS || UDPLATFORM_IOS_SIMULATOR
+  return (int64_t)usage.ru_maxrss; // Bytes on Apple platforms
+# else
+  return (int64_t)usage.ru_maxrss * 1024; // Kilobytes elsewhere
+# endif
+#endif
+}
+
+static void vcGLTFBench_PrintString(const char *pString)
+{
+  putchar('"');
+  for (const char *pChar = pString; *pChar != '\0'; ++pChar)
+  {
+    if (*pChar == '"' || *pChar == '\\')
+      printf("\\%c", *pChar);
+    else if ((unsigned char)*pChar < 0x20)
+      printf("\\u%04x", *pChar);
+    else
+      putchar(*pChar);
+  }
+  putchar('"');
+}
+
+static void vcGLTFBench_PrintTiming(const char *pName, const vcGLTFBenchTiming &timing, int frames)
+{
+  printf("\"%s\":{\"meanMs\":%.4f,\"maxMs\":%.4f}", pName, timing.totalMilliseconds / udMax(frames, 1), timing.maxMilliseconds);
+}
+
+static void vcGLTFBench_AddTiming(vcGLTFBenchTiming *pTiming, uint64_t start)
+{
+  double milliseconds = udPerfCounterMilliseconds(start);
+  pTiming->totalMilliseconds += milliseconds;
+  pTiming->maxMilliseconds = udMax(pTiming->maxMilliseconds, milliseconds);
+}
+
+static void vcGLTFBench_RunModel(const char *pFilename, udWorkerPool *pWorkerPool, int frames)
+{
+  vcGLTFScene *pScene = nullptr;
+  vcGLTFLoadStats loadStats = {};
+  vcGLTFMemoryUsage memoryUsage = {};
+  vcGLTFRenderStats renderStats[vcGLTFRP_Count] = {};
+  vcGLTFBenchTiming updateTiming = {};
+  vcGLTFBenchTiming renderTiming[vcGLTFRP_Count] = {};
+  vcGLNullStats gpuStats = {};
+  vcGLNullStats loadedGPUStats = {};
+
+  uint64_t loadStart = udPerfCounterStart();
+  udResult result = vcGLTF_Load(&pScene, pFilename, pWorkerPool, vcGLTFLF_OptimizeIndices | vcGLTFLF_GenerateLODs);
+  double loadMilliseconds = udPerfCounterMilliseconds(loadStart);
+
+  if (result == udR_Success)
+  {
+    vcGLTF_GetLoadStats(pScene, &loadStats);
+    vcGLTF_GetMemoryUsage(pScene, &memoryUsage);
+    loadedGPUStats = vcGLNull_GetStats();
+
+    // Frame the whole model from above and to one side
+    udDouble4x4 worldMatrix = udDouble4x4::identity();
+    udDouble3 boundsMin = udDouble3::zero();
+    udDouble3 boundsMax = udDouble3::one();
+    vcGLTF_GetBounds(pScene, worldMatrix, &boundsMin, &boundsMax);
+
+    udDouble3 centre = (boundsMin + boundsMax) * 0.5;
+    double radius = udMax(udMag3(boundsMax - boundsMin) * 0.5, 0.01);
+
+    udRay<double> camera;
+    camera.position = centre + udNormalize3(udDouble3::create(1.0, -1.0, 0.5)) * radius * 2.5;
+    camera.direction = udNormalize3(centre - camera.position);
+
+    udDouble4x4 viewMatrix = udInverse(udDouble4x4::lookAt(camera.position, centre));
+    udDouble4x4 projectionMatrix = udDouble4x4::perspectiveZO(UD_DEG2RAD(60.0), 16.0 / 9.0, radius * 0.01, radius * 10.0);
+
+    vcGLTFLightSet lighting = {};
+    lighting.ambientLighting = udFloat3::create(0.2f, 0.2f, 0.2f);
+    lighting.lightCount = 1;
+    lighting.lights[0].type = vcGLTFLightType_Directional;
+    lighting.lights[0].direction = udFloat3::create(0.f, 0.f, -1.f);
+    lighting.lights[0].color = udFloat3::create(1.f, 1.f, 1.f);
+    lighting.lights[0].intensity = 1.f;
+
+    for (int frame = 0; frame < frames; ++frame)
+    {
+      vcGLNull_ResetFrameStats();
+
+      uint64_t updateStart = udPerfCounterStart();
+      vcGLTF_Update(pScene, 1.0 / 60.0);
+      vcGLTFBench_AddTiming(&updateTiming, updateStart);
+
+      for (int pass = 0; pass < vcGLTFRP_Count; ++pass)
+      {
+        uint64_t renderStart = udPerfCounterStart();
+        vcGLTF_Render(pScene, camera, worldMatrix, viewMatrix, projectionMatrix, (vcGLTFRenderPass)pass, lighting);
+        vcGLTFBench_AddTiming(&renderTiming[pass], renderStart);
+      }
+    }
+
+    for (int pass = 0; pass < vcGLTFRP_Count; ++pass)
+      vcGLTF_GetRenderStats(pScene, (vcGLTFRenderPass)pass, &renderStats[pass]);
+
+    gpuStats = vcGLNull_GetStats();
+    vcGLTF_Destroy(&pScene);
+  }
+
+  printf("{\"model\":");
+  vcGLTFBench_PrintString(pFilename);
+  printf(",\"result\":");
+  vcGLTFBench_PrintString(udResultAsString(result));
+
+  if (result == udR_Success)
+  {
+    printf(",\"frames\":%d,\"load\":{\"totalMs\":%.4f,\"phasesMs\":{", frames, loadMilliseconds);
+    for (int phase = 0; phase < vcGLTFLP_Count; ++phase)
+      printf("%s\"%s\":%.4f", (phase == 0 ? "" : ","), g_vcGLTFBenchPhaseNames[phase], loadStats.phaseMilliseconds[phase]);
+    printf("},\"fileBytesRead\":%lld,\"accessorBytesDecoded\":%lld,\"verticesUploaded\":%lld,\"indicesUploaded\":%lld,\"texturesRequested\":%d,\"meshesCreated\":%lld,\"meshBytes\":%lld,\"texturesCreated\":%lld,\"textureBytes\":%lld}", (long long)loadStats.fileBytesRead, (long long)loadStats.accessorBytesDecoded, (long long)loadStats.verticesUploaded, (long long)loadStats.indicesUploaded, loadStats.texturesRequested, (long long)loadedGPUStats.meshesCreated, (long long)loadedGPUStats.meshBytesAlive, (long long)loadedGPUStats.texturesCreated, (long long)loadedGPUStats.textureBytesUploaded);
+
+    printf(",\"memory\":{\"peakResidentBytes\":%lld,\"peakMeshBytes\":%lld,\"sceneHostBytes\":%lld,\"sceneBufferBytes\":%lld,\"sceneGPUBytes\":%lld}", (long long)vcGLTFBench_PeakResidentBytes(), (long long)gpuStats.meshBytesPeak, (long long)memoryUsage.hostTotal, (long long)memoryUsage.bufferBytes, (long long)memoryUsage.gpuTotal);
+
+    printf(",");
+    vcGLTFBench_PrintTiming("update", updateTiming, frames);
+
+    printf(",\"render\":{");
+    for (int pass = 0; pass < vcGLTFRP_Count; ++pass)
+    {
+      const vcGLTFRenderStats &stats = renderStats[pass];
+
+      if (pass != 0)
+        printf(",");
+      printf("\"%s\":{", g_vcGLTFBenchPassNames[pass]);
+      vcGLTFBench_PrintTiming("submit", renderTiming[pass], frames);
+      printf(",\"instancesTested\":%d,\"instancesCulled\":%d,\"instancesPending\":%d,\"drawCalls\":%d,\"triangles\":%lld,\"shaderBinds\":%d,\"textureBinds\":%d,\"constantBufferBytes\":%lld}", stats.instancesTested, stats.instancesCulledMask + stats.instancesCulledFrustum + stats.instancesCulledOcclusion + stats.instancesCulledLOD, stats.instancesPending, stats.drawCalls, (long long)stats.trianglesSubmitted, stats.shaderBinds, stats.textureBinds, (long long)stats.constantBufferBytes);
+    }
+    printf("}");
+
+    // Null backend counters for the last frame, across all passes
+    printf(",\"lastFrame\":{\"drawCalls\":%lld,\"triangles\":%lld,\"shaderBinds\":%lld,\"textureBinds\":%lld,\"constantBufferBinds\":%lld,\"stateChanges\":%lld}", (long long)gpuStats.drawCalls, (long long)gpuStats.trianglesDrawn, (long long)gpuStats.shaderBinds, (long long)gpuStats.textureBinds, (long long)gpuStats.constantBufferBinds, (long long)gpuStats.stateChanges);
+  }
+
+  printf("}\n");
+  fflush(stdout);
+}
+
+static void vcGLTFBench_RunDirectory(const char *pDirectory, udWorkerPool *pWorkerPool, int frames)
+{
+  udFindDir *pFindDir = nullptr;
+  if (udOpenDir(&pFindDir, pDirectory) != udR_Success)
+    return;
+
+  do
+  {
+    if (pFindDir->pFilename[0] == '.')
+      continue;
+
+    const char *pPath = nullptr;
+    udSprintf(&pPath, "%s/%s", pDirectory, pFindDir->pFilename);
+
+    if (pFindDir->isDirectory)
+      vcGLTFBench_RunDirectory(pPath, pWorkerPool, frames);
+    else if (udStrEndsWithi(pFindDir->pFilename, ".gltf"))
+      vcGLTFBench_RunModel(pPath, pWorkerPool, frames);
+
+    udFree(pPath);
+  } while (udReadDir(pFindDir) == udR_Success);
+
+  udCloseDir(&pFindDir);
+}
+
+int main(int argc, char **ppArgv)
+{
+  if (argc < 2)
+  {
+    fprintf(stderr, "Usage: %s <model directory> [frames] [trace.json]\n", ppArgv[0]);
+    return 1;
+  }
+
+  int frames = (argc > 2) ? udMax(atoi(ppArgv[2]), 1) : 300;
+
+  udWorkerPool *pWorkerPool = nullptr;
+  if (udWorkerPool_Create(&pWorkerPool, (uint8_t)udClamp((int)udGetHardwareThreadCount() - 1, 1, 255), "vcGLTFBench") != udR_Success)
+    return 1;
+
+  vcGLTF_GenerateGlobalShaders();
+
+  if (argc > 3)
+    vcGLTF_SetTracing(true);
+
+  vcGLTFBench_RunDirectory(ppArgv[1], pWorkerPool, frames);
+
+  // The workers have to be finished before the trace is read and freed
+  udWorkerPool_Destroy(&pWorkerPool);
+
+  if (argc > 3 && vcGLTF_WriteTrace(ppArgv[3]) != udR_Success)
+    fprintf(stderr, "Unable to write the trace to %s\n", ppArgv[3]);
+
+  vcGLTF_ShutdownTracing();
+  vcGLTF_DestroyGlobalShaders();
+
+  return 0;
+}
@@ -0,0 +1,134 @@
+// Headless test for the CPU occlusion buffer; links against the null vcGL backend in vcGLNull.cpp
+// Usage: vcGLTFOcclusionTest
+// Rasterizes known occluders and checks vcGLTF_OcclusionTestBounds against bounds in front of, behind and beside them, then
+// checks which alpha masked primitives can lay down depth in the pre-pass.
+// vcGLTF.cpp is included directly so the rasterizer and buffer (which aren't part of vcGLTF.h) can be reached; don't also
+// link vcGLTF.cpp into this executable
+
+#include "../vcGLTF.cpp"
+
+#include <stdio.h>
+
+static int g_vcGLTFOcclusionTestFailures = 0;
+
+static void vcGLTFOcclusionTest_Check(bool condition, const char *pDescription)
+{
+  printf("%s: %s\n", condition ? "pass" : "FAIL", pDescription);
+  if (!condition)
+    ++g_vcGLTFOcclusionTestFailures;
+}
+
+// Perspective transform where clip w is the scene z; x and y are left as is so the screen spans -z..z
+static udFloat4x4 vcGLTFOcclusionTest_SceneToClip()
+{
+  udFloat4x4 sceneToClip = udFloat4x4::identity();
+  sceneToClip.a[11] = 1.f;
+  sceneToClip.a[15] = 0.f;
+  return sceneToClip;
+}
+
+// Rasterizes the rectangle minX..maxX, minY..maxY at depth z as two counter clockwise triangles
+static void vcGLTFOcclusionTest_RasterizeQuad(vcGLTFOcclusionBuffer *pBuffer, const udFloat4x4 &sceneToClip, float minX, float minY, float maxX, float maxY, float z)
+{
+  udFloat4 corners[4];
+  corners[0] = sceneToClip * udFloat4::create(minX, minY, z, 1.f);
+  corners[1] = sceneToClip * udFloat4::create(maxX, minY, z, 1.f);
+  corners[2] = sceneToClip * udFloat4::create(maxX, maxY, z, 1.f);
+  corners[3] = sceneToClip * udFloat4::create(minX, maxY, z, 1.f);
+
+  udFloat4 first[3] = { corners[0], corners[1], corners[2] };
+  udFloat4 second[3] = { corners[0], corners[2], corners[3] };
+
+  vcGLTF_RasterizeOccluder(pBuffer, first, false);
+  vcGLTF_RasterizeOccluder(pBuffer, second, false);
+}
+
+static void vcGLTFOcclusionTest_Clear(vcGLTFOcclusionBuffer *pBuffer)
+{
+  memset(pBuffer->pLevels[0], 0, sizeof(float) * pBuffer->levelWidth[0] * pBuffer->levelHeight[0]);
+  pBuffer->active = false;
+}
+
+int main(int /*argc*/, char ** /*ppArgv*/)
+{
+  vcGLTFOcclusionBuffer buffer = {};
+  if (!vcGLTF_AllocateOcclusion(&buffer))
+  {
+    fprintf(stderr, "Unable to allocate the occlusion buffer\n");
+    return 1;
+  }
+
+  udFloat4x4 sceneToClip = vcGLTFOcclusionTest_SceneToClip();
+
+  // A wall at z = 2 covering more than the whole screen
+  vcGLTFOcclusionTest_Clear(&buffer);
+  vcGLTFOcclusionTest_Check(!vcGLTF_OcclusionTestBounds(buffer, sceneToClip, udFloat3::create(-0.5f, -0.5f, 4.f), udFloat3::create(0.5f, 0.5f, 5.f)), "nothing is occluded before the levels are built");
+
+  vcGLTFOcclusionTest_RasterizeQuad(&buffer, sceneToClip, -4.f, -4.f, 4.f, 4.f, 2.f);
+  vcGLTF_BuildOcclusionLevels(&buffer);
+
+  vcGLTFOcclusionTest_Check(buffer.pLevels[0][(buffer.levelHeight[0] / 2) * buffer.levelWidth[0] + buffer.levelWidth[0] / 2] == 0.5f, "wall stores 1/w at the centre texel");
+  vcGLTFOcclusionTest_Check(buffer.pLevels[vcGLTFLimit_OcclusionLevels - 1][0] == 0.5f, "coarsest level keeps the wall depth");
+  vcGLTFOcclusionTest_Check(vcGLTF_OcclusionTestBounds(buffer, sceneToClip, udFloat3::create(-0.5f, -0.5f, 4.f), udFloat3::create(0.5f, 0.5f, 5.f)), "small box behind the wall is occluded");
+  vcGLTFOcclusionTest_Check(vcGLTF_OcclusionTestBounds(buffer, sceneToClip, udFloat3::create(-10.f, -10.f, 10.f), udFloat3::create(10.f, 10.f, 12.f)), "screen filling box behind the wall is occluded");
+  vcGLTFOcclusionTest_Check(!vcGLTF_OcclusionTestBounds(buffer, sceneToClip, udFloat3::create(-0.5f, -0.5f, 1.f), udFloat3::create(0.5f, 0.5f, 1.5f)), "box in front of the wall is visible");
+  vcGLTFOcclusionTest_Check(!vcGLTF_OcclusionTestBounds(buffer, sceneToClip, udFloat3::create(-0.5f, -0.5f, 1.f), udFloat3::create(0.5f, 0.5f, 5.f)), "box passing through the wall is visible");
+  vcGLTFOcclusionTest_Check(!vcGLTF_OcclusionTestBounds(buffer, sceneToClip, udFloat3::create(-0.5f, -0.5f, -1.f), udFloat3::create(0.5f, 0.5f, 5.f)), "box crossing the camera plane is visible");
+
+  // The same wall facing away is culled unless it's double sided
+  vcGLTFOcclusionTest_Clear(&buffer);
+  udFloat4 backFacing[3] = { sceneToClip * udFloat4::create(-4.f, -4.f, 2.f, 1.f), sceneToClip * udFloat4::create(-4.f, 4.f, 2.f, 1.f), sceneToClip * udFloat4::create(4.f, 4.f, 2.f, 1.f) };
+  vcGLTF_RasterizeOccluder(&buffer, backFacing, false);
+  vcGLTF_BuildOcclusionLevels(&buffer);
+  vcGLTFOcclusionTest_Check(!vcGLTF_OcclusionTestBounds(buffer, sceneToClip, udFloat3::create(-2.5f, 0.5f, 4.f), udFloat3::create(-1.5f, 1.5f, 5.f)), "back facing occluder is skipped");
+
+  vcGLTFOcclusionTest_Clear(&buffer);
+  vcGLTF_RasterizeOccluder(&buffer, backFacing, true);
+  vcGLTF_BuildOcclusionLevels(&buffer);
+  vcGLTFOcclusionTest_Check(vcGLTF_OcclusionTestBounds(buffer, sceneToClip, udFloat3::create(-2.5f, 0.5f, 4.f), udFloat3::create(-1.5f, 1.5f, 5.f)), "double sided occluder is rasterized");
+
+  // A wall covering only the left half of the screen
+  vcGLTFOcclusionTest_Clear(&buffer);
+  vcGLTFOcclusionTest_RasterizeQuad(&buffer, sceneToClip, -4.f, -4.f, 0.f, 4.f, 2.f);
+  vcGLTF_BuildOcclusionLevels(&buffer);
+
+  vcGLTFOcclusionTest_Check(vcGLTF_OcclusionTestBounds(buffer, sceneToClip, udFloat3::create(-3.f, -1.f, 4.f), udFloat3::create(-1.f, 1.f, 5.f)), "box behind the half wall is occluded");
+  vcGLTFOcclusionTest_Check(!vcGLTF_OcclusionTestBounds(buffer, sceneToClip, udFloat3::create(1.f, -1.f, 4.f), udFloat3::create(3.f, 1.f, 5.f)), "box beside the half wall is visible");
+  vcGLTFOcclusionTest_Check(!vcGLTF_OcclusionTestBounds(buffer, sceneToClip, udFloat3::create(-1.f, -1.f, 4.f), udFloat3::create(1.f, 1.f, 5.f)), "box straddling the edge of the half wall is visible");
+
+  // A wall that crosses the camera plane is clipped rather than dropped
+  vcGLTFOcclusionTest_Clear(&buffer);
+  udFloat4 crossing[3] = { sceneToClip * udFloat4::create(-40.f, -40.f, -1.f, 1.f), sceneToClip * udFloat4::create(40.f, -40.f, 3.f, 1.f), sceneToClip * udFloat4::create(0.f, 40.f, 3.f, 1.f) };
+  vcGLTF_RasterizeOccluder(&buffer, crossing, true);
+  vcGLTF_BuildOcclusionLevels(&buffer);
+  vcGLTFOcclusionTest_Check(vcGLTF_OcclusionTestBounds(buffer, sceneToClip, udFloat3::create(-0.5f, -0.5f, 10.f), udFloat3::create(0.5f, 0.5f, 11.f)), "near clipped occluder still occludes");
+
+  // Alpha masked primitives only join the depth pre-pass when the depth shader cuts out the same texels as the shading pass
+  vcTexture *pFakeTexture = (vcTexture*)&buffer; // Only compared against nullptr
+  vcGLTFMaterial material = {};
+  vcGLTFMeshPrimitive primitive = {};
+  primitive.pMaterial = &material;
+  primitive.features = (vcGLTFFeatureBits)(vcRSB_UVSet0 | vcRSB_UVSet1);
+
+  vcGLTFOcclusionTest_Check(vcGLTF_DepthMatchesShading(primitive), "opaque primitive is drawn in the pre-pass");
+
+  material.alphaMode = vcGLTFAM_Mask;
+  material.pBaseColorTexture = pFakeTexture;
+  vcGLTFOcclusionTest_Check(vcGLTF_DepthMatchesShading(primitive), "masked primitive cut out by UV set 0 is drawn in the pre-pass");
+
+  material.baseColorUVSet = 1;
+  vcGLTFOcclusionTest_Check(!vcGLTF_DepthMatchesShading(primitive), "masked primitive cut out by UV set 1 is shaded directly");
+
+  material.baseColorUVSet = 0;
+  primitive.features = (vcGLTFFeatureBits)(vcRSB_UVSet0 | vcRSB_Colour);
+  vcGLTFOcclusionTest_Check(!vcGLTF_DepthMatchesShading(primitive), "masked primitive with vertex colour alpha is shaded directly");
+
+  material.pBaseColorTexture = nullptr;
+  primitive.features = vcRSB_None;
+  vcGLTFOcclusionTest_Check(!vcGLTF_DepthMatchesShading(primitive), "masked primitive without a base colour texture is shaded directly");
+
+  udFree(buffer.pLevels[0]);
+
+  printf("%d failure(s)\n", g_vcGLTFOcclusionTestFailures);
+  return (g_vcGLTFOcclusionTestFailures == 0) ? 0 : 1;
+}
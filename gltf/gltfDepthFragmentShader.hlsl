@@ -0,0 +1,39 @@
+struct PS_INPUT
+{
+  float4 s_Position : SV_POSITION;
+
+#ifdef ALPHA_TEST
+  float2 v_UVCoord1 : TEXCOORD0;
+#endif
+};
+
+struct PS_OUTPUT
+{
+  float4 colour : SV_Target;
+};
+
+#ifdef ALPHA_TEST
+cbuffer u_DepthSettings : register(b0)
+{
+  float4 u_BaseColorFactor;
+  float u_AlphaCutoff;
+  float3 __padding;
+}
+
+sampler baseColorSampler;
+Texture2D u_BaseColorSampler;
+#endif
+
+PS_OUTPUT main(PS_INPUT input)
+{
+  PS_OUTPUT output;
+
+#ifdef ALPHA_TEST
+  if (u_BaseColorFactor.a * u_BaseColorSampler.Sample(baseColorSampler, input.v_UVCoord1).a < u_AlphaCutoff)
+    discard;
+#endif
+
+  output.colour = float4(0.0, 0.0, 0.0, 0.0);
+
+  return output;
+}
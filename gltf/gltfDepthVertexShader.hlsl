@@ -0,0 +1,76 @@
+cbuffer u_EveryFrame : register(b0)
+{
+  float4x4 u_ViewProjectionMatrix;
+  float4x4 u_ModelMatrix;
+  float4x4 u_NormalMatrix;
+}
+
+#ifdef HAS_SKINNING
+cbuffer u_SkinningInfo : register(b1)
+{
+  float4x4 u_jointMatrix[96];
+  float4x4 u_jointNormalMatrix[96];
+}
+#endif
+
+struct VS_INPUT
+{
+  float3 a_Position : POSITION;
+
+#ifdef ALPHA_TEST
+  float2 a_UV1 : TEXCOORD0;
+#endif
+
+#ifdef HAS_SKINNING
+  float4 a_Joints : BLENDINDICES0;
+  float4 a_Weights : BLENDWEIGHT0;
+#endif
+};
+
+struct PS_INPUT
+{
+  float4 s_Position : SV_POSITION;
+
+#ifdef ALPHA_TEST
+  float2 v_UVCoord1 : TEXCOORD0;
+#endif
+};
+
+#ifdef HAS_SKINNING
+float4x4 getSkinningMatrix(VS_INPUT input)
+{
+  float4x4 skin = float4x4(0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+
+  skin +=
+    input.a_Weights.x * u_jointMatrix[int(input.a_Joints.x * 256)] +
+    input.a_Weights.y * u_jointMatrix[int(input.a_Joints.y * 256)] +
+    input.a_Weights.z * u_jointMatrix[int(input.a_Joints.z * 256)] +
+    input.a_Weights.w * u_jointMatrix[int(input.a_Joints.w * 256)];
+
+  return skin;
+}
+#endif
+
+PS_INPUT main(VS_INPUT input)
+{
+  PS_INPUT output;
+
+  // Same operations in the same order as gltfVertexShader, and precise so neither compile reorders or fuses them; the
+  // shaded pass depends on this for its equal depth test
+  precise float4 pos = float4(input.a_Position, 1.0);
+
+#ifdef HAS_SKINNING
+  pos = mul(getSkinningMatrix(input), pos);
+#endif
+
+  pos = mul(u_ModelMatrix, pos);
+
+  precise float4 clipPos = mul(u_ViewProjectionMatrix, pos);
+  output.s_Position = clipPos;
+
+#ifdef ALPHA_TEST
+  output.v_UVCoord1 = input.a_UV1;
+#endif
+
+  return output;
+}
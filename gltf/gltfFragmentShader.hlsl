@@ -100,6 +100,25 @@ Texture2D u_BaseColorSampler;
 sampler metallicRoughnessSampler;
 Texture2D u_MetallicRoughnessSampler;
 
+#ifdef CLUSTERED_LIGHTING
+// Lights binned on the CPU into a view frustum grid; see vcGLTF_BuildClusters
+cbuffer u_ClusterSettings : register(b1)
+{
+  float4x4 u_ClusterViewProjection;
+  float4 u_ClusterDimensions; // Tiles x, tiles y, depth slices, lights per texture row
+  float4 u_ClusterDepth; // Near w, slices / log(far w / near w), indices per texture row, unused
+}
+
+sampler clusterLightSampler;
+Texture2D u_ClusterLightSampler; // 4 texels per light
+
+sampler clusterIndexSampler;
+Texture2D u_ClusterIndexSampler; // 4 light indices per texel
+
+sampler clusterGridSampler;
+Texture2D u_ClusterGridSampler; // Start and count into the index list per cluster
+#endif
+
 struct MaterialInfo
 {
   float perceptualRoughness; // roughness value, as authored by the model creator (input to shader)
@@ -126,8 +145,10 @@ float3 linearTosRGB(float3 color)
   return pow(color, float3(INV_GAMMA, INV_GAMMA, INV_GAMMA));
 }
 
-// sRGB to linear approximation
+// sRGB to linear approximation; the same curve as linearTosRGB and vcGLTF_sRGBToLinear on the CPU
 // see http://chilliant.blogspot.com/2012/08/srgb-approximations-for-hlsl.html
+// The base colour and emissive maps are still decoded here per sample (and filtered in sRGB) as vcTexture can't create them
+// in an sRGB format; these calls go once it can
 float3 sRGBToLinear(float3 srgbIn)
 {
   return float3(pow(srgbIn.xyz, float3(GAMMA, GAMMA, GAMMA)));
@@ -232,77 +253,32 @@ float getSpotAttenuation(float3 pointToLight, float3 spotDirection, float outerC
 
 float2 getNormalUV(PS_INPUT input)
 {
-  float3 uv = float3(0.0, 0.0, 0.0);
-
-  if (u_NormalUVSet >= 0)
-  {
-    uv = float3(u_NormalUVSet < 1 ? input.v_UVCoord1 : input.v_UVCoord2, 1.0);
-  }
-
-  return uv.xy;
+  return (u_NormalUVSet < 1 ? input.v_UVCoord1 : input.v_UVCoord2);
 }
 
 float2 getEmissiveUV(PS_INPUT input)
 {
-  float3 uv = float3(0.0, 0.0, 0.0);
-
-  if (u_EmissiveUVSet >= 0)
-  {
-    uv = float3(u_EmissiveUVSet < 1 ? input.v_UVCoord1 : input.v_UVCoord2, 1.0);
-  }
-
-  return uv.xy;
+  return (u_EmissiveUVSet < 1 ? input.v_UVCoord1 : input.v_UVCoord2);
 }
 
 float2 getOcclusionUV(PS_INPUT input)
 {
-  float3 uv = float3(0.0, 0.0, 0.0);
-
-  if (u_OcclusionUVSet >= 0)
-  {
-    uv = float3(u_OcclusionUVSet < 1 ? input.v_UVCoord1 : input.v_UVCoord2, 1.0);
-  }
-
-  return uv.xy;
+  return (u_OcclusionUVSet < 1 ? input.v_UVCoord1 : input.v_UVCoord2);
 }
 
 float2 getBaseColorUV(PS_INPUT input)
 {
-  float3 uv = float3(0.0, 0.0, 0.0);
-
-  if (u_BaseColorUVSet >= 0)
-  {
-    uv = float3(u_BaseColorUVSet < 1 ? input.v_UVCoord1 : input.v_UVCoord2, 1.0);
-  }
-
-  return uv.xy;
+  return (u_BaseColorUVSet < 1 ? input.v_UVCoord1 : input.v_UVCoord2);
 }
 
 float2 getMetallicRoughnessUV(PS_INPUT input)
 {
-  float3 uv = float3(0.0, 0.0, 0.0);
-
-  if (u_MetallicRoughnessUVSet >= 0)
-  {
-    uv = float3(u_MetallicRoughnessUVSet < 1 ? input.v_UVCoord1 : input.v_UVCoord2, 1.0);
-  }
-
-  return uv.xy;
+  return (u_MetallicRoughnessUVSet < 1 ? input.v_UVCoord1 : input.v_UVCoord2);
 }
 
 // Get normal, tangent and bitangent vectors.
 NormalInfo getNormalInfo(PS_INPUT input, float3 v)
 {
-  float2 uv = float2(0.0, 0.0);
-
-  if (u_NormalUVSet >= 0)
-    uv = (u_NormalUVSet < 1 ? input.v_UVCoord1 : input.v_UVCoord2);
-
-  float3 uv_dx = ddx(float3(uv, 0.0));
-  float3 uv_dy = ddy(float3(uv, 0.0));
-
-  float3 t_ = (uv_dy.y * ddx(input.v_Position) - uv_dx.y * ddy(input.v_Position)) / (uv_dx.x * uv_dy.y - uv_dy.x * uv_dx.y);
-
   float3 n, t, b, ng;
 
   // Compute geometrical TBN:
@@ -315,8 +291,21 @@ NormalInfo getNormalInfo(PS_INPUT input, float3 v)
 #else
   // Normals are either present as vertex attributes or approximated.
   ng = normalize(input.v_Normal);
+
+#ifdef HAS_NORMAL_MAP
+  float2 uv = getNormalUV(input);
+  float3 uv_dx = ddx(float3(uv, 0.0));
+  float3 uv_dy = ddy(float3(uv, 0.0));
+
+  float3 t_ = (uv_dy.y * ddx(input.v_Position) - uv_dx.y * ddy(input.v_Position)) / (uv_dx.x * uv_dy.y - uv_dy.x * uv_dx.y);
+
   t = normalize(t_ - ng * dot(ng, t_));
   b = cross(ng, t);
+#else
+  // The tangent frame is only needed to perturb the normal, skip the derivatives
+  t = float3(0.0, 0.0, 0.0);
+  b = float3(0.0, 0.0, 0.0);
+#endif
 #endif
 
   // For a back-facing surface, the tangential basis vectors are negated.
@@ -326,16 +315,13 @@ NormalInfo getNormalInfo(PS_INPUT input, float3 v)
   ng *= facing;
 
   // Compute pertubed normals:
-  if (u_NormalUVSet >= 0)
-  {
-    n = u_NormalSampler.Sample(normalSampler, uv).rgb * 2.0 - 1.0;
-    n = n * float3(u_NormalScale, u_NormalScale, 1.0);
-    n = mul(normalize(n), float3x3(t, b, ng));
-  }
-  else
-  {
-    n = ng;
-  }
+#ifdef HAS_NORMAL_MAP
+  n = u_NormalSampler.Sample(normalSampler, getNormalUV(input)).rgb * 2.0 - 1.0;
+  n = n * float3(u_NormalScale, u_NormalScale, 1.0);
+  n = mul(normalize(n), float3x3(t, b, ng));
+#else
+  n = ng;
+#endif
 
   NormalInfo info;
   info.ng = ng;
@@ -351,8 +337,9 @@ float4 getBaseColor(PS_INPUT input)
   float4 baseColor = u_BaseColorFactor;
   float4 tintColor = float4(1.0, 1.0, 1.0, 1.0);
 
-  if (u_BaseColorUVSet >= 0)
-    baseColor *= sRGBToLinear(u_BaseColorSampler.Sample(baseColorSampler, getBaseColorUV(input)));
+#ifdef HAS_BASECOLOR_MAP
+  baseColor *= sRGBToLinear(u_BaseColorSampler.Sample(baseColorSampler, getBaseColorUV(input)));
+#endif
 
 #ifdef HAS_VERTEX_COLOR
   tintColor = input.v_Color;
@@ -366,14 +353,13 @@ MaterialInfo getMetallicRoughnessInfo(PS_INPUT input, MaterialInfo info, float f
   info.metallic = u_MetallicFactor;
   info.perceptualRoughness = u_RoughnessFactor;
 
-  if (u_MetallicRoughnessUVSet >= 0)
-  {
-    // Roughness is stored in the 'g' channel, metallic is stored in the 'b' channel.
-    // This layout intentionally reserves the 'r' channel for (optional) occlusion map data
-    float4 mrSample = u_MetallicRoughnessSampler.Sample(metallicRoughnessSampler, getMetallicRoughnessUV(input));
-    info.perceptualRoughness *= mrSample.g;
-    info.metallic *= mrSample.b;
-  }
+#ifdef HAS_METALLIC_ROUGHNESS_MAP
+  // Roughness is stored in the 'g' channel, metallic is stored in the 'b' channel.
+  // This layout intentionally reserves the 'r' channel for (optional) occlusion map data
+  float4 mrSample = u_MetallicRoughnessSampler.Sample(metallicRoughnessSampler, getMetallicRoughnessUV(input));
+  info.perceptualRoughness *= mrSample.g;
+  info.metallic *= mrSample.b;
+#endif
 
   // Achromatic f0 based on IOR.
   float3 f0 = float3(f0_ior, f0_ior, f0_ior);
@@ -384,6 +370,80 @@ MaterialInfo getMetallicRoughnessInfo(PS_INPUT input, MaterialInfo info, float f
   return info;
 }
 
+void applyLight(Light light, float3 position, float3 n, float3 v, MaterialInfo materialInfo, inout float3 f_diffuse, inout float3 f_specular)
+{
+  float3 pointToLight = -light.direction;
+  float rangeAttenuation = 1.0;
+  float spotAttenuation = 1.0;
+
+  if (light.type != LightType_Directional)
+  {
+    pointToLight = light.position - position;
+    rangeAttenuation = getRangeAttenuation(light.range, length(pointToLight));
+  }
+
+  if (light.type == LightType_Spot)
+  {
+    spotAttenuation = getSpotAttenuation(pointToLight, light.direction, light.outerConeCos, light.innerConeCos);
+  }
+
+  float3 intensity = rangeAttenuation * spotAttenuation * light.intensity * light.color;
+
+  float3 l = normalize(pointToLight);   // Direction from surface point to light
+  float3 h = normalize(l + v);          // Direction of the vector between l and v, called halfway vector
+  float NdotL = clampedDot(n, l);
+  float NdotV = clampedDot(n, v);
+  float NdotH = clampedDot(n, h);
+  float LdotH = clampedDot(l, h);
+  float VdotH = clampedDot(v, h);
+
+  if (NdotL > 0.0 || NdotV > 0.0)
+  {
+    // Calculation of analytical light
+    //https://github.com/KhronosGroup/glTF/tree/master/specification/2.0#acknowledgments AppendixB
+    f_diffuse += intensity * NdotL * BRDF_lambertian(materialInfo.f0, materialInfo.f90, materialInfo.albedoColor, VdotH);
+    f_specular += intensity * NdotL * BRDF_specularGGX(materialInfo.f0, materialInfo.f90, materialInfo.alphaRoughness, VdotH, NdotL, NdotV, NdotH);
+  }
+}
+
+#ifdef CLUSTERED_LIGHTING
+Light getClusterLight(int index)
+{
+  int lightsPerRow = int(u_ClusterDimensions.w);
+  int2 texel = int2((index % lightsPerRow) * 4, index / lightsPerRow);
+
+  float4 t0 = u_ClusterLightSampler.Load(int3(texel, 0));
+  float4 t1 = u_ClusterLightSampler.Load(int3(texel.x + 1, texel.y, 0));
+  float4 t2 = u_ClusterLightSampler.Load(int3(texel.x + 2, texel.y, 0));
+  float4 t3 = u_ClusterLightSampler.Load(int3(texel.x + 3, texel.y, 0));
+
+  Light light;
+  light.direction = t0.xyz;
+  light.range = t0.w;
+  light.color = t1.xyz;
+  light.intensity = t1.w;
+  light.position = t2.xyz;
+  light.innerConeCos = t2.w;
+  light.outerConeCos = t3.x;
+  light.type = int(t3.y);
+  light.__padding = t3.zw;
+
+  return light;
+}
+
+int2 getCluster(float3 position)
+{
+  float4 clip = mul(u_ClusterViewProjection, float4(position, 1.0));
+  float2 ndc = clip.xy / clip.w;
+
+  int tileX = clamp(int((ndc.x * 0.5 + 0.5) * u_ClusterDimensions.x), 0, int(u_ClusterDimensions.x) - 1);
+  int tileY = clamp(int((ndc.y * 0.5 + 0.5) * u_ClusterDimensions.y), 0, int(u_ClusterDimensions.y) - 1);
+  int slice = clamp(int(log(max(clip.w, u_ClusterDepth.x) / u_ClusterDepth.x) * u_ClusterDepth.y), 0, int(u_ClusterDimensions.z) - 1);
+
+  return int2(tileY * int(u_ClusterDimensions.x) + tileX, slice);
+}
+#endif
+
 PS_OUTPUT main(PS_INPUT input)
 {
   PS_OUTPUT output;
@@ -391,14 +451,13 @@ PS_OUTPUT main(PS_INPUT input)
 
   float4 baseColor = getBaseColor(input);
 
-  if (u_alphaMode == 0) //OPAQUE
-    baseColor.a = 1.0;
-
-#ifdef MATERIAL_UNLIT
-  g_finalColor = (float4(linearTosRGB(baseColor.rgb), baseColor.a));
-  return;
+#if !defined(ALPHAMODE_MASK) && !defined(ALPHAMODE_BLEND)
+  baseColor.a = 1.0;
 #endif
 
+#ifdef MATERIAL_UNLIT
+  float3 color = baseColor.rgb;
+#else
   float3 v = normalize(u_Camera - input.v_Position);
   NormalInfo normalInfo = getNormalInfo(input, v);
   float3 n = normalInfo.n;
@@ -436,72 +495,53 @@ PS_OUTPUT main(PS_INPUT input)
 
   // LIGHTING
   float3 f_emissive = float3(0.0, 0.0, 0.0);
-  float3 f_diffuse = float3(0, 0, 0) + sRGBToLinear(materialInfo.albedoColor * u_ambience.xyz);
+  float3 f_diffuse = materialInfo.albedoColor * u_ambience.xyz; // u_ambience is linearized on the CPU
   float3 f_specular = float3(0, 0, 0);
 
-  for (int i = 0; i < u_lightCount; ++i)
-  {
-    Light light = u_Lights[i];
-
-    float3 pointToLight = -light.direction;
-    float rangeAttenuation = 1.0;
-    float spotAttenuation = 1.0;
+#ifdef CLUSTERED_LIGHTING
+  float4 cluster = u_ClusterGridSampler.Load(int3(getCluster(input.v_Position), 0));
+  int indicesPerRow = int(u_ClusterDepth.z);
 
-    if (light.type != LightType_Directional)
-    {
-      pointToLight = light.position - input.v_Position;
-      rangeAttenuation = getRangeAttenuation(light.range, length(pointToLight));
-    }
-
-    if (light.type == LightType_Spot)
-    {
-      spotAttenuation = getSpotAttenuation(pointToLight, light.direction, light.outerConeCos, light.innerConeCos);
-    }
-
-    float3 intensity = rangeAttenuation * spotAttenuation * light.intensity * light.color;
-
-    float3 l = normalize(pointToLight);   // Direction from surface point to light
-    float3 h = normalize(l + v);          // Direction of the vector between l and v, called halfway vector
-    float NdotL = clampedDot(n, l);
-    float NdotV = clampedDot(n, v);
-    float NdotH = clampedDot(n, h);
-    float LdotH = clampedDot(l, h);
-    float VdotH = clampedDot(v, h);
-
-    if (NdotL > 0.0 || NdotV > 0.0)
-    {
-      // Calculation of analytical light
-      //https://github.com/KhronosGroup/glTF/tree/master/specification/2.0#acknowledgments AppendixB
-      f_diffuse += intensity * NdotL * BRDF_lambertian(materialInfo.f0, materialInfo.f90, materialInfo.albedoColor, VdotH);
-      f_specular += intensity * NdotL * BRDF_specularGGX(materialInfo.f0, materialInfo.f90, materialInfo.alphaRoughness, VdotH, NdotL, NdotV, NdotH);
-    }
+  for (int i = 0; i < int(cluster.y); ++i)
+  {
+    int index = int(cluster.x) + i;
+    int indexTexel = (index % indicesPerRow) / 4;
+    float4 indices = u_ClusterIndexSampler.Load(int3(indexTexel, index / indicesPerRow, 0));
+    applyLight(getClusterLight(int(indices[index % 4])), input.v_Position, n, v, materialInfo, f_diffuse, f_specular);
   }
+#else
+  for (int i = 0; i < u_lightCount; ++i)
+    applyLight(u_Lights[i], input.v_Position, n, v, materialInfo, f_diffuse, f_specular);
+#endif
 
   f_emissive = u_EmissiveFactor;
 
-  if (u_EmissiveUVSet >= 0)
-    f_emissive *= sRGBToLinear(u_EmissiveSampler.Sample(emissiveSampler, getEmissiveUV(input))).rgb;
+#ifdef HAS_EMISSIVE_MAP
+  f_emissive *= sRGBToLinear(u_EmissiveSampler.Sample(emissiveSampler, getEmissiveUV(input))).rgb;
+#endif
 
   float3 color = (f_emissive.rgb + f_diffuse + f_specular);
-  float ao = 1.0;
 
   // Apply optional PBR terms for additional (optional) shading
-  if (u_OcclusionUVSet >= 0)
-  {
-    ao = u_OcclusionSampler.Sample(occlusionSampler, getOcclusionUV(input)).r;
-    color = lerp(color, color * ao, u_OcclusionStrength);
-  }
+#ifdef HAS_OCCLUSION_MAP
+  float ao = u_OcclusionSampler.Sample(occlusionSampler, getOcclusionUV(input)).r;
+  color = lerp(color, color * ao, u_OcclusionStrength);
+#endif
+#endif // MATERIAL_UNLIT
 
-  if (u_alphaMode == 1) //MASK
-  {
-    // Late discard to avaoid samplig artifacts. See https://github.com/KhronosGroup/glTF-Sample-Viewer/issues/267
-    if (baseColor.a < u_AlphaCutoff)
-      discard;
+#ifdef ALPHAMODE_MASK
+  // Late discard to avaoid samplig artifacts. See https://github.com/KhronosGroup/glTF-Sample-Viewer/issues/267
+  if (baseColor.a < u_AlphaCutoff)
+    discard;
 
-    baseColor.a = 1.0;
-  }
+  baseColor.a = 1.0;
+#endif
 
+#ifdef MATERIAL_UNLIT
+  output.colour = float4(linearTosRGB(color), baseColor.a);
+#else
   output.colour = float4(toneMap(color), baseColor.a);
+#endif
 
   return output;
 }
@@ -270,7 +270,7 @@ float3 getTargetTangent(VS_INPUT input)
 
 float4 getPosition(VS_INPUT input)
 {
-  float4 pos = float4(input.a_Position, 1.0);
+  precise float4 pos = float4(input.a_Position, 1.0);
 
 #ifdef USE_MORPHING
   pos += getTargetPosition(input);
@@ -319,7 +319,8 @@ PS_INPUT main(VS_INPUT input)
 {
   PS_INPUT output;
 
-  float4 pos = mul(u_ModelMatrix, getPosition(input));
+  // precise and in the same order as gltfDepthVertexShader so the depth pre-pass's equal test matches exactly
+  precise float4 pos = mul(u_ModelMatrix, getPosition(input));
   output.v_Position = float3(pos.xyz) / pos.w;
 
 #ifdef HAS_TANGENTS
@@ -346,7 +347,8 @@ PS_INPUT main(VS_INPUT input)
   output.v_Color = input.a_Color;
 #endif
 
-  output.s_Position = mul(u_ViewProjectionMatrix, pos);
+  precise float4 clipPos = mul(u_ViewProjectionMatrix, pos);
+  output.s_Position = clipPos;
 
   return output;
 }
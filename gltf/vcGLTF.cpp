@@ -5,13 +5,18 @@
 #include "vcGL/gl/vcTexture.h"
 
 #include "udPlatform.h"
-#include "udJSON.h"
 #include "udPlatformUtil.h"
 #include "udFile.h"
 #include "udStringUtil.h"
 
+#include "mikktspace.h"
+
 #include "caching/ttTextureCache.h"
 
+#include <float.h>
+#include <stdarg.h>
+#include <stdlib.h>
+
 enum vcGLTFTypes
 {
   vcGLTFType_Int8 = 5120,
@@ -33,12 +38,28 @@ enum vcGLTFTypes
 
 enum vcGLTFFeatures
 {
+  // Vertex attributes; these change the vertex layout
   vcRSF_HasTangents,
   vcRSF_HasUVSet0,
   vcRSF_HasUVSet1,
   vcRSF_HasColour,
   vcRSF_HasSkinning,
 
+  vcRSF_VertexCount,
+
+  // Material properties; these only specialize the shaders
+  vcRSF_HasBaseColorMap = vcRSF_VertexCount,
+  vcRSF_HasMetallicRoughnessMap,
+  vcRSF_HasNormalMap,
+  vcRSF_HasEmissiveMap,
+  vcRSF_HasOcclusionMap,
+  vcRSF_AlphaMask,
+  vcRSF_AlphaBlend,
+  vcRSF_Unlit,
+
+  // Frame wide
+  vcRSF_ClusteredLighting,
+
   vcRSF_Count
 };
 
@@ -52,16 +73,62 @@ enum vcGLTFFeatureBits
   vcRSB_Colour = 1 << vcRSF_HasColour,
   vcRSB_Skinned = 1 << vcRSF_HasSkinning,
 
+  vcRSB_BaseColorMap = 1 << vcRSF_HasBaseColorMap,
+  vcRSB_MetallicRoughnessMap = 1 << vcRSF_HasMetallicRoughnessMap,
+  vcRSB_NormalMap = 1 << vcRSF_HasNormalMap,
+  vcRSB_EmissiveMap = 1 << vcRSF_HasEmissiveMap,
+  vcRSB_OcclusionMap = 1 << vcRSF_HasOcclusionMap,
+  vcRSB_AlphaMask = 1 << vcRSF_AlphaMask,
+  vcRSB_AlphaBlend = 1 << vcRSF_AlphaBlend,
+  vcRSB_Unlit = 1 << vcRSF_Unlit,
+
+  vcRSB_ClusteredLighting = 1 << vcRSF_ClusteredLighting,
+
+  vcRSB_VertexCount = 1 << vcRSF_VertexCount,
+  vcRSB_VertexMask = vcRSB_VertexCount - 1,
+
   vcRSB_Count = 1 << vcRSF_Count
 };
 
+// GLTF is Y-up, the renderer is Z-up
+const udFloat4x4 vcGLTF_SpaceChange = { 1, 0, 0, 0, 0, 0, 1, 0, 0, -1, 0, 0, 0, 0, 0, 1 };
+
 enum vcGLTFLimits // These are mostly from the shaders
 {
   vcGLTFLimit_JointCount = 96,
   vcGLTFLimit_LightCount = 8,
-  vcGLTFLimit_MeshMask = 32,
+  vcGLTFLimit_LODCount = 4, // Including the full detail mesh
+  vcGLTFLimit_VertexCacheSize = 16, // Post-transform cache size modelled when reordering triangles
+  vcGLTFLimit_PackVertexCount = 1 << 22, // Vertices in each shared vertex buffer before another is started
+  vcGLTFLimit_PackLayoutCount = 2 + vcRSF_VertexCount * 2, // Vertex layout entries a shared vertex buffer can describe
+
+  // Clustered lighting grid; tiles across the screen and exponential depth slices
+  vcGLTFLimit_ClusterTilesX = 16,
+  vcGLTFLimit_ClusterTilesY = 9,
+  vcGLTFLimit_ClusterSlices = 24,
+  vcGLTFLimit_ClusterTextureWidth = 256, // Texels per row of the light and index textures; each light is 4 texels
+
+  // Software occlusion buffer
+  vcGLTFLimit_OcclusionWidth = 256,
+  vcGLTFLimit_OcclusionHeight = 128,
+  vcGLTFLimit_OcclusionLevels = 6, // Including the full resolution level
+  vcGLTFLimit_OccluderCount = 16, // Instances rasterized each frame
+  vcGLTFLimit_OccluderTriangles = 4096, // Meshes with more triangles are never used as occluders
+
+  // Trace events
+  vcGLTFLimit_TraceThreads = 64,
+  vcGLTFLimit_TraceEvents = 1 << 15, // Kept per thread
+
+  vcGLTFLimit_ArenaBlockSize = 64 * 1024, // Smallest block added once the estimated arena size runs out
+
+  // Counting pass over the JSON; nothing the parse allocates for is nested deeper than this
+  vcGLTFLimit_JSONPathLength = 64,
+  vcGLTFLimit_JSONCountDepth = 16,
 };
 
+// Screen coverage (fraction of the viewport covered by the projected bounding sphere) below which each generated LOD is used
+const float vcGLTF_GeneratedLODCoverage[vcGLTFLimit_LODCount - 1] = { 0.1f, 0.02f, 0.005f };
+
 struct vcGLTFNode
 {
   bool dirty;
@@ -108,14 +175,101 @@ struct vcGLTFMeshInstance
   vcGLTFNode *pNode;
   int meshID;
   int skinID; // -1 for no skin
+
+  // MSFT_lod; lodMeshIDs[0] is meshID
+  int lodMeshCount;
+  int lodMeshIDs[vcGLTFLimit_LODCount];
+  float lodCoverage[vcGLTFLimit_LODCount + 1]; // MSFT_screencoverage, all 0 if not provided
+
+  // Bounds in the GLTF scene space (after the node hierarchy and skinning), updated by vcGLTF_UpdateInstanceBounds
+  udFloat3 sceneMin;
+  udFloat3 sceneMax;
 };
 
 struct vcGLTFMeshPrimitive
 {
   vcGLTFFeatureBits features;
   vcMesh *pMesh;
+  vcMesh *pPositionMesh; // Position only stream for depth passes; nullptr when the full vertex is required
+
+  // Meshes are usually shared scene wide (see vcGLTFMeshPack); -1 if the primitive owns them
+  int packID;
+  int positionPackID;
+
+  // Range in pMesh / pPositionMesh; the LOD ranges below are relative to these
+  int indexStart;
+  int positionIndexStart;
+  int indexCount;
 
   vcGLTFMaterial *pMaterial;
+
+  // Bind pose bounds in mesh space
+  udFloat3 localMin;
+  udFloat3 localMax;
+
+  // Generated LOD chain stored after each other in the index buffer; 0 when the primitive has no chain
+  int lodCount;
+  int lodIndexStart[vcGLTFLimit_LODCount];
+  int lodIndexCount[vcGLTFLimit_LODCount];
+
+  // Skinned primitives only; bounds of the vertices influenced by each JOINTS_0 index as [min, max] pairs
+  int jointBoundCount;
+  udFloat3 *pJointBounds;
+};
+
+struct vcGLTFBVHNode
+{
+  udFloat3 boundsMin;
+  int leftFirst; // Left child for interior nodes (right is leftFirst + 1), first item for leaves
+  udFloat3 boundsMax;
+  int itemCount; // 0 for interior nodes
+};
+
+struct vcGLTFBVHTriangle
+{
+  udFloat3 v0;
+  udFloat3 edge1;
+  udFloat3 edge2;
+
+  int primitiveID;
+  int triangleID;
+};
+
+struct vcGLTFBVH
+{
+  int nodeCount;
+  vcGLTFBVHNode *pNodes;
+
+  int triangleCount;
+  vcGLTFBVHTriangle *pTriangles;
+
+  int maxDepth; // Root is 0; traversal never holds more than maxDepth + 1 nodes on its stack
+};
+
+enum vcGLTFMeshState
+{
+  vcGLTFMS_Created, // While loading
+  vcGLTFMS_Deferred, // vcGLTFLF_DeferMeshes; only the name and bounds (from the accessors) are known
+  vcGLTFMS_Requested, // Queued by vcGLTF_Render
+  vcGLTFMS_Streamed, // Created after loading; can be evicted
+  vcGLTFMS_Failed, // Couldn't be streamed; never requested again
+};
+
+struct vcGLTFAttributeDesc
+{
+  char name[16]; // "POSITION", "TEXCOORD_0" etc.
+  int accessor;
+};
+
+// A primitive as read from the JSON; kept so deferred meshes can be created after loading
+struct vcGLTFPrimitiveDesc
+{
+  int mode; // 4 (triangles) if not set
+  int material; // 0 if not set
+  int indices; // Accessor, -1 if not set
+
+  int attributeCount;
+  vcGLTFAttributeDesc *pAttributes;
 };
 
 struct vcGLTFMesh
@@ -123,14 +277,52 @@ struct vcGLTFMesh
   const char *pName;
   int numPrimitives;
   vcGLTFMeshPrimitive *pPrimitives;
+
+  int primitiveDescCount;
+  vcGLTFPrimitiveDesc *pPrimitiveDescs;
+
+  udFloat3 localMin;
+  udFloat3 localMax;
+
+  vcGLTFBVH bvh; // Triangles are gathered while decoding, the nodes are built on the worker pool
+  volatile int32_t bvhReady;
+
+  vcGLTFMeshState state;
+  int lastDrawnFrame; // Streamed meshes only
+  int64_t vertexBytes; // Streamed meshes only, so eviction can remove them from the scene totals
+  int64_t indexBytes;
 };
 
 struct vcGLTFBuffer
 {
-  int64_t byteLength;
+  const char *pURI;
+  int64_t byteLength; // As declared; the loaded file must match it
   uint8_t *pBytes;
 };
 
+// Read from the JSON text by vcGLTF_ParseDocument; missing members are 0
+struct vcGLTFAccessor
+{
+  int bufferView; // -1 if not set
+  int componentType; // vcGLTFTypes
+  int64_t count;
+  int64_t byteOffset;
+  int64_t byteStride; // Not part of the accessor since glTF 1.0 but still written by some exporters
+  char type[8]; // "SCALAR", "VEC3" etc.
+
+  bool hasBounds; // Both min & max were given
+  udFloat3 min; // First 3 components only
+  udFloat3 max;
+};
+
+struct vcGLTFBufferView
+{
+  int buffer;
+  int64_t byteOffset;
+  int64_t byteLength;
+  int64_t byteStride;
+};
+
 enum vcGLTFChannelTarget
 {
   vcGLTFChannelTarget_Translation, // X,Y,Z
@@ -160,6 +352,7 @@ struct vcGLTFAnimationSampler
 
   float *pTime;
   vcGLTFInterpolation interpolationMethod;
+  int outputBytes;
 
   union
   {
@@ -198,9 +391,133 @@ struct vcGLTFSkin
   udFloat4x4 *pInverseBindMatrices; // If nullptr; identity
 };
 
+// Primitives with the same vertex layout are appended to shared buffers while loading. The indices are rebased as they're
+// appended so each primitive is just an index range; the vcMesh is created once loading finishes
+struct vcGLTFMeshPack
+{
+  vcVertexLayoutTypes layout[vcGLTFLimit_PackLayoutCount];
+  int layoutCount;
+  uint32_t vertexStride;
+  int shaderFeatures; // Shader bound when the mesh is created, -1 for the depth position shader
+
+  uint8_t *pVertData;
+  uint32_t vertexCount;
+  uint32_t vertexCapacity;
+
+  uint32_t *pIndices;
+  uint32_t indexCount;
+  uint32_t indexCapacity;
+
+  vcMesh *pMesh;
+};
+
+// Uniform grid over the range limited lights passed to vcGLTF_Render, rebuilt each call. Lights without a range (and
+// directional lights) reach everything so they're kept in a separate list
+struct vcGLTFLightGrid
+{
+  udFloat3 origin;
+  float cellSize;
+  int dims[3];
+
+  uint32_t cellCapacity;
+  uint32_t *pCellStarts; // Cell count + 1 offsets into pEntries
+
+  uint32_t entryCapacity;
+  uint32_t *pEntries; // Light indices
+
+  uint32_t globalCount;
+  uint32_t globalCapacity;
+  uint32_t *pGlobalLights;
+
+  uint32_t stampCapacity;
+  uint32_t *pStamps; // Last query that visited each light so lights spanning several cells are only scored once
+  uint32_t queryID;
+};
+
+// View frustum cluster grid for vcGLTFLM_Clustered, rebuilt each vcGLTF_Render. Lights and per cluster light index lists
+// are uploaded as RGBA32F textures as vcGL has no structured buffers
+struct vcGLTFClusterLighting
+{
+  uint32_t clusterCounts[vcGLTFLimit_ClusterTilesX * vcGLTFLimit_ClusterTilesY * vcGLTFLimit_ClusterSlices];
+  udFloat4 gridTexels[vcGLTFLimit_ClusterTilesX * vcGLTFLimit_ClusterTilesY * vcGLTFLimit_ClusterSlices]; // Start, count
+  vcTexture *pGridTexture;
+
+  uint32_t lightRowCapacity; // Rows in the light texture
+  float *pLightTexels;
+  vcTexture *pLightTexture;
+
+  uint32_t indexCapacity; // Multiple of 4 * vcGLTFLimit_ClusterTextureWidth
+  float *pIndexTexels;
+  vcTexture *pIndexTexture;
+
+  // Cluster range covered by each light, stored between the counting and fill passes
+  uint32_t rangeCapacity;
+  uint32_t *pLightRanges; // 6 per light
+};
+
+// Low resolution depth buffer the largest on screen occluders are rasterized into on the CPU each frame. Stores 1/w so
+// larger is nearer; each coarser level keeps the furthest (smallest) value of the 2x2 texels below it
+struct vcGLTFOcclusionBuffer
+{
+  float *pLevels[vcGLTFLimit_OcclusionLevels];
+  int levelWidth[vcGLTFLimit_OcclusionLevels];
+  int levelHeight[vcGLTFLimit_OcclusionLevels];
+  bool active; // Occluders were rasterized this frame
+};
+
+// Bump allocator for scene data that doesn't change once it's loaded (names, nodes, primitives, animations, skins). It isn't
+// thread safe: only one thread may allocate at a time (vcGLTF_Load, then the thread calling vcGLTF_Render for deferred
+// meshes) and worker pool jobs must never allocate from it. vcGLTF_Destroy releases it all at once
+struct vcGLTFArenaBlock
+{
+  vcGLTFArenaBlock *pNext;
+  size_t capacity;
+  size_t used;
+  size_t __padding; // Keeps the data that follows 16 byte aligned
+};
+
+struct vcGLTFArena
+{
+  vcGLTFArenaBlock *pBlocks; // Most recent first
+  size_t blockSize; // Capacity of the next block, unless an allocation needs more
+};
+
+#define vcGLTF_ArenaAllocType(pArena, type, count) ((type*)vcGLTF_ArenaAlloc(pArena, sizeof(type) * (count)))
+
+// Bit per item with a second level holding a bit per word, set if that word has any bits set
+struct vcGLTFBitset
+{
+  size_t count;
+  uint64_t *pWords;
+  uint64_t *pSummary; // Shares the pWords allocation
+};
+
+struct vcGLTFTransparentItem
+{
+  int instanceID;
+  const vcGLTFMesh *pMesh;
+  int primitiveID;
+  int generatedLOD;
+  int constantsID; // Into pCachedConstants for pre-pass items, otherwise -1
+};
+
+// Instance constants set during the depth pre-pass, kept so the shaded half reuses them instead of rebuilding them
+struct vcGLTFCachedConstants
+{
+  udFloat4x4 modelMatrix;
+  udFloat4x4 normalMatrix;
+  int jointCount;
+  uint32_t paletteStart; // Into pCachedPalette; jointCount joint matrices followed by jointCount normal matrices
+};
+
+struct vcGLTFStreamingJob;
+
 struct vcGLTFScene
 {
   udWorkerPool *pWorkerPool;
+  vcGLTFLoadFlags loadFlags;
+
+  vcGLTFArena arena;
 
   char *pPath;
 
@@ -212,6 +529,12 @@ struct vcGLTFScene
   int bufferCount;
   vcGLTFBuffer *pBuffers;
 
+  int bufferViewCount;
+  vcGLTFBufferView *pBufferViews;
+
+  int accessorCount;
+  vcGLTFAccessor *pAccessors;
+
   int meshCount;
   vcGLTFMesh *pMeshes;
 
@@ -224,10 +547,71 @@ struct vcGLTFScene
   int skinCount;
   vcGLTFSkin *pSkins;
 
+  int packCount;
+  vcGLTFMeshPack *pPacks;
+
+  volatile int32_t pendingTasks; // Worker pool tasks still referencing this scene
+
+  // Top level BVH over meshInstances, refit after the instance bounds change
+  int instanceNodeCount;
+  int instanceMaxDepth;
+  vcGLTFBVHNode *pInstanceNodes;
+  int *pInstanceOrder;
+
+  // Scratch for draws deferred until after the instance loop (the sorted transparent pass and the shaded half of the
+  // depth pre-pass), grown as needed
+  uint32_t transparentCapacity;
+  vcGLTFTransparentItem *pTransparentItems;
+  uint32_t *pTransparentKeys; // 2x capacity, ping-ponged by the radix sort
+  uint32_t *pTransparentOrder; // 2x capacity
+
+  uint32_t cachedConstantCapacity;
+  vcGLTFCachedConstants *pCachedConstants;
+  uint32_t cachedPaletteCapacity;
+  udFloat4x4 *pCachedPalette;
+
+  vcGLTFLightGrid lightGrid;
+  vcGLTFClusterLighting clusters;
+  vcGLTFOcclusionBuffer occlusion;
+
+  vcGLTFLoadStats loadStats;
+  vcGLTFLoadPhase loadPhase; // vcGLTFLP_Count when nothing is being timed
+  uint64_t loadPhaseStart;
+  bool loading; // Phases are only timed by vcGLTF_Load; streamed meshes decode on the worker pool
+
+  vcGLTFRenderStats renderStats[vcGLTFRP_Count];
+
+  // vcGLTFLF_DeferMeshes
+  int *pMeshRequests; // Oldest first; each mesh is queued at most once
+  int meshRequestCount;
+  float streamingBudgetMs;
+  int evictFrames;
+  int streamingFrame; // frameIndex when the requests were last processed; -1 before the first render
+  vcGLTFStreamingJob *pStreamingJob; // Requests being decoded on the worker pool, one job at a time
+  int frameIndex; // Calls to vcGLTF_Update
+
+  // GPU mesh bytes created for this scene
+  int64_t vertexBytes;
+  int64_t indexBytes;
+
+  // Counted against the global memory budget until the scene is destroyed; the estimate while loading, then the measured usage
+  int64_t chargedHostBytes;
+  int64_t chargedGPUBytes;
+  bool reduceMemory; // Didn't fit the budget with the derived data (generated LODs and tangents, depth position streams)
+
   // Move these to a "scene instance" at some point...
   float currentTime;
   vcGLTFAnimation *pCurrentAnimation;
-  int64_t meshMask;
+  bool depthPrepass;
+
+  // Set bits are visible. visibleInstances combines the two (a hidden node hides its whole subtree) and is rebuilt before
+  // the next render or raycast after either changes
+  vcGLTFBitset meshVisibility;
+  vcGLTFBitset nodeVisibility;
+  vcGLTFBitset visibleNodes;
+  vcGLTFBitset visibleInstances;
+  size_t visibleInstanceCount;
+  bool visibilityDirty;
 };
 
 struct vcGLTFShader
@@ -242,7 +626,16 @@ struct vcGLTFShader
   vcShaderSampler *pNormalMapSampler;
   vcShaderSampler *pEmissiveMapSampler;
   vcShaderSampler *pOcclusionMapSampler;
-} g_shaderTypes[vcRSB_Count] = {};
+
+  // Clustered lighting variants only
+  vcShaderConstantBuffer *pClusterUniformBuffer;
+  vcShaderSampler *pClusterLightSampler;
+  vcShaderSampler *pClusterIndexSampler;
+  vcShaderSampler *pClusterGridSampler;
+};
+
+// Indexed by vertex and material feature bits, allocated when a variant is first requested
+vcGLTFShader *g_pShaderTypes[vcRSB_Count] = {};
 
 struct vcGLTFVertInputs
 {
@@ -300,10 +693,145 @@ struct vcGLTFVertFragSettings
 } s_gltfFragInfo = {};
 
 
-void vcGLTF_GenerateGlobalShaders()
+struct vcGLTFClusterSettings
 {
-  vcGLTF_DestroyGlobalShaders();
+  udFloat4x4 u_ClusterViewProjection;
+  udFloat4 u_ClusterDimensions; // Tiles x, tiles y, depth slices, lights per texture row
+  udFloat4 u_ClusterDepth; // Near w, slices / log(far w / near w), indices per texture row, unused
+} s_gltfClusterInfo = {};
+
+struct vcGLTFDepthShader
+{
+  vcShader *pShader;
+  vcShaderConstantBuffer *pVertUniformBuffer;
+  vcShaderConstantBuffer *pSkinningUniformBuffer;
+  vcShaderConstantBuffer *pFragUniformBuffer;
+
+  vcShaderSampler *pBaseColourSampler;
+
+  bool compileAttempted;
+};
+
+// Full vertex variants are indexed by vertex feature bits (+vcRSB_VertexCount when alpha tested) and are only used for skinned or alpha tested primitives
+vcGLTFDepthShader g_depthShaderTypes[vcRSB_VertexCount * 2] = {};
+vcGLTFDepthShader g_depthPositionShader = {};
+
+// Variants are compiled the first time a primitive needs them, so the sources are kept around until the shaders are destroyed
+struct vcGLTFShaderSources
+{
+  const char *pVertShader;
+  const char *pFragShader;
+  const char *pDepthVertShader;
+  const char *pDepthFragShader;
+} g_shaderSources = {};
+
+// Accumulated through the current vcGLTF_Render call, then stored in the scene for that pass
+vcGLTFRenderStats s_gltfRenderStats = {};
+
+// Shared by all scenes; scenes may load on different threads so changes are made under the spin lock
+struct vcGLTFMemoryBudget
+{
+  volatile int32_t lock;
+
+  int64_t hostBudget; // 0 is unlimited
+  int64_t gpuBudget;
+
+  int64_t hostCharged;
+  int64_t gpuCharged;
+} s_gltfMemoryBudget = {};
+
+const char *g_vcGLTFLoadPhaseNames[] = { "Parse", "Buffer I/O", "Materials", "Nodes", "Mesh decode", "Normal generation", "Tangent generation", "Mesh processing", "Upload", "Animations", "Skins", "Finalize" };
+UDCOMPILEASSERT(udLengthOf(g_vcGLTFLoadPhaseNames) == vcGLTFLP_Count, "Array out of date!");
+
+// Chrome trace events; each thread writes only its own ring so no locking is needed. vcGLTF_WriteTrace reads them all and
+// vcGLTF_ResetTracing / vcGLTF_ShutdownTracing clear and free them, all three only while no thread is tracing
+struct vcGLTFTraceEvent
+{
+  const char *pName; // Must be a string literal (or otherwise live for the rest of the process)
+  uint64_t start;
+  uint64_t end;
+  int arg; // -1 for none
+};
+
+struct vcGLTFTraceRing
+{
+  volatile uint32_t written; // Total ever written (wrapping); the ring keeps the last vcGLTFLimit_TraceEvents
+  vcGLTFTraceEvent events[vcGLTFLimit_TraceEvents];
+};
+UDCOMPILEASSERT((vcGLTFLimit_TraceEvents & (vcGLTFLimit_TraceEvents - 1)) == 0, "Trace rings are indexed with a mask");
+
+struct vcGLTFTrace
+{
+  volatile int32_t enabled;
+  uint64_t epoch;
 
+  volatile int32_t threadCount;
+  vcGLTFTraceRing *pRings[vcGLTFLimit_TraceThreads];
+} s_gltfTrace = {};
+
+thread_local int t_gltfTraceThread = -1; // Index into s_gltfTrace.pRings, -2 if there were no rings left
+
+uint64_t vcGLTF_TraceStart()
+{
+  return (s_gltfTrace.enabled != 0) ? udPerfCounterStart() : 0;
+}
+
+void vcGLTF_TraceEvent(const char *pName, uint64_t start, uint64_t end, int arg = -1)
+{
+  if (s_gltfTrace.enabled == 0 || start < s_gltfTrace.epoch)
+    return;
+
+  if (t_gltfTraceThread == -1)
+  {
+    t_gltfTraceThread = udInterlockedPostIncrement(&s_gltfTrace.threadCount);
+    if (t_gltfTraceThread >= vcGLTFLimit_TraceThreads)
+      t_gltfTraceThread = -2;
+  }
+
+  if (t_gltfTraceThread < 0)
+    return;
+
+  vcGLTFTraceRing *pRing = s_gltfTrace.pRings[t_gltfTraceThread];
+  if (pRing == nullptr)
+  {
+    pRing = udAllocType(vcGLTFTraceRing, 1, udAF_Zero);
+    if (pRing == nullptr)
+      return;
+
+    udInterlockedExchangePointer(&s_gltfTrace.pRings[t_gltfTraceThread], pRing);
+  }
+
+  uint32_t written = pRing->written;
+  vcGLTFTraceEvent *pEvent = &pRing->events[written & (vcGLTFLimit_TraceEvents - 1)];
+  pEvent->pName = pName;
+  pEvent->start = start;
+  pEvent->end = end;
+  pEvent->arg = arg;
+
+  pRing->written = written + 1;
+}
+
+// Records an event covering the rest of the enclosing block
+struct vcGLTFTraceScope
+{
+  const char *pName;
+  int arg;
+  uint64_t start;
+
+  vcGLTFTraceScope(const char *pEventName, int eventArg = -1) : pName(pEventName), arg(eventArg), start(vcGLTF_TraceStart()) {}
+  ~vcGLTFTraceScope() { if (start != 0) vcGLTF_TraceEvent(pName, start, udPerfCounterStart(), arg); }
+};
+
+struct vcGLTFDepthFragSettings
+{
+  udFloat4 u_BaseColorFactor;
+  float u_AlphaCutoff;
+  udFloat3 __padding;
+} s_gltfDepthFragInfo = {};
+
+// Fills the vertex layout and shader defines for a set of feature bits, returns the layout count
+int vcGLTF_GetShaderLayout(int features, vcVertexLayoutTypes *pLayout, const char **ppDefines, int *pDefineCount)
+{
   struct TypeStuff
   {
     const char *pDefine;
@@ -329,1305 +857,7945 @@ void vcGLTF_GenerateGlobalShaders()
   types[vcRSF_HasSkinning].layoutType0 = vcVLT_BoneIDs;
   types[vcRSF_HasSkinning].layoutType1 = vcVLT_BoneWeights;
 
-  const char* defines[vcRSF_Count] = {};
+  types[vcRSF_HasBaseColorMap].pDefine = "HAS_BASECOLOR_MAP";
+  types[vcRSF_HasMetallicRoughnessMap].pDefine = "HAS_METALLIC_ROUGHNESS_MAP";
+  types[vcRSF_HasNormalMap].pDefine = "HAS_NORMAL_MAP";
+  types[vcRSF_HasEmissiveMap].pDefine = "HAS_EMISSIVE_MAP";
+  types[vcRSF_HasOcclusionMap].pDefine = "HAS_OCCLUSION_MAP";
+  types[vcRSF_AlphaMask].pDefine = "ALPHAMODE_MASK";
+  types[vcRSF_AlphaBlend].pDefine = "ALPHAMODE_BLEND";
+  types[vcRSF_Unlit].pDefine = "MATERIAL_UNLIT";
+  types[vcRSF_ClusteredLighting].pDefine = "CLUSTERED_LIGHTING";
 
   const int RequiredVertTypes = 2;
-  vcVertexLayoutTypes vltList[RequiredVertTypes + (vcRSF_Count*2)] = {};
-  vltList[0] = vcVLT_Position3;
-  vltList[1] = vcVLT_Normal3;
+  pLayout[0] = vcVLT_Position3;
+  pLayout[1] = vcVLT_Normal3;
 
-  const char *pVertShaderSource = nullptr;
-  const char *pFragShaderSource = nullptr;
+  int extraDefines = 0;
+  int extraLayouts = 0;
+  for (int j = 0; j < vcRSF_Count; ++j)
+  {
+    if (features & (1 << j))
+    {
+      ppDefines[extraDefines] = types[j].pDefine;
+      ++extraDefines;
 
-  vcShader_LoadTextFromFile("asset://assets/shaders/gltfVertexShader", &pVertShaderSource, vcGLSamplerShaderStage_Vertex);
-  vcShader_LoadTextFromFile("asset://assets/shaders/gltfFragmentShader", &pFragShaderSource, vcGLSamplerShaderStage_Fragment);
+      if (j >= vcRSF_VertexCount)
+        continue;
 
-  for (int i = 0; i < vcRSB_Count; ++i)
-  {
-    if ((i & (vcRSB_UVSet0 | vcRSB_UVSet1)) == vcRSB_UVSet1)
-      continue;
+      pLayout[RequiredVertTypes + extraLayouts] = types[j].layoutType0;
+      ++extraLayouts;
 
-    int extraDefines = 0;
-    int extraLayouts = 0;
-    for (int j = 0; j < vcRSF_Count; ++j)
-    {
-      if (i & (1 << j))
+      if (types[j].layoutType1 != vcVLT_Unsupported)
       {
-        defines[extraDefines] = types[j].pDefine;
-        vltList[RequiredVertTypes + extraLayouts] = types[j].layoutType0;
-        
-        ++extraDefines;
+        pLayout[RequiredVertTypes + extraLayouts] = types[j].layoutType1;
         ++extraLayouts;
-
-        if (types[j].layoutType1 != vcVLT_Unsupported)
-        {
-          vltList[RequiredVertTypes + extraLayouts] = types[j].layoutType1;
-          ++extraLayouts;
-        }
       }
     }
+  }
 
-    vcLayout_Sort(&vltList[RequiredVertTypes], extraLayouts);
+  vcLayout_Sort(&pLayout[RequiredVertTypes], extraLayouts);
 
-    vcShader_CreateFromText(&g_shaderTypes[i].pShader, pVertShaderSource, pFragShaderSource, vltList, RequiredVertTypes + extraLayouts, "gltfVertexShader", "gltfFragmentShader", defines, extraDefines);
+  *pDefineCount = extraDefines;
+  return RequiredVertTypes + extraLayouts;
+}
 
-    vcShader_GetConstantBuffer(&g_shaderTypes[i].pVertUniformBuffer, g_shaderTypes[i].pShader, "u_EveryFrame", sizeof(s_gltfVertInfo));
-    vcShader_GetConstantBuffer(&g_shaderTypes[i].pSkinningUniformBuffer, g_shaderTypes[i].pShader, "u_SkinningInfo", sizeof(s_gltfVertSkinningInfo));
-    vcShader_GetConstantBuffer(&g_shaderTypes[i].pFragUniformBuffer, g_shaderTypes[i].pShader, "u_FragSettings", sizeof(s_gltfFragInfo));
+void vcGLTF_CreateDepthShader(vcGLTFDepthShader *pDepthShader, const vcVertexLayoutTypes *pLayout, int layoutCount, const char **ppDefines, int defineCount)
+{
+  pDepthShader->compileAttempted = true;
 
-    vcShader_GetSamplerIndex(&g_shaderTypes[i].pBaseColourSampler, g_shaderTypes[i].pShader, "u_BaseColorSampler");
-    vcShader_GetSamplerIndex(&g_shaderTypes[i].pMetallicRoughnessSampler, g_shaderTypes[i].pShader, "u_MetallicRoughnessSampler");
-    vcShader_GetSamplerIndex(&g_shaderTypes[i].pNormalMapSampler, g_shaderTypes[i].pShader, "u_NormalSampler");
-    vcShader_GetSamplerIndex(&g_shaderTypes[i].pEmissiveMapSampler, g_shaderTypes[i].pShader, "u_EmissiveSampler");
-    vcShader_GetSamplerIndex(&g_shaderTypes[i].pOcclusionMapSampler, g_shaderTypes[i].pShader, "u_OcclusionSampler");
-  }
+  if (!vcShader_CreateFromText(&pDepthShader->pShader, g_shaderSources.pDepthVertShader, g_shaderSources.pDepthFragShader, pLayout, layoutCount, "gltfDepthVertexShader", "gltfDepthFragmentShader", ppDefines, defineCount))
+    return;
+
+  vcShader_GetConstantBuffer(&pDepthShader->pVertUniformBuffer, pDepthShader->pShader, "u_EveryFrame", sizeof(s_gltfVertInfo));
+  vcShader_GetConstantBuffer(&pDepthShader->pSkinningUniformBuffer, pDepthShader->pShader, "u_SkinningInfo", sizeof(s_gltfVertSkinningInfo));
+  vcShader_GetConstantBuffer(&pDepthShader->pFragUniformBuffer, pDepthShader->pShader, "u_DepthSettings", sizeof(s_gltfDepthFragInfo));
 
-  udFree(pVertShaderSource);
-  udFree(pFragShaderSource);
+  vcShader_GetSamplerIndex(&pDepthShader->pBaseColourSampler, pDepthShader->pShader, "u_BaseColorSampler");
 }
 
-void vcGLTF_DestroyGlobalShaders()
+void vcGLTF_DestroyDepthShader(vcGLTFDepthShader *pDepthShader)
 {
-  for (int i = 0; i < vcRSB_Count; ++i)
-  {
-    vcShader_ReleaseConstantBuffer(g_shaderTypes[i].pShader, g_shaderTypes[i].pVertUniformBuffer);
-    vcShader_ReleaseConstantBuffer(g_shaderTypes[i].pShader, g_shaderTypes[i].pFragUniformBuffer);
+  vcShader_ReleaseConstantBuffer(pDepthShader->pShader, pDepthShader->pVertUniformBuffer);
+  vcShader_ReleaseConstantBuffer(pDepthShader->pShader, pDepthShader->pSkinningUniformBuffer);
+  vcShader_ReleaseConstantBuffer(pDepthShader->pShader, pDepthShader->pFragUniformBuffer);
 
-    vcShader_DestroyShader(&g_shaderTypes[i].pShader);
-  }
+  vcShader_DestroyShader(&pDepthShader->pShader);
+
+  *pDepthShader = {};
 }
 
-udResult vcGLTF_LoadBuffer(vcGLTFScene *pScene, const udJSON &root, int bufferID)
+// Returns the shader for a set of vertex and material feature bits, compiling it on first use; pShader is nullptr if it failed to compile
+const vcGLTFShader &vcGLTF_GetShader(int features)
 {
-  udResult result = udR_Failure_;
+  static const vcGLTFShader EmptyShader = {};
 
-  const char *pPath = root.Get("buffers[%d].uri", bufferID).AsString();
-  int64_t loadedSize = 0;
+  if (g_pShaderTypes[features] != nullptr)
+    return *g_pShaderTypes[features];
 
-  UD_ERROR_NULL(pPath, udR_ObjectNotFound);
+  if (g_shaderSources.pVertShader == nullptr || g_shaderSources.pFragShader == nullptr)
+    return EmptyShader;
 
-  if (udFile_Load(pPath, &pScene->pBuffers[bufferID].pBytes, &loadedSize) != udR_Success)
-    UD_ERROR_CHECK(udFile_Load(udTempStr("%s%s", pScene->pPath, pPath), &pScene->pBuffers[bufferID].pBytes, &loadedSize));
+  g_pShaderTypes[features] = udAllocType(vcGLTFShader, 1, udAF_Zero);
+  if (g_pShaderTypes[features] == nullptr)
+    return EmptyShader;
 
-  UD_ERROR_IF(root.Get("buffers[%d].byteLength", bufferID).AsInt() != loadedSize, udR_CorruptData);
+  vcGLTFShader &shader = *g_pShaderTypes[features];
 
-  pScene->pBuffers[bufferID].byteLength = loadedSize;
-  result = udR_Success;
+  const char* defines[vcRSF_Count + 1] = {};
+  vcVertexLayoutTypes vltList[2 + (vcRSF_Count*2)] = {};
 
-epilogue:
-  if (result != udR_Success)
-    udFree(pScene->pBuffers[bufferID].pBytes);
+  int defineCount = 0;
+  int layoutCount = vcGLTF_GetShaderLayout(features, vltList, defines, &defineCount);
 
-  return result;
+  if (!vcShader_CreateFromText(&shader.pShader, g_shaderSources.pVertShader, g_shaderSources.pFragShader, vltList, layoutCount, "gltfVertexShader", "gltfFragmentShader", defines, defineCount))
+    return shader;
+
+  vcShader_GetConstantBuffer(&shader.pVertUniformBuffer, shader.pShader, "u_EveryFrame", sizeof(s_gltfVertInfo));
+  vcShader_GetConstantBuffer(&shader.pSkinningUniformBuffer, shader.pShader, "u_SkinningInfo", sizeof(s_gltfVertSkinningInfo));
+  vcShader_GetConstantBuffer(&shader.pFragUniformBuffer, shader.pShader, "u_FragSettings", sizeof(s_gltfFragInfo));
+
+  vcShader_GetSamplerIndex(&shader.pBaseColourSampler, shader.pShader, "u_BaseColorSampler");
+  vcShader_GetSamplerIndex(&shader.pMetallicRoughnessSampler, shader.pShader, "u_MetallicRoughnessSampler");
+  vcShader_GetSamplerIndex(&shader.pNormalMapSampler, shader.pShader, "u_NormalSampler");
+  vcShader_GetSamplerIndex(&shader.pEmissiveMapSampler, shader.pShader, "u_EmissiveSampler");
+  vcShader_GetSamplerIndex(&shader.pOcclusionMapSampler, shader.pShader, "u_OcclusionSampler");
+
+  if (features & vcRSB_ClusteredLighting)
+  {
+    vcShader_GetConstantBuffer(&shader.pClusterUniformBuffer, shader.pShader, "u_ClusterSettings", sizeof(s_gltfClusterInfo));
+    vcShader_GetSamplerIndex(&shader.pClusterLightSampler, shader.pShader, "u_ClusterLightSampler");
+    vcShader_GetSamplerIndex(&shader.pClusterIndexSampler, shader.pShader, "u_ClusterIndexSampler");
+    vcShader_GetSamplerIndex(&shader.pClusterGridSampler, shader.pShader, "u_ClusterGridSampler");
+  }
+
+  return shader;
 }
 
-udResult vcGLTF_LoadTexture(vcGLTFScene *pScene, const udJSON &root, int textureID, vcTexture **ppTexture)
+// Depth shader for primitives without a position only stream, compiled on first use like vcGLTF_GetShader
+const vcGLTFDepthShader &vcGLTF_GetDepthShader(int features, bool alphaTest)
 {
-  size_t textureCount = root.Get("textures").ArrayLength();
+  features &= vcRSB_VertexMask;
+  vcGLTFDepthShader &shader = g_depthShaderTypes[features + (alphaTest ? vcRSB_VertexCount : 0)];
 
-  if (textureID >= 0 && textureID < textureCount)
-  {
-    const char *pURI = root.Get("images[%d].uri", root.Get("textures[%d].source", textureID).AsInt()).AsString();
-    int sampler = root.Get("textures[%d].sampler", textureID).AsInt();
+  if (shader.compileAttempted || g_shaderSources.pDepthVertShader == nullptr || g_shaderSources.pDepthFragShader == nullptr)
+    return shader;
 
-    vcTextureFilterMode filterMode;
-    int filter = root.Get("samplers[%d].magFilter", sampler).AsInt();
-    if (filter == vcGLTFType_Linear)
-      filterMode = vcTFM_Linear;
-    else
-      filterMode = vcTFM_Nearest;
+  const char* defines[vcRSF_Count + 1] = {};
+  vcVertexLayoutTypes vltList[2 + (vcRSF_Count*2)] = {};
 
-    vcTextureWrapMode wrapMode;
-    int wrapS = root.Get("samplers[%d].wrapS", sampler).AsInt(vcGLTFType_Nearest);
-    int wrapT = root.Get("samplers[%d].wrapT", sampler).AsInt(vcGLTFType_Nearest);
+  int defineCount = 0;
+  int layoutCount = vcGLTF_GetShaderLayout(features, vltList, defines, &defineCount);
 
-    if (wrapS == vcGLTFType_ClampEdge)
-      wrapMode = vcTWM_Clamp;
-    else if (wrapS == vcGLTFType_MirroredRepeat)
-      wrapMode = vcTWM_MirroredRepeat;
-    else
-      wrapMode = vcTWM_Repeat;
+  // The full vertex is bound but only the defines the depth shader uses matter
+  defineCount = 0;
+  if (features & vcRSB_Skinned)
+    defines[defineCount++] = "HAS_SKINNING";
+  if (alphaTest)
+    defines[defineCount++] = "ALPHA_TEST";
 
-    if (wrapS != wrapT)
-    {
-      if (wrapT == vcGLTFType_ClampEdge)
-        wrapMode = wrapMode | vcTWM_ClampT | vcTWM_UniqueST;
-      else if (wrapT == vcGLTFType_MirroredRepeat)
-        wrapMode = wrapMode | vcTWM_MirroredRepeatT | vcTWM_UniqueST;
-      else
-        wrapMode = wrapMode | vcTWM_RepeatT | vcTWM_UniqueST;
-    }
+  vcGLTF_CreateDepthShader(&shader, vltList, layoutCount, defines, defineCount);
 
-    if (udStrBeginsWith(pURI, "data:"))
-      vcTexture_CreateFromFilename(ppTexture, pURI, nullptr, nullptr, filterMode, false, wrapMode);
-    else if (pURI != nullptr)
-      *ppTexture = ttTextureCache_Get(udTempStr("%s/%s", pScene->pPath, pURI), filterMode, false, wrapMode);
+  return shader;
+}
+
+const vcGLTFDepthShader &vcGLTF_GetDepthPositionShader()
+{
+  if (!g_depthPositionShader.compileAttempted && g_shaderSources.pDepthVertShader != nullptr && g_shaderSources.pDepthFragShader != nullptr)
+  {
+    const vcVertexLayoutTypes positionOnly[] = { vcVLT_Position3 };
+    vcGLTF_CreateDepthShader(&g_depthPositionShader, positionOnly, (int)udLengthOf(positionOnly), nullptr, 0);
   }
 
-  return udR_Success;
+  return g_depthPositionShader;
 }
 
-udFloat3 GetNormal(int i0, int i1, int i2, uint8_t *pBufferStart, ptrdiff_t byteStride)
+void vcGLTF_GenerateGlobalShaders()
 {
-  float *pPF = nullptr;
+  vcGLTF_DestroyGlobalShaders();
 
-  pPF = (float*)(pBufferStart + (i0) * byteStride);
-  udFloat3 p0 = { pPF[0], pPF[1], pPF[2] };
+  // Only the sources are loaded here, variants are compiled as meshes that need them are created
+  vcShader_LoadTextFromFile("asset://assets/shaders/gltfVertexShader", &g_shaderSources.pVertShader, vcGLSamplerShaderStage_Vertex);
+  vcShader_LoadTextFromFile("asset://assets/shaders/gltfFragmentShader", &g_shaderSources.pFragShader, vcGLSamplerShaderStage_Fragment);
+  vcShader_LoadTextFromFile("asset://assets/shaders/gltfDepthVertexShader", &g_shaderSources.pDepthVertShader, vcGLSamplerShaderStage_Vertex);
+  vcShader_LoadTextFromFile("asset://assets/shaders/gltfDepthFragmentShader", &g_shaderSources.pDepthFragShader, vcGLSamplerShaderStage_Fragment);
+}
 
-  pPF = (float*)(pBufferStart + (i1) * byteStride);
-  udFloat3 p1 = { pPF[0], pPF[1], pPF[2] };
+void vcGLTF_DestroyGlobalShaders()
+{
+  for (int i = 0; i < vcRSB_Count; ++i)
+  {
+    if (g_pShaderTypes[i] == nullptr)
+      continue;
 
-  pPF = (float*)(pBufferStart + (i2) * byteStride);
-  udFloat3 p2 = { pPF[0], pPF[1], pPF[2] };
+    vcShader_ReleaseConstantBuffer(g_pShaderTypes[i]->pShader, g_pShaderTypes[i]->pVertUniformBuffer);
+    vcShader_ReleaseConstantBuffer(g_pShaderTypes[i]->pShader, g_pShaderTypes[i]->pSkinningUniformBuffer);
+    vcShader_ReleaseConstantBuffer(g_pShaderTypes[i]->pShader, g_pShaderTypes[i]->pFragUniformBuffer);
+    if (g_pShaderTypes[i]->pClusterUniformBuffer != nullptr)
+      vcShader_ReleaseConstantBuffer(g_pShaderTypes[i]->pShader, g_pShaderTypes[i]->pClusterUniformBuffer);
 
-  return udCross(p1 - p0, p2 - p0);
+    vcShader_DestroyShader(&g_pShaderTypes[i]->pShader);
+
+    udFree(g_pShaderTypes[i]);
+  }
+
+  for (int i = 0; i < vcRSB_VertexCount * 2; ++i)
+    vcGLTF_DestroyDepthShader(&g_depthShaderTypes[i]);
+
+  vcGLTF_DestroyDepthShader(&g_depthPositionShader);
+
+  udFree(g_shaderSources.pVertShader);
+  udFree(g_shaderSources.pFragShader);
+  udFree(g_shaderSources.pDepthVertShader);
+  udFree(g_shaderSources.pDepthFragShader);
 }
 
-udResult vcGLTF_ReadAccessor(vcGLTFScene *pScene, const udJSON &root, int attributeAccessorIndex, int *pTotalOffset, int readCount, uint8_t *pPtr, int stride, vcVertexLayoutTypes layoutType = vcVLT_TotalTypes)
+// Space an allocation of bytes takes in a block
+size_t vcGLTF_ArenaBytes(size_t bytes)
 {
-  udResult result = udR_Success;
+  const size_t Alignment = 16;
+  UDCOMPILEASSERT(sizeof(vcGLTFArenaBlock) % Alignment == 0, "Arena block header must keep the data aligned");
 
-  const udJSON& accessor = root.Get("accessors[%d]", attributeAccessorIndex);
+  return (bytes + Alignment - 1) & ~(Alignment - 1);
+}
 
-  int bufferViewID = accessor.Get("bufferView").AsInt(-1);
-  int bufferID = root.Get("bufferViews[%d].buffer", bufferViewID).AsInt();
-  if (bufferID <= -1)
-    __debugbreak();
+// Memory is zeroed; returns nullptr for 0 bytes
+void *vcGLTF_ArenaAlloc(vcGLTFArena *pArena, size_t bytes)
+{
+  if (bytes == 0)
+    return nullptr;
 
-  const char* pAccessorType = accessor.Get("type").AsString();
-  vcGLTFTypes accessorComponentType = (vcGLTFTypes)accessor.Get("componentType").AsInt();
-  ptrdiff_t byteOffset = accessor.Get("byteOffset").AsInt64() + root.Get("bufferViews[%d].byteOffset", accessor.Get("bufferView").AsInt(-1)).AsInt64();
-  ptrdiff_t byteStride = accessor.Get("byteStride").AsInt64() + root.Get("bufferViews[%d].byteStride", accessor.Get("bufferView").AsInt(-1)).AsInt64();
+  bytes = vcGLTF_ArenaBytes(bytes);
 
-  int count = 3;
-  int offset = *pTotalOffset;
+  vcGLTFArenaBlock *pBlock = pArena->pBlocks;
+  if (pBlock == nullptr || pBlock->used + bytes > pBlock->capacity)
+  {
+    size_t capacity = udMax(bytes, pArena->blockSize);
+
+    pBlock = (vcGLTFArenaBlock*)udAllocType(uint8_t, sizeof(vcGLTFArenaBlock) + capacity, udAF_Zero);
+    if (pBlock == nullptr)
+      return nullptr;
+
+    pBlock->pNext = pArena->pBlocks;
+    pBlock->capacity = capacity;
+    pArena->pBlocks = pBlock;
+    pArena->blockSize = vcGLTFLimit_ArenaBlockSize; // The estimate was used up; grow in smaller steps from here
+  }
+
+  void *pMemory = (uint8_t*)(pBlock + 1) + pBlock->used;
+  pBlock->used += bytes;
+
+  return pMemory;
+}
+
+const char *vcGLTF_ArenaStrdup(vcGLTFArena *pArena, const char *pString)
+{
+  if (pString == nullptr)
+    return nullptr;
+
+  size_t length = udStrlen(pString) + 1;
+  char *pCopy = vcGLTF_ArenaAllocType(pArena, char, length);
+  if (pCopy != nullptr)
+    memcpy(pCopy, pString, length);
+
+  return pCopy;
+}
+
+// Makes sure the next allocations, totalling bytes (see vcGLTF_ArenaBytes), fit without another estimate sized block. For
+// data whose size is only known once the accessors are read
+void vcGLTF_ArenaReserve(vcGLTFArena *pArena, size_t bytes)
+{
+  const vcGLTFArenaBlock *pBlock = pArena->pBlocks;
+  if (pBlock != nullptr && pBlock->used + bytes <= pBlock->capacity)
+    return;
+
+  pArena->blockSize = udMax(pArena->blockSize, bytes);
+}
+
+void vcGLTF_ArenaDestroy(vcGLTFArena *pArena)
+{
+  while (pArena->pBlocks != nullptr)
+  {
+    vcGLTFArenaBlock *pNext = pArena->pBlocks->pNext;
+    udFree(pArena->pBlocks);
+    pArena->pBlocks = pNext;
+  }
+}
+
+// Index of the lowest set bit; bits can't be 0
+int vcGLTF_LowestBit(uint64_t bits)
+{
+  static const uint8_t DeBruijnIndex[64] =
+  {
+    0, 1, 48, 2, 57, 49, 28, 3, 61, 58, 50, 42, 38, 29, 17, 4, 62, 55, 59, 36, 53, 51, 43, 22, 45, 39, 33, 30, 24, 18, 12, 5,
+    63, 47, 56, 27, 60, 41, 37, 16, 54, 35, 52, 21, 44, 32, 23, 11, 46, 26, 40, 15, 34, 20, 31, 10, 25, 14, 19, 9, 13, 8, 7, 6
+  };
+
+  return DeBruijnIndex[((bits & (0 - bits)) * 0x03F79D71B4CB0A89ull) >> 58];
+}
+
+void vcGLTF_BitsetUpdateSummary(vcGLTFBitset *pBitset)
+{
+  size_t wordCount = (pBitset->count + 63) / 64;
+
+  memset(pBitset->pSummary, 0, sizeof(uint64_t) * ((wordCount + 63) / 64));
+  for (size_t word = 0; word < wordCount; ++word)
+  {
+    if (pBitset->pWords[word] != 0)
+      pBitset->pSummary[word / 64] |= (uint64_t(1) << (word % 64));
+  }
+}
+
+void vcGLTF_BitsetSetAll(vcGLTFBitset *pBitset, bool value)
+{
+  size_t wordCount = (pBitset->count + 63) / 64;
+  if (wordCount == 0)
+    return;
+
+  memset(pBitset->pWords, value ? 0xFF : 0, sizeof(uint64_t) * wordCount);
+
+  // Bits past the end stay clear so vcGLTF_BitsetNext never finds them
+  if (pBitset->count % 64 != 0)
+    pBitset->pWords[wordCount - 1] &= (uint64_t(1) << (pBitset->count % 64)) - 1;
+
+  vcGLTF_BitsetUpdateSummary(pBitset);
+}
+
+udResult vcGLTF_BitsetInit(vcGLTFBitset *pBitset, size_t count, bool value)
+{
+  size_t wordCount = (count + 63) / 64;
+
+  pBitset->count = count;
+  if (count == 0)
+    return udR_Success;
+
+  // The summary shares the allocation
+  pBitset->pWords = udAllocType(uint64_t, wordCount + (wordCount + 63) / 64, udAF_None);
+  if (pBitset->pWords == nullptr)
+    return udR_MemoryAllocationFailure;
+
+  pBitset->pSummary = pBitset->pWords + wordCount;
+  vcGLTF_BitsetSetAll(pBitset, value);
+
+  return udR_Success;
+}
+
+void vcGLTF_BitsetDestroy(vcGLTFBitset *pBitset)
+{
+  udFree(pBitset->pWords);
+  pBitset->pSummary = nullptr;
+  pBitset->count = 0;
+}
+
+bool vcGLTF_BitsetGet(const vcGLTFBitset &bitset, size_t index)
+{
+  if (index >= bitset.count)
+    return false;
+
+  return (bitset.pWords[index / 64] & (uint64_t(1) << (index % 64))) != 0;
+}
+
+void vcGLTF_BitsetSet(vcGLTFBitset *pBitset, size_t index, bool value)
+{
+  if (index >= pBitset->count)
+    return;
+
+  uint64_t *pWord = &pBitset->pWords[index / 64];
+  if (value)
+    *pWord |= (uint64_t(1) << (index % 64));
+  else
+    *pWord &= ~(uint64_t(1) << (index % 64));
+
+  size_t word = index / 64;
+  if (*pWord != 0)
+    pBitset->pSummary[word / 64] |= (uint64_t(1) << (word % 64));
+  else
+    pBitset->pSummary[word / 64] &= ~(uint64_t(1) << (word % 64));
+}
+
+// First set bit at or after index, or count if there isn't one. Empty words are skipped 64 at a time using the summary
+size_t vcGLTF_BitsetNext(const vcGLTFBitset &bitset, size_t index)
+{
+  if (index >= bitset.count)
+    return bitset.count;
+
+  size_t wordCount = (bitset.count + 63) / 64;
+  size_t word = index / 64;
+  uint64_t bits = bitset.pWords[word] & (~uint64_t(0) << (index % 64));
+
+  while (bits == 0)
+  {
+    ++word;
+    if (word >= wordCount)
+      return bitset.count;
+
+    uint64_t summary = bitset.pSummary[word / 64] >> (word % 64);
+    if (summary == 0)
+    {
+      word = (word / 64) * 64 + 63; // Next summary word
+      continue;
+    }
+
+    word += vcGLTF_LowestBit(summary);
+    bits = bitset.pWords[word];
+  }
+
+  return word * 64 + vcGLTF_LowestBit(bits);
+}
+
+// Minimal forward only JSON reader the whole document is streamed through into typed arrays (see vcGLTF_ParseDocument).
+// Strings that are kept are decoded in place, so the text must stay writable and alive until loading finishes
+struct vcGLTFJSONReader
+{
+  char *pText;
+  bool failed;
+};
+
+void vcGLTF_JSONSkipWhitespace(vcGLTFJSONReader *pReader)
+{
+  while (*pReader->pText == ' ' || *pReader->pText == '\t' || *pReader->pText == '\n' || *pReader->pText == '\r')
+    ++pReader->pText;
+}
+
+bool vcGLTF_JSONExpect(vcGLTFJSONReader *pReader, char character)
+{
+  vcGLTF_JSONSkipWhitespace(pReader);
+
+  if (*pReader->pText != character)
+  {
+    pReader->failed = true;
+    return false;
+  }
+
+  ++pReader->pText;
+  return true;
+}
+
+// Copies the raw characters (escapes aren't decoded) into pString, truncating to stringSize, and moves past the string.
+// Used for member names and enumerated values, which are plain ASCII
+bool vcGLTF_JSONReadString(vcGLTFJSONReader *pReader, char *pString, size_t stringSize)
+{
+  if (!vcGLTF_JSONExpect(pReader, '"'))
+    return false;
+
+  size_t length = 0;
+  while (*pReader->pText != '"')
+  {
+    if (*pReader->pText == '\0')
+    {
+      pReader->failed = true;
+      return false;
+    }
+
+    if (*pReader->pText == '\\' && pReader->pText[1] != '\0')
+    {
+      if (length + 1 < stringSize)
+        pString[length++] = *pReader->pText;
+      ++pReader->pText;
+    }
+
+    if (length + 1 < stringSize)
+      pString[length++] = *pReader->pText;
+    ++pReader->pText;
+  }
+
+  ++pReader->pText;
+
+  if (stringSize > 0)
+    pString[length] = '\0';
+
+  return true;
+}
+
+// The 4 hex digits of a \u escape
+uint32_t vcGLTF_JSONReadHex4(vcGLTFJSONReader *pReader)
+{
+  uint32_t value = 0;
+
+  for (int i = 0; i < 4; ++i)
+  {
+    char character = *pReader->pText;
+    uint32_t digit = 0;
+
+    if (character >= '0' && character <= '9')
+      digit = character - '0';
+    else if (character >= 'a' && character <= 'f')
+      digit = character - 'a' + 10;
+    else if (character >= 'A' && character <= 'F')
+      digit = character - 'A' + 10;
+    else
+    {
+      pReader->failed = true;
+      return 0;
+    }
+
+    value = value * 16 + digit;
+    ++pReader->pText;
+  }
+
+  return value;
+}
+
+// Decodes the string's escapes in place (the result is never longer than the escaped text) and terminates it. Returns a
+// pointer into the text, or nullptr if the value isn't a string
+char *vcGLTF_JSONReadStringInPlace(vcGLTFJSONReader *pReader)
+{
+  if (!vcGLTF_JSONExpect(pReader, '"'))
+    return nullptr;
+
+  char *pString = pReader->pText;
+  char *pOut = pString;
+
+  while (*pReader->pText != '"')
+  {
+    char character = *pReader->pText;
+    if (character == '\0')
+    {
+      pReader->failed = true;
+      return nullptr;
+    }
+
+    ++pReader->pText;
+
+    if (character != '\\')
+    {
+      *pOut++ = character;
+      continue;
+    }
+
+    char escape = *pReader->pText;
+    if (escape == '\0')
+    {
+      pReader->failed = true;
+      return nullptr;
+    }
+
+    ++pReader->pText;
+
+    if (escape == 'u')
+    {
+      uint32_t codepoint = vcGLTF_JSONReadHex4(pReader);
+      if (pReader->failed)
+        return nullptr;
+
+      // Surrogate pairs are combined; unpaired surrogates are written as they are
+      if (codepoint >= 0xD800 && codepoint < 0xDC00 && pReader->pText[0] == '\\' && pReader->pText[1] == 'u')
+      {
+        vcGLTFJSONReader lowReader = { pReader->pText + 2, false };
+        uint32_t lowSurrogate = vcGLTF_JSONReadHex4(&lowReader);
+
+        if (!lowReader.failed && lowSurrogate >= 0xDC00 && lowSurrogate < 0xE000)
+        {
+          codepoint = 0x10000 + ((codepoint - 0xD800) << 10) + (lowSurrogate - 0xDC00);
+          pReader->pText = lowReader.pText;
+        }
+      }
+
+      if (codepoint < 0x80)
+      {
+        *pOut++ = (char)codepoint;
+      }
+      else if (codepoint < 0x800)
+      {
+        *pOut++ = (char)(0xC0 | (codepoint >> 6));
+        *pOut++ = (char)(0x80 | (codepoint & 0x3F));
+      }
+      else if (codepoint < 0x10000)
+      {
+        *pOut++ = (char)(0xE0 | (codepoint >> 12));
+        *pOut++ = (char)(0x80 | ((codepoint >> 6) & 0x3F));
+        *pOut++ = (char)(0x80 | (codepoint & 0x3F));
+      }
+      else
+      {
+        *pOut++ = (char)(0xF0 | (codepoint >> 18));
+        *pOut++ = (char)(0x80 | ((codepoint >> 12) & 0x3F));
+        *pOut++ = (char)(0x80 | ((codepoint >> 6) & 0x3F));
+        *pOut++ = (char)(0x80 | (codepoint & 0x3F));
+      }
+    }
+    else
+    {
+      switch (escape)
+      {
+      case 'b': *pOut++ = '\b'; break;
+      case 'f': *pOut++ = '\f'; break;
+      case 'n': *pOut++ = '\n'; break;
+      case 'r': *pOut++ = '\r'; break;
+      case 't': *pOut++ = '\t'; break;
+      default: *pOut++ = escape; break; // '"', '\\' & '/'
+      }
+    }
+  }
+
+  ++pReader->pText;
+  *pOut = '\0';
+
+  return pString;
+}
+
+// Doesn't depend on the C locale like strtod does (which stops at the '.' where ',' is the decimal separator). Integers
+// are exact up to 2^53 and everything else is within an ulp or two, which is well past what the floats it fills need
+double vcGLTF_JSONReadNumber(vcGLTFJSONReader *pReader)
+{
+  static const double PowersOfTen[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 }; // All exact
+  const int MaxPower = (int)udLengthOf(PowersOfTen) - 1;
+  const uint64_t MantissaLimit = 100000000000000000ULL; // Digits after the 17th significant one only move the exponent
+
+  vcGLTF_JSONSkipWhitespace(pReader);
+
+  char *pCharacter = pReader->pText;
+  bool negative = (*pCharacter == '-');
+  if (negative)
+    ++pCharacter;
+
+  if (*pCharacter < '0' || *pCharacter > '9')
+  {
+    pReader->failed = true;
+    return 0.0;
+  }
+
+  uint64_t mantissa = 0;
+  int exponent = 0;
+
+  for (; *pCharacter >= '0' && *pCharacter <= '9'; ++pCharacter)
+  {
+    if (mantissa < MantissaLimit)
+      mantissa = mantissa * 10 + (*pCharacter - '0');
+    else
+      ++exponent;
+  }
+
+  if (*pCharacter == '.')
+  {
+    for (++pCharacter; *pCharacter >= '0' && *pCharacter <= '9'; ++pCharacter)
+    {
+      if (mantissa < MantissaLimit)
+      {
+        mantissa = mantissa * 10 + (*pCharacter - '0');
+        --exponent;
+      }
+    }
+  }
+
+  if (*pCharacter == 'e' || *pCharacter == 'E')
+  {
+    ++pCharacter;
+
+    bool negativeExponent = (*pCharacter == '-');
+    if (*pCharacter == '-' || *pCharacter == '+')
+      ++pCharacter;
+
+    int exponentValue = 0;
+    for (; *pCharacter >= '0' && *pCharacter <= '9'; ++pCharacter)
+    {
+      if (exponentValue < 10000) // Well past where doubles become 0 or infinite
+        exponentValue = exponentValue * 10 + (*pCharacter - '0');
+    }
+
+    exponent += negativeExponent ? -exponentValue : exponentValue;
+  }
+
+  double value = (double)mantissa;
+
+  for (; exponent > MaxPower; exponent -= MaxPower)
+    value *= PowersOfTen[MaxPower];
+  for (; exponent < -MaxPower; exponent += MaxPower)
+    value /= PowersOfTen[MaxPower];
+
+  if (exponent >= 0)
+    value *= PowersOfTen[exponent];
+  else
+    value /= PowersOfTen[-exponent];
+
+  pReader->pText = pCharacter;
+
+  return negative ? -value : value;
+}
+
+// Skips any value, including nested objects and arrays
+bool vcGLTF_JSONSkipValue(vcGLTFJSONReader *pReader)
+{
+  int depth = 0;
+
+  do
+  {
+    vcGLTF_JSONSkipWhitespace(pReader);
+
+    char character = *pReader->pText;
+    if (character == '"')
+    {
+      char unused;
+      if (!vcGLTF_JSONReadString(pReader, &unused, 0))
+        return false;
+    }
+    else if (character == '{' || character == '[')
+    {
+      ++depth;
+      ++pReader->pText;
+    }
+    else if (character == '}' || character == ']')
+    {
+      --depth;
+      ++pReader->pText;
+    }
+    else if (character == ',' || character == ':')
+    {
+      ++pReader->pText;
+    }
+    else if (character == '\0')
+    {
+      pReader->failed = true;
+      return false;
+    }
+    else
+    {
+      // Numbers, true, false & null
+      while (*pReader->pText != '\0' && strchr(",:]} \t\r\n", *pReader->pText) == nullptr)
+        ++pReader->pText;
+    }
+  } while (depth > 0);
+
+  return true;
+}
+
+// true; anything else reads as false
+bool vcGLTF_JSONReadBool(vcGLTFJSONReader *pReader)
+{
+  vcGLTF_JSONSkipWhitespace(pReader);
+
+  bool value = udStrBeginsWith(pReader->pText, "true");
+  vcGLTF_JSONSkipValue(pReader);
+
+  return value;
+}
+
+// Moves to the next member of the object being read and reads its name; false once the object is closed
+bool vcGLTF_JSONNextMember(vcGLTFJSONReader *pReader, char *pName, size_t nameSize)
+{
+  vcGLTF_JSONSkipWhitespace(pReader);
+
+  if (*pReader->pText == ',')
+  {
+    ++pReader->pText;
+    vcGLTF_JSONSkipWhitespace(pReader);
+  }
+
+  if (*pReader->pText == '}')
+  {
+    ++pReader->pText;
+    return false;
+  }
+
+  return vcGLTF_JSONReadString(pReader, pName, nameSize) && vcGLTF_JSONExpect(pReader, ':');
+}
+
+// Moves to the next element of the array being read; false once the array is closed
+bool vcGLTF_JSONNextElement(vcGLTFJSONReader *pReader)
+{
+  vcGLTF_JSONSkipWhitespace(pReader);
+
+  if (*pReader->pText == ',')
+  {
+    ++pReader->pText;
+    vcGLTF_JSONSkipWhitespace(pReader);
+  }
+
+  if (*pReader->pText == ']')
+  {
+    ++pReader->pText;
+    return false;
+  }
+
+  if (*pReader->pText == '\0')
+  {
+    pReader->failed = true;
+    return false;
+  }
+
+  return true;
+}
+
+// Elements in the array starting at the reader, without moving it; -1 if the array is malformed
+int vcGLTF_JSONCountElements(const vcGLTFJSONReader &reader)
+{
+  vcGLTFJSONReader counter = reader;
+  int count = 0;
+
+  if (!vcGLTF_JSONExpect(&counter, '['))
+    return -1;
+
+  while (vcGLTF_JSONNextElement(&counter) && vcGLTF_JSONSkipValue(&counter))
+    ++count;
+
+  return counter.failed ? -1 : count;
+}
+
+// Members in the object starting at the reader, without moving it; -1 if the object is malformed
+int vcGLTF_JSONCountMembers(const vcGLTFJSONReader &reader)
+{
+  vcGLTFJSONReader counter = reader;
+  int count = 0;
+  char unused;
+
+  if (!vcGLTF_JSONExpect(&counter, '{'))
+    return -1;
+
+  while (vcGLTF_JSONNextMember(&counter, &unused, 0) && vcGLTF_JSONSkipValue(&counter))
+    ++count;
+
+  return counter.failed ? -1 : count;
+}
+
+// Reads up to count numbers of an array into pValues, leaving the rest as they were; returns how many were read
+int vcGLTF_JSONReadFloats(vcGLTFJSONReader *pReader, float *pValues, int count)
+{
+  int read = 0;
+
+  if (!vcGLTF_JSONExpect(pReader, '['))
+    return 0;
+
+  while (vcGLTF_JSONNextElement(pReader) && !pReader->failed)
+  {
+    if (read < count)
+      pValues[read++] = (float)vcGLTF_JSONReadNumber(pReader);
+    else
+      vcGLTF_JSONSkipValue(pReader);
+  }
+
+  return read;
+}
+
+// As vcGLTF_JSONReadFloats, for indices
+int vcGLTF_JSONReadInts(vcGLTFJSONReader *pReader, int *pValues, int count)
+{
+  int read = 0;
+
+  if (!vcGLTF_JSONExpect(pReader, '['))
+    return 0;
+
+  while (vcGLTF_JSONNextElement(pReader) && !pReader->failed)
+  {
+    if (read < count)
+      pValues[read++] = (int)vcGLTF_JSONReadNumber(pReader);
+    else
+      vcGLTF_JSONSkipValue(pReader);
+  }
+
+  return read;
+}
+
+// What vcGLTF_ParseDocument allocates from the arena, from a counting pass over the text so the arena is sized first
+struct vcGLTFDocumentCounts
+{
+  int accessors;
+  int bufferViews;
+  int buffers;
+  int materials;
+  int meshes;
+  int primitives;
+  int attributes;
+  int nodes;
+  int children;
+  int skins;
+  int joints;
+  int animations;
+  int animationSamplers;
+  int channels;
+
+  int strings;
+  size_t stringBytes; // Including the terminators
+};
+
+// Adds the size of the array (or object when isObject is set) at pPath if it's one the parse allocates for
+void vcGLTF_AddDocumentCount(vcGLTFDocumentCounts *pCounts, const char *pPath, bool isObject, int count)
+{
+  struct
+  {
+    const char *pPath;
+    bool isObject;
+    int *pCount;
+  } counted[] =
+  {
+    { "accessors", false, &pCounts->accessors },
+    { "bufferViews", false, &pCounts->bufferViews },
+    { "buffers", false, &pCounts->buffers },
+    { "materials", false, &pCounts->materials },
+    { "meshes", false, &pCounts->meshes },
+    { "meshes/primitives", false, &pCounts->primitives },
+    { "meshes/primitives/attributes", true, &pCounts->attributes },
+    { "nodes", false, &pCounts->nodes },
+    { "nodes/children", false, &pCounts->children },
+    { "skins", false, &pCounts->skins },
+    { "skins/joints", false, &pCounts->joints },
+    { "animations", false, &pCounts->animations },
+    { "animations/samplers", false, &pCounts->animationSamplers },
+    { "animations/channels", false, &pCounts->channels },
+  };
+
+  for (size_t i = 0; i < udLengthOf(counted); ++i)
+  {
+    if (counted[i].isObject == isObject && udStrEqual(counted[i].pPath, pPath))
+    {
+      *counted[i].pCount += count;
+      return;
+    }
+  }
+}
+
+// Walks the value at the reader; pPath holds the member names on the way down ("meshes/primitives"), array elements don't
+// add to it. Values nested too deeply for the path are skipped as the parse never allocates for them
+void vcGLTF_CountValue(vcGLTFJSONReader *pReader, char *pPath, size_t pathLength, int depth, vcGLTFDocumentCounts *pCounts)
+{
+  const char *arenaStrings[] = { "buffers/uri", "materials/name", "meshes/name", "skins/name" };
+
+  vcGLTF_JSONSkipWhitespace(pReader);
+  char character = *pReader->pText;
+
+  if (character == '"')
+  {
+    const char *pStart = pReader->pText;
+    vcGLTF_JSONSkipValue(pReader);
+
+    for (size_t i = 0; i < udLengthOf(arenaStrings); ++i)
+    {
+      if (udStrEqual(arenaStrings[i], pPath))
+      {
+        // The quotes make room for the terminator
+        pCounts->stringBytes += pReader->pText - pStart - 1;
+        ++pCounts->strings;
+        break;
+      }
+    }
+
+    return;
+  }
+
+  if ((character != '[' && character != '{') || depth >= vcGLTFLimit_JSONCountDepth)
+  {
+    vcGLTF_JSONSkipValue(pReader);
+    return;
+  }
+
+  ++pReader->pText;
+  int count = 0;
+
+  if (character == '[')
+  {
+    while (vcGLTF_JSONNextElement(pReader) && !pReader->failed)
+    {
+      vcGLTF_CountValue(pReader, pPath, pathLength, depth + 1, pCounts);
+      ++count;
+    }
+  }
+  else
+  {
+    char name[32];
+    while (vcGLTF_JSONNextMember(pReader, name, sizeof(name)) && !pReader->failed)
+    {
+      size_t nameLength = udStrlen(name);
+      size_t separator = (pathLength > 0) ? 1 : 0;
+
+      if (pathLength + separator + nameLength < vcGLTFLimit_JSONPathLength)
+      {
+        if (separator > 0)
+          pPath[pathLength] = '/';
+        memcpy(pPath + pathLength + separator, name, nameLength + 1);
+
+        vcGLTF_CountValue(pReader, pPath, pathLength + separator + nameLength, depth + 1, pCounts);
+        pPath[pathLength] = '\0';
+      }
+      else
+      {
+        vcGLTF_JSONSkipValue(pReader);
+      }
+
+      ++count;
+    }
+  }
+
+  vcGLTF_AddDocumentCount(pCounts, pPath, character == '{', count);
+}
+
+udResult vcGLTF_CountDocument(char *pText, vcGLTFDocumentCounts *pCounts)
+{
+  vcGLTFJSONReader reader = { pText, false };
+  char path[vcGLTFLimit_JSONPathLength] = {};
+
+  memset(pCounts, 0, sizeof(vcGLTFDocumentCounts));
+
+  vcGLTF_JSONSkipWhitespace(&reader);
+  if (*reader.pText != '{')
+    return udR_ParseError;
+
+  vcGLTF_CountValue(&reader, path, 0, 0, pCounts);
+
+  return reader.failed ? udR_ParseError : udR_Success;
+}
+
+// Everything vcGLTF_ParseDocument and loading allocate from the arena except the animation keys, which are reserved once
+// the accessors are known (see vcGLTF_LoadAnimations)
+size_t vcGLTF_EstimateArenaSize(const vcGLTFDocumentCounts &counts, size_t pathBytes)
+{
+  const size_t Padding = vcGLTF_ArenaBytes(1); // More than rounding adds to any one allocation
+  size_t bytes = vcGLTF_ArenaBytes(pathBytes);
+
+  // Scene wide arrays
+  bytes += vcGLTF_ArenaBytes(counts.accessors * sizeof(vcGLTFAccessor)) + vcGLTF_ArenaBytes(counts.bufferViews * sizeof(vcGLTFBufferView));
+  bytes += vcGLTF_ArenaBytes(counts.buffers * sizeof(vcGLTFBuffer));
+  bytes += vcGLTF_ArenaBytes(udMax(counts.materials, 1) * sizeof(vcGLTFMaterial));
+  bytes += vcGLTF_ArenaBytes(counts.meshes * sizeof(vcGLTFMesh));
+  bytes += vcGLTF_ArenaBytes(counts.nodes * sizeof(vcGLTFNode));
+  bytes += vcGLTF_ArenaBytes(counts.skins * sizeof(vcGLTFSkin));
+  bytes += vcGLTF_ArenaBytes(counts.animations * sizeof(vcGLTFAnimation));
+
+  // Arrays per mesh (descriptions and primitives), primitive, node, skin (joints and inverse binds) and animation
+  bytes += counts.primitives * (sizeof(vcGLTFPrimitiveDesc) + sizeof(vcGLTFMeshPrimitive)) + counts.meshes * 2 * Padding;
+  bytes += counts.attributes * sizeof(vcGLTFAttributeDesc) + counts.primitives * Padding;
+  bytes += counts.children * sizeof(vcGLTFNode*) + counts.nodes * Padding;
+  bytes += counts.joints * (sizeof(int) + sizeof(udFloat4x4)) + counts.skins * 2 * Padding;
+  bytes += counts.animationSamplers * sizeof(vcGLTFAnimationSampler) + counts.channels * sizeof(vcGLTFAnimationChannel) + counts.animations * 2 * Padding;
+  bytes += counts.stringBytes + counts.strings * Padding;
+
+  return bytes + bytes / 8; // Joint bounds, which depend on the vertices
+}
+
+struct vcGLTFSceneDesc
+{
+  int nodeCount;
+  int *pNodes;
+};
+
+struct vcGLTFTextureDesc
+{
+  int source; // Image, -1 if not set
+  int sampler; // -1 if not set
+};
+
+struct vcGLTFSamplerDesc
+{
+  int magFilter; // 0 if not set
+  int wrapS;
+  int wrapT;
+};
+
+// Texture indices of a material, -1 where not set; the rest of the material is read straight into vcGLTFMaterial
+struct vcGLTFMaterialDesc
+{
+  int baseColorTexture;
+  int metallicRoughnessTexture;
+  int normalTexture;
+  int emissiveTexture;
+  int occlusionTexture;
+};
+
+struct vcGLTFNodeDesc
+{
+  int mesh; // -1 if not set
+  int skin; // 0 if not set
+  bool hasCamera; // Or a light
+  bool hasOtherMembers; // Any not used by "animation hierarchy" nodes
+
+  int lodCount;
+  int lodNodes[vcGLTFLimit_LODCount - 1]; // MSFT_lod ids
+  int coverageCount;
+  float coverage[vcGLTFLimit_LODCount + 1]; // MSFT_screencoverage
+};
+
+struct vcGLTFAnimationDesc
+{
+  int *pSamplerInputs; // Accessor per sampler; pSamplerOutputs shares the allocation
+  int *pSamplerOutputs;
+  int *pChannelSamplers;
+};
+
+// The parts of the JSON that are only needed while loading; everything else is parsed straight into the scene
+struct vcGLTFDocument
+{
+  int scene;
+  int sceneCount;
+  vcGLTFSceneDesc *pScenes;
+
+  int imageCount;
+  const char **ppImageURIs; // Into the JSON text; nullptr for images stored in buffer views
+  int textureCount;
+  vcGLTFTextureDesc *pTextures;
+  int samplerCount;
+  vcGLTFSamplerDesc *pSamplers;
+
+  vcGLTFMaterialDesc *pMaterials; // vcGLTFScene::materialCount of each
+  vcGLTFNodeDesc *pNodes; // vcGLTFScene::nodeCount
+  int *pSkinInverseBinds; // Accessor per skin, -1 for identity
+
+  int animationCount;
+  vcGLTFAnimationDesc *pAnimations;
+};
+
+void vcGLTF_DestroyDocument(vcGLTFDocument *pDocument)
+{
+  for (int i = 0; i < pDocument->sceneCount && pDocument->pScenes != nullptr; ++i)
+    udFree(pDocument->pScenes[i].pNodes);
+
+  for (int i = 0; i < pDocument->animationCount && pDocument->pAnimations != nullptr; ++i)
+  {
+    udFree(pDocument->pAnimations[i].pSamplerInputs);
+    udFree(pDocument->pAnimations[i].pChannelSamplers);
+  }
+
+  udFree(pDocument->pScenes);
+  udFree(pDocument->ppImageURIs);
+  udFree(pDocument->pTextures);
+  udFree(pDocument->pSamplers);
+  udFree(pDocument->pMaterials);
+  udFree(pDocument->pNodes);
+  udFree(pDocument->pSkinInverseBinds);
+  udFree(pDocument->pAnimations);
+
+  memset(pDocument, 0, sizeof(vcGLTFDocument));
+}
+
+bool vcGLTF_ParseAccessorArray(vcGLTFScene *pScene, vcGLTFJSONReader *pReader)
+{
+  int count = vcGLTF_JSONCountElements(*pReader);
+  if (count < 0)
+    return false;
+
+  pScene->accessorCount = count;
+  pScene->pAccessors = vcGLTF_ArenaAllocType(&pScene->arena, vcGLTFAccessor, count);
+  if (count > 0 && pScene->pAccessors == nullptr)
+    return false;
+
+  vcGLTF_JSONExpect(pReader, '[');
+
+  char name[32];
+  for (int i = 0; i < count && vcGLTF_JSONNextElement(pReader) && vcGLTF_JSONExpect(pReader, '{'); ++i)
+  {
+    vcGLTFAccessor *pAccessor = &pScene->pAccessors[i];
+    bool hasMin = false;
+    bool hasMax = false;
+
+    pAccessor->bufferView = -1;
+
+    while (vcGLTF_JSONNextMember(pReader, name, sizeof(name)))
+    {
+      if (udStrEqual(name, "bufferView"))
+        pAccessor->bufferView = (int)vcGLTF_JSONReadNumber(pReader);
+      else if (udStrEqual(name, "byteOffset"))
+        pAccessor->byteOffset = (int64_t)vcGLTF_JSONReadNumber(pReader);
+      else if (udStrEqual(name, "byteStride"))
+        pAccessor->byteStride = (int64_t)vcGLTF_JSONReadNumber(pReader);
+      else if (udStrEqual(name, "componentType"))
+        pAccessor->componentType = (int)vcGLTF_JSONReadNumber(pReader);
+      else if (udStrEqual(name, "count"))
+        pAccessor->count = (int64_t)vcGLTF_JSONReadNumber(pReader);
+      else if (udStrEqual(name, "type"))
+        vcGLTF_JSONReadString(pReader, pAccessor->type, sizeof(pAccessor->type));
+      else if (udStrEqual(name, "min"))
+        hasMin = (vcGLTF_JSONReadFloats(pReader, &pAccessor->min.x, 3) > 0);
+      else if (udStrEqual(name, "max"))
+        hasMax = (vcGLTF_JSONReadFloats(pReader, &pAccessor->max.x, 3) > 0);
+      else
+        vcGLTF_JSONSkipValue(pReader);
+
+      if (pReader->failed)
+        return false;
+    }
+
+    pAccessor->hasBounds = (hasMin && hasMax);
+  }
+
+  // Closes the array
+  return !vcGLTF_JSONNextElement(pReader) && !pReader->failed;
+}
+
+bool vcGLTF_ParseBufferViewArray(vcGLTFScene *pScene, vcGLTFJSONReader *pReader)
+{
+  int count = vcGLTF_JSONCountElements(*pReader);
+  if (count < 0)
+    return false;
+
+  pScene->bufferViewCount = count;
+  pScene->pBufferViews = vcGLTF_ArenaAllocType(&pScene->arena, vcGLTFBufferView, count);
+  if (count > 0 && pScene->pBufferViews == nullptr)
+    return false;
+
+  vcGLTF_JSONExpect(pReader, '[');
+
+  char name[32];
+  for (int i = 0; i < count && vcGLTF_JSONNextElement(pReader) && vcGLTF_JSONExpect(pReader, '{'); ++i)
+  {
+    vcGLTFBufferView *pBufferView = &pScene->pBufferViews[i];
+
+    while (vcGLTF_JSONNextMember(pReader, name, sizeof(name)))
+    {
+      if (udStrEqual(name, "buffer"))
+        pBufferView->buffer = (int)vcGLTF_JSONReadNumber(pReader);
+      else if (udStrEqual(name, "byteOffset"))
+        pBufferView->byteOffset = (int64_t)vcGLTF_JSONReadNumber(pReader);
+      else if (udStrEqual(name, "byteLength"))
+        pBufferView->byteLength = (int64_t)vcGLTF_JSONReadNumber(pReader);
+      else if (udStrEqual(name, "byteStride"))
+        pBufferView->byteStride = (int64_t)vcGLTF_JSONReadNumber(pReader);
+      else
+        vcGLTF_JSONSkipValue(pReader);
+
+      if (pReader->failed)
+        return false;
+    }
+  }
+
+  return !vcGLTF_JSONNextElement(pReader) && !pReader->failed;
+}
+
+bool vcGLTF_ParseBufferArray(vcGLTFScene *pScene, vcGLTFJSONReader *pReader)
+{
+  int count = vcGLTF_JSONCountElements(*pReader);
+  if (count < 0)
+    return false;
+
+  pScene->bufferCount = count;
+  pScene->pBuffers = vcGLTF_ArenaAllocType(&pScene->arena, vcGLTFBuffer, count);
+  if (count > 0 && pScene->pBuffers == nullptr)
+    return false;
+
+  vcGLTF_JSONExpect(pReader, '[');
+
+  char name[32];
+  for (int i = 0; i < count && vcGLTF_JSONNextElement(pReader) && vcGLTF_JSONExpect(pReader, '{'); ++i)
+  {
+    vcGLTFBuffer *pBuffer = &pScene->pBuffers[i];
+
+    while (vcGLTF_JSONNextMember(pReader, name, sizeof(name)))
+    {
+      if (udStrEqual(name, "uri"))
+        pBuffer->pURI = vcGLTF_ArenaStrdup(&pScene->arena, vcGLTF_JSONReadStringInPlace(pReader));
+      else if (udStrEqual(name, "byteLength"))
+        pBuffer->byteLength = (int64_t)vcGLTF_JSONReadNumber(pReader);
+      else
+        vcGLTF_JSONSkipValue(pReader);
+
+      if (pReader->failed)
+        return false;
+    }
+  }
+
+  return !vcGLTF_JSONNextElement(pReader) && !pReader->failed;
+}
+
+bool vcGLTF_ParseImageArray(vcGLTFDocument *pDocument, vcGLTFJSONReader *pReader)
+{
+  int count = vcGLTF_JSONCountElements(*pReader);
+  if (count < 0)
+    return false;
+
+  pDocument->imageCount = count;
+  pDocument->ppImageURIs = udAllocType(const char*, count, udAF_Zero);
+  if (count > 0 && pDocument->ppImageURIs == nullptr)
+    return false;
+
+  vcGLTF_JSONExpect(pReader, '[');
+
+  char name[32];
+  for (int i = 0; i < count && vcGLTF_JSONNextElement(pReader) && vcGLTF_JSONExpect(pReader, '{'); ++i)
+  {
+    while (vcGLTF_JSONNextMember(pReader, name, sizeof(name)))
+    {
+      if (udStrEqual(name, "uri"))
+        pDocument->ppImageURIs[i] = vcGLTF_JSONReadStringInPlace(pReader);
+      else
+        vcGLTF_JSONSkipValue(pReader);
+
+      if (pReader->failed)
+        return false;
+    }
+  }
+
+  return !vcGLTF_JSONNextElement(pReader) && !pReader->failed;
+}
+
+bool vcGLTF_ParseTextureArray(vcGLTFDocument *pDocument, vcGLTFJSONReader *pReader)
+{
+  int count = vcGLTF_JSONCountElements(*pReader);
+  if (count < 0)
+    return false;
+
+  pDocument->textureCount = count;
+  pDocument->pTextures = udAllocType(vcGLTFTextureDesc, count, udAF_Zero);
+  if (count > 0 && pDocument->pTextures == nullptr)
+    return false;
+
+  vcGLTF_JSONExpect(pReader, '[');
+
+  char name[32];
+  for (int i = 0; i < count && vcGLTF_JSONNextElement(pReader) && vcGLTF_JSONExpect(pReader, '{'); ++i)
+  {
+    vcGLTFTextureDesc *pTexture = &pDocument->pTextures[i];
+
+    pTexture->source = -1;
+    pTexture->sampler = -1;
+
+    while (vcGLTF_JSONNextMember(pReader, name, sizeof(name)))
+    {
+      if (udStrEqual(name, "source"))
+        pTexture->source = (int)vcGLTF_JSONReadNumber(pReader);
+      else if (udStrEqual(name, "sampler"))
+        pTexture->sampler = (int)vcGLTF_JSONReadNumber(pReader);
+      else
+        vcGLTF_JSONSkipValue(pReader);
+
+      if (pReader->failed)
+        return false;
+    }
+  }
+
+  return !vcGLTF_JSONNextElement(pReader) && !pReader->failed;
+}
+
+bool vcGLTF_ParseSamplerArray(vcGLTFDocument *pDocument, vcGLTFJSONReader *pReader)
+{
+  int count = vcGLTF_JSONCountElements(*pReader);
+  if (count < 0)
+    return false;
+
+  pDocument->samplerCount = count;
+  pDocument->pSamplers = udAllocType(vcGLTFSamplerDesc, count, udAF_Zero);
+  if (count > 0 && pDocument->pSamplers == nullptr)
+    return false;
+
+  vcGLTF_JSONExpect(pReader, '[');
+
+  char name[32];
+  for (int i = 0; i < count && vcGLTF_JSONNextElement(pReader) && vcGLTF_JSONExpect(pReader, '{'); ++i)
+  {
+    vcGLTFSamplerDesc *pSampler = &pDocument->pSamplers[i];
+
+    pSampler->wrapS = vcGLTFType_Repeat;
+    pSampler->wrapT = vcGLTFType_Repeat;
+
+    while (vcGLTF_JSONNextMember(pReader, name, sizeof(name)))
+    {
+      if (udStrEqual(name, "magFilter"))
+        pSampler->magFilter = (int)vcGLTF_JSONReadNumber(pReader);
+      else if (udStrEqual(name, "wrapS"))
+        pSampler->wrapS = (int)vcGLTF_JSONReadNumber(pReader);
+      else if (udStrEqual(name, "wrapT"))
+        pSampler->wrapT = (int)vcGLTF_JSONReadNumber(pReader);
+      else
+        vcGLTF_JSONSkipValue(pReader);
+
+      if (pReader->failed)
+        return false;
+    }
+  }
+
+  return !vcGLTF_JSONNextElement(pReader) && !pReader->failed;
+}
+
+// Spec defaults; also used as is when the file has no materials
+void vcGLTF_DefaultMaterial(vcGLTFMaterial *pMaterial)
+{
+  memset(pMaterial, 0, sizeof(vcGLTFMaterial));
+
+  pMaterial->baseColorFactor = udFloat4::one();
+  pMaterial->metallicFactor = 1.f;
+  pMaterial->roughnessFactor = 1.f;
+  pMaterial->normalScale = 1.f;
+  pMaterial->alphaMode = vcGLTFAM_Opaque;
+  pMaterial->alphaCutoff = -1.f;
+}
+
+// { "index", "texCoord" } and, for normal textures, "scale"
+bool vcGLTF_ParseTextureInfo(vcGLTFJSONReader *pReader, int *pTextureID, int *pUVSet, float *pScale)
+{
+  char name[32];
+
+  if (!vcGLTF_JSONExpect(pReader, '{'))
+    return false;
+
+  while (vcGLTF_JSONNextMember(pReader, name, sizeof(name)))
+  {
+    if (udStrEqual(name, "index"))
+      *pTextureID = (int)vcGLTF_JSONReadNumber(pReader);
+    else if (udStrEqual(name, "texCoord"))
+      *pUVSet = (int)vcGLTF_JSONReadNumber(pReader);
+    else if (udStrEqual(name, "scale") && pScale != nullptr)
+      *pScale = (float)vcGLTF_JSONReadNumber(pReader);
+    else
+      vcGLTF_JSONSkipValue(pReader);
+
+    if (pReader->failed)
+      return false;
+  }
+
+  return !pReader->failed;
+}
+
+bool vcGLTF_ParseMaterial(vcGLTFScene *pScene, vcGLTFJSONReader *pReader, vcGLTFMaterial *pMaterial, vcGLTFMaterialDesc *pDesc)
+{
+  char name[32];
+  char member[32];
+  char value[16];
+  float alphaCutoff = 0.5f;
+
+  vcGLTF_DefaultMaterial(pMaterial);
+  pDesc->baseColorTexture = -1;
+  pDesc->metallicRoughnessTexture = -1;
+  pDesc->normalTexture = -1;
+  pDesc->emissiveTexture = -1;
+  pDesc->occlusionTexture = -1;
+
+  while (vcGLTF_JSONNextMember(pReader, name, sizeof(name)))
+  {
+    if (udStrEqual(name, "name"))
+    {
+      pMaterial->pName = vcGLTF_ArenaStrdup(&pScene->arena, vcGLTF_JSONReadStringInPlace(pReader));
+    }
+    else if (udStrEqual(name, "pbrMetallicRoughness") && vcGLTF_JSONExpect(pReader, '{'))
+    {
+      while (vcGLTF_JSONNextMember(pReader, member, sizeof(member)) && !pReader->failed)
+      {
+        if (udStrEqual(member, "baseColorFactor"))
+          vcGLTF_JSONReadFloats(pReader, &pMaterial->baseColorFactor.x, 4);
+        else if (udStrEqual(member, "baseColorTexture"))
+          vcGLTF_ParseTextureInfo(pReader, &pDesc->baseColorTexture, &pMaterial->baseColorUVSet, nullptr);
+        else if (udStrEqual(member, "metallicFactor"))
+          pMaterial->metallicFactor = (float)vcGLTF_JSONReadNumber(pReader);
+        else if (udStrEqual(member, "roughnessFactor"))
+          pMaterial->roughnessFactor = (float)vcGLTF_JSONReadNumber(pReader);
+        else if (udStrEqual(member, "metallicRoughnessTexture"))
+          vcGLTF_ParseTextureInfo(pReader, &pDesc->metallicRoughnessTexture, &pMaterial->metallicRoughnessUVSet, nullptr);
+        else
+          vcGLTF_JSONSkipValue(pReader);
+      }
+    }
+    else if (udStrEqual(name, "normalTexture"))
+    {
+      vcGLTF_ParseTextureInfo(pReader, &pDesc->normalTexture, &pMaterial->normalUVSet, &pMaterial->normalScale);
+    }
+    else if (udStrEqual(name, "emissiveFactor"))
+    {
+      vcGLTF_JSONReadFloats(pReader, &pMaterial->emissiveFactor.x, 3);
+    }
+    else if (udStrEqual(name, "emissiveTexture"))
+    {
+      vcGLTF_ParseTextureInfo(pReader, &pDesc->emissiveTexture, &pMaterial->emissiveUVSet, nullptr);
+    }
+    else if (udStrEqual(name, "occlusionTexture"))
+    {
+      vcGLTF_ParseTextureInfo(pReader, &pDesc->occlusionTexture, &pMaterial->occlusionUVSet, nullptr);
+    }
+    else if (udStrEqual(name, "alphaMode") && vcGLTF_JSONReadString(pReader, value, sizeof(value)))
+    {
+      if (udStrEquali(value, "MASK"))
+        pMaterial->alphaMode = vcGLTFAM_Mask;
+      else if (udStrEquali(value, "BLEND"))
+        pMaterial->alphaMode = vcGLTFAM_Blend;
+    }
+    else if (udStrEqual(name, "alphaCutoff"))
+    {
+      alphaCutoff = (float)vcGLTF_JSONReadNumber(pReader);
+    }
+    else if (udStrEqual(name, "doubleSided"))
+    {
+      pMaterial->doubleSided = vcGLTF_JSONReadBool(pReader);
+    }
+    else if (udStrEqual(name, "extensions") && vcGLTF_JSONExpect(pReader, '{'))
+    {
+      while (vcGLTF_JSONNextMember(pReader, member, sizeof(member)) && vcGLTF_JSONSkipValue(pReader))
+      {
+        if (udStrEqual(member, "KHR_materials_unlit"))
+          pMaterial->unlit = true;
+      }
+    }
+    else
+    {
+      vcGLTF_JSONSkipValue(pReader);
+    }
+
+    if (pReader->failed)
+      return false;
+  }
+
+  // The cutoff only applies to masked materials
+  if (pMaterial->alphaMode == vcGLTFAM_Mask)
+    pMaterial->alphaCutoff = alphaCutoff;
+
+  return !pReader->failed;
+}
+
+bool vcGLTF_ParseMaterialArray(vcGLTFScene *pScene, vcGLTFDocument *pDocument, vcGLTFJSONReader *pReader)
+{
+  int count = vcGLTF_JSONCountElements(*pReader);
+  if (count < 0)
+    return false;
+
+  pScene->materialCount = count;
+  pScene->pMaterials = vcGLTF_ArenaAllocType(&pScene->arena, vcGLTFMaterial, count);
+  pDocument->pMaterials = udAllocType(vcGLTFMaterialDesc, count, udAF_Zero);
+  if (count > 0 && (pScene->pMaterials == nullptr || pDocument->pMaterials == nullptr))
+    return false;
+
+  vcGLTF_JSONExpect(pReader, '[');
+
+  for (int i = 0; i < count && vcGLTF_JSONNextElement(pReader) && vcGLTF_JSONExpect(pReader, '{'); ++i)
+  {
+    if (!vcGLTF_ParseMaterial(pScene, pReader, &pScene->pMaterials[i], &pDocument->pMaterials[i]))
+      return false;
+  }
+
+  return !vcGLTF_JSONNextElement(pReader) && !pReader->failed;
+}
+
+bool vcGLTF_ParsePrimitiveArray(vcGLTFScene *pScene, vcGLTFJSONReader *pReader, vcGLTFMesh *pMesh)
+{
+  int count = vcGLTF_JSONCountElements(*pReader);
+  if (count < 0)
+    return false;
+
+  pMesh->primitiveDescCount = count;
+  pMesh->pPrimitiveDescs = vcGLTF_ArenaAllocType(&pScene->arena, vcGLTFPrimitiveDesc, count);
+  if (count > 0 && pMesh->pPrimitiveDescs == nullptr)
+    return false;
+
+  vcGLTF_JSONExpect(pReader, '[');
+
+  char name[32];
+  for (int i = 0; i < count && vcGLTF_JSONNextElement(pReader) && vcGLTF_JSONExpect(pReader, '{'); ++i)
+  {
+    vcGLTFPrimitiveDesc *pPrimitive = &pMesh->pPrimitiveDescs[i];
+
+    pPrimitive->mode = 4;
+    pPrimitive->indices = -1;
+
+    while (vcGLTF_JSONNextMember(pReader, name, sizeof(name)))
+    {
+      if (udStrEqual(name, "mode"))
+      {
+        pPrimitive->mode = (int)vcGLTF_JSONReadNumber(pReader);
+      }
+      else if (udStrEqual(name, "material"))
+      {
+        pPrimitive->material = (int)vcGLTF_JSONReadNumber(pReader);
+      }
+      else if (udStrEqual(name, "indices"))
+      {
+        pPrimitive->indices = (int)vcGLTF_JSONReadNumber(pReader);
+      }
+      else if (udStrEqual(name, "attributes"))
+      {
+        int attributeCount = vcGLTF_JSONCountMembers(*pReader);
+        if (attributeCount < 0)
+          return false;
+
+        pPrimitive->pAttributes = vcGLTF_ArenaAllocType(&pScene->arena, vcGLTFAttributeDesc, attributeCount);
+        if (attributeCount > 0 && pPrimitive->pAttributes == nullptr)
+          return false;
+
+        vcGLTF_JSONExpect(pReader, '{');
+
+        vcGLTFAttributeDesc *pAttribute = pPrimitive->pAttributes;
+        for (; pPrimitive->attributeCount < attributeCount && vcGLTF_JSONNextMember(pReader, pAttribute->name, sizeof(pAttribute->name)); ++pAttribute)
+        {
+          pAttribute->accessor = (int)vcGLTF_JSONReadNumber(pReader);
+          ++pPrimitive->attributeCount;
+        }
+
+        // Closes the object
+        vcGLTF_JSONNextMember(pReader, name, sizeof(name));
+      }
+      else
+      {
+        vcGLTF_JSONSkipValue(pReader);
+      }
+
+      if (pReader->failed)
+        return false;
+    }
+  }
+
+  return !vcGLTF_JSONNextElement(pReader) && !pReader->failed;
+}
+
+bool vcGLTF_ParseMeshArray(vcGLTFScene *pScene, vcGLTFJSONReader *pReader)
+{
+  int count = vcGLTF_JSONCountElements(*pReader);
+  if (count < 0)
+    return false;
+
+  pScene->meshCount = count;
+  pScene->pMeshes = vcGLTF_ArenaAllocType(&pScene->arena, vcGLTFMesh, count);
+  if (count > 0 && pScene->pMeshes == nullptr)
+    return false;
+
+  vcGLTF_JSONExpect(pReader, '[');
+
+  char name[32];
+  for (int i = 0; i < count && vcGLTF_JSONNextElement(pReader) && vcGLTF_JSONExpect(pReader, '{'); ++i)
+  {
+    vcGLTFMesh *pMesh = &pScene->pMeshes[i];
+
+    while (vcGLTF_JSONNextMember(pReader, name, sizeof(name)))
+    {
+      if (udStrEqual(name, "name"))
+        pMesh->pName = vcGLTF_ArenaStrdup(&pScene->arena, vcGLTF_JSONReadStringInPlace(pReader));
+      else if (udStrEqual(name, "primitives"))
+        pReader->failed = !vcGLTF_ParsePrimitiveArray(pScene, pReader, pMesh);
+      else
+        vcGLTF_JSONSkipValue(pReader);
+
+      if (pReader->failed)
+        return false;
+    }
+  }
+
+  return !vcGLTF_JSONNextElement(pReader) && !pReader->failed;
+}
+
+// Child pointers are set here as every node is allocated before the array is read; out of range children are dropped
+bool vcGLTF_ParseNodeChildren(vcGLTFScene *pScene, vcGLTFJSONReader *pReader, vcGLTFNode *pNode)
+{
+  int count = vcGLTF_JSONCountElements(*pReader);
+  if (count < 0)
+    return false;
+
+  pNode->ppChildren = vcGLTF_ArenaAllocType(&pScene->arena, vcGLTFNode*, count);
+  if (count > 0 && pNode->ppChildren == nullptr)
+    return false;
+
+  vcGLTF_JSONExpect(pReader, '[');
+
+  while (vcGLTF_JSONNextElement(pReader) && !pReader->failed)
+  {
+    int childIndex = (int)vcGLTF_JSONReadNumber(pReader);
+
+    if (childIndex >= 0 && childIndex < pScene->nodeCount && pNode->childCount < count)
+      pNode->ppChildren[pNode->childCount++] = &pScene->pNodes[childIndex];
+  }
+
+  return !pReader->failed;
+}
+
+bool vcGLTF_ParseNode(vcGLTFScene *pScene, vcGLTFJSONReader *pReader, vcGLTFNode *pNode, vcGLTFNodeDesc *pDesc)
+{
+  // We support "animation heirachy" nodes which have these types
+  const char *allowedTypes[] =
+  {
+    "name",
+    "translation",
+    "rotation",
+    "scale",
+    "children",
+    "matrix"
+  };
+
+  char name[32];
+  char member[32];
+  char extension[32];
+  udFloat4x4 matrix = udFloat4x4::identity();
+  bool hasMatrix = false;
+
+  pNode->rotation = udFloatQuat::identity();
+  pNode->scale = udFloat3::one();
+  pDesc->mesh = -1;
+
+  while (vcGLTF_JSONNextMember(pReader, name, sizeof(name)))
+  {
+    size_t allowedTypeIndex = 0;
+    for (allowedTypeIndex = 0; allowedTypeIndex < udLengthOf(allowedTypes); ++allowedTypeIndex)
+    {
+      if (udStrEqual(allowedTypes[allowedTypeIndex], name))
+        break;
+    }
+
+    if (allowedTypeIndex == udLengthOf(allowedTypes))
+      pDesc->hasOtherMembers = true;
+
+    if (udStrEqual(name, "matrix"))
+    {
+      hasMatrix = (vcGLTF_JSONReadFloats(pReader, matrix.a, 16) == 16);
+    }
+    else if (udStrEqual(name, "translation"))
+    {
+      vcGLTF_JSONReadFloats(pReader, &pNode->translation.x, 3);
+    }
+    else if (udStrEqual(name, "rotation"))
+    {
+      vcGLTF_JSONReadFloats(pReader, &pNode->rotation.x, 4);
+    }
+    else if (udStrEqual(name, "scale"))
+    {
+      vcGLTF_JSONReadFloats(pReader, &pNode->scale.x, 3);
+    }
+    else if (udStrEqual(name, "children"))
+    {
+      pReader->failed = !vcGLTF_ParseNodeChildren(pScene, pReader, pNode);
+    }
+    else if (udStrEqual(name, "mesh"))
+    {
+      pDesc->mesh = (int)vcGLTF_JSONReadNumber(pReader);
+    }
+    else if (udStrEqual(name, "skin"))
+    {
+      pDesc->skin = (int)vcGLTF_JSONReadNumber(pReader);
+    }
+    else if (udStrEqual(name, "camera") || udStrEqual(name, "light"))
+    {
+      pDesc->hasCamera = true;
+      vcGLTF_JSONSkipValue(pReader);
+    }
+    else if (udStrEqual(name, "extensions") && vcGLTF_JSONExpect(pReader, '{'))
+    {
+      // MSFT_lod lists nodes whose meshes are progressively coarser versions of this one
+      while (vcGLTF_JSONNextMember(pReader, extension, sizeof(extension)) && !pReader->failed)
+      {
+        if (udStrEqual(extension, "MSFT_lod") && vcGLTF_JSONExpect(pReader, '{'))
+        {
+          while (vcGLTF_JSONNextMember(pReader, member, sizeof(member)) && !pReader->failed)
+          {
+            if (udStrEqual(member, "ids"))
+              pDesc->lodCount = vcGLTF_JSONReadInts(pReader, pDesc->lodNodes, (int)udLengthOf(pDesc->lodNodes));
+            else
+              vcGLTF_JSONSkipValue(pReader);
+          }
+        }
+        else
+        {
+          vcGLTF_JSONSkipValue(pReader);
+        }
+      }
+    }
+    else if (udStrEqual(name, "extras") && vcGLTF_JSONExpect(pReader, '{'))
+    {
+      while (vcGLTF_JSONNextMember(pReader, member, sizeof(member)) && !pReader->failed)
+      {
+        if (udStrEqual(member, "MSFT_screencoverage"))
+          pDesc->coverageCount = vcGLTF_JSONReadFloats(pReader, pDesc->coverage, (int)udLengthOf(pDesc->coverage));
+        else
+          vcGLTF_JSONSkipValue(pReader);
+      }
+    }
+    else
+    {
+      vcGLTF_JSONSkipValue(pReader);
+    }
+
+    if (pReader->failed)
+      return false;
+  }
+
+  if (hasMatrix)
+    matrix.extractTransforms(pNode->translation, pNode->scale, pNode->rotation);
+
+  return !pReader->failed;
+}
+
+bool vcGLTF_ParseNodeArray(vcGLTFScene *pScene, vcGLTFDocument *pDocument, vcGLTFJSONReader *pReader)
+{
+  int count = vcGLTF_JSONCountElements(*pReader);
+  if (count < 0)
+    return false;
+
+  pScene->nodeCount = count;
+  pScene->pNodes = vcGLTF_ArenaAllocType(&pScene->arena, vcGLTFNode, count);
+  pDocument->pNodes = udAllocType(vcGLTFNodeDesc, count, udAF_Zero);
+  if (count > 0 && (pScene->pNodes == nullptr || pDocument->pNodes == nullptr))
+    return false;
+
+  vcGLTF_JSONExpect(pReader, '[');
+
+  for (int i = 0; i < count && vcGLTF_JSONNextElement(pReader) && vcGLTF_JSONExpect(pReader, '{'); ++i)
+  {
+    if (!vcGLTF_ParseNode(pScene, pReader, &pScene->pNodes[i], &pDocument->pNodes[i]))
+      return false;
+  }
+
+  return !vcGLTF_JSONNextElement(pReader) && !pReader->failed;
+}
+
+bool vcGLTF_ParseSceneArray(vcGLTFDocument *pDocument, vcGLTFJSONReader *pReader)
+{
+  int count = vcGLTF_JSONCountElements(*pReader);
+  if (count < 0)
+    return false;
+
+  pDocument->sceneCount = count;
+  pDocument->pScenes = udAllocType(vcGLTFSceneDesc, count, udAF_Zero);
+  if (count > 0 && pDocument->pScenes == nullptr)
+    return false;
+
+  vcGLTF_JSONExpect(pReader, '[');
+
+  char name[32];
+  for (int i = 0; i < count && vcGLTF_JSONNextElement(pReader) && vcGLTF_JSONExpect(pReader, '{'); ++i)
+  {
+    vcGLTFSceneDesc *pSceneDesc = &pDocument->pScenes[i];
+
+    while (vcGLTF_JSONNextMember(pReader, name, sizeof(name)))
+    {
+      if (udStrEqual(name, "nodes"))
+      {
+        int nodeCount = vcGLTF_JSONCountElements(*pReader);
+        if (nodeCount < 0)
+          return false;
+
+        pSceneDesc->pNodes = udAllocType(int, nodeCount, udAF_None);
+        if (nodeCount > 0 && pSceneDesc->pNodes == nullptr)
+          return false;
+
+        pSceneDesc->nodeCount = vcGLTF_JSONReadInts(pReader, pSceneDesc->pNodes, nodeCount);
+      }
+      else
+      {
+        vcGLTF_JSONSkipValue(pReader);
+      }
+
+      if (pReader->failed)
+        return false;
+    }
+  }
+
+  return !vcGLTF_JSONNextElement(pReader) && !pReader->failed;
+}
+
+bool vcGLTF_ParseAnimationSamplers(vcGLTFScene *pScene, vcGLTFJSONReader *pReader, vcGLTFAnimation *pAnimation, vcGLTFAnimationDesc *pDesc)
+{
+  const char *interpolationNames[] = { "LINEAR", "STEP", "CUBICSPLINE" };
+  UDCOMPILEASSERT(udLengthOf(interpolationNames) == vcGLTFInterpolation_Count, "Array out of date!");
+
+  int count = vcGLTF_JSONCountElements(*pReader);
+  if (count < 0)
+    return false;
+
+  pAnimation->numSamplers = count;
+  pAnimation->pSamplers = vcGLTF_ArenaAllocType(&pScene->arena, vcGLTFAnimationSampler, count);
+  pDesc->pSamplerInputs = udAllocType(int, count * 2, udAF_Zero);
+  pDesc->pSamplerOutputs = pDesc->pSamplerInputs + count;
+  if (count > 0 && (pAnimation->pSamplers == nullptr || pDesc->pSamplerInputs == nullptr))
+    return false;
+
+  vcGLTF_JSONExpect(pReader, '[');
+
+  char name[32];
+  char value[16];
+  for (int i = 0; i < count && vcGLTF_JSONNextElement(pReader) && vcGLTF_JSONExpect(pReader, '{'); ++i)
+  {
+    while (vcGLTF_JSONNextMember(pReader, name, sizeof(name)))
+    {
+      if (udStrEqual(name, "input"))
+      {
+        pDesc->pSamplerInputs[i] = (int)vcGLTF_JSONReadNumber(pReader);
+      }
+      else if (udStrEqual(name, "output"))
+      {
+        pDesc->pSamplerOutputs[i] = (int)vcGLTF_JSONReadNumber(pReader);
+      }
+      else if (udStrEqual(name, "interpolation") && vcGLTF_JSONReadString(pReader, value, sizeof(value)))
+      {
+        int j = 0;
+        for (j = 0; j < vcGLTFInterpolation_Count; ++j)
+        {
+          if (udStrEqual(interpolationNames[j], value))
+          {
+            pAnimation->pSamplers[i].interpolationMethod = (vcGLTFInterpolation)j;
+            break;
+          }
+        }
+
+        if (j == vcGLTFInterpolation_Count)
+          __debugbreak();
+      }
+      else
+      {
+        vcGLTF_JSONSkipValue(pReader);
+      }
+
+      if (pReader->failed)
+        return false;
+    }
+  }
+
+  return !vcGLTF_JSONNextElement(pReader) && !pReader->failed;
+}
+
+bool vcGLTF_ParseAnimationChannels(vcGLTFScene *pScene, vcGLTFJSONReader *pReader, vcGLTFAnimation *pAnimation, vcGLTFAnimationDesc *pDesc)
+{
+  const char *supportedPaths[] = { "translation", "rotation", "scale", "weights" };
+  UDCOMPILEASSERT(udLengthOf(supportedPaths) == vcGLTFChannelTarget_Count, "Array out of date!");
+
+  int count = vcGLTF_JSONCountElements(*pReader);
+  if (count < 0)
+    return false;
+
+  pAnimation->numChannels = count;
+  pAnimation->pChannels = vcGLTF_ArenaAllocType(&pScene->arena, vcGLTFAnimationChannel, count);
+  pDesc->pChannelSamplers = udAllocType(int, count, udAF_Zero);
+  if (count > 0 && (pAnimation->pChannels == nullptr || pDesc->pChannelSamplers == nullptr))
+    return false;
+
+  vcGLTF_JSONExpect(pReader, '[');
+
+  char name[32];
+  char member[32];
+  char value[16];
+  for (int i = 0; i < count && vcGLTF_JSONNextElement(pReader) && vcGLTF_JSONExpect(pReader, '{'); ++i)
+  {
+    vcGLTFAnimationChannel *pChannel = &pAnimation->pChannels[i];
+
+    while (vcGLTF_JSONNextMember(pReader, name, sizeof(name)))
+    {
+      if (udStrEqual(name, "sampler"))
+      {
+        pDesc->pChannelSamplers[i] = (int)vcGLTF_JSONReadNumber(pReader);
+      }
+      else if (udStrEqual(name, "target") && vcGLTF_JSONExpect(pReader, '{'))
+      {
+        while (vcGLTF_JSONNextMember(pReader, member, sizeof(member)) && !pReader->failed)
+        {
+          if (udStrEqual(member, "node"))
+          {
+            pChannel->nodeIndex = (int)vcGLTF_JSONReadNumber(pReader);
+          }
+          else if (udStrEqual(member, "path") && vcGLTF_JSONReadString(pReader, value, sizeof(value)))
+          {
+            int j = 0;
+            for (j = 0; j < vcGLTFChannelTarget_Count; ++j)
+            {
+              if (udStrEqual(supportedPaths[j], value))
+              {
+                pChannel->target = (vcGLTFChannelTarget)j;
+                break;
+              }
+            }
+
+            if (j == vcGLTFChannelTarget_Count)
+              __debugbreak();
+          }
+          else
+          {
+            vcGLTF_JSONSkipValue(pReader);
+          }
+        }
+      }
+      else
+      {
+        vcGLTF_JSONSkipValue(pReader);
+      }
+
+      if (pReader->failed)
+        return false;
+    }
+  }
+
+  return !vcGLTF_JSONNextElement(pReader) && !pReader->failed;
+}
+
+bool vcGLTF_ParseAnimationArray(vcGLTFScene *pScene, vcGLTFDocument *pDocument, vcGLTFJSONReader *pReader)
+{
+  int count = vcGLTF_JSONCountElements(*pReader);
+  if (count < 0)
+    return false;
+
+  pScene->animationCount = count;
+  pScene->pAnimations = vcGLTF_ArenaAllocType(&pScene->arena, vcGLTFAnimation, count);
+  pDocument->animationCount = count;
+  pDocument->pAnimations = udAllocType(vcGLTFAnimationDesc, count, udAF_Zero);
+  if (count > 0 && (pScene->pAnimations == nullptr || pDocument->pAnimations == nullptr))
+    return false;
+
+  vcGLTF_JSONExpect(pReader, '[');
+
+  char name[32];
+  for (int i = 0; i < count && vcGLTF_JSONNextElement(pReader) && vcGLTF_JSONExpect(pReader, '{'); ++i)
+  {
+    while (vcGLTF_JSONNextMember(pReader, name, sizeof(name)))
+    {
+      if (udStrEqual(name, "samplers"))
+        pReader->failed = !vcGLTF_ParseAnimationSamplers(pScene, pReader, &pScene->pAnimations[i], &pDocument->pAnimations[i]);
+      else if (udStrEqual(name, "channels"))
+        pReader->failed = !vcGLTF_ParseAnimationChannels(pScene, pReader, &pScene->pAnimations[i], &pDocument->pAnimations[i]);
+      else
+        vcGLTF_JSONSkipValue(pReader);
+
+      if (pReader->failed)
+        return false;
+    }
+  }
+
+  return !vcGLTF_JSONNextElement(pReader) && !pReader->failed;
+}
+
+bool vcGLTF_ParseSkinArray(vcGLTFScene *pScene, vcGLTFDocument *pDocument, vcGLTFJSONReader *pReader)
+{
+  int count = vcGLTF_JSONCountElements(*pReader);
+  if (count < 0)
+    return false;
+
+  pScene->skinCount = count;
+  pScene->pSkins = vcGLTF_ArenaAllocType(&pScene->arena, vcGLTFSkin, count);
+  pDocument->pSkinInverseBinds = udAllocType(int, count, udAF_None);
+  if (count > 0 && (pScene->pSkins == nullptr || pDocument->pSkinInverseBinds == nullptr))
+    return false;
+
+  vcGLTF_JSONExpect(pReader, '[');
+
+  char name[32];
+  for (int i = 0; i < count && vcGLTF_JSONNextElement(pReader) && vcGLTF_JSONExpect(pReader, '{'); ++i)
+  {
+    vcGLTFSkin *pSkin = &pScene->pSkins[i];
+    pDocument->pSkinInverseBinds[i] = -1;
+
+    while (vcGLTF_JSONNextMember(pReader, name, sizeof(name)))
+    {
+      if (udStrEqual(name, "name"))
+      {
+        pSkin->pName = vcGLTF_ArenaStrdup(&pScene->arena, vcGLTF_JSONReadStringInPlace(pReader));
+      }
+      else if (udStrEqual(name, "skeleton"))
+      {
+        pSkin->baseJoint = (int)vcGLTF_JSONReadNumber(pReader);
+      }
+      else if (udStrEqual(name, "inverseBindMatrices"))
+      {
+        pDocument->pSkinInverseBinds[i] = (int)vcGLTF_JSONReadNumber(pReader);
+      }
+      else if (udStrEqual(name, "joints"))
+      {
+        int jointCount = vcGLTF_JSONCountElements(*pReader);
+        if (jointCount < 0)
+          return false;
+
+        pSkin->pJoints = vcGLTF_ArenaAllocType(&pScene->arena, int, jointCount);
+        if (jointCount > 0 && pSkin->pJoints == nullptr)
+          return false;
+
+        pSkin->jointCount = vcGLTF_JSONReadInts(pReader, pSkin->pJoints, jointCount);
+      }
+      else
+      {
+        vcGLTF_JSONSkipValue(pReader);
+      }
+
+      if (pReader->failed)
+        return false;
+    }
+  }
+
+  return !vcGLTF_JSONNextElement(pReader) && !pReader->failed;
+}
+
+// extensionsRequired & extensionsUsed
+bool vcGLTF_CheckExtensions(vcGLTFJSONReader *pReader)
+{
+  const char *supportedExtensions[] = { "MSFT_lod", "KHR_materials_unlit" };
+  char name[64];
+
+  if (!vcGLTF_JSONExpect(pReader, '['))
+    return false;
+
+  while (vcGLTF_JSONNextElement(pReader) && vcGLTF_JSONReadString(pReader, name, sizeof(name)))
+  {
+    size_t supportedIndex = 0;
+    for (supportedIndex = 0; supportedIndex < udLengthOf(supportedExtensions); ++supportedIndex)
+    {
+      if (udStrEqual(supportedExtensions[supportedIndex], name))
+        break;
+    }
+
+    if (supportedIndex == udLengthOf(supportedExtensions))
+      __debugbreak(); // Unsupported extension
+  }
+
+  return !pReader->failed;
+}
+
+// Streams the whole document into the scene's typed arrays (in the arena, which must already be sized; see
+// vcGLTF_EstimateArenaSize) and pDocument. Sections may come in any order as none refers to another's parsed data
+udResult vcGLTF_ParseDocument(vcGLTFScene *pScene, vcGLTFDocument *pDocument, char *pText)
+{
+  vcGLTFJSONReader reader = { pText, false };
+  char name[32];
+
+  if (!vcGLTF_JSONExpect(&reader, '{'))
+    return udR_ParseError;
+
+  while (vcGLTF_JSONNextMember(&reader, name, sizeof(name)))
+  {
+    bool parsed = true;
+
+    if (udStrEqual(name, "accessors"))
+      parsed = vcGLTF_ParseAccessorArray(pScene, &reader);
+    else if (udStrEqual(name, "bufferViews"))
+      parsed = vcGLTF_ParseBufferViewArray(pScene, &reader);
+    else if (udStrEqual(name, "buffers"))
+      parsed = vcGLTF_ParseBufferArray(pScene, &reader);
+    else if (udStrEqual(name, "images"))
+      parsed = vcGLTF_ParseImageArray(pDocument, &reader);
+    else if (udStrEqual(name, "textures"))
+      parsed = vcGLTF_ParseTextureArray(pDocument, &reader);
+    else if (udStrEqual(name, "samplers"))
+      parsed = vcGLTF_ParseSamplerArray(pDocument, &reader);
+    else if (udStrEqual(name, "materials"))
+      parsed = vcGLTF_ParseMaterialArray(pScene, pDocument, &reader);
+    else if (udStrEqual(name, "meshes"))
+      parsed = vcGLTF_ParseMeshArray(pScene, &reader);
+    else if (udStrEqual(name, "nodes"))
+      parsed = vcGLTF_ParseNodeArray(pScene, pDocument, &reader);
+    else if (udStrEqual(name, "scenes"))
+      parsed = vcGLTF_ParseSceneArray(pDocument, &reader);
+    else if (udStrEqual(name, "scene"))
+      pDocument->scene = (int)vcGLTF_JSONReadNumber(&reader);
+    else if (udStrEqual(name, "animations"))
+      parsed = vcGLTF_ParseAnimationArray(pScene, pDocument, &reader);
+    else if (udStrEqual(name, "skins"))
+      parsed = vcGLTF_ParseSkinArray(pScene, pDocument, &reader);
+    else if (udStrEqual(name, "extensionsRequired") || udStrEqual(name, "extensionsUsed"))
+      parsed = vcGLTF_CheckExtensions(&reader);
+    else
+      parsed = vcGLTF_JSONSkipValue(&reader);
+
+    if (!parsed || reader.failed)
+      return udR_ParseError;
+  }
+
+  return reader.failed ? udR_ParseError : udR_Success;
+}
+
+// Accessor of the named attribute, -1 if the primitive doesn't have it
+int vcGLTF_FindAttribute(const vcGLTFPrimitiveDesc &primitive, const char *pName)
+{
+  for (int i = 0; i < primitive.attributeCount; ++i)
+  {
+    if (udStrEqual(primitive.pAttributes[i].name, pName))
+      return primitive.pAttributes[i].accessor;
+  }
+
+  return -1;
+}
+
+vcGLTFAccessor vcGLTF_MissingAccessor()
+{
+  vcGLTFAccessor missing = {};
+  missing.bufferView = -1;
+  return missing;
+}
+
+// Out of range IDs get an empty accessor (bufferView -1) or buffer view
+const vcGLTFAccessor &vcGLTF_GetAccessor(const vcGLTFScene *pScene, int accessorID)
+{
+  static const vcGLTFAccessor Missing = vcGLTF_MissingAccessor();
+
+  if (accessorID < 0 || accessorID >= pScene->accessorCount)
+    return Missing;
+
+  return pScene->pAccessors[accessorID];
+}
+
+const vcGLTFBufferView &vcGLTF_GetBufferView(const vcGLTFScene *pScene, int bufferViewID)
+{
+  static const vcGLTFBufferView Missing = {};
+
+  if (bufferViewID < 0 || bufferViewID >= pScene->bufferViewCount)
+    return Missing;
+
+  return pScene->pBufferViews[bufferViewID];
+}
+
+// Time is attributed to one phase at a time; nested work switches to its phase and then back to the one returned
+vcGLTFLoadPhase vcGLTF_SetLoadPhase(vcGLTFScene *pScene, vcGLTFLoadPhase phase)
+{
+  if (!pScene->loading)
+    return vcGLTFLP_Count;
+
+  uint64_t now = udPerfCounterStart();
+  vcGLTFLoadPhase previous = pScene->loadPhase;
+
+  if (previous != vcGLTFLP_Count)
+  {
+    pScene->loadStats.phaseMilliseconds[previous] += udPerfCounterMilliseconds(pScene->loadPhaseStart, now);
+    vcGLTF_TraceEvent(g_vcGLTFLoadPhaseNames[previous], pScene->loadPhaseStart, now);
+  }
+
+  pScene->loadPhaseStart = now;
+  pScene->loadPhase = phase;
+
+  return previous;
+}
+
+void vcGLTF_LogProgress(vcGLTFScene *pScene, const char *pFormat, ...)
+{
+  if ((pScene->loadFlags & vcGLTFLF_LogProgress) == 0)
+    return;
+
+  va_list args;
+  va_start(args, pFormat);
+  vprintf(pFormat, args);
+  va_end(args);
+}
+
+void vcGLTF_CountMeshBytes(vcGLTFScene *pScene, const vcVertexLayoutTypes *pLayout, int layoutCount, uint32_t vertexCount, uint32_t indexCount, bool shortIndices)
+{
+  pScene->vertexBytes += (int64_t)vcLayout_GetSize(pLayout, layoutCount) * vertexCount;
+  pScene->indexBytes += (int64_t)indexCount * (shortIndices ? sizeof(uint16_t) : sizeof(uint32_t));
+}
+
+udResult vcGLTF_LoadBuffer(vcGLTFScene *pScene, int bufferID)
+{
+  vcGLTFLoadPhase previousPhase = vcGLTF_SetLoadPhase(pScene, vcGLTFLP_BufferIO);
+  udResult result = udR_Failure_;
+
+  const char *pPath = pScene->pBuffers[bufferID].pURI;
+  int64_t loadedSize = 0;
+
+  UD_ERROR_NULL(pPath, udR_ObjectNotFound);
+
+  if (udFile_Load(pPath, &pScene->pBuffers[bufferID].pBytes, &loadedSize) != udR_Success)
+    UD_ERROR_CHECK(udFile_Load(udTempStr("%s%s", pScene->pPath, pPath), &pScene->pBuffers[bufferID].pBytes, &loadedSize));
+
+  UD_ERROR_IF(pScene->pBuffers[bufferID].byteLength != loadedSize, udR_CorruptData);
+
+  result = udR_Success;
+
+epilogue:
+  if (result != udR_Success)
+    udFree(pScene->pBuffers[bufferID].pBytes);
+
+  pScene->loadStats.fileBytesRead += loadedSize;
+  vcGLTF_SetLoadPhase(pScene, previousPhase);
+
+  return result;
+}
+
+udResult vcGLTF_LoadTexture(vcGLTFScene *pScene, const vcGLTFDocument &document, int textureID, vcTexture **ppTexture)
+{
+  if (textureID >= 0 && textureID < document.textureCount)
+  {
+    const vcGLTFTextureDesc &texture = document.pTextures[textureID];
+    const char *pURI = (texture.source >= 0 && texture.source < document.imageCount) ? document.ppImageURIs[texture.source] : nullptr;
+
+    vcGLTFSamplerDesc sampler = { 0, vcGLTFType_Repeat, vcGLTFType_Repeat };
+    if (texture.sampler >= 0 && texture.sampler < document.samplerCount)
+      sampler = document.pSamplers[texture.sampler];
+
+    vcTextureFilterMode filterMode;
+    int filter = sampler.magFilter;
+    if (filter == vcGLTFType_Linear)
+      filterMode = vcTFM_Linear;
+    else
+      filterMode = vcTFM_Nearest;
+
+    vcTextureWrapMode wrapMode;
+    int wrapS = sampler.wrapS;
+    int wrapT = sampler.wrapT;
+
+    if (wrapS == vcGLTFType_ClampEdge)
+      wrapMode = vcTWM_Clamp;
+    else if (wrapS == vcGLTFType_MirroredRepeat)
+      wrapMode = vcTWM_MirroredRepeat;
+    else
+      wrapMode = vcTWM_Repeat;
+
+    if (wrapS != wrapT)
+    {
+      if (wrapT == vcGLTFType_ClampEdge)
+        wrapMode = wrapMode | vcTWM_ClampT | vcTWM_UniqueST;
+      else if (wrapT == vcGLTFType_MirroredRepeat)
+        wrapMode = wrapMode | vcTWM_MirroredRepeatT | vcTWM_UniqueST;
+      else
+        wrapMode = wrapMode | vcTWM_RepeatT | vcTWM_UniqueST;
+    }
+
+    ++pScene->loadStats.texturesRequested;
+
+    if (udStrBeginsWith(pURI, "data:"))
+      vcTexture_CreateFromFilename(ppTexture, pURI, nullptr, nullptr, filterMode, false, wrapMode);
+    else if (pURI != nullptr)
+      *ppTexture = ttTextureCache_Get(udTempStr("%s/%s", pScene->pPath, pURI), filterMode, false, wrapMode);
+  }
+
+  return udR_Success;
+}
+
+udFloat3 GetNormal(int i0, int i1, int i2, uint8_t *pBufferStart, ptrdiff_t byteStride)
+{
+  float *pPF = nullptr;
+
+  pPF = (float*)(pBufferStart + (i0) * byteStride);
+  udFloat3 p0 = { pPF[0], pPF[1], pPF[2] };
+
+  pPF = (float*)(pBufferStart + (i1) * byteStride);
+  udFloat3 p1 = { pPF[0], pPF[1], pPF[2] };
+
+  pPF = (float*)(pBufferStart + (i2) * byteStride);
+  udFloat3 p2 = { pPF[0], pPF[1], pPF[2] };
+
+  return udCross(p1 - p0, p2 - p0);
+}
+
+int vcGLTF_GetLayoutOffset(const vcVertexLayoutTypes *pTypes, int totalTypes, vcVertexLayoutTypes type)
+{
+  for (int i = 0; i < totalTypes; ++i)
+  {
+    if (pTypes[i] == type)
+      return (int)vcLayout_GetSize(pTypes, i);
+  }
+
+  return -1;
+}
+
+// The same curve as sRGBToLinear in gltfFragmentShader (which decodes colour textures and encodes the output); material
+// factors are already linear in GLTF so only colours authored in sRGB (like the ambient light) go through this
+udFloat3 vcGLTF_sRGBToLinear(const udFloat3 &srgb)
+{
+  const float Gamma = 2.2f;
+  return udFloat3::create(udPow(udMax(srgb.x, 0.f), Gamma), udPow(udMax(srgb.y, 0.f), Gamma), udPow(udMax(srgb.z, 0.f), Gamma));
+}
+
+bool vcGLTF_BoundsValid(const udFloat3 &boundsMin, const udFloat3 &boundsMax)
+{
+  return boundsMin.x <= boundsMax.x && boundsMin.y <= boundsMax.y && boundsMin.z <= boundsMax.z;
+}
+
+void vcGLTF_ExpandBounds(udFloat3 *pBoundsMin, udFloat3 *pBoundsMax, const udFloat3 &otherMin, const udFloat3 &otherMax)
+{
+  *pBoundsMin = udMin(*pBoundsMin, otherMin);
+  *pBoundsMax = udMax(*pBoundsMax, otherMax);
+}
+
+// Transforms an AABB by an affine matrix, the result is the AABB of the transformed box
+void vcGLTF_TransformBounds(const udFloat4x4 &matrix, const udFloat3 &inMin, const udFloat3 &inMax, udFloat3 *pOutMin, udFloat3 *pOutMax)
+{
+  udFloat3 center = (inMin + inMax) * 0.5f;
+  udFloat3 extents = (inMax - inMin) * 0.5f;
+
+  udFloat3 newCenter = (matrix * udFloat4::create(center, 1.f)).toVector3();
+  udFloat3 newExtents;
+
+  for (int i = 0; i < 3; ++i)
+    newExtents[i] = udAbs(matrix.a[0 + i]) * extents.x + udAbs(matrix.a[4 + i]) * extents.y + udAbs(matrix.a[8 + i]) * extents.z;
+
+  *pOutMin = newCenter - newExtents;
+  *pOutMax = newCenter + newExtents;
+}
+
+struct vcGLTFFrustum
+{
+  udDouble4 planes[6]; // Left, Right, Bottom, Top, Near, Far; inside is positive
+};
+
+// Gribb/Hartmann plane extraction; the near plane uses the [-w, w] depth range which is conservative for [0, w] APIs
+void vcGLTF_ExtractFrustum(const udDouble4x4 &clipMatrix, vcGLTFFrustum *pFrustum)
+{
+  udDouble4 rows[4];
+  for (int i = 0; i < 4; ++i)
+    rows[i] = udDouble4::create(clipMatrix.a[0 + i], clipMatrix.a[4 + i], clipMatrix.a[8 + i], clipMatrix.a[12 + i]);
+
+  pFrustum->planes[0] = rows[3] + rows[0];
+  pFrustum->planes[1] = rows[3] - rows[0];
+  pFrustum->planes[2] = rows[3] + rows[1];
+  pFrustum->planes[3] = rows[3] - rows[1];
+  pFrustum->planes[4] = rows[3] + rows[2];
+  pFrustum->planes[5] = rows[3] - rows[2];
+}
+
+// Moves the frustum into the space that matrix transforms from
+void vcGLTF_TransformFrustum(const vcGLTFFrustum &frustum, const udDouble4x4 &matrix, vcGLTFFrustum *pLocalFrustum)
+{
+  for (int p = 0; p < 6; ++p)
+  {
+    for (int j = 0; j < 4; ++j)
+      pLocalFrustum->planes[p][j] = frustum.planes[p].x * matrix.a[j * 4 + 0] + frustum.planes[p].y * matrix.a[j * 4 + 1] + frustum.planes[p].z * matrix.a[j * 4 + 2] + frustum.planes[p].w * matrix.a[j * 4 + 3];
+  }
+}
+
+bool vcGLTF_FrustumTestBounds(const vcGLTFFrustum &frustum, const udFloat3 &boundsMin, const udFloat3 &boundsMax)
+{
+  if (!vcGLTF_BoundsValid(boundsMin, boundsMax))
+    return true;
+
+  for (int p = 0; p < 6; ++p)
+  {
+    const udDouble4 &plane = frustum.planes[p];
+
+    // Furthest corner along the plane normal
+    double x = (plane.x > 0.0) ? boundsMax.x : boundsMin.x;
+    double y = (plane.y > 0.0) ? boundsMax.y : boundsMin.y;
+    double z = (plane.z > 0.0) ? boundsMax.z : boundsMin.z;
+
+    if (plane.x * x + plane.y * y + plane.z * z + plane.w < 0.0)
+      return false;
+  }
+
+  return true;
+}
+
+float vcGLTF_BoundsHalfArea(const udFloat3 &boundsMin, const udFloat3 &boundsMax)
+{
+  udFloat3 extents = boundsMax - boundsMin;
+  return extents.x * extents.y + extents.y * extents.z + extents.z * extents.x;
+}
+
+// Binned SAH build over arbitrary item bounds, pOrder receives the item order the leaves index into
+int vcGLTF_BuildBVH(const udFloat3 *pItemMin, const udFloat3 *pItemMax, int itemCount, int maxLeafSize, vcGLTFBVHNode **ppNodes, int **ppOrder, int *pMaxDepth)
+{
+  enum { BinCount = 12 };
+
+  struct Bin
+  {
+    udFloat3 boundsMin;
+    udFloat3 boundsMax;
+    int count;
+  };
+
+  int maxNodes = udMax(1, itemCount * 2 - 1);
+  vcGLTFBVHNode *pNodes = udAllocType(vcGLTFBVHNode, maxNodes, udAF_Zero);
+  int *pOrder = udAllocType(int, udMax(1, itemCount), udAF_None);
+  udFloat3 *pCentroids = udAllocType(udFloat3, udMax(1, itemCount), udAF_None);
+  int *pStack = udAllocType(int, maxNodes, udAF_None);
+  int *pDepths = udAllocType(int, maxNodes, udAF_Zero);
+  int maxDepth = 0;
+
+  for (int i = 0; i < itemCount; ++i)
+  {
+    pOrder[i] = i;
+    pCentroids[i] = (pItemMin[i] + pItemMax[i]) * 0.5f;
+  }
+
+  int nodeCount = 1;
+  pNodes[0].leftFirst = 0;
+  pNodes[0].itemCount = itemCount;
+
+  int stackSize = 0;
+  pStack[stackSize++] = 0;
+
+  while (stackSize > 0)
+  {
+    int nodeIndex = pStack[--stackSize];
+    vcGLTFBVHNode *pNode = &pNodes[nodeIndex];
+    int first = pNode->leftFirst;
+    int count = pNode->itemCount;
+
+    maxDepth = udMax(maxDepth, pDepths[nodeIndex]);
+
+    udFloat3 centroidMin = udFloat3::create(FLT_MAX);
+    udFloat3 centroidMax = udFloat3::create(-FLT_MAX);
+    pNode->boundsMin = udFloat3::create(FLT_MAX);
+    pNode->boundsMax = udFloat3::create(-FLT_MAX);
+
+    for (int i = first; i < first + count; ++i)
+    {
+      vcGLTF_ExpandBounds(&pNode->boundsMin, &pNode->boundsMax, pItemMin[pOrder[i]], pItemMax[pOrder[i]]);
+      vcGLTF_ExpandBounds(&centroidMin, &centroidMax, pCentroids[pOrder[i]], pCentroids[pOrder[i]]);
+    }
+
+    if (count <= 1)
+      continue;
+
+    int bestAxis = -1;
+    int bestSplit = -1;
+    float bestCost = FLT_MAX;
+
+    for (int axis = 0; axis < 3; ++axis)
+    {
+      float extent = centroidMax[axis] - centroidMin[axis];
+      if (extent <= 0.f)
+        continue;
+
+      Bin bins[BinCount];
+      for (int b = 0; b < BinCount; ++b)
+      {
+        bins[b].boundsMin = udFloat3::create(FLT_MAX);
+        bins[b].boundsMax = udFloat3::create(-FLT_MAX);
+        bins[b].count = 0;
+      }
+
+      float scale = BinCount / extent;
+      for (int i = first; i < first + count; ++i)
+      {
+        int b = udMin(BinCount - 1, (int)((pCentroids[pOrder[i]][axis] - centroidMin[axis]) * scale));
+        vcGLTF_ExpandBounds(&bins[b].boundsMin, &bins[b].boundsMax, pItemMin[pOrder[i]], pItemMax[pOrder[i]]);
+        ++bins[b].count;
+      }
+
+      float leftArea[BinCount - 1];
+      int leftCount[BinCount - 1];
+      udFloat3 sweepMin = udFloat3::create(FLT_MAX);
+      udFloat3 sweepMax = udFloat3::create(-FLT_MAX);
+      int sweepCount = 0;
+
+      for (int b = 0; b < BinCount - 1; ++b)
+      {
+        sweepCount += bins[b].count;
+        if (bins[b].count > 0)
+          vcGLTF_ExpandBounds(&sweepMin, &sweepMax, bins[b].boundsMin, bins[b].boundsMax);
+        leftCount[b] = sweepCount;
+        leftArea[b] = (sweepCount > 0) ? vcGLTF_BoundsHalfArea(sweepMin, sweepMax) : 0.f;
+      }
+
+      sweepMin = udFloat3::create(FLT_MAX);
+      sweepMax = udFloat3::create(-FLT_MAX);
+      sweepCount = 0;
+
+      for (int b = BinCount - 1; b > 0; --b)
+      {
+        sweepCount += bins[b].count;
+        if (bins[b].count > 0)
+          vcGLTF_ExpandBounds(&sweepMin, &sweepMax, bins[b].boundsMin, bins[b].boundsMax);
+
+        if (leftCount[b - 1] == 0 || sweepCount == 0)
+          continue;
+
+        float cost = leftArea[b - 1] * leftCount[b - 1] + vcGLTF_BoundsHalfArea(sweepMin, sweepMax) * sweepCount;
+        if (cost < bestCost)
+        {
+          bestCost = cost;
+          bestAxis = axis;
+          bestSplit = b - 1;
+        }
+      }
+    }
+
+    if (bestAxis == -1)
+      continue; // All centroids are coincident
+
+    // Traversal and intersection are treated as equally expensive
+    float leafCost = count * vcGLTF_BoundsHalfArea(pNode->boundsMin, pNode->boundsMax);
+    if (count <= maxLeafSize && bestCost >= leafCost)
+      continue;
+
+    float scale = BinCount / (centroidMax[bestAxis] - centroidMin[bestAxis]);
+    int i = first;
+    int j = first + count - 1;
+    while (i <= j)
+    {
+      int b = udMin(BinCount - 1, (int)((pCentroids[pOrder[i]][bestAxis] - centroidMin[bestAxis]) * scale));
+      if (b <= bestSplit)
+      {
+        ++i;
+      }
+      else
+      {
+        int temp = pOrder[i];
+        pOrder[i] = pOrder[j];
+        pOrder[j] = temp;
+        --j;
+      }
+    }
+
+    int left = nodeCount;
+    nodeCount += 2;
+
+    pNodes[left].leftFirst = first;
+    pNodes[left].itemCount = i - first;
+    pNodes[left + 1].leftFirst = i;
+    pNodes[left + 1].itemCount = count - (i - first);
+
+    pNode->leftFirst = left;
+    pNode->itemCount = 0;
+
+    pDepths[left] = pDepths[nodeIndex] + 1;
+    pDepths[left + 1] = pDepths[nodeIndex] + 1;
+
+    pStack[stackSize++] = left + 1;
+    pStack[stackSize++] = left;
+  }
+
+  udFree(pStack);
+  udFree(pDepths);
+  udFree(pCentroids);
+
+  *ppNodes = pNodes;
+  *ppOrder = pOrder;
+  *pMaxDepth = maxDepth;
+
+  return nodeCount;
+}
+
+// Returns the entry distance or FLT_MAX if the ray misses the box before maxT
+float vcGLTF_RayBoundsDistance(const udFloat3 &origin, const udFloat3 &invDirection, const udFloat3 &boundsMin, const udFloat3 &boundsMax, float maxT)
+{
+  float tMin = 0.f;
+  float tMax = maxT;
+
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    float t0 = (boundsMin[axis] - origin[axis]) * invDirection[axis];
+    float t1 = (boundsMax[axis] - origin[axis]) * invDirection[axis];
+
+    tMin = udMax(tMin, udMin(t0, t1));
+    tMax = udMin(tMax, udMax(t0, t1));
+  }
+
+  return (tMin <= tMax) ? tMin : FLT_MAX;
+}
+
+udFloat3 vcGLTF_SafeInverseDirection(const udFloat3 &direction)
+{
+  udFloat3 inverse;
+  for (int axis = 0; axis < 3; ++axis)
+    inverse[axis] = (direction[axis] != 0.f) ? 1.f / direction[axis] : FLT_MAX;
+
+  return inverse;
+}
+
+// Moller-Trumbore; returns the distance along the ray or FLT_MAX
+float vcGLTF_RayTriangleDistance(const udFloat3 &origin, const udFloat3 &direction, const vcGLTFBVHTriangle &triangle)
+{
+  udFloat3 p = udCross3(direction, triangle.edge2);
+  float determinant = udDot3(triangle.edge1, p);
+
+  if (udAbs(determinant) < 1e-12f)
+    return FLT_MAX;
+
+  float invDeterminant = 1.f / determinant;
+  udFloat3 toOrigin = origin - triangle.v0;
+
+  float u = udDot3(toOrigin, p) * invDeterminant;
+  if (u < 0.f || u > 1.f)
+    return FLT_MAX;
+
+  udFloat3 q = udCross3(toOrigin, triangle.edge1);
+  float v = udDot3(direction, q) * invDeterminant;
+  if (v < 0.f || u + v > 1.f)
+    return FLT_MAX;
+
+  float t = udDot3(triangle.edge2, q) * invDeterminant;
+  return (t >= 0.f) ? t : FLT_MAX;
+}
+
+bool vcGLTF_RaycastBVH(const vcGLTFBVH &bvh, const udFloat3 &origin, const udFloat3 &direction, float *pClosestT, int *pTriangleIndex)
+{
+  if (bvh.nodeCount == 0)
+    return false;
+
+  udFloat3 invDirection = vcGLTF_SafeInverseDirection(direction);
+  bool hit = false;
+
+  // Deep (degenerate) trees get a stack from the heap
+  int localStack[128];
+  int *pStack = localStack;
+  if (bvh.maxDepth + 1 > (int)udLengthOf(localStack))
+    pStack = udAllocType(int, bvh.maxDepth + 1, udAF_None);
+
+  int stackSize = 0;
+
+  if (pStack != nullptr && vcGLTF_RayBoundsDistance(origin, invDirection, bvh.pNodes[0].boundsMin, bvh.pNodes[0].boundsMax, *pClosestT) != FLT_MAX)
+    pStack[stackSize++] = 0;
+
+  while (stackSize > 0)
+  {
+    const vcGLTFBVHNode &node = bvh.pNodes[pStack[--stackSize]];
+
+    if (node.itemCount > 0)
+    {
+      for (int i = node.leftFirst; i < node.leftFirst + node.itemCount; ++i)
+      {
+        float t = vcGLTF_RayTriangleDistance(origin, direction, bvh.pTriangles[i]);
+        if (t < *pClosestT)
+        {
+          *pClosestT = t;
+          *pTriangleIndex = i;
+          hit = true;
+        }
+      }
+      continue;
+    }
+
+    float leftT = vcGLTF_RayBoundsDistance(origin, invDirection, bvh.pNodes[node.leftFirst].boundsMin, bvh.pNodes[node.leftFirst].boundsMax, *pClosestT);
+    float rightT = vcGLTF_RayBoundsDistance(origin, invDirection, bvh.pNodes[node.leftFirst + 1].boundsMin, bvh.pNodes[node.leftFirst + 1].boundsMax, *pClosestT);
+
+    // Push the far child first so the near child is visited first
+    if (leftT <= rightT)
+    {
+      if (rightT != FLT_MAX)
+        pStack[stackSize++] = node.leftFirst + 1;
+      if (leftT != FLT_MAX)
+        pStack[stackSize++] = node.leftFirst;
+    }
+    else
+    {
+      if (leftT != FLT_MAX)
+        pStack[stackSize++] = node.leftFirst;
+      if (rightT != FLT_MAX)
+        pStack[stackSize++] = node.leftFirst + 1;
+    }
+  }
+
+  if (pStack != localStack)
+    udFree(pStack);
+
+  return hit;
+}
+
+struct vcGLTFQuadric
+{
+  double a2, ab, ac, ad, b2, bc, bd, c2, cd, d2;
+};
+
+void vcGLTF_QuadricAdd(vcGLTFQuadric *pQuadric, const vcGLTFQuadric &other)
+{
+  pQuadric->a2 += other.a2; pQuadric->ab += other.ab; pQuadric->ac += other.ac; pQuadric->ad += other.ad;
+  pQuadric->b2 += other.b2; pQuadric->bc += other.bc; pQuadric->bd += other.bd;
+  pQuadric->c2 += other.c2; pQuadric->cd += other.cd;
+  pQuadric->d2 += other.d2;
+}
+
+double vcGLTF_QuadricError(const vcGLTFQuadric &q, const udFloat3 &p)
+{
+  double x = p.x, y = p.y, z = p.z;
+  double error = q.a2 * x * x + 2 * q.ab * x * y + 2 * q.ac * x * z + 2 * q.ad * x + q.b2 * y * y + 2 * q.bc * y * z + 2 * q.bd * y + q.c2 * z * z + 2 * q.cd * z + q.d2;
+  return udMax(error, 0.0);
+}
+
+struct vcGLTFCollapse
+{
+  float cost;
+  uint32_t from;
+  uint32_t to;
+};
+
+int vcGLTF_CompareCollapse(const void *pA, const void *pB)
+{
+  float a = ((const vcGLTFCollapse*)pA)->cost;
+  float b = ((const vcGLTFCollapse*)pB)->cost;
+  return (a < b) ? -1 : ((a > b) ? 1 : 0);
+}
+
+// Quadric error metric edge collapse (Garland & Heckbert). Vertices only ever collapse onto other existing vertices so the
+// result indexes the original vertex buffer. Boundary vertices (including attribute seams, which are boundaries in the index
+// topology) are locked. Returns the new index count written to pDestination which must hold indexCount indices.
+int vcGLTF_SimplifyIndices(uint32_t *pDestination, const uint32_t *pIndices, int indexCount, const uint8_t *pPositions, uint32_t positionStride, int vertexCount, int targetIndexCount, float maxError)
+{
+#define VCGLTF_POSITION(i) (*(const udFloat3*)(pPositions + (size_t)positionStride * (i)))
+
+  memcpy(pDestination, pIndices, sizeof(uint32_t) * indexCount);
+  int resultCount = indexCount;
+
+  vcGLTFQuadric *pQuadrics = udAllocType(vcGLTFQuadric, vertexCount, udAF_Zero);
+  uint8_t *pLocked = udAllocType(uint8_t, vertexCount, udAF_Zero);
+  uint8_t *pTouched = udAllocType(uint8_t, vertexCount, udAF_Zero);
+  uint32_t *pAdjacencyOffsets = udAllocType(uint32_t, vertexCount + 1, udAF_Zero);
+  uint32_t *pAdjacency = udAllocType(uint32_t, indexCount, udAF_None);
+  vcGLTFCollapse *pCollapses = udAllocType(vcGLTFCollapse, indexCount, udAF_None);
+
+  // Plane quadrics
+  for (int t = 0; t < indexCount; t += 3)
+  {
+    udFloat3 p0 = VCGLTF_POSITION(pIndices[t + 0]);
+    udFloat3 normal = udCross3(VCGLTF_POSITION(pIndices[t + 1]) - p0, VCGLTF_POSITION(pIndices[t + 2]) - p0);
+    float length = udMag3(normal);
+    if (length <= 0.f)
+      continue;
+
+    normal = normal / length;
+
+    vcGLTFQuadric q;
+    double a = normal.x, b = normal.y, c = normal.z, d = -udDot3(normal, p0);
+    q.a2 = a * a; q.ab = a * b; q.ac = a * c; q.ad = a * d;
+    q.b2 = b * b; q.bc = b * c; q.bd = b * d;
+    q.c2 = c * c; q.cd = c * d;
+    q.d2 = d * d;
+
+    for (int k = 0; k < 3; ++k)
+      vcGLTF_QuadricAdd(&pQuadrics[pIndices[t + k]], q);
+  }
+
+  // Edges used by a single triangle are boundaries
+  {
+    uint32_t tableSize = 1;
+    while (tableSize < (uint32_t)indexCount * 2)
+      tableSize <<= 1;
+
+    uint64_t *pKeys = udAllocType(uint64_t, tableSize, udAF_None);
+    uint32_t *pCounts = udAllocType(uint32_t, tableSize, udAF_Zero);
+    memset(pKeys, 0xFF, sizeof(uint64_t) * tableSize);
+
+    for (int pass = 0; pass < 2; ++pass)
+    {
+      for (int i = 0; i < indexCount; ++i)
+      {
+        uint32_t a = pIndices[i];
+        uint32_t b = pIndices[(i % 3 == 2) ? i - 2 : i + 1];
+        uint64_t key = (a < b) ? ((uint64_t(a) << 32) | b) : ((uint64_t(b) << 32) | a);
+        uint32_t slot = (uint32_t)((key * 0x9E3779B97F4A7C15ULL) >> 32) & (tableSize - 1);
+
+        while (pKeys[slot] != key && pKeys[slot] != UINT64_MAX)
+          slot = (slot + 1) & (tableSize - 1);
+
+        if (pass == 0)
+        {
+          pKeys[slot] = key;
+          ++pCounts[slot];
+        }
+        else if (pCounts[slot] == 1)
+        {
+          pLocked[a] = 1;
+          pLocked[b] = 1;
+        }
+      }
+    }
+
+    udFree(pKeys);
+    udFree(pCounts);
+  }
+
+  double maxErrorSq = (double)maxError * maxError;
+
+  while (resultCount > targetIndexCount)
+  {
+    // Cheapest legal direction for every edge
+    int collapseCount = 0;
+    for (int i = 0; i < resultCount; ++i)
+    {
+      uint32_t a = pDestination[i];
+      uint32_t b = pDestination[(i % 3 == 2) ? i - 2 : i + 1];
+
+      vcGLTFQuadric q = pQuadrics[a];
+      vcGLTF_QuadricAdd(&q, pQuadrics[b]);
+
+      double costAB = pLocked[a] ? DBL_MAX : vcGLTF_QuadricError(q, VCGLTF_POSITION(b));
+      double costBA = pLocked[b] ? DBL_MAX : vcGLTF_QuadricError(q, VCGLTF_POSITION(a));
+
+      if (costAB == DBL_MAX && costBA == DBL_MAX)
+        continue;
+
+      vcGLTFCollapse *pCollapse = &pCollapses[collapseCount++];
+      pCollapse->cost = (float)udMin(costAB, costBA);
+      pCollapse->from = (costAB <= costBA) ? a : b;
+      pCollapse->to = (costAB <= costBA) ? b : a;
+    }
+
+    if (collapseCount == 0)
+      break;
+
+    qsort(pCollapses, collapseCount, sizeof(vcGLTFCollapse), vcGLTF_CompareCollapse);
+
+    // Vertex to triangle adjacency for the flip test
+    memset(pAdjacencyOffsets, 0, sizeof(uint32_t) * (vertexCount + 1));
+    for (int i = 0; i < resultCount; ++i)
+      ++pAdjacencyOffsets[pDestination[i] + 1];
+    for (int v = 0; v < vertexCount; ++v)
+      pAdjacencyOffsets[v + 1] += pAdjacencyOffsets[v];
+    for (int i = 0; i < resultCount; ++i)
+      pAdjacency[pAdjacencyOffsets[pDestination[i]]++] = (uint32_t)(i / 3);
+    for (int v = vertexCount; v > 0; --v)
+      pAdjacencyOffsets[v] = pAdjacencyOffsets[v - 1];
+    pAdjacencyOffsets[0] = 0;
+
+    memset(pTouched, 0, vertexCount);
+
+    // Each collapse removes roughly two triangles
+    int collapseLimit = udMax(1, (resultCount - targetIndexCount) / 6);
+    int collapsed = 0;
+
+    for (int c = 0; c < collapseCount && collapsed < collapseLimit; ++c)
+    {
+      const vcGLTFCollapse &collapse = pCollapses[c];
+
+      if (collapse.cost > maxErrorSq)
+        break;
+
+      if (pTouched[collapse.from] || pTouched[collapse.to])
+        continue;
+
+      udFloat3 target = VCGLTF_POSITION(collapse.to);
+      bool flips = false;
+
+      for (uint32_t adj = pAdjacencyOffsets[collapse.from]; adj < pAdjacencyOffsets[collapse.from + 1] && !flips; ++adj)
+      {
+        const uint32_t *pTri = &pDestination[pAdjacency[adj] * 3];
+        if (pTri[0] == collapse.to || pTri[1] == collapse.to || pTri[2] == collapse.to)
+          continue; // This triangle disappears
+
+        udFloat3 before[3], after[3];
+        for (int k = 0; k < 3; ++k)
+        {
+          before[k] = VCGLTF_POSITION(pTri[k]);
+          after[k] = (pTri[k] == collapse.from) ? target : before[k];
+        }
+
+        udFloat3 normalBefore = udCross3(before[1] - before[0], before[2] - before[0]);
+        udFloat3 normalAfter = udCross3(after[1] - after[0], after[2] - after[0]);
+
+        if (udDot3(normalBefore, normalAfter) <= 0.f)
+          flips = true;
+      }
+
+      if (flips)
+        continue;
+
+      // Neighbours of the removed vertex can't collapse again this pass since their triangles changed
+      for (uint32_t adj = pAdjacencyOffsets[collapse.from]; adj < pAdjacencyOffsets[collapse.from + 1]; ++adj)
+      {
+        const uint32_t *pTri = &pDestination[pAdjacency[adj] * 3];
+        pTouched[pTri[0]] = pTouched[pTri[1]] = pTouched[pTri[2]] = 1;
+      }
+
+      vcGLTF_QuadricAdd(&pQuadrics[collapse.to], pQuadrics[collapse.from]);
+
+      for (uint32_t adj = pAdjacencyOffsets[collapse.from]; adj < pAdjacencyOffsets[collapse.from + 1]; ++adj)
+      {
+        uint32_t *pTri = &pDestination[pAdjacency[adj] * 3];
+        for (int k = 0; k < 3; ++k)
+        {
+          if (pTri[k] == collapse.from)
+            pTri[k] = collapse.to;
+        }
+      }
+
+      ++collapsed;
+    }
+
+    if (collapsed == 0)
+      break;
+
+    // Remove degenerate triangles
+    int writeIndex = 0;
+    for (int i = 0; i < resultCount; i += 3)
+    {
+      uint32_t a = pDestination[i], b = pDestination[i + 1], c = pDestination[i + 2];
+      if (a == b || b == c || a == c)
+        continue;
+
+      pDestination[writeIndex++] = a;
+      pDestination[writeIndex++] = b;
+      pDestination[writeIndex++] = c;
+    }
+
+    resultCount = writeIndex;
+  }
+
+  udFree(pQuadrics);
+  udFree(pLocked);
+  udFree(pTouched);
+  udFree(pAdjacencyOffsets);
+  udFree(pAdjacency);
+  udFree(pCollapses);
+
+#undef VCGLTF_POSITION
+
+  return resultCount;
+}
+
+// Bytes per component of an accessor componentType
+int vcGLTF_ComponentSize(vcGLTFTypes componentType)
+{
+  switch (componentType)
+  {
+  case vcGLTFType_Int8:
+  case vcGLTFType_UInt8:
+    return 1;
+  case vcGLTFType_Int16:
+  case vcGLTFType_UInt16:
+    return 2;
+  case vcGLTFType_F64:
+    return 8;
+  default:
+    return 4;
+  }
+}
+
+// Only reads the scene so it's safe on the worker pool; the buffer must already be loaded (vcGLTF_LoadAccessorBuffer)
+udResult vcGLTF_DecodeAccessor(const vcGLTFScene *pScene, int attributeAccessorIndex, int *pTotalOffset, int readCount, uint8_t *pPtr, int stride, int64_t *pBytesDecoded, vcVertexLayoutTypes layoutType = vcVLT_TotalTypes)
+{
+  udResult result = udR_Success;
+
+  const vcGLTFAccessor &accessor = vcGLTF_GetAccessor(pScene, attributeAccessorIndex);
+  const vcGLTFBufferView &bufferView = vcGLTF_GetBufferView(pScene, accessor.bufferView);
+
+  int bufferID = bufferView.buffer;
+  if (bufferID <= -1)
+    __debugbreak();
+
+  const char* pAccessorType = accessor.type;
+  vcGLTFTypes accessorComponentType = (vcGLTFTypes)accessor.componentType;
+  ptrdiff_t byteOffset = accessor.byteOffset + bufferView.byteOffset;
+  ptrdiff_t byteStride = accessor.byteStride + bufferView.byteStride;
+
+  int count = 3;
+  int offset = *pTotalOffset;
+
+  if (layoutType == vcVLT_ColourBGRA)
+  {
+    if (udStrEqual(pAccessorType, "VEC3"))
+      count = 3;
+    else
+      count = 4;
+    *pTotalOffset += sizeof(uint32_t);
+  }
+  else if (layoutType == vcVLT_BoneIDs)
+  {
+    count = 4;
+    *pTotalOffset += sizeof(uint32_t);
+  }
+  else if (udStrEqual(pAccessorType, "VEC3"))
+  {
+    count = 3;
+    *pTotalOffset += (count * sizeof(float));
+  }
+  else if (udStrEqual(pAccessorType, "VEC2"))
+  {
+    count = 2;
+    *pTotalOffset += (count * sizeof(float));
+  }
+  else if (udStrEqual(pAccessorType, "VEC4"))
+  {
+    count = 4;
+    *pTotalOffset += (count * sizeof(float));
+  }
+  else if (udStrEqual(pAccessorType, "SCALAR"))
+  {
+    count = 1;
+    *pTotalOffset += (count * sizeof(float));
+  }
+  else if (udStrEqual(pAccessorType, "MAT4"))
+  {
+    count = 16;
+    *pTotalOffset += (count * sizeof(float));
+  }
+  else
+  {
+    __debugbreak();
+  }
+
+  if (bufferID < 0 || bufferID >= pScene->bufferCount)
+    __debugbreak();
+
+  if (bufferID < 0 || bufferID >= pScene->bufferCount || pScene->pBuffers[bufferID].pBytes == nullptr)
+    return udR_ReadFailure;
+
+  if (byteStride == 0)
+  {
+    if (accessorComponentType == vcGLTFType_F32)
+      byteStride = count * sizeof(float);
+    else if (accessorComponentType == vcGLTFType_Int16 || accessorComponentType == vcGLTFType_UInt16)
+      byteStride = count * sizeof(uint16_t);
+    else
+      __debugbreak();
+  }
+
+  if (stride == 0)
+    stride = (int)byteStride;
+
+  *pBytesDecoded += (int64_t)readCount * count * vcGLTF_ComponentSize(accessorComponentType);
+
+  if (layoutType == vcVLT_ColourBGRA)
+  {
+    for (int vi = 0; vi < readCount; ++vi)
+    {
+      float *pFloats = (float*)(pScene->pBuffers[bufferID].pBytes + byteOffset + vi * byteStride);
+      int32_t *pVertI32 = (int32_t*)(pPtr + stride * vi + offset);
+
+      uint32_t temp = ((int(udRound(pFloats[0] * 255.f)) & 0xFF) << 0) | ((int(udRound(pFloats[1] * 255.f)) & 0xFF) << 8) | ((int(udRound(pFloats[2] * 255.f)) & 0xFF) << 16);
+
+      if (count == 3)
+        temp |= 0xFF000000;
+      else
+        temp |= (int(pFloats[3] * 255.f) << 24);
+
+      pVertI32[0] = temp;
+    }
+  }
+  else if (layoutType == vcVLT_BoneIDs)
+  {
+    for (int vi = 0; vi < readCount; ++vi)
+    {
+      uint16_t *pIDs = (uint16_t*)(pScene->pBuffers[bufferID].pBytes + byteOffset + vi * byteStride);
+      uint32_t *pVertI32 = (uint32_t*)(pPtr + stride * vi + offset);
+
+      *pVertI32 = ((pIDs[3] & 0xFF) << 24) | ((pIDs[2] & 0xFF) << 16) | ((pIDs[1] & 0xFF) << 8) | ((pIDs[0] & 0xFF) << 0);
+    }
+  }
+  else
+  {
+    for (int vi = 0; vi < readCount; ++vi)
+    {
+      float *pFloats = (float*)(pScene->pBuffers[bufferID].pBytes + byteOffset + vi * byteStride);
+      float *pVertFloats = (float*)(pPtr + stride * vi + offset);
+
+      for (int element = 0; element < count; ++element)
+      {
+        pVertFloats[element] = pFloats[element];
+      }
+    }
+  }
+
+  return result;
+}
+
+// Failures are left for the decode to report as udR_ReadFailure
+void vcGLTF_LoadAccessorBuffer(vcGLTFScene *pScene, int accessorIndex)
+{
+  const vcGLTFAccessor &accessor = vcGLTF_GetAccessor(pScene, accessorIndex);
+  if (accessor.bufferView < 0 || accessor.bufferView >= pScene->bufferViewCount)
+    return;
+
+  int bufferID = vcGLTF_GetBufferView(pScene, accessor.bufferView).buffer;
+  if (bufferID >= 0 && bufferID < pScene->bufferCount && pScene->pBuffers[bufferID].pBytes == nullptr)
+    vcGLTF_LoadBuffer(pScene, bufferID);
+}
+
+// Loads every buffer the mesh's primitives read, so decoding them never writes to the scene
+void vcGLTF_LoadMeshBuffers(vcGLTFScene *pScene, int meshID)
+{
+  const vcGLTFMesh &mesh = pScene->pMeshes[meshID];
+
+  for (int i = 0; i < mesh.primitiveDescCount; ++i)
+  {
+    const vcGLTFPrimitiveDesc &primitive = mesh.pPrimitiveDescs[i];
+
+    if (primitive.indices != -1)
+      vcGLTF_LoadAccessorBuffer(pScene, primitive.indices);
+
+    for (int j = 0; j < primitive.attributeCount; ++j)
+      vcGLTF_LoadAccessorBuffer(pScene, primitive.pAttributes[j].accessor);
+  }
+}
+
+// Animations and skins read their accessors on the loading thread, loading buffers as they go
+udResult vcGLTF_ReadAccessor(vcGLTFScene *pScene, int accessorIndex, int *pTotalOffset, int readCount, uint8_t *pPtr, int stride)
+{
+  vcGLTF_LoadAccessorBuffer(pScene, accessorIndex);
+  return vcGLTF_DecodeAccessor(pScene, accessorIndex, pTotalOffset, readCount, pPtr, stride, &pScene->loadStats.accessorBytesDecoded);
+}
+
+// The factors were read by vcGLTF_ParseMaterial; only the textures are left
+udResult vcGLTF_LoadMaterial(vcGLTFScene *pScene, const vcGLTFDocument &document, int material)
+{
+  // The default material (for files without any) has no textures
+  if (document.pMaterials != nullptr && material >= 0 && material < pScene->materialCount)
+  {
+    vcGLTFMaterial *pMat = &pScene->pMaterials[material];
+    const vcGLTFMaterialDesc &desc = document.pMaterials[material];
+
+    if (desc.baseColorTexture != -1)
+      vcGLTF_LoadTexture(pScene, document, desc.baseColorTexture, &pMat->pBaseColorTexture);
+
+    if (desc.metallicRoughnessTexture != -1)
+      vcGLTF_LoadTexture(pScene, document, desc.metallicRoughnessTexture, &pMat->pMetallicRoughnessTexture);
+
+    if (desc.normalTexture != -1)
+      vcGLTF_LoadTexture(pScene, document, desc.normalTexture, &pMat->pNormalTexture);
+
+    if (desc.emissiveTexture != -1)
+      vcGLTF_LoadTexture(pScene, document, desc.emissiveTexture, &pMat->pEmissiveTexture);
+
+    if (desc.occlusionTexture != -1)
+      vcGLTF_LoadTexture(pScene, document, desc.occlusionTexture, &pMat->pOcclusionTexture);
+  }
+
+  return udR_Success;
+}
+
+bool vcGLTF_DepthNeedsAlphaTest(const vcGLTFMeshPrimitive &prim)
+{
+  return prim.pMaterial->alphaMode == vcGLTFAM_Mask && prim.pMaterial->pBaseColorTexture != nullptr && prim.pMaterial->baseColorUVSet == 0 && (prim.features & vcRSB_UVSet0);
+}
+
+// The depth shaders only cut out with the base colour texture's alpha on UV set 0, so alpha masked primitives using any other
+// alpha (another UV set, vertex colour or just the factor) would write depth where the shading pass discards
+bool vcGLTF_DepthMatchesShading(const vcGLTFMeshPrimitive &prim)
+{
+  if (prim.pMaterial->alphaMode != vcGLTFAM_Mask)
+    return true;
+
+  return vcGLTF_DepthNeedsAlphaTest(prim) && (prim.features & vcRSB_Colour) == 0;
+}
+
+// Material bits are derived each time they're needed so edits through vcGLTF_GetMaterial pick the matching variant
+int vcGLTF_GetMaterialFeatures(const vcGLTFMaterial *pMaterial)
+{
+  int features = vcRSB_None;
+
+  if (pMaterial->pBaseColorTexture != nullptr)
+    features |= vcRSB_BaseColorMap;
+
+  if (pMaterial->alphaMode == vcGLTFAM_Mask)
+    features |= vcRSB_AlphaMask;
+  else if (pMaterial->alphaMode == vcGLTFAM_Blend)
+    features |= vcRSB_AlphaBlend;
+
+  // Unlit materials ignore everything but the base colour
+  if (pMaterial->unlit)
+    return features | vcRSB_Unlit;
+
+  if (pMaterial->pMetallicRoughnessTexture != nullptr)
+    features |= vcRSB_MetallicRoughnessMap;
+  if (pMaterial->pNormalTexture != nullptr)
+    features |= vcRSB_NormalMap;
+  if (pMaterial->pEmissiveTexture != nullptr)
+    features |= vcRSB_EmissiveMap;
+  if (pMaterial->pOcclusionTexture != nullptr)
+    features |= vcRSB_OcclusionMap;
+
+  return features;
+}
+
+// The joint bounds are udAlloc'd as this runs on the worker pool for streamed meshes; vcGLTF_UploadPrimitive moves them into the arena
+void vcGLTF_CalculatePrimitiveBounds(vcGLTFMeshPrimitive *pPrimitive, const vcGLTFAccessor &positionAccessor, const vcVertexLayoutTypes *pTypes, int totalTypes, const uint8_t *pVertData, uint32_t vertexStride, int vertexCount)
+{
+  int positionOffset = vcGLTF_GetLayoutOffset(pTypes, totalTypes, vcVLT_Position3);
+  int jointOffset = vcGLTF_GetLayoutOffset(pTypes, totalTypes, vcVLT_BoneIDs);
+  int weightOffset = vcGLTF_GetLayoutOffset(pTypes, totalTypes, vcVLT_BoneWeights);
+
+  pPrimitive->localMin = udFloat3::create(FLT_MAX);
+  pPrimitive->localMax = udFloat3::create(-FLT_MAX);
+
+  if (positionOffset == -1)
+    return;
+
+  // The spec requires min & max on POSITION but not every exporter writes them
+  if (positionAccessor.hasBounds)
+  {
+    pPrimitive->localMin = positionAccessor.min;
+    pPrimitive->localMax = positionAccessor.max;
+  }
+  else
+  {
+    for (int vi = 0; vi < vertexCount; ++vi)
+    {
+      const float *pPosition = (const float*)(pVertData + vertexStride * vi + positionOffset);
+      udFloat3 position = udFloat3::create(pPosition[0], pPosition[1], pPosition[2]);
+      vcGLTF_ExpandBounds(&pPrimitive->localMin, &pPrimitive->localMax, position, position);
+    }
+  }
+
+  if (jointOffset == -1 || weightOffset == -1)
+    return;
+
+  // Skinned vertices are a weighted blend of their joint transforms so they stay inside the union of each joint's transformed bounds
+  int maxJoint = -1;
+  for (int vi = 0; vi < vertexCount; ++vi)
+  {
+    uint32_t joints = *(const uint32_t*)(pVertData + vertexStride * vi + jointOffset);
+    const float *pWeights = (const float*)(pVertData + vertexStride * vi + weightOffset);
+
+    for (int k = 0; k < 4; ++k)
+    {
+      if (pWeights[k] > 0.f)
+        maxJoint = udMax(maxJoint, (int)((joints >> (k * 8)) & 0xFF));
+    }
+  }
+
+  if (maxJoint == -1)
+    return;
+
+  pPrimitive->pJointBounds = udAllocType(udFloat3, (maxJoint + 1) * 2, udAF_None);
+  if (pPrimitive->pJointBounds == nullptr)
+    return;
+
+  pPrimitive->jointBoundCount = maxJoint + 1;
+
+  for (int j = 0; j < pPrimitive->jointBoundCount; ++j)
+  {
+    pPrimitive->pJointBounds[j * 2 + 0] = udFloat3::create(FLT_MAX);
+    pPrimitive->pJointBounds[j * 2 + 1] = udFloat3::create(-FLT_MAX);
+  }
+
+  for (int vi = 0; vi < vertexCount; ++vi)
+  {
+    const float *pPosition = (const float*)(pVertData + vertexStride * vi + positionOffset);
+    uint32_t joints = *(const uint32_t*)(pVertData + vertexStride * vi + jointOffset);
+    const float *pWeights = (const float*)(pVertData + vertexStride * vi + weightOffset);
+
+    udFloat3 position = udFloat3::create(pPosition[0], pPosition[1], pPosition[2]);
+
+    for (int k = 0; k < 4; ++k)
+    {
+      if (pWeights[k] > 0.f)
+      {
+        int joint = (joints >> (k * 8)) & 0xFF;
+        vcGLTF_ExpandBounds(&pPrimitive->pJointBounds[joint * 2 + 0], &pPrimitive->pJointBounds[joint * 2 + 1], position, position);
+      }
+    }
+  }
+}
+
+void vcGLTF_GatherBVHTriangles(vcGLTFBVH *pBVH, int primitiveID, const uint8_t *pVertData, uint32_t vertexStride, int positionOffset, int vertexCount, const void *pIndices, int indexCount, bool shortIndices)
+{
+  if (positionOffset == -1)
+    return;
+
+  int triangleCount = ((pIndices != nullptr) ? indexCount : vertexCount) / 3;
+  if (triangleCount == 0)
+    return;
+
+  pBVH->pTriangles = udReallocType(pBVH->pTriangles, vcGLTFBVHTriangle, pBVH->triangleCount + triangleCount);
+
+  for (int t = 0; t < triangleCount; ++t)
+  {
+    udFloat3 corners[3];
+
+    for (int c = 0; c < 3; ++c)
+    {
+      int index = t * 3 + c;
+      if (pIndices != nullptr)
+        index = shortIndices ? ((const uint16_t*)pIndices)[index] : ((const int32_t*)pIndices)[index];
+
+      const float *pPosition = (const float*)(pVertData + vertexStride * index + positionOffset);
+      corners[c] = udFloat3::create(pPosition[0], pPosition[1], pPosition[2]);
+    }
+
+    vcGLTFBVHTriangle *pTriangle = &pBVH->pTriangles[pBVH->triangleCount + t];
+    pTriangle->v0 = corners[0];
+    pTriangle->edge1 = corners[1] - corners[0];
+    pTriangle->edge2 = corners[2] - corners[0];
+    pTriangle->primitiveID = primitiveID;
+    pTriangle->triangleID = t;
+  }
+
+  pBVH->triangleCount += triangleCount;
+}
+
+void vcGLTF_BuildMeshBVH(vcGLTFMesh *pMesh)
+{
+  vcGLTFTraceScope traceScope("Build mesh BVH");
+  vcGLTFBVH *pBVH = &pMesh->bvh;
+
+  if (pBVH->triangleCount > 0)
+  {
+    udFloat3 *pTriangleMin = udAllocType(udFloat3, pBVH->triangleCount, udAF_None);
+    udFloat3 *pTriangleMax = udAllocType(udFloat3, pBVH->triangleCount, udAF_None);
+
+    for (int i = 0; i < pBVH->triangleCount; ++i)
+    {
+      const vcGLTFBVHTriangle &triangle = pBVH->pTriangles[i];
+      udFloat3 v1 = triangle.v0 + triangle.edge1;
+      udFloat3 v2 = triangle.v0 + triangle.edge2;
+
+      pTriangleMin[i] = udMin(triangle.v0, udMin(v1, v2));
+      pTriangleMax[i] = udMax(triangle.v0, udMax(v1, v2));
+    }
+
+    int *pOrder = nullptr;
+    pBVH->nodeCount = vcGLTF_BuildBVH(pTriangleMin, pTriangleMax, pBVH->triangleCount, 4, &pBVH->pNodes, &pOrder, &pBVH->maxDepth);
+
+    // Store the triangles in leaf order so leaves index them directly
+    vcGLTFBVHTriangle *pOrdered = udAllocType(vcGLTFBVHTriangle, pBVH->triangleCount, udAF_None);
+    for (int i = 0; i < pBVH->triangleCount; ++i)
+      pOrdered[i] = pBVH->pTriangles[pOrder[i]];
+
+    udFree(pBVH->pTriangles);
+    pBVH->pTriangles = pOrdered;
+
+    udFree(pOrder);
+    udFree(pTriangleMin);
+    udFree(pTriangleMax);
+  }
+
+  udInterlockedExchange(&pMesh->bvhReady, 1);
+}
+
+struct vcGLTFBVHBuildTask
+{
+  vcGLTFScene *pScene;
+  vcGLTFMesh *pMesh;
+};
+
+void vcGLTF_BuildMeshBVHTask(void *pData)
+{
+  vcGLTFBVHBuildTask *pTask = (vcGLTFBVHBuildTask*)pData;
+
+  vcGLTF_BuildMeshBVH(pTask->pMesh);
+  udInterlockedPreDecrement(&pTask->pScene->pendingTasks);
+}
+
+void vcGLTF_QueueMeshBVH(vcGLTFScene *pScene, vcGLTFMesh *pMesh)
+{
+  if (pScene->pWorkerPool != nullptr)
+  {
+    vcGLTFBVHBuildTask *pTask = udAllocType(vcGLTFBVHBuildTask, 1, udAF_Zero);
+    pTask->pScene = pScene;
+    pTask->pMesh = pMesh;
+
+    udInterlockedPreIncrement(&pScene->pendingTasks);
+
+    if (udWorkerPool_AddTask(pScene->pWorkerPool, vcGLTF_BuildMeshBVHTask, pTask, true) == udR_Success)
+      return;
+
+    udInterlockedPreDecrement(&pScene->pendingTasks);
+    udFree(pTask);
+  }
+
+  vcGLTF_BuildMeshBVH(pMesh);
+}
+
+// Returns a new index buffer (same index size as the source) holding the full detail indices followed by each LOD, or nullptr if simplification didn't help
+void *vcGLTF_GenerateLODChain(vcGLTFMeshPrimitive *pPrimitive, const void *pIndices, int *pIndexCount, bool shortIndices, const uint8_t *pVertData, uint32_t vertexStride, int positionOffset, int vertexCount)
+{
+  int indexCount = *pIndexCount;
+
+  if (positionOffset == -1 || indexCount < 3 * 64 || !vcGLTF_BoundsValid(pPrimitive->localMin, pPrimitive->localMax))
+    return nullptr;
+
+  float diagonal = udMag3(pPrimitive->localMax - pPrimitive->localMin);
+
+  uint32_t *pLODIndices = udAllocType(uint32_t, indexCount * vcGLTFLimit_LODCount, udAF_None);
+  for (int i = 0; i < indexCount; ++i)
+    pLODIndices[i] = shortIndices ? ((const uint16_t*)pIndices)[i] : ((const uint32_t*)pIndices)[i];
+
+  pPrimitive->lodIndexStart[0] = 0;
+  pPrimitive->lodIndexCount[0] = indexCount;
+  pPrimitive->lodCount = 1;
+
+  int totalIndices = indexCount;
+
+  // Each level halves the previous one and is allowed twice the geometric error
+  for (int lod = 1; lod < vcGLTFLimit_LODCount; ++lod)
+  {
+    int sourceCount = pPrimitive->lodIndexCount[lod - 1];
+    int targetCount = (sourceCount / 2) / 3 * 3;
+    float maxError = diagonal * 0.005f * (float)(1 << lod);
+
+    int lodCount = vcGLTF_SimplifyIndices(&pLODIndices[totalIndices], &pLODIndices[pPrimitive->lodIndexStart[lod - 1]], sourceCount, pVertData + positionOffset, vertexStride, vertexCount, targetCount, maxError);
+
+    // Not worth another level unless it removes at least a quarter of the triangles
+    if (lodCount == 0 || lodCount > sourceCount * 3 / 4)
+      break;
+
+    pPrimitive->lodIndexStart[lod] = totalIndices;
+    pPrimitive->lodIndexCount[lod] = lodCount;
+    pPrimitive->lodCount = lod + 1;
+    totalIndices += lodCount;
+  }
+
+  if (pPrimitive->lodCount == 1)
+  {
+    pPrimitive->lodCount = 0;
+    udFree(pLODIndices);
+    return nullptr;
+  }
+
+  void *pResult = pLODIndices;
+
+  if (shortIndices)
+  {
+    uint16_t *pShortIndices = udAllocType(uint16_t, totalIndices, udAF_None);
+    for (int i = 0; i < totalIndices; ++i)
+      pShortIndices[i] = (uint16_t)pLODIndices[i];
+
+    udFree(pLODIndices);
+    pResult = pShortIndices;
+  }
+
+  *pIndexCount = totalIndices;
+  return pResult;
+}
+
+// Reads one corner of the triangle list built by vcGLTF_GenerateTangents for MikkTSpace
+struct vcGLTFTangentMesh
+{
+  uint8_t *pVertData; // One vertex per corner
+  uint32_t vertexStride;
+  int triangleCount;
+  int positionOffset;
+  int normalOffset;
+  int uvOffset;
+  int tangentOffset;
+};
+
+int vcGLTF_TangentFaceCount(const SMikkTSpaceContext *pContext)
+{
+  return ((vcGLTFTangentMesh*)pContext->m_pUserData)->triangleCount;
+}
+
+int vcGLTF_TangentFaceVertexCount(const SMikkTSpaceContext * /*pContext*/, const int /*face*/)
+{
+  return 3;
+}
+
+void vcGLTF_TangentRead(const SMikkTSpaceContext *pContext, float *pOut, int face, int corner, int offset, int count)
+{
+  const vcGLTFTangentMesh *pMesh = (vcGLTFTangentMesh*)pContext->m_pUserData;
+  memcpy(pOut, pMesh->pVertData + pMesh->vertexStride * (face * 3 + corner) + offset, sizeof(float) * count);
+}
+
+void vcGLTF_TangentPosition(const SMikkTSpaceContext *pContext, float pPosition[], const int face, const int corner)
+{
+  vcGLTF_TangentRead(pContext, pPosition, face, corner, ((vcGLTFTangentMesh*)pContext->m_pUserData)->positionOffset, 3);
+}
+
+void vcGLTF_TangentNormal(const SMikkTSpaceContext *pContext, float pNormal[], const int face, const int corner)
+{
+  vcGLTF_TangentRead(pContext, pNormal, face, corner, ((vcGLTFTangentMesh*)pContext->m_pUserData)->normalOffset, 3);
+}
+
+void vcGLTF_TangentUV(const SMikkTSpaceContext *pContext, float pUV[], const int face, const int corner)
+{
+  vcGLTF_TangentRead(pContext, pUV, face, corner, ((vcGLTFTangentMesh*)pContext->m_pUserData)->uvOffset, 2);
+}
+
+void vcGLTF_TangentStore(const SMikkTSpaceContext *pContext, const float pTangent[], const float sign, const int face, const int corner)
+{
+  const vcGLTFTangentMesh *pMesh = (vcGLTFTangentMesh*)pContext->m_pUserData;
+  *(udFloat4*)(pMesh->pVertData + pMesh->vertexStride * (face * 3 + corner) + pMesh->tangentOffset) = udFloat4::create(pTangent[0], pTangent[1], pTangent[2], sign);
+}
+
+// Returns a new non-indexed vertex buffer (one vertex per triangle corner) with the tangent attribute filled by MikkTSpace, or
+// nullptr on failure. MikkTSpace produces a tangent per corner, so the caller welds the result to get indices back
+uint8_t* vcGLTF_GenerateTangents(const uint8_t *pVertData, uint32_t vertexStride, int vertexCount, const void *pIndices, int indexCount, bool shortIndices, int positionOffset, int normalOffset, int uvOffset, int tangentOffset, int *pCornerCount)
+{
+  vcGLTFTraceScope traceScope("Generate tangents");
+
+  int cornerCount = ((pIndices != nullptr) ? indexCount : vertexCount) / 3 * 3;
+  if (cornerCount == 0)
+    return nullptr;
+
+  uint8_t *pCorners = udAllocType(uint8_t, (size_t)vertexStride * cornerCount, udAF_None);
+  if (pCorners == nullptr)
+    return nullptr;
+
+  for (int i = 0; i < cornerCount; ++i)
+  {
+    uint32_t index = i;
+    if (pIndices != nullptr)
+      index = shortIndices ? ((const uint16_t*)pIndices)[i] : ((const uint32_t*)pIndices)[i];
+
+    memcpy(pCorners + (size_t)vertexStride * i, pVertData + (size_t)vertexStride * index, vertexStride);
+  }
+
+  vcGLTFTangentMesh mesh = {};
+  mesh.pVertData = pCorners;
+  mesh.vertexStride = vertexStride;
+  mesh.triangleCount = cornerCount / 3;
+  mesh.positionOffset = positionOffset;
+  mesh.normalOffset = normalOffset;
+  mesh.uvOffset = uvOffset;
+  mesh.tangentOffset = tangentOffset;
+
+  SMikkTSpaceInterface callbacks = {};
+  callbacks.m_getNumFaces = vcGLTF_TangentFaceCount;
+  callbacks.m_getNumVerticesOfFace = vcGLTF_TangentFaceVertexCount;
+  callbacks.m_getPosition = vcGLTF_TangentPosition;
+  callbacks.m_getNormal = vcGLTF_TangentNormal;
+  callbacks.m_getTexCoord = vcGLTF_TangentUV;
+  callbacks.m_setTSpaceBasic = vcGLTF_TangentStore;
+
+  SMikkTSpaceContext context = {};
+  context.m_pInterface = &callbacks;
+  context.m_pUserData = &mesh;
+
+  if (!genTangSpaceDefault(&context))
+  {
+    udFree(pCorners);
+    return nullptr;
+  }
+
+  *pCornerCount = cornerCount;
+  return pCorners;
+}
+
+// Merges byte-identical vertices in place, compacting pVertData. pRemap receives the new index of every original vertex; returns the unique vertex count
+int vcGLTF_WeldVertices(uint8_t *pVertData, uint32_t vertexStride, int vertexCount, uint32_t *pRemap)
+{
+  uint32_t tableSize = 1;
+  while (tableSize < (uint32_t)vertexCount * 2)
+    tableSize <<= 1;
+
+  uint32_t *pTable = udAllocType(uint32_t, tableSize, udAF_None);
+  if (pTable == nullptr)
+  {
+    for (int v = 0; v < vertexCount; ++v)
+      pRemap[v] = v;
+    return vertexCount;
+  }
+
+  memset(pTable, 0xFF, sizeof(uint32_t) * tableSize);
+
+  int uniqueCount = 0;
+  for (int v = 0; v < vertexCount; ++v)
+  {
+    const uint8_t *pVertex = pVertData + v * vertexStride;
+
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    for (uint32_t b = 0; b < vertexStride; ++b)
+      hash = (hash ^ pVertex[b]) * 16777619u;
+
+    uint32_t slot = hash & (tableSize - 1);
+    while (pTable[slot] != UINT32_MAX && memcmp(pVertData + pTable[slot] * vertexStride, pVertex, vertexStride) != 0)
+      slot = (slot + 1) & (tableSize - 1);
+
+    if (pTable[slot] == UINT32_MAX)
+    {
+      // Unique vertices only ever move down so the compacted copy never overwrites an unread vertex
+      if (uniqueCount != v)
+        memcpy(pVertData + uniqueCount * vertexStride, pVertex, vertexStride);
+
+      pTable[slot] = uniqueCount;
+      ++uniqueCount;
+    }
+
+    pRemap[v] = pTable[slot];
+  }
+
+  udFree(pTable);
+  return uniqueCount;
+}
+
+// Tipsify (Sander, Nehab & Barczak 2007) triangle order for a FIFO post-transform cache. pClusterStarts receives the first
+// triangle of each run the walk produced (a new run starts at each dead end); returns the run count
+int vcGLTF_TipsifyIndices(uint32_t *pDestination, const uint32_t *pIndices, int indexCount, int vertexCount, int *pClusterStarts)
+{
+  int triangleCount = indexCount / 3;
+  int clusterCount = 0;
+
+  int *pAdjacencyOffsets = udAllocType(int, vertexCount + 1, udAF_Zero);
+  int *pAdjacency = udAllocType(int, triangleCount * 3, udAF_None);
+  int *pLiveCount = udAllocType(int, vertexCount, udAF_Zero);
+  int *pCacheTime = udAllocType(int, vertexCount, udAF_Zero);
+  uint32_t *pDeadEnd = udAllocType(uint32_t, triangleCount * 3, udAF_None);
+  bool *pEmitted = udAllocType(bool, triangleCount, udAF_Zero);
+
+  if (pAdjacencyOffsets == nullptr || pAdjacency == nullptr || pLiveCount == nullptr || pCacheTime == nullptr || pDeadEnd == nullptr || pEmitted == nullptr)
+  {
+    memcpy(pDestination, pIndices, sizeof(uint32_t) * triangleCount * 3);
+    pClusterStarts[clusterCount++] = 0;
+    goto epilogue;
+  }
+
+  for (int i = 0; i < triangleCount * 3; ++i)
+    ++pLiveCount[pIndices[i]];
+
+  for (int v = 0; v < vertexCount; ++v)
+    pAdjacencyOffsets[v + 1] = pAdjacencyOffsets[v] + pLiveCount[v];
+
+  // pCacheTime doubles as the fill cursor while building the vertex to triangle lists
+  for (int i = 0; i < triangleCount * 3; ++i)
+    pAdjacency[pAdjacencyOffsets[pIndices[i]] + pCacheTime[pIndices[i]]++] = i / 3;
+  memset(pCacheTime, 0, sizeof(int) * vertexCount);
+
+  {
+    int timeStamp = vcGLTFLimit_VertexCacheSize + 1;
+    int deadEndCount = 0;
+    int outputCount = 0;
+    int cursor = 0;
+    int fanningVertex = (triangleCount > 0) ? (int)pIndices[0] : -1;
+
+    if (fanningVertex >= 0)
+      pClusterStarts[clusterCount++] = 0;
+
+    while (fanningVertex >= 0)
+    {
+      int candidateStart = deadEndCount;
+
+      for (int a = pAdjacencyOffsets[fanningVertex]; a < pAdjacencyOffsets[fanningVertex + 1]; ++a)
+      {
+        int triangle = pAdjacency[a];
+        if (pEmitted[triangle])
+          continue;
+
+        for (int k = 0; k < 3; ++k)
+        {
+          uint32_t v = pIndices[triangle * 3 + k];
+          pDestination[outputCount++] = v;
+          pDeadEnd[deadEndCount++] = v;
+          --pLiveCount[v];
+
+          if (timeStamp - pCacheTime[v] > vcGLTFLimit_VertexCacheSize)
+            pCacheTime[v] = timeStamp++;
+        }
+
+        pEmitted[triangle] = true;
+      }
+
+      // Prefer the 1-ring vertex that will still be in the cache once its remaining triangles are emitted
+      int nextVertex = -1;
+      int bestPriority = -1;
+      for (int c = candidateStart; c < deadEndCount; ++c)
+      {
+        uint32_t v = pDeadEnd[c];
+        if (pLiveCount[v] <= 0)
+          continue;
+
+        int priority = 0;
+        if (timeStamp - pCacheTime[v] + 2 * pLiveCount[v] <= vcGLTFLimit_VertexCacheSize)
+          priority = timeStamp - pCacheTime[v];
+
+        if (priority > bestPriority)
+        {
+          bestPriority = priority;
+          nextVertex = (int)v;
+        }
+      }
+
+      if (nextVertex == -1)
+      {
+        // Dead end; back track through recently emitted vertices, then fall back to input order
+        while (deadEndCount > 0 && nextVertex == -1)
+        {
+          uint32_t v = pDeadEnd[--deadEndCount];
+          if (pLiveCount[v] > 0)
+            nextVertex = (int)v;
+        }
+
+        while (nextVertex == -1 && cursor < vertexCount)
+        {
+          if (pLiveCount[cursor] > 0)
+            nextVertex = cursor;
+          else
+            ++cursor;
+        }
+
+        if (nextVertex != -1)
+          pClusterStarts[clusterCount++] = outputCount / 3;
+      }
+
+      fanningVertex = nextVertex;
+    }
+  }
+
+epilogue:
+  udFree(pAdjacencyOffsets);
+  udFree(pAdjacency);
+  udFree(pLiveCount);
+  udFree(pCacheTime);
+  udFree(pDeadEnd);
+  udFree(pEmitted);
+
+  return clusterCount;
+}
+
+struct vcGLTFClusterSort
+{
+  float key;
+  int cluster;
+};
+
+int vcGLTF_CompareClusterSort(const void *pA, const void *pB)
+{
+  float a = ((const vcGLTFClusterSort*)pA)->key;
+  float b = ((const vcGLTFClusterSort*)pB)->key;
+  return (a > b) ? -1 : ((a < b) ? 1 : 0);
+}
+
+// Orders the runs from vcGLTF_TipsifyIndices so those facing away from the mesh centre draw first; they are the most likely
+// to occlude the rest of the mesh, which reduces overdraw without losing the cache locality within each run
+void vcGLTF_SortClustersForOverdraw(uint32_t *pDestination, const uint32_t *pIndices, int indexCount, const int *pClusterStarts, int clusterCount, const uint8_t *pPositions, uint32_t positionStride)
+{
+  int triangleCount = indexCount / 3;
+  vcGLTFClusterSort *pSort = udAllocType(vcGLTFClusterSort, clusterCount, udAF_None);
+
+  if (clusterCount < 2 || pSort == nullptr)
+  {
+    memcpy(pDestination, pIndices, sizeof(uint32_t) * triangleCount * 3);
+    udFree(pSort);
+    return;
+  }
+
+  udFloat3 meshCentroid = udFloat3::zero();
+  float meshArea = 0.f;
+
+  udFloat3 *pClusterCentroids = udAllocType(udFloat3, clusterCount, udAF_Zero);
+  udFloat3 *pClusterNormals = udAllocType(udFloat3, clusterCount, udAF_Zero);
+
+  if (pClusterCentroids == nullptr || pClusterNormals == nullptr)
+  {
+    memcpy(pDestination, pIndices, sizeof(uint32_t) * triangleCount * 3);
+    goto epilogue;
+  }
+
+  for (int c = 0; c < clusterCount; ++c)
+  {
+    int end = (c + 1 < clusterCount) ? pClusterStarts[c + 1] : triangleCount;
+    float clusterArea = 0.f;
+
+    for (int t = pClusterStarts[c]; t < end; ++t)
+    {
+      const udFloat3 &p0 = *(const udFloat3*)(pPositions + pIndices[t * 3 + 0] * positionStride);
+      const udFloat3 &p1 = *(const udFloat3*)(pPositions + pIndices[t * 3 + 1] * positionStride);
+      const udFloat3 &p2 = *(const udFloat3*)(pPositions + pIndices[t * 3 + 2] * positionStride);
+
+      udFloat3 normal = udCross3(p1 - p0, p2 - p0);
+      float area = udMag3(normal);
+
+      pClusterCentroids[c] += (p0 + p1 + p2) * (area / 3.f);
+      pClusterNormals[c] += normal;
+      clusterArea += area;
+    }
+
+    meshCentroid += pClusterCentroids[c];
+    meshArea += clusterArea;
+
+    if (clusterArea > 0.f)
+      pClusterCentroids[c] = pClusterCentroids[c] / clusterArea;
+  }
+
+  if (meshArea > 0.f)
+    meshCentroid = meshCentroid / meshArea;
+
+  for (int c = 0; c < clusterCount; ++c)
+  {
+    float normalLength = udMag3(pClusterNormals[c]);
+
+    pSort[c].cluster = c;
+    pSort[c].key = (normalLength > 0.f) ? udDot3(pClusterCentroids[c] - meshCentroid, pClusterNormals[c] / normalLength) : -FLT_MAX;
+  }
+
+  qsort(pSort, clusterCount, sizeof(vcGLTFClusterSort), vcGLTF_CompareClusterSort);
+
+  {
+    int outputCount = 0;
+    for (int c = 0; c < clusterCount; ++c)
+    {
+      int start = pClusterStarts[pSort[c].cluster];
+      int end = (pSort[c].cluster + 1 < clusterCount) ? pClusterStarts[pSort[c].cluster + 1] : triangleCount;
+
+      memcpy(&pDestination[outputCount], &pIndices[start * 3], sizeof(uint32_t) * (end - start) * 3);
+      outputCount += (end - start) * 3;
+    }
+  }
+
+epilogue:
+  udFree(pSort);
+  udFree(pClusterCentroids);
+  udFree(pClusterNormals);
+}
+
+// Renumbers vertices in the order the indices first reference them so vertex fetches walk the buffer linearly
+void vcGLTF_OptimizeVertexFetch(uint32_t *pIndices, int indexCount, uint8_t *pVertData, uint32_t vertexStride, int vertexCount)
+{
+  uint32_t *pRemap = udAllocType(uint32_t, vertexCount, udAF_None);
+  uint8_t *pNewVertData = udAllocType(uint8_t, vertexStride * vertexCount, udAF_None);
+
+  if (pRemap != nullptr && pNewVertData != nullptr)
+  {
+    memset(pRemap, 0xFF, sizeof(uint32_t) * vertexCount);
+    uint32_t nextVertex = 0;
+
+    for (int i = 0; i < indexCount; ++i)
+    {
+      if (pRemap[pIndices[i]] == UINT32_MAX)
+        pRemap[pIndices[i]] = nextVertex++;
+
+      pIndices[i] = pRemap[pIndices[i]];
+    }
+
+    // Unreferenced vertices are kept at the end
+    for (int v = 0; v < vertexCount; ++v)
+    {
+      if (pRemap[v] == UINT32_MAX)
+        pRemap[v] = nextVertex++;
+
+      memcpy(pNewVertData + pRemap[v] * vertexStride, pVertData + v * vertexStride, vertexStride);
+    }
+
+    memcpy(pVertData, pNewVertData, vertexStride * vertexCount);
+  }
+
+  udFree(pRemap);
+  udFree(pNewVertData);
+}
+
+// Reorders triangles (per LOD level) for the vertex cache and overdraw, then the vertices for fetch locality. pIndices is modified in place
+void vcGLTF_OptimizeMeshIndices(const vcGLTFMeshPrimitive *pPrimitive, void *pIndices, int indexCount, bool shortIndices, uint8_t *pVertData, uint32_t vertexStride, int positionOffset, int vertexCount)
+{
+  uint32_t *pWorking = udAllocType(uint32_t, indexCount * 2, udAF_None);
+  int *pClusterStarts = udAllocType(int, indexCount / 3 + 1, udAF_None);
+
+  if (pWorking == nullptr || pClusterStarts == nullptr)
+  {
+    udFree(pWorking);
+    udFree(pClusterStarts);
+    return;
+  }
+
+  uint32_t *pOrdered = pWorking + indexCount;
+
+  for (int i = 0; i < indexCount; ++i)
+    pWorking[i] = shortIndices ? ((const uint16_t*)pIndices)[i] : ((const uint32_t*)pIndices)[i];
+
+  int rangeCount = udMax(pPrimitive->lodCount, 1);
+  for (int range = 0; range < rangeCount; ++range)
+  {
+    int start = (pPrimitive->lodCount > 0) ? pPrimitive->lodIndexStart[range] : 0;
+    int count = (pPrimitive->lodCount > 0) ? pPrimitive->lodIndexCount[range] : indexCount;
+
+    int clusterCount = vcGLTF_TipsifyIndices(&pOrdered[start], &pWorking[start], count, vertexCount, pClusterStarts);
+    vcGLTF_SortClustersForOverdraw(&pWorking[start], &pOrdered[start], count, pClusterStarts, clusterCount, pVertData + positionOffset, vertexStride);
+  }
+
+  vcGLTF_OptimizeVertexFetch(pWorking, indexCount, pVertData, vertexStride, vertexCount);
+
+  for (int i = 0; i < indexCount; ++i)
+  {
+    if (shortIndices)
+      ((uint16_t*)pIndices)[i] = (uint16_t)pWorking[i];
+    else
+      ((uint32_t*)pIndices)[i] = pWorking[i];
+  }
+
+  udFree(pWorking);
+  udFree(pClusterStarts);
+}
+
+// Appends a primitive to a shared buffer with a matching layout; returns the pack ID and the primitive's first index, or -1 if it can't be packed
+int vcGLTF_AppendToPack(vcGLTFScene *pScene, const vcVertexLayoutTypes *pLayout, int layoutCount, int shaderFeatures, const uint8_t *pVertData, uint32_t vertexCount, const void *pIndices, uint32_t indexCount, bool shortIndices, int *pIndexStart)
+{
+  // Deferred scenes create meshes after the packs have been uploaded, and evict them one at a time
+  if ((pScene->loadFlags & vcGLTFLF_DeferMeshes) || layoutCount > vcGLTFLimit_PackLayoutCount || vertexCount > vcGLTFLimit_PackVertexCount)
+    return -1;
+
+  uint32_t vertexStride = vcLayout_GetSize(pLayout, layoutCount);
+
+  int packID = -1;
+  for (int i = pScene->packCount - 1; i >= 0 && packID == -1; --i)
+  {
+    vcGLTFMeshPack *pPack = &pScene->pPacks[i];
+    if (pPack->layoutCount == layoutCount && memcmp(pPack->layout, pLayout, sizeof(vcVertexLayoutTypes) * layoutCount) == 0 && pPack->vertexCount + vertexCount <= vcGLTFLimit_PackVertexCount)
+      packID = i;
+  }
+
+  if (packID == -1)
+  {
+    vcGLTFMeshPack *pPacks = udReallocType(pScene->pPacks, vcGLTFMeshPack, pScene->packCount + 1);
+    if (pPacks == nullptr)
+      return -1;
+
+    pScene->pPacks = pPacks;
+    packID = pScene->packCount++;
+
+    vcGLTFMeshPack *pPack = &pScene->pPacks[packID];
+    memset(pPack, 0, sizeof(vcGLTFMeshPack));
+    memcpy(pPack->layout, pLayout, sizeof(vcVertexLayoutTypes) * layoutCount);
+    pPack->layoutCount = layoutCount;
+    pPack->vertexStride = vertexStride;
+    pPack->shaderFeatures = shaderFeatures;
+  }
+
+  vcGLTFMeshPack *pPack = &pScene->pPacks[packID];
+
+  if (pPack->vertexCount + vertexCount > pPack->vertexCapacity)
+  {
+    uint32_t newCapacity = udMax(pPack->vertexCapacity * 2, pPack->vertexCount + vertexCount);
+    uint8_t *pNewVertData = udReallocType(pPack->pVertData, uint8_t, (size_t)newCapacity * vertexStride);
+    if (pNewVertData == nullptr)
+      return -1;
+
+    pPack->pVertData = pNewVertData;
+    pPack->vertexCapacity = newCapacity;
+  }
+
+  if (pPack->indexCount + indexCount > pPack->indexCapacity)
+  {
+    uint32_t newCapacity = udMax(pPack->indexCapacity * 2, pPack->indexCount + indexCount);
+    uint32_t *pNewIndices = udReallocType(pPack->pIndices, uint32_t, newCapacity);
+    if (pNewIndices == nullptr)
+      return -1;
+
+    pPack->pIndices = pNewIndices;
+    pPack->indexCapacity = newCapacity;
+  }
+
+  memcpy(pPack->pVertData + (size_t)pPack->vertexCount * vertexStride, pVertData, (size_t)vertexCount * vertexStride);
+
+  // Non-indexed primitives get sequential indices
+  uint32_t *pDestIndices = &pPack->pIndices[pPack->indexCount];
+  for (uint32_t i = 0; i < indexCount; ++i)
+  {
+    uint32_t index = i;
+    if (pIndices != nullptr)
+      index = shortIndices ? ((const uint16_t*)pIndices)[i] : ((const uint32_t*)pIndices)[i];
+
+    pDestIndices[i] = pPack->vertexCount + index;
+  }
+
+  *pIndexStart = (int)pPack->indexCount;
+
+  pPack->vertexCount += vertexCount;
+  pPack->indexCount += indexCount;
+
+  return packID;
+}
+
+// Uploads the shared buffers once every mesh has been appended and points the primitives at them
+void vcGLTF_CreatePackedMeshes(vcGLTFScene *pScene)
+{
+  for (int i = 0; i < pScene->packCount; ++i)
+  {
+    vcGLTFMeshPack *pPack = &pScene->pPacks[i];
+
+    pScene->loadStats.verticesUploaded += pPack->vertexCount;
+    pScene->loadStats.indicesUploaded += pPack->indexCount;
+    vcGLTF_CountMeshBytes(pScene, pPack->layout, pPack->layoutCount, pPack->vertexCount, pPack->indexCount, pPack->vertexCount <= UINT16_MAX + 1);
+
+    if (pPack->shaderFeatures == -1)
+      vcShader_Bind(vcGLTF_GetDepthPositionShader().pShader);
+    else
+      vcShader_Bind(vcGLTF_GetShader(pPack->shaderFeatures).pShader);
+
+    if (pPack->vertexCount <= UINT16_MAX + 1)
+    {
+      // Narrowed in place; the 16-bit indices never overtake the 32-bit ones still being read
+      uint16_t *pShortIndices = (uint16_t*)pPack->pIndices;
+      for (uint32_t index = 0; index < pPack->indexCount; ++index)
+        pShortIndices[index] = (uint16_t)pPack->pIndices[index];
+
+      vcMesh_Create(&pPack->pMesh, pPack->layout, pPack->layoutCount, pPack->pVertData, pPack->vertexCount, pShortIndices, pPack->indexCount, vcMF_IndexShort);
+    }
+    else
+    {
+      vcMesh_Create(&pPack->pMesh, pPack->layout, pPack->layoutCount, pPack->pVertData, pPack->vertexCount, pPack->pIndices, pPack->indexCount, vcMF_None);
+    }
+
+    udFree(pPack->pVertData);
+    udFree(pPack->pIndices);
+    pPack->vertexCapacity = 0;
+    pPack->indexCapacity = 0;
+  }
+
+  for (int i = 0; i < pScene->meshCount; ++i)
+  {
+    for (int j = 0; j < pScene->pMeshes[i].numPrimitives; ++j)
+    {
+      vcGLTFMeshPrimitive *pPrimitive = &pScene->pMeshes[i].pPrimitives[j];
+
+      if (pPrimitive->packID != -1)
+        pPrimitive->pMesh = pScene->pPacks[pPrimitive->packID].pMesh;
+
+      if (pPrimitive->positionPackID != -1)
+        pPrimitive->pPositionMesh = pScene->pPacks[pPrimitive->positionPackID].pMesh;
+    }
+  }
+}
+
+struct vcGLTFAttributeType
+{
+  const char *pAttrName;
+  const char *pAccessorType;
+  vcVertexLayoutTypes type;
+  vcGLTFFeatureBits featureBits;
+};
+
+const vcGLTFAttributeType g_vcGLTFAttributeTypes[] = {
+  { "POSITION", "VEC3", vcVLT_Position3, vcRSB_None },
+  { "NORMAL", "VEC3", vcVLT_Normal3, vcRSB_None },
+  { "TANGENT", "VEC4", vcVLT_Tangent4, vcRSB_Tangents },
+  { "TEXCOORD_0", "VEC2", vcVLT_TextureCoords2_0, vcRSB_UVSet0 },
+  { "TEXCOORD_1", "VEC2", vcVLT_TextureCoords2_1, vcRSB_UVSet1 },
+  { "COLOR_0", "VEC3", vcVLT_ColourBGRA, vcRSB_Colour },
+  { "COLOR_0", "VEC4", vcVLT_ColourBGRA, vcRSB_Colour },
+  { "JOINTS_0", "VEC4", vcVLT_BoneIDs, vcRSB_Skinned },
+  { "WEIGHTS_0", "VEC4", vcVLT_BoneWeights, vcRSB_Skinned },
+};
+
+// A primitive in its final vertex layout, waiting for vcGLTF_UploadPrimitive. Decoding writes only to this, never to the scene,
+// so streamed meshes can decode on the worker pool
+struct vcGLTFDecodedPrimitive
+{
+  vcVertexLayoutTypes *pTypes;
+  int totalAttributes;
+  uint8_t *pVertData;
+  int vertexCount;
+
+  void *pIndexBuffer; // Points into the glTF buffer unless indexCopy is set; nullptr when not indexed
+  int32_t indexCount;
+  bool indexCopy;
+
+  vcMeshFlags meshFlags;
+  vcGLTFFeatureBits featureBits;
+
+  // Slots vcGLTF_ReadPrimitive left zeroed for the generation steps
+  bool generateNormals;
+  bool generateTangents;
+  vcVertexLayoutTypes tangentUVType;
+  bool welded;
+
+  int64_t accessorBytes; // Added to the load stats on upload
+
+  vcGLTFMeshPrimitive derived; // Bounds, LOD chain and (udAlloc'd) joint bounds; copied to the mesh's primitive on upload
+  vcGLTFBVH bvh; // Triangles only; appended to the mesh's on upload
+};
+
+void vcGLTF_FreeDecodedPrimitive(vcGLTFDecodedPrimitive *pDecoded)
+{
+  udFree(pDecoded->pTypes);
+  udFree(pDecoded->pVertData);
+
+  if (pDecoded->indexCopy)
+    udFree(pDecoded->pIndexBuffer);
+
+  udFree(pDecoded->derived.pJointBounds);
+  udFree(pDecoded->bvh.pTriangles);
+
+  memset(pDecoded, 0, sizeof(vcGLTFDecodedPrimitive));
+}
+
+// Arena allocations for the mesh; these are made before decoding as the worker pool must never use the arena
+void vcGLTF_BeginMesh(vcGLTFScene *pScene, int meshID)
+{
+  vcGLTFMesh *pMesh = &pScene->pMeshes[meshID];
+
+  int numPrimitives = pMesh->primitiveDescCount;
+  pMesh->numPrimitives = numPrimitives;
+
+  if (pMesh->pPrimitives == nullptr)
+  {
+    pMesh->pPrimitives = vcGLTF_ArenaAllocType(&pScene->arena, vcGLTFMeshPrimitive, numPrimitives);
+  }
+  else
+  {
+    // Evicted meshes reuse their primitives, and their joint bounds as decoding the same vertices again gives the same count
+    for (int i = 0; i < numPrimitives; ++i)
+    {
+      int jointBoundCount = pMesh->pPrimitives[i].jointBoundCount;
+      udFloat3 *pJointBounds = pMesh->pPrimitives[i].pJointBounds;
+
+      memset(&pMesh->pPrimitives[i], 0, sizeof(vcGLTFMeshPrimitive));
+      pMesh->pPrimitives[i].jointBoundCount = jointBoundCount;
+      pMesh->pPrimitives[i].pJointBounds = pJointBounds;
+    }
+  }
+
+  for (int i = 0; i < numPrimitives; ++i)
+  {
+    int material = pMesh->pPrimitiveDescs[i].material;
+
+    if (material < 0 || material >= pScene->materialCount)
+    {
+      __debugbreak();
+      material = 0;
+    }
+    pMesh->pPrimitives[i].pMaterial = &pScene->pMaterials[material];
+  }
+}
+
+// Reads the primitive's indices and attributes into its final vertex layout, leaving zeroed slots for the normals and tangents
+// that get generated. The buffers must already be loaded (vcGLTF_LoadMeshBuffers). On failure pDecoded still needs
+// vcGLTF_FreeDecodedPrimitive
+udResult vcGLTF_ReadPrimitive(const vcGLTFScene *pScene, int meshID, int primitiveID, vcGLTFDecodedPrimitive *pDecoded)
+{
+  udResult result = udR_Failure_;
+
+  const vcGLTFPrimitiveDesc &primitive = pScene->pMeshes[meshID].pPrimitiveDescs[primitiveID];
+  const vcGLTFMaterial *pMaterial = pScene->pMeshes[meshID].pPrimitives[primitiveID].pMaterial;
+
+  vcMeshFlags meshFlags = vcMF_None;
+  vcGLTFFeatureBits featureBits = vcRSB_None;
+
+  void *pIndexBuffer = nullptr;
+  int32_t indexCount = 0;
+  bool indexCopy = false;
+
+  int totalAttributes = primitive.attributeCount;
+  vcVertexLayoutTypes *pTypes = nullptr;
+  uint8_t *pVertData = nullptr;
+  uint32_t vertexStride = 0;
+  int maxCount = -1;
+  int totalOffset = 0;
+  int64_t accessorBytes = 0;
+
+  bool hasNormals = false;
+  bool generateTangents = false;
+  vcVertexLayoutTypes tangentUVType = vcVLT_TextureCoords2_0;
+
+  int mode = primitive.mode; // Points, Lines, Triangles
+  if (mode != 4)
+    __debugbreak();
+
+  int indexAccessor = primitive.indices;
+
+  if (indexAccessor != -1)
+  {
+    const vcGLTFAccessor &accessor = vcGLTF_GetAccessor(pScene, indexAccessor);
+
+    if (udStrEqual("SCALAR", accessor.type))
+    {
+      indexCount = (int32_t)accessor.count;
+
+      int bufferID = vcGLTF_GetBufferView(pScene, accessor.bufferView).buffer;
+      UD_ERROR_IF(bufferID < 0 || bufferID >= pScene->bufferCount, udR_CorruptData);
+
+      vcGLTFTypes indexType = (vcGLTFTypes)accessor.componentType;
+      ptrdiff_t offset = accessor.byteOffset + vcGLTF_GetBufferView(pScene, accessor.bufferView).byteOffset;
+
+      if (indexType == vcGLTFType_Int16 || indexType == vcGLTFType_UInt16 || indexType == vcGLTFType_Int8 || indexType == vcGLTFType_UInt8)
+        meshFlags = meshFlags | vcMF_IndexShort;
+      else if (indexType != vcGLTFType_Int32 && indexType != vcGLTFType_Uint32)
+        __debugbreak();
+
+      UD_ERROR_NULL(pScene->pBuffers[bufferID].pBytes, udR_ReadFailure);
+      pIndexBuffer = (pScene->pBuffers[bufferID].pBytes + offset);
+
+      accessorBytes += (int64_t)indexCount * vcGLTF_ComponentSize(indexType);
+
+      if (indexType == vcGLTFType_Int8 || indexType == vcGLTFType_UInt8)
+      {
+        uint16_t *pNewIndexBuffer = udAllocType(uint16_t, indexCount, udAF_None);
+        UD_ERROR_NULL(pNewIndexBuffer, udR_MemoryAllocationFailure);
+
+        for (int index = 0; index < indexCount; ++index)
+          pNewIndexBuffer[index] = ((uint8_t*)pIndexBuffer)[index];
+        indexCopy = true;
+        pIndexBuffer = pNewIndexBuffer;
+      }
+    }
+  }
+
+  pTypes = udAllocType(vcVertexLayoutTypes, totalAttributes+2, udAF_None); //+2 in case we need to add normals and tangents
+  UD_ERROR_NULL(pTypes, udR_MemoryAllocationFailure);
+
+  for (size_t j = 0; j < totalAttributes; ++j)
+  {
+    const char *pAttributeName = primitive.pAttributes[j].name;
+    int attributeAccessorIndex = primitive.pAttributes[j].accessor;
+
+    const vcGLTFAccessor &accessor = vcGLTF_GetAccessor(pScene, attributeAccessorIndex);
+
+    const char *pAccessorType = accessor.type;
+    int attributeType = accessor.componentType;
+    int attributeCount = (int)accessor.count;
+
+    int bufferID = vcGLTF_GetBufferView(pScene, accessor.bufferView).buffer;
+    UD_ERROR_IF(bufferID < 0 || bufferID >= pScene->bufferCount, udR_CorruptData);
+    UD_ERROR_NULL(pScene->pBuffers[bufferID].pBytes, udR_ReadFailure);
+
+    if (maxCount == -1)
+      maxCount = attributeCount;
+    else if (maxCount != attributeCount)
+      __debugbreak();
+
+    pTypes[j] = vcVLT_Unsupported;
+
+    for (size_t stIter = 0; stIter < udLengthOf(g_vcGLTFAttributeTypes); ++stIter)
+    {
+      if (udStrEqual(pAttributeName, g_vcGLTFAttributeTypes[stIter].pAttrName) && udStrEqual(pAccessorType, g_vcGLTFAttributeTypes[stIter].pAccessorType))
+      {
+        pTypes[j] = g_vcGLTFAttributeTypes[stIter].type;
+        featureBits = (vcGLTFFeatureBits)(featureBits | g_vcGLTFAttributeTypes[stIter].featureBits);
+        break;
+      }
+    }
+
+    if ((pTypes[j] == vcVLT_BoneIDs && attributeType != vcGLTFType_UInt16) || (pTypes[j] != vcVLT_BoneIDs && attributeType != vcGLTFType_F32))
+      __debugbreak();
+
+    if (pTypes[j] == vcVLT_Normal3)
+      hasNormals = true;
+    else if (pTypes[j] == vcVLT_Unsupported)
+      __debugbreak();
+  }
+
+  if (!hasNormals)
+  {
+    pTypes[totalAttributes] = vcVLT_Normal3;
+    ++totalAttributes;
+  }
+
+  // Normal mapped primitives without tangents get them generated rather than reconstructed from derivatives per pixel
+  {
+    vcGLTFFeatureBits tangentUVBit = (pMaterial->normalUVSet == 1) ? vcRSB_UVSet1 : vcRSB_UVSet0;
+    tangentUVType = (pMaterial->normalUVSet == 1) ? vcVLT_TextureCoords2_1 : vcVLT_TextureCoords2_0;
+    generateTangents = (!pScene->reduceMemory && pMaterial->pNormalTexture != nullptr && (featureBits & vcRSB_Tangents) == 0 && (featureBits & tangentUVBit) != 0);
+  }
+
+  if (generateTangents)
+  {
+    pTypes[totalAttributes] = vcVLT_Tangent4;
+    ++totalAttributes;
+    featureBits = (vcGLTFFeatureBits)(featureBits | vcRSB_Tangents);
+  }
+
+  vcLayout_Sort(pTypes, totalAttributes);
+
+  vertexStride = vcLayout_GetSize(pTypes, totalAttributes);
+  pVertData = udAllocType(uint8_t, vertexStride * maxCount, udAF_Zero);
+  UD_ERROR_NULL(pVertData, udR_MemoryAllocationFailure);
+
+  // Decode the buffers
+  for (int ai = 0; ai < totalAttributes; ++ai)
+  {
+    if (pTypes[ai] == vcVLT_Normal3 && !hasNormals)
+    {
+      totalOffset += 3 * sizeof(float); // Filled in by vcGLTF_GeneratePrimitiveNormals
+    }
+    else if (pTypes[ai] == vcVLT_Tangent4 && generateTangents)
+    {
+      totalOffset += 4 * sizeof(float); // Filled in by vcGLTF_GeneratePrimitiveTangents once the vertices are final
+    }
+    else
+    {
+      int attributeAccessorIndex = -1;
+      
+      for (int atIter = 0; atIter < primitive.attributeCount && attributeAccessorIndex == -1; ++atIter)
+      {
+        for (size_t stIter = 0; stIter < udLengthOf(g_vcGLTFAttributeTypes); ++stIter)
+        {
+          if (g_vcGLTFAttributeTypes[stIter].type == pTypes[ai] && udStrEqual(primitive.pAttributes[atIter].name, g_vcGLTFAttributeTypes[stIter].pAttrName))
+          {
+            attributeAccessorIndex = primitive.pAttributes[atIter].accessor;
+            break;
+          }
+        }
+      }
+
+      UD_ERROR_CHECK(vcGLTF_DecodeAccessor(pScene, attributeAccessorIndex, &totalOffset, maxCount, pVertData, vertexStride, &accessorBytes, pTypes[ai]));
+    }
+  }
+
+  result = udR_Success;
+
+epilogue:
+  pDecoded->pTypes = pTypes;
+  pDecoded->totalAttributes = totalAttributes;
+  pDecoded->pVertData = pVertData;
+  pDecoded->vertexCount = maxCount;
+  pDecoded->pIndexBuffer = pIndexBuffer;
+  pDecoded->indexCount = indexCount;
+  pDecoded->indexCopy = indexCopy;
+  pDecoded->meshFlags = meshFlags;
+  pDecoded->featureBits = featureBits;
+  pDecoded->generateNormals = !hasNormals;
+  pDecoded->generateTangents = generateTangents;
+  pDecoded->tangentUVType = tangentUVType;
+  pDecoded->accessorBytes = accessorBytes;
+
+  return result;
+}
+
+// Each vertex gets the face normal of the last triangle that uses it
+void vcGLTF_GeneratePrimitiveNormals(vcGLTFDecodedPrimitive *pDecoded)
+{
+  if (!pDecoded->generateNormals)
+    return;
+
+  uint32_t vertexStride = vcLayout_GetSize(pDecoded->pTypes, pDecoded->totalAttributes);
+  int positionOffset = vcGLTF_GetLayoutOffset(pDecoded->pTypes, pDecoded->totalAttributes, vcVLT_Position3);
+  int normalOffset = vcGLTF_GetLayoutOffset(pDecoded->pTypes, pDecoded->totalAttributes, vcVLT_Normal3);
+
+  if (positionOffset == -1)
+  {
+    __debugbreak(); // No position found?
+    return;
+  }
+
+  uint8_t *pPositions = pDecoded->pVertData + positionOffset;
+  int32_t indexCount = pDecoded->indexCount;
+
+  for (int vi = 0; vi < pDecoded->vertexCount; ++vi)
+  {
+    float *pVertFloats = (float*)(pDecoded->pVertData + vertexStride * vi + normalOffset);
+
+    udFloat3 normal = { 0.f, 0.f, 1.f };
+
+    if (pDecoded->pIndexBuffer == nullptr)
+    {
+      int triangleStart = (vi / 3);
+      normal = GetNormal(triangleStart, triangleStart + 1, triangleStart + 2, pPositions, vertexStride);
+    }
+    else
+    {
+      if (pDecoded->meshFlags & vcMF_IndexShort)
+      {
+        uint16_t *pIndices = (uint16_t*)pDecoded->pIndexBuffer;
+        for (int indexIter = 0; indexIter < indexCount; ++indexIter)
+        {
+          if (pIndices[indexIter] == vi)
+          {
+            int triangleStart = (indexIter / 3) * 3;
+            normal = GetNormal(pIndices[triangleStart], pIndices[triangleStart + 1], pIndices[triangleStart + 2], pPositions, vertexStride);
+          }
+        }
+      }
+      else
+      {
+        int32_t *pIndices = (int32_t*)pDecoded->pIndexBuffer;
+        for (int indexIter = 0; indexIter < indexCount; ++indexIter)
+        {
+          if (pIndices[indexIter] == vi)
+          {
+            int triangleStart = (indexIter / 3) * 3;
+            normal = GetNormal(pIndices[triangleStart], pIndices[triangleStart + 1], pIndices[triangleStart + 2], pPositions, vertexStride);
+          }
+        }
+      }
+    }
+
+    for (int element = 0; element < 3; ++element)
+    {
+      pVertFloats[element] = normal[element];
+    }
+  }
+}
+
+// Merges identical vertices and indexes the primitive, using 16-bit indices where they fit
+void vcGLTF_WeldPrimitive(vcGLTFDecodedPrimitive *pDecoded)
+{
+  int vertexCount = pDecoded->vertexCount;
+  if (vertexCount <= 0)
+    return;
+
+  uint32_t vertexStride = vcLayout_GetSize(pDecoded->pTypes, pDecoded->totalAttributes);
+  uint32_t *pRemap = udAllocType(uint32_t, vertexCount, udAF_None);
+
+  if (pRemap == nullptr)
+    return;
+
+  int weldedCount = vcGLTF_WeldVertices(pDecoded->pVertData, vertexStride, vertexCount, pRemap);
+  bool shortIndices = (weldedCount <= UINT16_MAX + 1);
+
+  // Non-indexed primitives get an index buffer from the remap
+  int newIndexCount = (pDecoded->pIndexBuffer == nullptr) ? vertexCount : pDecoded->indexCount;
+  void *pWeldedIndices = udAlloc(newIndexCount * (shortIndices ? sizeof(uint16_t) : sizeof(uint32_t)));
+
+  if (pWeldedIndices != nullptr)
+  {
+    for (int index = 0; index < newIndexCount; ++index)
+    {
+      uint32_t original = index;
+      if (pDecoded->pIndexBuffer != nullptr)
+        original = (pDecoded->meshFlags & vcMF_IndexShort) ? ((uint16_t*)pDecoded->pIndexBuffer)[index] : ((uint32_t*)pDecoded->pIndexBuffer)[index];
+
+      if (shortIndices)
+        ((uint16_t*)pWeldedIndices)[index] = (uint16_t)pRemap[original];
+      else
+        ((uint32_t*)pWeldedIndices)[index] = pRemap[original];
+    }
+
+    if (pDecoded->indexCopy)
+      udFree(pDecoded->pIndexBuffer);
+
+    pDecoded->pIndexBuffer = pWeldedIndices;
+    pDecoded->indexCopy = true;
+    pDecoded->indexCount = newIndexCount;
+    pDecoded->vertexCount = weldedCount;
+    pDecoded->welded = true;
+
+    if (shortIndices)
+      pDecoded->meshFlags = pDecoded->meshFlags | vcMF_IndexShort;
+    else
+      pDecoded->meshFlags = (vcMeshFlags)(pDecoded->meshFlags & ~vcMF_IndexShort);
+  }
+
+  udFree(pRemap);
+}
+
+// MikkTSpace writes one vertex per triangle corner, so the primitive is welded afterwards even without vcGLTFLF_WeldVertices.
+// Safe on the worker pool as it only touches pDecoded
+void vcGLTF_GeneratePrimitiveTangents(vcGLTFDecodedPrimitive *pDecoded)
+{
+  const vcVertexLayoutTypes *pTypes = pDecoded->pTypes;
+  int totalAttributes = pDecoded->totalAttributes;
+  int positionOffset = vcGLTF_GetLayoutOffset(pTypes, totalAttributes, vcVLT_Position3);
+
+  if (!pDecoded->generateTangents || pDecoded->vertexCount <= 0 || positionOffset == -1)
+    return;
+
+  int cornerCount = 0;
+  uint8_t *pCorners = vcGLTF_GenerateTangents(pDecoded->pVertData, vcLayout_GetSize(pTypes, totalAttributes), pDecoded->vertexCount, pDecoded->pIndexBuffer, pDecoded->indexCount, (pDecoded->meshFlags & vcMF_IndexShort) != 0,
+    positionOffset, vcGLTF_GetLayoutOffset(pTypes, totalAttributes, vcVLT_Normal3),
+    vcGLTF_GetLayoutOffset(pTypes, totalAttributes, pDecoded->tangentUVType), vcGLTF_GetLayoutOffset(pTypes, totalAttributes, vcVLT_Tangent4), &cornerCount);
+
+  if (pCorners == nullptr)
+    return;
+
+  // The corners replace the vertices and indices
+  udFree(pDecoded->pVertData);
+  pDecoded->pVertData = pCorners;
+  pDecoded->vertexCount = cornerCount;
+
+  if (pDecoded->indexCopy)
+    udFree(pDecoded->pIndexBuffer);
+
+  pDecoded->pIndexBuffer = nullptr;
+  pDecoded->indexCopy = false;
+  pDecoded->indexCount = 0;
+  pDecoded->meshFlags = (vcMeshFlags)(pDecoded->meshFlags & ~vcMF_IndexShort);
+
+  vcGLTF_WeldPrimitive(pDecoded);
+}
+
+// Welds (when asked), gathers the BVH triangles and bounds, then builds the LOD chain and optimizes the index order
+udResult vcGLTF_FinishPrimitive(const vcGLTFScene *pScene, int meshID, int primitiveID, vcGLTFDecodedPrimitive *pDecoded)
+{
+  const vcGLTFPrimitiveDesc &primitive = pScene->pMeshes[meshID].pPrimitiveDescs[primitiveID];
+  vcGLTFMeshPrimitive *pDerived = &pDecoded->derived;
+
+  if ((pScene->loadFlags & vcGLTFLF_WeldVertices) && !pDecoded->welded)
+    vcGLTF_WeldPrimitive(pDecoded);
+
+  const vcVertexLayoutTypes *pTypes = pDecoded->pTypes;
+  int totalAttributes = pDecoded->totalAttributes;
+  uint32_t vertexStride = vcLayout_GetSize(pTypes, totalAttributes);
+  int positionOffset = vcGLTF_GetLayoutOffset(pTypes, totalAttributes, vcVLT_Position3);
+  bool shortIndices = (pDecoded->meshFlags & vcMF_IndexShort) != 0;
+
+  vcGLTF_GatherBVHTriangles(&pDecoded->bvh, primitiveID, pDecoded->pVertData, vertexStride, positionOffset, pDecoded->vertexCount, pDecoded->pIndexBuffer, pDecoded->indexCount, shortIndices);
+  vcGLTF_CalculatePrimitiveBounds(pDerived, vcGLTF_GetAccessor(pScene, vcGLTF_FindAttribute(primitive, "POSITION")), pTypes, totalAttributes, pDecoded->pVertData, vertexStride, pDecoded->vertexCount);
+
+  if ((pScene->loadFlags & vcGLTFLF_GenerateLODs) && pDecoded->pIndexBuffer != nullptr)
+  {
+    void *pLODIndexBuffer = vcGLTF_GenerateLODChain(pDerived, pDecoded->pIndexBuffer, &pDecoded->indexCount, shortIndices, pDecoded->pVertData, vertexStride, positionOffset, pDecoded->vertexCount);
+
+    if (pLODIndexBuffer != nullptr)
+    {
+      if (pDecoded->indexCopy)
+        udFree(pDecoded->pIndexBuffer);
+
+      pDecoded->pIndexBuffer = pLODIndexBuffer;
+      pDecoded->indexCopy = true;
+    }
+  }
+
+  if ((pScene->loadFlags & vcGLTFLF_OptimizeIndices) && pDecoded->pIndexBuffer != nullptr && positionOffset != -1)
+  {
+    if (!pDecoded->indexCopy)
+    {
+      size_t indexBytes = pDecoded->indexCount * (shortIndices ? sizeof(uint16_t) : sizeof(uint32_t));
+      void *pOwnedIndices = udAlloc(indexBytes);
+      if (pOwnedIndices == nullptr)
+        return udR_MemoryAllocationFailure;
+
+      memcpy(pOwnedIndices, pDecoded->pIndexBuffer, indexBytes);
+
+      pDecoded->pIndexBuffer = pOwnedIndices;
+      pDecoded->indexCopy = true;
+    }
+
+    vcGLTF_OptimizeMeshIndices(pDerived, pDecoded->pIndexBuffer, pDecoded->indexCount, shortIndices, pDecoded->pVertData, vertexStride, positionOffset, pDecoded->vertexCount);
+  }
+
+  return udR_Success;
+}
+
+// Every decode step in turn. Only reads the scene so streamed meshes decode on the worker pool; the buffers must already be
+// loaded (vcGLTF_LoadMeshBuffers). On failure pDecoded still needs vcGLTF_FreeDecodedPrimitive
+udResult vcGLTF_DecodePrimitive(const vcGLTFScene *pScene, int meshID, int primitiveID, vcGLTFDecodedPrimitive *pDecoded)
+{
+  udResult result = vcGLTF_ReadPrimitive(pScene, meshID, primitiveID, pDecoded);
+  if (result != udR_Success)
+    return result;
+
+  vcGLTF_GeneratePrimitiveNormals(pDecoded);
+  vcGLTF_GeneratePrimitiveTangents(pDecoded);
+
+  return vcGLTF_FinishPrimitive(pScene, meshID, primitiveID, pDecoded);
+}
+
+// Creates the GPU meshes for a decoded primitive and moves what was derived from it into the mesh; needs the GL context and
+// uses the arena so never runs on the worker pool
+udResult vcGLTF_UploadPrimitive(vcGLTFScene *pScene, vcGLTFMesh *pMesh, int primitiveID, const vcGLTFDecodedPrimitive &decoded)
+{
+  udResult result = udR_Success;
+
+  vcGLTFMeshPrimitive *pPrimitive = &pMesh->pPrimitives[primitiveID];
+  const vcVertexLayoutTypes *pTypes = decoded.pTypes;
+  int totalAttributes = decoded.totalAttributes;
+  const uint8_t *pVertData = decoded.pVertData;
+  uint32_t vertexStride = vcLayout_GetSize(pTypes, totalAttributes);
+  int maxCount = decoded.vertexCount;
+  const void *pIndexBuffer = decoded.pIndexBuffer;
+  int32_t indexCount = decoded.indexCount;
+  vcMeshFlags meshFlags = decoded.meshFlags;
+  bool shortIndices = (meshFlags & vcMF_IndexShort) != 0;
+
+  pScene->loadStats.accessorBytesDecoded += decoded.accessorBytes;
+
+  pPrimitive->localMin = decoded.derived.localMin;
+  pPrimitive->localMax = decoded.derived.localMax;
+  pPrimitive->lodCount = decoded.derived.lodCount;
+  memcpy(pPrimitive->lodIndexStart, decoded.derived.lodIndexStart, sizeof(pPrimitive->lodIndexStart));
+  memcpy(pPrimitive->lodIndexCount, decoded.derived.lodIndexCount, sizeof(pPrimitive->lodIndexCount));
+
+  // Kept through eviction (see vcGLTF_BeginMesh) so re-streaming doesn't allocate them again
+  if (decoded.derived.pJointBounds != nullptr)
+  {
+    if (pPrimitive->pJointBounds == nullptr || pPrimitive->jointBoundCount < decoded.derived.jointBoundCount)
+      pPrimitive->pJointBounds = vcGLTF_ArenaAllocType(&pScene->arena, udFloat3, decoded.derived.jointBoundCount * 2);
+
+    if (pPrimitive->pJointBounds != nullptr)
+    {
+      pPrimitive->jointBoundCount = decoded.derived.jointBoundCount;
+      memcpy(pPrimitive->pJointBounds, decoded.derived.pJointBounds, sizeof(udFloat3) * 2 * decoded.derived.jointBoundCount);
+    }
+  }
+
+  if (decoded.bvh.triangleCount > 0)
+  {
+    vcGLTFBVHTriangle *pTriangles = udReallocType(pMesh->bvh.pTriangles, vcGLTFBVHTriangle, pMesh->bvh.triangleCount + decoded.bvh.triangleCount);
+    if (pTriangles == nullptr)
+      return udR_MemoryAllocationFailure;
+
+    memcpy(&pTriangles[pMesh->bvh.triangleCount], decoded.bvh.pTriangles, sizeof(vcGLTFBVHTriangle) * decoded.bvh.triangleCount);
+    pMesh->bvh.pTriangles = pTriangles;
+    pMesh->bvh.triangleCount += decoded.bvh.triangleCount;
+  }
+
+  pPrimitive->features = decoded.featureBits;
+  pPrimitive->indexCount = (pIndexBuffer == nullptr) ? maxCount : indexCount;
+
+  // Compiles the variants now, including the one clustered lighting frames draw lit primitives with; the shader also needs to
+  // be bound when a mesh is created. Material edits that change the feature bits still compile their variant on the next draw
+  int shaderFeatures = decoded.featureBits | vcGLTF_GetMaterialFeatures(pPrimitive->pMaterial);
+  if ((shaderFeatures & vcRSB_Unlit) == 0)
+    vcGLTF_GetShader(shaderFeatures | vcRSB_ClusteredLighting);
+
+  vcShader_Bind(vcGLTF_GetShader(shaderFeatures).pShader);
+
+  pPrimitive->packID = vcGLTF_AppendToPack(pScene, pTypes, totalAttributes, shaderFeatures, pVertData, maxCount, pIndexBuffer, pPrimitive->indexCount, shortIndices, &pPrimitive->indexStart);
+
+  if (pPrimitive->packID == -1)
+  {
+    pScene->loadStats.verticesUploaded += maxCount;
+    pScene->loadStats.indicesUploaded += (pIndexBuffer == nullptr) ? 0 : indexCount;
+    vcGLTF_CountMeshBytes(pScene, pTypes, totalAttributes, maxCount, (pIndexBuffer == nullptr) ? 0 : indexCount, shortIndices);
+
+    if (pIndexBuffer == nullptr)
+      result = vcMesh_Create(&pPrimitive->pMesh, pTypes, totalAttributes, pVertData, maxCount, nullptr, 0, vcMF_NoIndexBuffer | meshFlags);
+    else
+      result = vcMesh_Create(&pPrimitive->pMesh, pTypes, totalAttributes, pVertData, maxCount, pIndexBuffer, indexCount, meshFlags);
+
+    if (result != udR_Success)
+      return result;
+  }
+
+  // Depth only passes fetch just the positions unless the primitive needs skinning or alpha testing (or memory is short)
+  pPrimitive->positionPackID = -1;
+  if (!pScene->reduceMemory && (decoded.featureBits & vcRSB_Skinned) == 0 && !vcGLTF_DepthNeedsAlphaTest(*pPrimitive))
+  {
+    int positionOffset = vcGLTF_GetLayoutOffset(pTypes, totalAttributes, vcVLT_Position3);
+    const vcVertexLayoutTypes positionOnly[] = { vcVLT_Position3 };
+    udFloat3 *pPositions = udAllocType(udFloat3, maxCount, udAF_None);
+
+    if (pPositions == nullptr)
+      return udR_MemoryAllocationFailure;
+
+    for (int vi = 0; vi < maxCount; ++vi)
+      pPositions[vi] = *(const udFloat3*)(pVertData + vertexStride * vi + positionOffset);
+
+    vcShader_Bind(vcGLTF_GetDepthPositionShader().pShader);
+
+    pPrimitive->positionPackID = vcGLTF_AppendToPack(pScene, positionOnly, (int)udLengthOf(positionOnly), -1, (uint8_t*)pPositions, maxCount, pIndexBuffer, pPrimitive->indexCount, shortIndices, &pPrimitive->positionIndexStart);
+
+    if (pPrimitive->positionPackID == -1)
+    {
+      pScene->loadStats.verticesUploaded += maxCount;
+      pScene->loadStats.indicesUploaded += (pIndexBuffer == nullptr) ? 0 : indexCount;
+      vcGLTF_CountMeshBytes(pScene, positionOnly, (int)udLengthOf(positionOnly), maxCount, (pIndexBuffer == nullptr) ? 0 : indexCount, shortIndices);
+
+      if (pIndexBuffer == nullptr)
+        result = vcMesh_Create(&pPrimitive->pPositionMesh, positionOnly, (int)udLengthOf(positionOnly), pPositions, maxCount, nullptr, 0, vcMF_NoIndexBuffer | meshFlags);
+      else
+        result = vcMesh_Create(&pPrimitive->pPositionMesh, positionOnly, (int)udLengthOf(positionOnly), pPositions, maxCount, pIndexBuffer, indexCount, meshFlags);
+    }
+
+    udFree(pPositions);
+  }
+  else
+  {
+    // Compile the depth variant now rather than in the middle of the first shadow pass
+    vcGLTF_GetDepthShader(decoded.featureBits, vcGLTF_DepthNeedsAlphaTest(*pPrimitive));
+  }
+
+  return result;
+}
+
+// The mesh bounds are the union of the primitive bounds; the BVH is built once every primitive has been decoded
+void vcGLTF_FinishMesh(vcGLTFScene *pScene, vcGLTFMesh *pMesh)
+{
+  pMesh->localMin = udFloat3::create(FLT_MAX);
+  pMesh->localMax = udFloat3::create(-FLT_MAX);
+
+  for (int i = 0; i < pMesh->numPrimitives; ++i)
+  {
+    if (vcGLTF_BoundsValid(pMesh->pPrimitives[i].localMin, pMesh->pPrimitives[i].localMax))
+      vcGLTF_ExpandBounds(&pMesh->localMin, &pMesh->localMax, pMesh->pPrimitives[i].localMin, pMesh->pPrimitives[i].localMax);
+  }
+
+  vcGLTF_QueueMeshBVH(pScene, pMesh);
+}
+
+// One primitive's tangents; the loading thread waits on pRemaining until every queued task is done
+struct vcGLTFTangentTask
+{
+  vcGLTFDecodedPrimitive *pDecoded;
+  volatile int32_t *pRemaining;
+};
+
+void vcGLTF_GenerateTangentsTask(void *pData)
+{
+  vcGLTFTangentTask *pTask = (vcGLTFTangentTask*)pData;
+  vcGLTFTraceScope traceScope("Generate tangents");
+
+  vcGLTF_GeneratePrimitiveTangents(pTask->pDecoded);
+  udInterlockedPreDecrement(pTask->pRemaining);
+}
+
+// Generates the tangents here when there's no worker pool
+void vcGLTF_QueueTangents(vcGLTFScene *pScene, vcGLTFDecodedPrimitive *pDecoded, volatile int32_t *pRemaining)
+{
+  if (pScene->pWorkerPool != nullptr)
+  {
+    vcGLTFTangentTask *pTask = udAllocType(vcGLTFTangentTask, 1, udAF_Zero);
+
+    if (pTask != nullptr)
+    {
+      pTask->pDecoded = pDecoded;
+      pTask->pRemaining = pRemaining;
+
+      udInterlockedPreIncrement(pRemaining);
+
+      if (udWorkerPool_AddTask(pScene->pWorkerPool, vcGLTF_GenerateTangentsTask, pTask, true) == udR_Success)
+        return;
+
+      udInterlockedPreDecrement(pRemaining);
+      udFree(pTask);
+    }
+  }
+
+  vcGLTF_GeneratePrimitiveTangents(pDecoded);
+}
+
+// Decodes and uploads the mesh's primitives on the loading thread, with each step run over every primitive so their tangents
+// can be generated on the worker pool together. Streamed meshes decode entirely on the worker pool and upload in
+// vcGLTF_ProcessMeshRequests instead
+udResult vcGLTF_CreateMesh(vcGLTFScene *pScene, int meshID)
+{
+  vcGLTFTraceScope traceScope("Create mesh", meshID);
+  vcGLTFLoadPhase previousPhase = vcGLTF_SetLoadPhase(pScene, vcGLTFLP_MeshDecode);
+  udResult result = udR_Success;
+  vcGLTFMesh *pMesh = &pScene->pMeshes[meshID];
+
+  vcGLTF_BeginMesh(pScene, meshID);
+  vcGLTF_LoadMeshBuffers(pScene, meshID);
+
+  int decodedCount = pMesh->numPrimitives;
+  int primitiveCount = decodedCount; // A primitive that fails a step is dropped along with every one after it
+  vcGLTFDecodedPrimitive *pDecoded = udAllocType(vcGLTFDecodedPrimitive, decodedCount, udAF_Zero);
+  volatile int32_t tangentsRemaining = 0;
+  bool generateTangents = false;
+
+  if (pDecoded == nullptr && decodedCount > 0)
+  {
+    result = udR_MemoryAllocationFailure;
+    decodedCount = 0;
+    primitiveCount = 0;
+  }
+
+  for (int i = 0; i < primitiveCount; ++i)
+  {
+    udResult stepResult = vcGLTF_ReadPrimitive(pScene, meshID, i, &pDecoded[i]);
+
+    if (stepResult != udR_Success)
+    {
+      result = stepResult;
+      primitiveCount = i;
+    }
+  }
+
+  for (int i = 0; i < primitiveCount; ++i)
+  {
+    if (pDecoded[i].generateNormals)
+    {
+      vcGLTF_SetLoadPhase(pScene, vcGLTFLP_NormalGeneration);
+      vcGLTF_GeneratePrimitiveNormals(&pDecoded[i]);
+    }
+
+    generateTangents = generateTangents || pDecoded[i].generateTangents;
+  }
+
+  // The loading thread has the GL context so it's never one of the pool's workers and can wait on them here
+  if (generateTangents)
+  {
+    vcGLTF_SetLoadPhase(pScene, vcGLTFLP_TangentGeneration);
+
+    for (int i = 0; i < primitiveCount; ++i)
+    {
+      if (pDecoded[i].generateTangents)
+        vcGLTF_QueueTangents(pScene, &pDecoded[i], &tangentsRemaining);
+    }
+
+    while (tangentsRemaining > 0)
+      udYield();
+  }
+
+  vcGLTF_SetLoadPhase(pScene, vcGLTFLP_MeshProcessing);
+
+  for (int i = 0; i < primitiveCount; ++i)
+  {
+    udResult stepResult = vcGLTF_FinishPrimitive(pScene, meshID, i, &pDecoded[i]);
+
+    if (stepResult != udR_Success)
+    {
+      result = stepResult;
+      primitiveCount = i;
+    }
+  }
+
+  vcGLTF_SetLoadPhase(pScene, vcGLTFLP_Upload);
+
+  for (int i = 0; i < primitiveCount; ++i)
+  {
+    udResult stepResult = vcGLTF_UploadPrimitive(pScene, pMesh, i, pDecoded[i]);
+
+    if (stepResult != udR_Success)
+    {
+      vcMesh_Destroy(&pMesh->pPrimitives[i].pMesh);
+      vcMesh_Destroy(&pMesh->pPrimitives[i].pPositionMesh);
+      result = stepResult;
+      primitiveCount = i;
+    }
+  }
+
+  pMesh->numPrimitives = primitiveCount;
+
+  for (int i = 0; i < decodedCount; ++i)
+    vcGLTF_FreeDecodedPrimitive(&pDecoded[i]);
+  udFree(pDecoded);
+
+  vcGLTF_SetLoadPhase(pScene, vcGLTFLP_MeshDecode);
+  vcGLTF_FinishMesh(pScene, pMesh);
+  vcGLTF_SetLoadPhase(pScene, previousPhase);
+
+  return result;
+}
+
+struct vcGLTFStreamedMesh
+{
+  int meshID;
+  int primitiveCount;
+  vcGLTFDecodedPrimitive *pPrimitives;
+  udResult result;
+};
+
+// Requested meshes, oldest first, decoded by vcGLTF_DecodeMeshesTask and uploaded by vcGLTF_ProcessMeshRequests
+struct vcGLTFStreamingJob
+{
+  vcGLTFScene *pScene;
+  int meshCount;
+  vcGLTFStreamedMesh *pMeshes;
+
+  volatile int32_t decodedCount; // Meshes before this are ready to upload
+  int uploadedCount;
+};
+
+void vcGLTF_FreeStreamedMesh(vcGLTFStreamedMesh *pStreamed)
+{
+  if (pStreamed->pPrimitives != nullptr)
+  {
+    for (int i = 0; i < pStreamed->primitiveCount; ++i)
+      vcGLTF_FreeDecodedPrimitive(&pStreamed->pPrimitives[i]);
+  }
+
+  udFree(pStreamed->pPrimitives);
+}
+
+void vcGLTF_DestroyStreamingJob(vcGLTFStreamingJob **ppJob)
+{
+  vcGLTFStreamingJob *pJob = *ppJob;
+  if (pJob == nullptr)
+    return;
+
+  for (int i = 0; i < pJob->meshCount; ++i)
+    vcGLTF_FreeStreamedMesh(&pJob->pMeshes[i]);
+
+  udFree(pJob->pMeshes);
+  udFree(*ppJob);
+}
+
+// Only reads the scene; vcGLTF_StartStreamingJob has already loaded the buffers and made the arena allocations. The job may
+// be freed as soon as the last mesh is counted as decoded, so the scene is held on to for the final decrement
+void vcGLTF_DecodeMeshesTask(void *pData)
+{
+  vcGLTFStreamingJob *pJob = (vcGLTFStreamingJob*)pData;
+  vcGLTFScene *pScene = pJob->pScene;
+  int meshCount = pJob->meshCount;
+
+  for (int i = 0; i < meshCount; ++i)
+  {
+    vcGLTFStreamedMesh *pStreamed = &pJob->pMeshes[i];
+    vcGLTFTraceScope traceScope("Decode mesh", pStreamed->meshID);
+
+    pStreamed->result = (pStreamed->pPrimitives == nullptr && pStreamed->primitiveCount > 0) ? udR_MemoryAllocationFailure : udR_Success;
+
+    for (int j = 0; j < pStreamed->primitiveCount && pStreamed->result == udR_Success; ++j)
+      pStreamed->result = vcGLTF_DecodePrimitive(pScene, pStreamed->meshID, j, &pStreamed->pPrimitives[j]);
+
+    udInterlockedPreIncrement(&pJob->decodedCount);
+  }
+
+  udInterlockedPreDecrement(&pScene->pendingTasks);
+}
+
+// Union of the POSITION accessor min & max of each primitive; false if any primitive is missing them
+bool vcGLTF_ReadMeshBounds(const vcGLTFScene *pScene, int meshID, udFloat3 *pMin, udFloat3 *pMax)
+{
+  const vcGLTFMesh &mesh = pScene->pMeshes[meshID];
+
+  *pMin = udFloat3::create(FLT_MAX);
+  *pMax = udFloat3::create(-FLT_MAX);
+
+  for (int i = 0; i < mesh.primitiveDescCount; ++i)
+  {
+    const vcGLTFAccessor &accessor = vcGLTF_GetAccessor(pScene, vcGLTF_FindAttribute(mesh.pPrimitiveDescs[i], "POSITION"));
+    if (!accessor.hasBounds)
+      return false;
+
+    vcGLTF_ExpandBounds(pMin, pMax, accessor.min, accessor.max);
+  }
+
+  return vcGLTF_BoundsValid(*pMin, *pMax);
+}
+
+// With vcGLTFLF_DeferMeshes only the bounds are read until vcGLTF_Render needs the mesh. Skinned meshes and
+// those without POSITION bounds are still created now as their bounds come from the vertices
+void vcGLTF_PrepareMesh(vcGLTFScene *pScene, int meshID, bool skinned)
+{
+  vcGLTFMesh *pMesh = &pScene->pMeshes[meshID];
+
+  if (pMesh->pPrimitives != nullptr)
+    return;
+
+  udFloat3 localMin, localMax;
+  if ((pScene->loadFlags & vcGLTFLF_DeferMeshes) && !skinned && vcGLTF_ReadMeshBounds(pScene, meshID, &localMin, &localMax))
+  {
+    if (pMesh->state == vcGLTFMS_Created)
+    {
+      pMesh->localMin = localMin;
+      pMesh->localMax = localMax;
+      pMesh->state = vcGLTFMS_Deferred;
+    }
+
+    return;
+  }
+
+  vcGLTF_CreateMesh(pScene, meshID);
+  pMesh->state = vcGLTFMS_Created;
+}
+
+udResult vcGLTF_ProcessChildNode(vcGLTFScene *pScene, const vcGLTFDocument &document, int nodeIndex, udFloat4x4 parentMatrix, vcGLTFNode *pParentNode)
+{
+  if (nodeIndex < 0 || nodeIndex >= pScene->nodeCount)
+    return udR_ObjectNotFound;
+
+  const vcGLTFNodeDesc &child = document.pNodes[nodeIndex];
+  vcGLTFNode *pNode = &pScene->pNodes[nodeIndex];
+
+  if (pNode->pParent != nullptr && pNode->pParent != pParentNode)
+    __debugbreak(); // This means this node has multiple parents
+
+  pNode->pParent = pParentNode;
+  pNode->dirty = true;
+
+  // vcGLTF_ParseNode already split any matrix into these
+  udFloat4x4 childMatrix = udFloat4x4::rotationQuat(pNode->rotation, pNode->translation) * udFloat4x4::scaleNonUniform(pNode->scale);
+  udFloat4x4 chainedMatrix = parentMatrix * childMatrix;
+
+  if (child.mesh != -1)
+  {
+    vcGLTFMeshInstance *pMesh = pScene->meshInstances.PushBack();
+
+    pMesh->pNode = pNode;
+    pMesh->meshID = child.mesh;
+    pMesh->skinID = child.skin;
+
+    if (pMesh->skinID >= pScene->skinCount)
+      pMesh->skinID = -1;
+
+    if (pMesh->meshID >= pScene->meshCount)
+      pMesh->meshID = 0;
+
+    vcGLTF_PrepareMesh(pScene, pMesh->meshID, pMesh->skinID >= 0);
+
+    pMesh->lodMeshCount = 1;
+    pMesh->lodMeshIDs[0] = pMesh->meshID;
+    memset(pMesh->lodCoverage, 0, sizeof(pMesh->lodCoverage));
+
+    // MSFT_lod lists nodes whose meshes are progressively coarser versions of this one
+    for (int lod = 0; lod < child.lodCount && pMesh->lodMeshCount < vcGLTFLimit_LODCount; ++lod)
+    {
+      int lodNode = child.lodNodes[lod];
+      int lodMeshID = (lodNode >= 0 && lodNode < pScene->nodeCount) ? document.pNodes[lodNode].mesh : -1;
+      if (lodMeshID < 0 || lodMeshID >= pScene->meshCount)
+        break;
+
+      vcGLTF_PrepareMesh(pScene, lodMeshID, pMesh->skinID >= 0);
+
+      pMesh->lodMeshIDs[pMesh->lodMeshCount] = lodMeshID;
+      ++pMesh->lodMeshCount;
+    }
+
+    for (int lod = 0; lod < child.coverageCount && lod <= pMesh->lodMeshCount; ++lod)
+      pMesh->lodCoverage[lod] = child.coverage[lod];
+  }
+  else if (child.hasCamera)
+  {
+    // We don't care about these
+  }
+  else if (child.hasOtherMembers)
+  {
+    __debugbreak(); // New node type
+  }
+
+  for (int i = 0; i < pNode->childCount; ++i)
+    vcGLTF_ProcessChildNode(pScene, document, (int)(pNode->ppChildren[i] - pScene->pNodes), chainedMatrix, pNode);
+
+  return udR_Success;
+}
+
+// The samplers and channels were allocated by vcGLTF_ParseDocument; this reads their keys and links the channels up
+udResult vcGLTF_LoadAnimations(vcGLTFScene *pScene, const vcGLTFDocument &document)
+{
+  udResult result = udR_Success;
+
+  // The key sizes come from the accessors so they couldn't be part of vcGLTF_EstimateArenaSize
+  size_t keyBytes = 0;
+  for (int i = 0; i < pScene->animationCount; ++i)
+  {
+    for (int samplerIndex = 0; samplerIndex < pScene->pAnimations[i].numSamplers; ++samplerIndex)
+    {
+      keyBytes += vcGLTF_ArenaBytes((size_t)vcGLTF_GetAccessor(pScene, document.pAnimations[i].pSamplerInputs[samplerIndex]).count * sizeof(float));
+      keyBytes += vcGLTF_ArenaBytes((size_t)vcGLTF_GetAccessor(pScene, document.pAnimations[i].pSamplerOutputs[samplerIndex]).count * sizeof(udFloatQuat));
+    }
+  }
+  vcGLTF_ArenaReserve(&pScene->arena, keyBytes);
+
+  for (int i = 0; i < pScene->animationCount; ++i)
+  {
+    vcGLTF_LogProgress(pScene, "\t\tLoading Animation %d\n", i);
+
+    vcGLTFAnimation *pAnim = &pScene->pAnimations[i];
+    const vcGLTFAnimationDesc &desc = document.pAnimations[i];
+
+    for (int samplerIndex = 0; samplerIndex < pAnim->numSamplers; ++samplerIndex)
+    {
+      int totalOffset = 0;
+
+      int inputAccessor = desc.pSamplerInputs[samplerIndex];
+      int inputCount = (int)vcGLTF_GetAccessor(pScene, inputAccessor).count;
+
+      pAnim->pSamplers[samplerIndex].steps = inputCount;
+      pAnim->pSamplers[samplerIndex].pTime = vcGLTF_ArenaAllocType(&pScene->arena, float, inputCount);
+      vcGLTF_ReadAccessor(pScene, inputAccessor, &totalOffset, inputCount, (uint8_t*)pAnim->pSamplers[samplerIndex].pTime, 0);
+
+      int outputAccessor = desc.pSamplerOutputs[samplerIndex];
+      int outputCount = (int)vcGLTF_GetAccessor(pScene, outputAccessor).count;
+      int outputType = vcGLTF_GetAccessor(pScene, outputAccessor).componentType;
+
+      const char *pOutputType = vcGLTF_GetAccessor(pScene, outputAccessor).type;
+
+      if (pAnim->pSamplers[samplerIndex].interpolationMethod != vcGLTFInterpolation_CublicSpline && inputCount != outputCount)
+        __debugbreak();
+
+      if (pAnim->pSamplers[samplerIndex].interpolationMethod == vcGLTFInterpolation_CublicSpline && inputCount != (outputCount/3))
+        __debugbreak();
+
+      totalOffset = 0;
+
+      if (outputType == vcGLTFType_F32)
+      {
+        if (udStrEqual(pOutputType, "VEC4"))
+        {
+          pAnim->pSamplers[samplerIndex].pOutputFloatQuat = vcGLTF_ArenaAllocType(&pScene->arena, udFloatQuat, outputCount);
+          pAnim->pSamplers[samplerIndex].outputBytes = outputCount * sizeof(udFloatQuat);
+          vcGLTF_ReadAccessor(pScene, outputAccessor, &totalOffset, outputCount, (uint8_t*)pAnim->pSamplers[samplerIndex].pOutputFloatQuat, 0);
+        }
+        else if(udStrEqual(pOutputType, "VEC3"))
+        {
+          pAnim->pSamplers[samplerIndex].pOutputFloat3 = vcGLTF_ArenaAllocType(&pScene->arena, udFloat3, outputCount);
+          pAnim->pSamplers[samplerIndex].outputBytes = outputCount * sizeof(udFloat3);
+          vcGLTF_ReadAccessor(pScene, outputAccessor, &totalOffset, outputCount, (uint8_t*)pAnim->pSamplers[samplerIndex].pOutputFloat3, 0);
+        }
+        else
+        {
+          __debugbreak();
+        }
+      }
+      else
+      {
+        __debugbreak();
+      }
+    }
+
+    for (int channelIndex = 0; channelIndex < pAnim->numChannels; ++channelIndex)
+    {
+      int nodeIndex = pAnim->pChannels[channelIndex].nodeIndex;
+      int samplerIndex = desc.pChannelSamplers[channelIndex];
+
+      if (nodeIndex < 0 || nodeIndex > pScene->nodeCount)
+        __debugbreak();
+
+      if (samplerIndex < 0 || samplerIndex > pAnim->numSamplers)
+        __debugbreak();
+
+      pAnim->pChannels[channelIndex].pSampler = &pAnim->pSamplers[samplerIndex];
+
+      pAnim->totalTime = udMax(pAnim->totalTime, pAnim->pChannels[channelIndex].pSampler->pTime[pAnim->pChannels[channelIndex].pSampler->steps - 1]);
+    }
+  }
+
+  return result;
+}
+
+// The joints were read by vcGLTF_ParseDocument; only the inverse bind matrices are left
+udResult vcGLTF_LoadSkins(vcGLTFScene *pScene, const vcGLTFDocument &document)
+{
+  for (int i = 0; i < pScene->skinCount; ++i)
+  {
+    if (pScene->pSkins[i].jointCount > vcGLTFLimit_JointCount)
+      __debugbreak();
+
+    int inverseBinds = document.pSkinInverseBinds[i];
+    if (inverseBinds != -1)
+    {
+      pScene->pSkins[i].pInverseBindMatrices = vcGLTF_ArenaAllocType(&pScene->arena, udFloat4x4, pScene->pSkins[i].jointCount);
+
+      int offset = 0;
+      vcGLTF_ReadAccessor(pScene, inverseBinds, &offset, pScene->pSkins[i].jointCount, (uint8_t*)pScene->pSkins[i].pInverseBindMatrices, 0);
+    }
+  }
+
+  return udR_Success;
+}
+
+void vcGLTF_UpdateInstanceBounds(vcGLTFScene *pScene)
+{
+  for (size_t i = 0; i < pScene->meshInstances.length; ++i)
+  {
+    vcGLTFMeshInstance *pInstance = &pScene->meshInstances[i];
+    vcGLTFMesh *pMesh = &pScene->pMeshes[pInstance->meshID];
+    udFloat4x4 nodeMatrix = pInstance->pNode->GetMat(false);
+
+    pInstance->sceneMin = udFloat3::create(FLT_MAX);
+    pInstance->sceneMax = udFloat3::create(-FLT_MAX);
+
+    if (pInstance->skinID >= 0 && pInstance->skinID < pScene->skinCount)
+    {
+      vcGLTFSkin *pSkin = &pScene->pSkins[pInstance->skinID];
+      udFloat3 skinnedMin = udFloat3::create(FLT_MAX);
+      udFloat3 skinnedMax = udFloat3::create(-FLT_MAX);
+
+      for (int p = 0; p < pMesh->numPrimitives; ++p)
+      {
+        const vcGLTFMeshPrimitive &prim = pMesh->pPrimitives[p];
+
+        if (prim.pJointBounds == nullptr)
+        {
+          if (vcGLTF_BoundsValid(prim.localMin, prim.localMax))
+            vcGLTF_ExpandBounds(&skinnedMin, &skinnedMax, prim.localMin, prim.localMax);
+          continue;
+        }
+
+        for (int j = 0; j < prim.jointBoundCount && j < pSkin->jointCount; ++j)
+        {
+          if (!vcGLTF_BoundsValid(prim.pJointBounds[j * 2 + 0], prim.pJointBounds[j * 2 + 1]))
+            continue;
+
+          udFloat4x4 jointMatrix = pScene->pNodes[pSkin->pJoints[j]].GetMat(false);
+          if (pSkin->pInverseBindMatrices != nullptr)
+            jointMatrix = jointMatrix * pSkin->pInverseBindMatrices[j];
+
+          udFloat3 jointMin, jointMax;
+          vcGLTF_TransformBounds(jointMatrix, prim.pJointBounds[j * 2 + 0], prim.pJointBounds[j * 2 + 1], &jointMin, &jointMax);
+          vcGLTF_ExpandBounds(&skinnedMin, &skinnedMax, jointMin, jointMax);
+        }
+      }
+
+      if (vcGLTF_BoundsValid(skinnedMin, skinnedMax))
+        vcGLTF_TransformBounds(nodeMatrix, skinnedMin, skinnedMax, &pInstance->sceneMin, &pInstance->sceneMax);
+    }
+    else if (vcGLTF_BoundsValid(pMesh->localMin, pMesh->localMax))
+    {
+      vcGLTF_TransformBounds(nodeMatrix, pMesh->localMin, pMesh->localMax, &pInstance->sceneMin, &pInstance->sceneMax);
+    }
+  }
+}
+
+void vcGLTF_BuildInstanceBVH(vcGLTFScene *pScene)
+{
+  int instanceCount = (int)pScene->meshInstances.length;
+  if (instanceCount == 0)
+    return;
+
+  udFloat3 *pInstanceMin = udAllocType(udFloat3, instanceCount, udAF_None);
+  udFloat3 *pInstanceMax = udAllocType(udFloat3, instanceCount, udAF_None);
+
+  for (int i = 0; i < instanceCount; ++i)
+  {
+    pInstanceMin[i] = pScene->meshInstances[i].sceneMin;
+    pInstanceMax[i] = pScene->meshInstances[i].sceneMax;
+
+    // Instances without geometry still need a slot; they are refit to the correct bounds later
+    if (!vcGLTF_BoundsValid(pInstanceMin[i], pInstanceMax[i]))
+      pInstanceMin[i] = pInstanceMax[i] = udFloat3::zero();
+  }
+
+  pScene->instanceNodeCount = vcGLTF_BuildBVH(pInstanceMin, pInstanceMax, instanceCount, 1, &pScene->pInstanceNodes, &pScene->pInstanceOrder, &pScene->instanceMaxDepth);
+
+  udFree(pInstanceMin);
+  udFree(pInstanceMax);
+}
+
+// Topology is kept from the load-time build; only the bounds follow the animated instances
+void vcGLTF_RefitInstanceBVH(vcGLTFScene *pScene)
+{
+  for (int n = pScene->instanceNodeCount - 1; n >= 0; --n)
+  {
+    vcGLTFBVHNode *pNode = &pScene->pInstanceNodes[n];
+
+    if (pNode->itemCount > 0)
+    {
+      pNode->boundsMin = udFloat3::create(FLT_MAX);
+      pNode->boundsMax = udFloat3::create(-FLT_MAX);
+
+      for (int i = pNode->leftFirst; i < pNode->leftFirst + pNode->itemCount; ++i)
+      {
+        const vcGLTFMeshInstance &instance = pScene->meshInstances[pScene->pInstanceOrder[i]];
+        if (vcGLTF_BoundsValid(instance.sceneMin, instance.sceneMax))
+          vcGLTF_ExpandBounds(&pNode->boundsMin, &pNode->boundsMax, instance.sceneMin, instance.sceneMax);
+      }
+    }
+    else
+    {
+      pNode->boundsMin = udMin(pScene->pInstanceNodes[pNode->leftFirst].boundsMin, pScene->pInstanceNodes[pNode->leftFirst + 1].boundsMin);
+      pNode->boundsMax = udMax(pScene->pInstanceNodes[pNode->leftFirst].boundsMax, pScene->pInstanceNodes[pNode->leftFirst + 1].boundsMax);
+    }
+  }
+}
+
+int vcGLTF_AccessorComponents(const char *pAccessorType)
+{
+  const char *typeNames[] = { "SCALAR", "VEC2", "VEC3", "VEC4", "MAT2", "MAT3", "MAT4" };
+  const int components[] = { 1, 2, 3, 4, 4, 9, 16 };
+  UDCOMPILEASSERT(udLengthOf(typeNames) == udLengthOf(components), "Array out of date!");
+
+  for (size_t i = 0; i < udLengthOf(typeNames); ++i)
+  {
+    if (udStrEqual(typeNames[i], pAccessorType))
+      return components[i];
+  }
+
+  return 0;
+}
+
+// Decoded RGBA8 size of a PNG or JPEG from the start of its encoded bytes; 0 if the dimensions aren't in pHeader
+int64_t vcGLTF_ImageBytesFromHeader(const uint8_t *pHeader, size_t headerBytes)
+{
+  const uint8_t pngSignature[] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+  // IHDR is always the first chunk
+  if (headerBytes >= 24 && memcmp(pHeader, pngSignature, sizeof(pngSignature)) == 0)
+  {
+    int64_t width = ((int64_t)pHeader[16] << 24) | (pHeader[17] << 16) | (pHeader[18] << 8) | pHeader[19];
+    int64_t height = ((int64_t)pHeader[20] << 24) | (pHeader[21] << 16) | (pHeader[22] << 8) | pHeader[23];
+    return width * height * 4;
+  }
+
+  // Walk the JPEG segments to the first start of frame
+  if (headerBytes >= 4 && pHeader[0] == 0xFF && pHeader[1] == 0xD8)
+  {
+    size_t offset = 2;
+    while (offset + 9 <= headerBytes && pHeader[offset] == 0xFF)
+    {
+      uint8_t marker = pHeader[offset + 1];
+      if (marker == 0xFF)
+      {
+        ++offset; // Fill byte
+        continue;
+      }
+
+      if (marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC)
+      {
+        int64_t height = (pHeader[offset + 5] << 8) | pHeader[offset + 6];
+        int64_t width = (pHeader[offset + 7] << 8) | pHeader[offset + 8];
+        return width * height * 4;
+      }
+
+      if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD8))
+        offset += 2; // No length
+      else
+        offset += 2 + ((pHeader[offset + 2] << 8) | pHeader[offset + 3]);
+    }
+  }
+
+  return 0;
+}
+
+// GPU bytes for an image uri; from the decoded dimensions where the header is readable, otherwise the encoded size
+int64_t vcGLTF_EstimateImageBytes(vcGLTFScene *pScene, const char *pURI)
+{
+  const size_t HeaderBytes = 64 * 1024;
+
+  uint8_t *pHeader = udAllocType(uint8_t, HeaderBytes, udAF_None);
+  size_t headerBytes = 0;
+  int64_t encodedBytes = 0;
+  int64_t imageBytes = 0;
+
+  if (pHeader == nullptr)
+    return 0;
+
+  if (udStrBeginsWith(pURI, "data:"))
+  {
+    const char *pBase64 = strstr(pURI, ";base64,");
+    if (pBase64 != nullptr)
+    {
+      pBase64 += 8;
+      uint32_t bits = 0;
+      int bitCount = 0;
+
+      for (const char *pChar = pBase64; *pChar != '\0' && *pChar != '='; ++pChar)
+      {
+        ++encodedBytes;
+        if (headerBytes == HeaderBytes)
+          continue;
+
+        char c = *pChar;
+        int value = (c >= 'A' && c <= 'Z') ? c - 'A' : (c >= 'a' && c <= 'z') ? c - 'a' + 26 : (c >= '0' && c <= '9') ? c - '0' + 52 : (c == '+') ? 62 : (c == '/') ? 63 : -1;
+        if (value < 0)
+          continue;
+
+        bits = (bits << 6) | value;
+        bitCount += 6;
+        if (bitCount >= 8)
+        {
+          bitCount -= 8;
+          pHeader[headerBytes++] = (uint8_t)(bits >> bitCount);
+        }
+      }
+
+      encodedBytes = encodedBytes * 3 / 4;
+    }
+  }
+  else
+  {
+    udFile *pFile = nullptr;
+    if (udFile_Open(&pFile, udTempStr("%s/%s", pScene->pPath, pURI), udFOF_Read, &encodedBytes) == udR_Success)
+    {
+      udFile_Read(pFile, pHeader, (size_t)udMin((int64_t)HeaderBytes, encodedBytes), 0, udFSW_SeekSet, &headerBytes);
+      udFile_Close(&pFile);
+    }
+  }
+
+  imageBytes = vcGLTF_ImageBytesFromHeader(pHeader, headerBytes);
+  udFree(pHeader);
+
+  return (imageBytes > 0) ? imageBytes : encodedBytes;
+}
+
+// Upper bound of what loading will allocate, made from the JSON and image headers so it can be checked before any buffers are read.
+// The GPU bytes are the meshes, the texture bytes the images and the derived bytes are the data vcGLTFScene::reduceMemory skips
+void vcGLTF_EstimateMemory(vcGLTFScene *pScene, const vcGLTFDocument &document, int64_t *pHostBytes, int64_t *pGPUBytes, int64_t *pTextureBytes, int64_t *pDerivedGPUBytes)
+{
+  int64_t hostBytes = 0;
+  int64_t gpuBytes = 0;
+  int64_t textureBytes = 0;
+  int64_t derivedGPUBytes = 0;
+
+  for (int i = 0; i < pScene->bufferCount; ++i)
+    hostBytes += pScene->pBuffers[i].byteLength;
+
+  for (int meshID = 0; meshID < pScene->meshCount; ++meshID)
+  {
+    const vcGLTFMesh &mesh = pScene->pMeshes[meshID];
+
+    for (int i = 0; i < mesh.primitiveDescCount; ++i)
+    {
+      const vcGLTFPrimitiveDesc &primitive = mesh.pPrimitiveDescs[i];
+
+      // Everything is decoded to 32-bit components
+      int64_t vertexCount = vcGLTF_GetAccessor(pScene, vcGLTF_FindAttribute(primitive, "POSITION")).count;
+      int64_t vertexBytes = 0;
+
+      for (int j = 0; j < primitive.attributeCount; ++j)
+        vertexBytes += vertexCount * vcGLTF_AccessorComponents(vcGLTF_GetAccessor(pScene, primitive.pAttributes[j].accessor).type) * sizeof(float);
+
+      if (vcGLTF_FindAttribute(primitive, "NORMAL") == -1)
+        vertexBytes += vertexCount * sizeof(udFloat3);
+
+      int indexAccessor = primitive.indices;
+      int64_t indexCount = (indexAccessor == -1) ? vertexCount : vcGLTF_GetAccessor(pScene, indexAccessor).count;
+      int64_t indexBytes = (indexAccessor == -1) ? 0 : indexCount * sizeof(uint32_t);
+
+      gpuBytes += vertexBytes + indexBytes;
+      hostBytes += (indexCount / 3) * sizeof(vcGLTFBVHTriangle);
+
+      int material = primitive.material;
+      if (document.pMaterials != nullptr && material >= 0 && material < pScene->materialCount && vcGLTF_FindAttribute(primitive, "TANGENT") == -1 && document.pMaterials[material].normalTexture != -1)
+        derivedGPUBytes += vertexCount * sizeof(udFloat4);
+
+      if (vcGLTF_FindAttribute(primitive, "JOINTS_0") == -1)
+        derivedGPUBytes += vertexCount * sizeof(udFloat3) + indexBytes;
+
+      if (pScene->loadFlags & vcGLTFLF_GenerateLODs)
+        derivedGPUBytes += indexBytes; // Each level is at most half the one above
+    }
+  }
+
+  // vcGLTF_LoadTexture only creates textures from uris
+  for (int i = 0; i < document.imageCount; ++i)
+  {
+    const char *pURI = document.ppImageURIs[i];
+    if (pURI != nullptr)
+      textureBytes += vcGLTF_EstimateImageBytes(pScene, pURI);
+  }
+
+  *pHostBytes = hostBytes;
+  *pGPUBytes = gpuBytes;
+  *pTextureBytes = textureBytes;
+  *pDerivedGPUBytes = derivedGPUBytes;
+}
+
+void vcGLTF_LockMemoryBudget()
+{
+  while (udInterlockedCompareExchange(&s_gltfMemoryBudget.lock, 1, 0) != 0)
+    udYield();
+}
+
+void vcGLTF_UnlockMemoryBudget()
+{
+  udInterlockedExchange(&s_gltfMemoryBudget.lock, 0);
+}
+
+// Replaces what the scene has charged against the global budget
+void vcGLTF_ChargeMemory(vcGLTFScene *pScene, int64_t hostBytes, int64_t gpuBytes)
+{
+  vcGLTF_LockMemoryBudget();
+  s_gltfMemoryBudget.hostCharged += hostBytes - pScene->chargedHostBytes;
+  s_gltfMemoryBudget.gpuCharged += gpuBytes - pScene->chargedGPUBytes;
+  vcGLTF_UnlockMemoryBudget();
+
+  pScene->chargedHostBytes = hostBytes;
+  pScene->chargedGPUBytes = gpuBytes;
+}
+
+// Stops generating LODs, tangents and depth position streams for the meshes created from now on
+void vcGLTF_ReduceMemory(vcGLTFScene *pScene)
+{
+  if (pScene->reduceMemory)
+    return;
+
+  pScene->reduceMemory = true;
+  pScene->loadFlags = (vcGLTFLoadFlags)(pScene->loadFlags & ~vcGLTFLF_GenerateLODs);
+  vcGLTF_LogProgress(pScene, "\tOver the GPU memory budget; skipping generated LODs, tangents and depth position streams\n");
+}
+
+// Charges the estimate before loading; falls back to reduceMemory if only the derived data doesn't fit
+udResult vcGLTF_ReserveMemory(vcGLTFScene *pScene, const vcGLTFDocument &document)
+{
+  int64_t hostBytes = 0;
+  int64_t meshBytes = 0;
+  int64_t textureBytes = 0;
+  int64_t derivedGPUBytes = 0;
+  udResult result = udR_Success;
+
+  vcGLTF_EstimateMemory(pScene, document, &hostBytes, &meshBytes, &textureBytes, &derivedGPUBytes);
+
+  // Deferred scenes only upload the meshes that get drawn and stop creating them while the GPU budget is full, so only their
+  // textures are charged up front. Their meshes still decide whether the derived data fits
+  int64_t gpuBytes = textureBytes + ((pScene->loadFlags & vcGLTFLF_DeferMeshes) ? 0 : meshBytes);
+  bool reduceMemory = false;
+
+  vcGLTF_LockMemoryBudget();
+
+  const vcGLTFMemoryBudget &budget = s_gltfMemoryBudget;
+  if (budget.hostBudget > 0 && budget.hostCharged + hostBytes > budget.hostBudget)
+    result = udR_MemoryAllocationFailure;
+  else if (budget.gpuBudget > 0 && budget.gpuCharged + gpuBytes > budget.gpuBudget)
+    result = udR_MemoryAllocationFailure;
+  else if (budget.gpuBudget > 0 && budget.gpuCharged + textureBytes + meshBytes + derivedGPUBytes > budget.gpuBudget)
+    reduceMemory = true;
+
+  if (result == udR_Success)
+  {
+    pScene->chargedHostBytes = hostBytes;
+    pScene->chargedGPUBytes = gpuBytes + ((reduceMemory || (pScene->loadFlags & vcGLTFLF_DeferMeshes)) ? 0 : derivedGPUBytes);
+    s_gltfMemoryBudget.hostCharged += pScene->chargedHostBytes;
+    s_gltfMemoryBudget.gpuCharged += pScene->chargedGPUBytes;
+  }
+
+  vcGLTF_UnlockMemoryBudget();
+
+  if (reduceMemory)
+    vcGLTF_ReduceMemory(pScene);
+
+  if (result != udR_Success)
+    vcGLTF_LogProgress(pScene, "\tOver the memory budget (estimated %lld host bytes, %lld GPU bytes)\n", (long long)hostBytes, (long long)gpuBytes);
+
+  return result;
+}
+
+udResult vcGLTF_Load(vcGLTFScene **ppScene, const char *pFilename, udWorkerPool *pWorkerPool, vcGLTFLoadFlags flags /*= vcGLTFLF_None*/)
+{
+  vcGLTFTraceScope traceScope("vcGLTF_Load");
+  udResult result = udR_Failure_;
+  
+  vcGLTFScene *pScene = udAllocType(vcGLTFScene, 1, udAF_Zero);
+
+  pScene->pWorkerPool = pWorkerPool;
+  pScene->loadFlags = flags;
+  pScene->meshInstances.Init(8);
+
+  uint64_t loadStart = udPerfCounterStart();
+  int64_t fileSize = 0;
+  pScene->loadPhase = vcGLTFLP_Count;
+  pScene->loading = true;
+  vcGLTF_SetLoadPhase(pScene, vcGLTFLP_Parse);
+
+  char *pData = nullptr;
+  vcGLTFDocumentCounts counts = {};
+  vcGLTFDocument document = {};
+  const vcGLTFSceneDesc *pBaseScene = nullptr;
+
+  udFilename path(pFilename);
+  int pathLen = 0;
+  vcGLTFMemoryUsage memoryUsage = {};
+
+  vcGLTF_LogProgress(pScene, "Loading %s\n", pFilename);
+  UD_ERROR_CHECK(udFile_Load(pFilename, &pData, &fileSize));
+  pScene->loadStats.fileBytesRead += fileSize;
+
+  // Counted first so the whole document streams into one arena block
+  UD_ERROR_CHECK(vcGLTF_CountDocument(pData, &counts));
+
+  pathLen = path.ExtractFolder(nullptr, 0);
+  pScene->arena.blockSize = vcGLTF_EstimateArenaSize(counts, pathLen + 1);
+  pScene->pPath = vcGLTF_ArenaAllocType(&pScene->arena, char, pathLen + 1);
+  path.ExtractFolder(pScene->pPath, pathLen + 1);
+
+  UD_ERROR_CHECK(vcGLTF_ParseDocument(pScene, &document, pData));
+
+  if (pScene->materialCount == 0) // Need at least the "default" material
+  {
+    pScene->materialCount = 1;
+    pScene->pMaterials = vcGLTF_ArenaAllocType(&pScene->arena, vcGLTFMaterial, 1);
+    UD_ERROR_NULL(pScene->pMaterials, udR_MemoryAllocationFailure);
+    vcGLTF_DefaultMaterial(pScene->pMaterials);
+  }
+
+  vcGLTF_LogProgress(pScene, "\t%d nodes\n", pScene->nodeCount);
+  vcGLTF_LogProgress(pScene, "\t%d buffers\n", pScene->bufferCount);
+  vcGLTF_LogProgress(pScene, "\t%d meshes\n", pScene->meshCount);
+  vcGLTF_LogProgress(pScene, "\t%d materials\n", pScene->materialCount);
+
+  if ((pScene->loadFlags & vcGLTFLF_DeferMeshes) && pScene->meshCount > 0)
+    pScene->pMeshRequests = udAllocType(int, pScene->meshCount, udAF_None);
+  pScene->streamingBudgetMs = 4.f;
+  pScene->streamingFrame = -1;
+
+  if (document.scene >= 0 && document.scene < document.sceneCount)
+    pBaseScene = &document.pScenes[document.scene];
+
+  UD_ERROR_CHECK(vcGLTF_ReserveMemory(pScene, document));
+
+  // Load Scene, Nodes & Meshes
+  vcGLTF_SetLoadPhase(pScene, vcGLTFLP_Materials);
+  for (int i = 0; i < pScene->materialCount; ++i)
+    vcGLTF_LoadMaterial(pScene, document, i);
+
+  vcGLTF_SetLoadPhase(pScene, vcGLTFLP_Nodes);
+
+  for (int i = 0; pBaseScene != nullptr && i < pBaseScene->nodeCount; ++i)
+  {
+    int nodeID = pBaseScene->pNodes[i];
+    vcGLTF_LogProgress(pScene, "\tLoading scene node %d (nodeID: %d)\n", i+1, nodeID);
+    vcGLTF_ProcessChildNode(pScene, document, nodeID, udFloat4x4::identity(), nullptr);
+  }
+
+  UD_ERROR_CHECK(vcGLTF_BitsetInit(&pScene->meshVisibility, pScene->meshCount, true));
+  UD_ERROR_CHECK(vcGLTF_BitsetInit(&pScene->nodeVisibility, pScene->nodeCount, true));
+  UD_ERROR_CHECK(vcGLTF_BitsetInit(&pScene->visibleNodes, pScene->nodeCount, false));
+  UD_ERROR_CHECK(vcGLTF_BitsetInit(&pScene->visibleInstances, pScene->meshInstances.length, false));
+  pScene->visibilityDirty = true;
+
+  vcGLTF_SetLoadPhase(pScene, vcGLTFLP_Animations);
+  vcGLTF_LogProgress(pScene, "\tLoading animations\n");
+  vcGLTF_LoadAnimations(pScene, document);
+
+  if (pScene->skinCount > 0)
+  {
+    vcGLTF_SetLoadPhase(pScene, vcGLTFLP_Skins);
+    vcGLTF_LogProgress(pScene, "\tLoading skins\n");
+    vcGLTF_LoadSkins(pScene, document);
+  }
+
+  vcGLTF_SetLoadPhase(pScene, vcGLTFLP_Upload);
+  vcGLTF_CreatePackedMeshes(pScene);
+
+  vcGLTF_SetLoadPhase(pScene, vcGLTFLP_Finalize);
+  vcGLTF_UpdateInstanceBounds(pScene);
+  vcGLTF_BuildInstanceBVH(pScene);
+
+  vcGLTF_SetLoadPhase(pScene, vcGLTFLP_Count);
+  pScene->loading = false;
+  pScene->loadStats.totalMilliseconds = udPerfCounterMilliseconds(loadStart);
+
+  // The estimate is replaced by what was actually allocated
+  vcGLTF_GetMemoryUsage(pScene, &memoryUsage);
+  vcGLTF_ChargeMemory(pScene, memoryUsage.hostTotal, memoryUsage.gpuTotal);
+
+  if (pScene->loadFlags & vcGLTFLF_LogProgress)
+  {
+    for (int i = 0; i < vcGLTFLP_Count; ++i)
+      printf("\t%-20s %9.2fms\n", g_vcGLTFLoadPhaseNames[i], pScene->loadStats.phaseMilliseconds[i]);
+
+    printf("\t%-20s %9.2fms\n", "Total", pScene->loadStats.totalMilliseconds);
+    printf("\t%lld file bytes, %lld accessor bytes, %lld vertices, %lld indices, %d textures\n", (long long)pScene->loadStats.fileBytesRead, (long long)pScene->loadStats.accessorBytesDecoded, (long long)pScene->loadStats.verticesUploaded, (long long)pScene->loadStats.indicesUploaded, pScene->loadStats.texturesRequested);
+    printf("\t%lld host bytes, %lld GPU bytes\n", (long long)memoryUsage.hostTotal, (long long)memoryUsage.gpuTotal);
+  }
+
+  result = udR_Success;
+  *ppScene = pScene;
+  pScene = nullptr;
+
+epilogue:
+  if (pScene != nullptr)
+  {
+    vcGLTF_LogProgress(pScene, "\tLoading failed. Status: %s\n", udResultAsString(result));
+    vcGLTF_Destroy(&pScene);
+  }
+  else if (*ppScene != nullptr)
+  {
+    vcGLTF_LogProgress(*ppScene, "\tLoading complete. Status: %s\n", udResultAsString(result));
+  }
+
+  vcGLTF_DestroyDocument(&document);
+  udFree(pData); // After the document, which points into it
+
+  return result;
+}
+
+void vcGLTF_Destroy(vcGLTFScene **ppScene)
+{
+  if (ppScene == nullptr || *ppScene == nullptr)
+    return;
+
+  vcGLTFScene *pScene = *ppScene;
+  *ppScene = nullptr;
+
+  while (pScene->pendingTasks > 0)
+    udSleep(1);
+
+  vcGLTF_ChargeMemory(pScene, 0, 0);
+
+  for (int i = 0; i < pScene->meshCount; ++i)
+  {
+    for (int j = 0; j < pScene->pMeshes[i].numPrimitives; ++j)
+    {
+      // Shared meshes are destroyed with their pack
+      if (pScene->pMeshes[i].pPrimitives[j].packID == -1)
+        vcMesh_Destroy(&pScene->pMeshes[i].pPrimitives[j].pMesh);
+      if (pScene->pMeshes[i].pPrimitives[j].positionPackID == -1)
+        vcMesh_Destroy(&pScene->pMeshes[i].pPrimitives[j].pPositionMesh);
+    }
+
+    udFree(pScene->pMeshes[i].bvh.pNodes);
+    udFree(pScene->pMeshes[i].bvh.pTriangles);
+  }
+
+  for (int i = 0; i < pScene->packCount; ++i)
+  {
+    vcMesh_Destroy(&pScene->pPacks[i].pMesh);
+    udFree(pScene->pPacks[i].pVertData);
+    udFree(pScene->pPacks[i].pIndices);
+  }
+  udFree(pScene->pPacks);
+
+  udFree(pScene->pInstanceNodes);
+  udFree(pScene->pInstanceOrder);
+
+  udFree(pScene->pTransparentItems);
+  udFree(pScene->pTransparentKeys);
+  udFree(pScene->pTransparentOrder);
+  udFree(pScene->pCachedConstants);
+  udFree(pScene->pCachedPalette);
+
+  udFree(pScene->lightGrid.pCellStarts);
+  udFree(pScene->lightGrid.pEntries);
+  udFree(pScene->lightGrid.pGlobalLights);
+  udFree(pScene->lightGrid.pStamps);
+
+  vcTexture_Destroy(&pScene->clusters.pGridTexture);
+  vcTexture_Destroy(&pScene->clusters.pLightTexture);
+  vcTexture_Destroy(&pScene->clusters.pIndexTexture);
+  udFree(pScene->clusters.pLightTexels);
+  udFree(pScene->clusters.pIndexTexels);
+  udFree(pScene->clusters.pLightRanges);
+
+  udFree(pScene->occlusion.pLevels[0]); // All levels share one allocation
+
+  for (int i = 0; i < pScene->materialCount; ++i)
+  {
+    ttTextureCache_Release(&pScene->pMaterials[i].pBaseColorTexture);
+    ttTextureCache_Release(&pScene->pMaterials[i].pEmissiveTexture);
+    ttTextureCache_Release(&pScene->pMaterials[i].pMetallicRoughnessTexture);
+    ttTextureCache_Release(&pScene->pMaterials[i].pNormalTexture);
+    ttTextureCache_Release(&pScene->pMaterials[i].pOcclusionTexture);
+  }
+
+  for (int i = 0; i < pScene->bufferCount; ++i)
+    udFree(pScene->pBuffers[i].pBytes);
+
+  pScene->meshInstances.Deinit();
+
+  vcGLTF_DestroyStreamingJob(&pScene->pStreamingJob);
+  udFree(pScene->pMeshRequests);
+
+  vcGLTF_BitsetDestroy(&pScene->meshVisibility);
+  vcGLTF_BitsetDestroy(&pScene->nodeVisibility);
+  vcGLTF_BitsetDestroy(&pScene->visibleNodes);
+  vcGLTF_BitsetDestroy(&pScene->visibleInstances);
+
+  // Names, nodes, primitives, animations and skins all live in the arena
+  vcGLTF_ArenaDestroy(&pScene->arena);
+
+  udFree(pScene);
+}
+
+template<typename T>
+T vcGLTF_CubicSpline(T previousPoint, T previousTangent, T nextPoint, T nextTangent, float interpolationValue)
+{
+  float t = interpolationValue;
+  float t2 = t * t;
+  float t3 = t2 * t;
+
+  return (2.f * t3 - 3.f * t2 + 1.f) * previousPoint + (t3 - 2.f * t2 + t) * previousTangent + (-2.f * t3 + 3.f * t2) * nextPoint + (t3 - t2) * nextTangent;
+}
+
+udResult vcGLTF_Update(vcGLTFScene *pScene, double dt)
+{
+  vcGLTFTraceScope traceScope("vcGLTF_Update");
+  ++pScene->frameIndex;
+
+  if (pScene->pCurrentAnimation == nullptr && pScene->pAnimations != nullptr)
+    pScene->pCurrentAnimation = &pScene->pAnimations[0];
+
+  if (pScene->pCurrentAnimation != nullptr)
+  {
+    pScene->currentTime += (float)dt;
+
+    vcGLTFAnimation *pAnim = pScene->pCurrentAnimation;
+
+    while (pScene->currentTime > pAnim->totalTime)
+      pScene->currentTime -= pAnim->totalTime;
+
+    uint64_t traceStart = vcGLTF_TraceStart();
+
+    for (int i = 0; i < pAnim->numChannels; ++i)
+    {
+      vcGLTFAnimationChannel *pChnl = &pAnim->pChannels[i];
+      vcGLTFNode *pNode = &pScene->pNodes[pChnl->nodeIndex];
+
+      pNode->dirty = true;
+
+      for (int j = 0; j < pChnl->pSampler->steps - 1; ++j)
+      {
+        if (pChnl->pSampler->pTime[j] < pScene->currentTime && pChnl->pSampler->pTime[j + 1] > pScene->currentTime)
+        {
+          float tdelta = (pChnl->pSampler->pTime[j + 1] - pChnl->pSampler->pTime[j]);
+          float ratio = (pScene->currentTime - pChnl->pSampler->pTime[j]) / tdelta;
+
+          switch (pChnl->target)
+          {
+          case vcGLTFChannelTarget_Translation:
+            if (pChnl->pSampler->interpolationMethod == vcGLTFInterpolation_Linear)
+              pNode->translation = udLerp(pChnl->pSampler->pOutputFloat3[j], pChnl->pSampler->pOutputFloat3[j + 1], ratio);
+            else if (pChnl->pSampler->interpolationMethod == vcGLTFInterpolation_Step)
+              pNode->translation = pChnl->pSampler->pOutputFloat3[j];
+            else if (pChnl->pSampler->interpolationMethod == vcGLTFInterpolation_CublicSpline)
+              pNode->translation = vcGLTF_CubicSpline(pChnl->pSampler->pOutputFloat3[j * 3 + 1], tdelta * pChnl->pSampler->pOutputFloat3[j * 3 + 2], pChnl->pSampler->pOutputFloat3[(j + 1) * 3 + 1], tdelta * pChnl->pSampler->pOutputFloat3[(j + 1) * 3 + 0], ratio);
+            break;
+          case vcGLTFChannelTarget_Rotation:
+            if (pChnl->pSampler->interpolationMethod == vcGLTFInterpolation_Linear)
+              pNode->rotation = udSlerp(pChnl->pSampler->pOutputFloatQuat[j], pChnl->pSampler->pOutputFloatQuat[j + 1], (double)ratio);
+            else if (pChnl->pSampler->interpolationMethod == vcGLTFInterpolation_Step)
+              pNode->rotation = pChnl->pSampler->pOutputFloatQuat[j];
+            else if (pChnl->pSampler->interpolationMethod == vcGLTFInterpolation_CublicSpline)
+              pNode->rotation = vcGLTF_CubicSpline(pChnl->pSampler->pOutputFloatQuat[j * 3 + 1], tdelta * pChnl->pSampler->pOutputFloatQuat[j * 3 + 2], pChnl->pSampler->pOutputFloatQuat[(j + 1) * 3 + 1], tdelta * pChnl->pSampler->pOutputFloatQuat[(j + 1) * 3 + 0], ratio);
+            break;
+          case vcGLTFChannelTarget_Scale:
+            if (pChnl->pSampler->interpolationMethod == vcGLTFInterpolation_Linear)
+              pNode->scale = udLerp(pChnl->pSampler->pOutputFloat3[j], pChnl->pSampler->pOutputFloat3[j + 1], ratio);
+            else if (pChnl->pSampler->interpolationMethod == vcGLTFInterpolation_Step)
+              pNode->scale = pChnl->pSampler->pOutputFloat3[j];
+            else if (pChnl->pSampler->interpolationMethod == vcGLTFInterpolation_CublicSpline)
+              pNode->scale = vcGLTF_CubicSpline(pChnl->pSampler->pOutputFloat3[j * 3 + 1], tdelta * pChnl->pSampler->pOutputFloat3[j * 3 + 2], pChnl->pSampler->pOutputFloat3[(j + 1) * 3 + 1], tdelta * pChnl->pSampler->pOutputFloat3[(j + 1) * 3 + 0], ratio);
+            break;
+          case vcGLTFChannelTarget_Weights:
+            __debugbreak();
+            break;
+          }
+
+          break;
+        }
+      }
+    }
+
+    uint64_t traceEnd = udPerfCounterStart();
+    vcGLTF_TraceEvent("Sample animation", traceStart, traceEnd);
+    traceStart = traceEnd;
+
+    for (int i = 0; i < pScene->nodeCount; ++i)
+    {
+      pScene->pNodes[i].GetMat(false);
+    }
+
+    traceEnd = udPerfCounterStart();
+    vcGLTF_TraceEvent("Update hierarchy", traceStart, traceEnd);
+    traceStart = traceEnd;
+
+    vcGLTF_UpdateInstanceBounds(pScene);
+    vcGLTF_RefitInstanceBVH(pScene);
+
+    vcGLTF_TraceEvent("Update instance bounds", traceStart, udPerfCounterStart());
+  }
+
+  return udR_Success;
+}
+
+// Approximate fraction of the viewport covered by the projected bounding sphere of the bounds
+float vcGLTF_ScreenCoverage(const udDouble4x4 &sceneToView, const udDouble4x4 &projectionMatrix, const udFloat3 &boundsMin, const udFloat3 &boundsMax)
+{
+  if (!vcGLTF_BoundsValid(boundsMin, boundsMax))
+    return 1.f;
+
+  udDouble3 center = udDouble3::create((boundsMin + boundsMax) * 0.5f);
+  double scale = udMax(udMag3(sceneToView.axis.x.toVector3()), udMax(udMag3(sceneToView.axis.y.toVector3()), udMag3(sceneToView.axis.z.toVector3())));
+  double radius = udMag3(boundsMax - boundsMin) * 0.5 * scale;
+
+  udDouble4 clip = projectionMatrix * (sceneToView * udDouble4::create(center, 1.0));
+  double w = 1.0;
+
+  if (projectionMatrix.a[11] != 0.0) // Perspective
+  {
+    w = clip.w;
+    if (w <= radius)
+      return 1.f; // The camera is inside or touching the bounds
+  }
+
+  double radiusX = radius * udAbs(projectionMatrix.a[0]) / w;
+  double radiusY = radius * udAbs(projectionMatrix.a[5]) / w;
+
+  // Ellipse area over the 2x2 NDC viewport
+  return (float)udMin(1.0, 3.141592653589793 * radiusX * radiusY / 4.0);
+}
+
+// Returns false if the instance shouldn't be drawn at all at this coverage
+bool vcGLTF_SelectLOD(const vcGLTFMeshInstance &instance, float coverage, int *pMeshLOD, int *pGeneratedLOD)
+{
+  *pGeneratedLOD = 0;
+  while (*pGeneratedLOD < vcGLTFLimit_LODCount - 1 && coverage < vcGLTF_GeneratedLODCoverage[*pGeneratedLOD])
+    ++(*pGeneratedLOD);
+
+  *pMeshLOD = 0;
+  if (instance.lodMeshCount <= 1)
+    return true;
+
+  if (instance.lodCoverage[0] == 0.f)
+  {
+    // No MSFT_screencoverage so the generated thresholds are used for the chain from the file
+    *pMeshLOD = udMin(*pGeneratedLOD, instance.lodMeshCount - 1);
+    *pGeneratedLOD = 0;
+    return true;
+  }
+
+  // lodCoverage[i] is the minimum coverage for LOD i; an extra trailing value is the minimum coverage to draw anything
+  *pGeneratedLOD = 0;
+  for (int i = 0; i < instance.lodMeshCount; ++i)
+  {
+    if (coverage >= instance.lodCoverage[i])
+    {
+      *pMeshLOD = i;
+      return true;
+    }
+  }
+
+  *pMeshLOD = instance.lodMeshCount - 1;
+  return !(instance.lodCoverage[instance.lodMeshCount] > 0.f && coverage < instance.lodCoverage[instance.lodMeshCount]);
+}
+
+// Maps a float to a key that sorts in the same order as an unsigned integer
+inline uint32_t vcGLTF_FloatSortKey(float value)
+{
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  return (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+}
+
+// LSD radix sort, 8 bits per pass; pKeys and pIndices must hold 2x count. Returns the sorted (ascending) index list
+uint32_t* vcGLTF_RadixSort(uint32_t *pKeys, uint32_t *pIndices, uint32_t count)
+{
+  uint32_t *pKeysIn = pKeys;
+  uint32_t *pKeysOut = pKeys + count;
+  uint32_t *pIndicesIn = pIndices;
+  uint32_t *pIndicesOut = pIndices + count;
+
+  for (uint32_t i = 0; i < count; ++i)
+    pIndicesIn[i] = i;
+
+  if (count < 2)
+    return pIndicesIn;
+
+  for (int shift = 0; shift < 32; shift += 8)
+  {
+    uint32_t histogram[256] = {};
+    for (uint32_t i = 0; i < count; ++i)
+      ++histogram[(pKeysIn[i] >> shift) & 0xFF];
+
+    // Every key shares this digit; the pass would be a copy
+    if (histogram[(pKeysIn[0] >> shift) & 0xFF] == count)
+      continue;
+
+    uint32_t offset = 0;
+    for (int b = 0; b < 256; ++b)
+    {
+      uint32_t digitCount = histogram[b];
+      histogram[b] = offset;
+      offset += digitCount;
+    }
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+      uint32_t dest = histogram[(pKeysIn[i] >> shift) & 0xFF]++;
+      pKeysOut[dest] = pKeysIn[i];
+      pIndicesOut[dest] = pIndicesIn[i];
+    }
+
+    uint32_t *pTemp = pKeysIn;
+    pKeysIn = pKeysOut;
+    pKeysOut = pTemp;
+
+    pTemp = pIndicesIn;
+    pIndicesIn = pIndicesOut;
+    pIndicesOut = pTemp;
+  }
+
+  return pIndicesIn;
+}
+
+void vcGLTF_PushTransparentItem(vcGLTFScene *pScene, uint32_t *pCount, const vcGLTFTransparentItem &item, uint32_t key)
+{
+  if (*pCount == pScene->transparentCapacity)
+  {
+    uint32_t newCapacity = udMax(64u, pScene->transparentCapacity * 2);
+
+    vcGLTFTransparentItem *pItems = udReallocType(pScene->pTransparentItems, vcGLTFTransparentItem, newCapacity);
+    if (pItems == nullptr)
+      return;
+    pScene->pTransparentItems = pItems;
+
+    uint32_t *pKeys = udReallocType(pScene->pTransparentKeys, uint32_t, newCapacity * 2);
+    if (pKeys == nullptr)
+      return;
+    pScene->pTransparentKeys = pKeys;
+
+    uint32_t *pOrder = udReallocType(pScene->pTransparentOrder, uint32_t, newCapacity * 2);
+    if (pOrder == nullptr)
+      return;
+    pScene->pTransparentOrder = pOrder;
+
+    pScene->transparentCapacity = newCapacity;
+  }
+
+  pScene->pTransparentItems[*pCount] = item;
+  pScene->pTransparentKeys[*pCount] = key;
+  ++(*pCount);
+}
+
+bool vcGLTF_ReserveIndices(uint32_t **ppArray, uint32_t *pCapacity, uint32_t required)
+{
+  if (required <= *pCapacity)
+    return true;
+
+  uint32_t newCapacity = udMax(required, *pCapacity * 2);
+  uint32_t *pNewArray = udReallocType(*ppArray, uint32_t, newCapacity);
+  if (pNewArray == nullptr)
+    return false;
+
+  *ppArray = pNewArray;
+  *pCapacity = newCapacity;
+  return true;
+}
+
+void vcGLTF_LightGridCellRange(const vcGLTFLightGrid &grid, const udFloat3 &boundsMin, const udFloat3 &boundsMax, int *pCellMin, int *pCellMax)
+{
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    pCellMin[axis] = udClamp((int)((boundsMin[axis] - grid.origin[axis]) / grid.cellSize), 0, grid.dims[axis] - 1);
+    pCellMax[axis] = udClamp((int)((boundsMax[axis] - grid.origin[axis]) / grid.cellSize), 0, grid.dims[axis] - 1);
+  }
+}
+
+void vcGLTF_BuildLightGrid(vcGLTFLightGrid *pGrid, const vcGLTFLight *pLights, int lightCount)
+{
+  vcGLTFTraceScope traceScope("Build light grid");
+  const int MaxDimension = 32;
+  const int MaxCellsPerLight = 512; // Larger lights go in the global list rather than flooding the grid
+
+  pGrid->globalCount = 0;
+  pGrid->dims[0] = pGrid->dims[1] = pGrid->dims[2] = 0;
+
+  if (!vcGLTF_ReserveIndices(&pGrid->pStamps, &pGrid->stampCapacity, lightCount) || !vcGLTF_ReserveIndices(&pGrid->pGlobalLights, &pGrid->globalCapacity, lightCount))
+    return;
+
+  if (lightCount > 0)
+    memset(pGrid->pStamps, 0, sizeof(uint32_t) * lightCount);
+  pGrid->queryID = 0;
+
+  udFloat3 lightsMin = udFloat3::create(FLT_MAX);
+  udFloat3 lightsMax = udFloat3::create(-FLT_MAX);
+  float totalRange = 0.f;
+  int localCount = 0;
+
+  for (int i = 0; i < lightCount; ++i)
+  {
+    if (pLights[i].type == vcGLTFLightType_Directional || pLights[i].range <= 0.f)
+      continue;
+
+    lightsMin = udMin(lightsMin, pLights[i].position - udFloat3::create(pLights[i].range));
+    lightsMax = udMax(lightsMax, pLights[i].position + udFloat3::create(pLights[i].range));
+    totalRange += pLights[i].range;
+    ++localCount;
+  }
+
+  if (localCount > 0)
+  {
+    udFloat3 extents = lightsMax - lightsMin;
+    pGrid->origin = lightsMin;
+    pGrid->cellSize = udMax(totalRange / localCount, udMax(extents.x, udMax(extents.y, extents.z)) / MaxDimension);
+
+    for (int axis = 0; axis < 3; ++axis)
+      pGrid->dims[axis] = udClamp((int)(extents[axis] / pGrid->cellSize) + 1, 1, MaxDimension);
+  }
+
+  uint32_t cellCount = (uint32_t)(pGrid->dims[0] * pGrid->dims[1] * pGrid->dims[2]);
+  if (!vcGLTF_ReserveIndices(&pGrid->pCellStarts, &pGrid->cellCapacity, cellCount + 1))
+  {
+    pGrid->dims[0] = pGrid->dims[1] = pGrid->dims[2] = 0;
+    return;
+  }
+
+  memset(pGrid->pCellStarts, 0, sizeof(uint32_t) * (cellCount + 1));
+
+  // Count then fill so each cell's lights are contiguous
+  for (int pass = 0; pass < 2; ++pass)
+  {
+    pGrid->globalCount = 0;
+
+    for (int i = 0; i < lightCount; ++i)
+    {
+      int cellMin[3] = {};
+      int cellMax[3] = {};
+      bool global = (pLights[i].type == vcGLTFLightType_Directional || pLights[i].range <= 0.f || cellCount == 0);
+
+      if (!global)
+      {
+        vcGLTF_LightGridCellRange(*pGrid, pLights[i].position - udFloat3::create(pLights[i].range), pLights[i].position + udFloat3::create(pLights[i].range), cellMin, cellMax);
+        global = ((cellMax[0] - cellMin[0] + 1) * (cellMax[1] - cellMin[1] + 1) * (cellMax[2] - cellMin[2] + 1) > MaxCellsPerLight);
+      }
+
+      if (global)
+      {
+        pGrid->pGlobalLights[pGrid->globalCount++] = i;
+        continue;
+      }
+
+      for (int z = cellMin[2]; z <= cellMax[2]; ++z)
+      {
+        for (int y = cellMin[1]; y <= cellMax[1]; ++y)
+        {
+          for (int x = cellMin[0]; x <= cellMax[0]; ++x)
+          {
+            uint32_t cell = (z * pGrid->dims[1] + y) * pGrid->dims[0] + x;
+
+            if (pass == 0)
+              ++pGrid->pCellStarts[cell + 1];
+            else
+              pGrid->pEntries[pGrid->pCellStarts[cell]++] = i;
+          }
+        }
+      }
+    }
+
+    if (pass == 0)
+    {
+      for (uint32_t cell = 0; cell < cellCount; ++cell)
+        pGrid->pCellStarts[cell + 1] += pGrid->pCellStarts[cell];
+
+      if (!vcGLTF_ReserveIndices(&pGrid->pEntries, &pGrid->entryCapacity, pGrid->pCellStarts[cellCount]))
+      {
+        // Everything falls back to the global list
+        pGrid->dims[0] = pGrid->dims[1] = pGrid->dims[2] = 0;
+        cellCount = 0;
+      }
+    }
+  }
+
+  // The fill pass advanced each start to the next cell's start
+  for (uint32_t cell = cellCount; cell > 0; --cell)
+    pGrid->pCellStarts[cell] = pGrid->pCellStarts[cell - 1];
+  pGrid->pCellStarts[0] = 0;
+}
+
+// Estimated contribution of a light to anything inside the bounds; 0 if it can't reach them
+float vcGLTF_LightInfluence(const vcGLTFLight &light, const udFloat3 &boundsMin, const udFloat3 &boundsMax)
+{
+  float brightness = light.intensity * udMax(light.color.x, udMax(light.color.y, light.color.z));
+
+  if (light.type == vcGLTFLightType_Directional)
+    return brightness * 1e6f; // Always wins over local lights
+
+  udFloat3 offset = udMax(udMax(boundsMin - light.position, light.position - boundsMax), udFloat3::zero());
+  float distanceSq = udMagSq3(offset);
+
+  float attenuation = 1.f;
+  if (light.range > 0.f)
+  {
+    float ratio = distanceSq / (light.range * light.range);
+    if (ratio >= 1.f)
+      return 0.f;
+
+    attenuation = 1.f - ratio * ratio; // Matches the shader's 1 - (d / range)^4 window
+  }
+
+  return brightness * attenuation / udMax(distanceSq, 1.f);
+}
+
+// Keeps s_gltfFragInfo.u_Lights sorted by score, dropping the weakest once full
+void vcGLTF_ConsiderLight(const vcGLTFLight &light, const udFloat3 &boundsMin, const udFloat3 &boundsMax, float *pScores, int *pSelectedCount)
+{
+  float score = vcGLTF_LightInfluence(light, boundsMin, boundsMax);
+  if (score <= 0.f || (*pSelectedCount == vcGLTFLimit_LightCount && score <= pScores[vcGLTFLimit_LightCount - 1]))
+    return;
+
+  int slot = udMin(*pSelectedCount, vcGLTFLimit_LightCount - 1);
+  while (slot > 0 && pScores[slot - 1] < score)
+  {
+    pScores[slot] = pScores[slot - 1];
+    s_gltfFragInfo.u_Lights[slot] = s_gltfFragInfo.u_Lights[slot - 1];
+    --slot;
+  }
+
+  pScores[slot] = score;
+  s_gltfFragInfo.u_Lights[slot] = light;
+  *pSelectedCount = udMin(*pSelectedCount + 1, (int)vcGLTFLimit_LightCount);
+}
+
+// Picks the most influential lights for the bounds (world space) into s_gltfFragInfo
+void vcGLTF_SelectLights(vcGLTFLightGrid *pGrid, const vcGLTFLightList &lighting, const udFloat3 &boundsMin, const udFloat3 &boundsMax)
+{
+  float scores[vcGLTFLimit_LightCount];
+  int selectedCount = 0;
+
+  ++pGrid->queryID;
+
+  // Candidates from the grid cells first, then the lights that reach everywhere
+  int cellMin[3] = {};
+  int cellMax[3] = {};
+  bool useGrid = (pGrid->dims[0] > 0);
+  if (useGrid)
+    vcGLTF_LightGridCellRange(*pGrid, boundsMin, boundsMax, cellMin, cellMax);
+
+  for (int z = cellMin[2]; useGrid && z <= cellMax[2]; ++z)
+  {
+    for (int y = cellMin[1]; y <= cellMax[1]; ++y)
+    {
+      for (int x = cellMin[0]; x <= cellMax[0]; ++x)
+      {
+        uint32_t cell = (z * pGrid->dims[1] + y) * pGrid->dims[0] + x;
+
+        for (uint32_t entry = pGrid->pCellStarts[cell]; entry < pGrid->pCellStarts[cell + 1]; ++entry)
+        {
+          uint32_t lightIndex = pGrid->pEntries[entry];
+          if (pGrid->pStamps[lightIndex] == pGrid->queryID)
+            continue;
+
+          pGrid->pStamps[lightIndex] = pGrid->queryID;
+
+          vcGLTF_ConsiderLight(lighting.pLights[lightIndex], boundsMin, boundsMax, scores, &selectedCount);
+        }
+      }
+    }
+  }
+
+  for (uint32_t i = 0; i < pGrid->globalCount; ++i)
+    vcGLTF_ConsiderLight(lighting.pLights[pGrid->pGlobalLights[i]], boundsMin, boundsMax, scores, &selectedCount);
+
+  s_gltfFragInfo.u_lightCount = selectedCount;
+}
+
+// Bins the lights into the view frustum clusters and uploads the textures the clustered shader variants read
+bool vcGLTF_BuildClusters(vcGLTFClusterLighting *pClusters, const udDouble4x4 &viewProjectionMatrix, const vcGLTFLightList &lighting)
+{
+  vcGLTFTraceScope traceScope("Build light clusters");
+  const int TilesX = vcGLTFLimit_ClusterTilesX;
+  const int TilesY = vcGLTFLimit_ClusterTilesY;
+  const int Slices = vcGLTFLimit_ClusterSlices;
+  const int LightsPerRow = vcGLTFLimit_ClusterTextureWidth / 4;
+  const int ClusterCount = TilesX * TilesY * Slices;
+
+  udFloat4x4 clip = udFloat4x4::create(viewProjectionMatrix);
+  udFloat4 wRow = udFloat4::create(clip.a[3], clip.a[7], clip.a[11], clip.a[15]);
+  float wScale = udMag3(wRow.toVector3());
+
+  if (!vcGLTF_ReserveIndices(&pClusters->pLightRanges, &pClusters->rangeCapacity, lighting.lightCount * 6))
+    return false;
+
+  // Depth range of the slices comes from the lights themselves; clamping both sides keeps it correct for any range
+  float wNear = FLT_MAX;
+  float wFar = 0.f;
+
+  for (int i = 0; i < lighting.lightCount; ++i)
+  {
+    const vcGLTFLight &light = lighting.pLights[i];
+    if (light.type == vcGLTFLightType_Directional || light.range <= 0.f)
+      continue;
+
+    float wCentre = udDot3(wRow.toVector3(), light.position) + wRow.w;
+    wNear = udMin(wNear, wCentre - light.range * wScale);
+    wFar = udMax(wFar, wCentre + light.range * wScale);
+  }
+
+  if (wFar <= 0.f) // Nothing with a range in front of the camera
+    wNear = wFar = 0.f;
+
+  wNear = udMax(wNear, 0.1f);
+  wFar = udMax(wFar, wNear * 2.f);
+  float sliceScale = Slices / logf(wFar / wNear);
+
+  memset(pClusters->clusterCounts, 0, sizeof(pClusters->clusterCounts));
+
+  for (int i = 0; i < lighting.lightCount; ++i)
+  {
+    const vcGLTFLight &light = lighting.pLights[i];
+    uint32_t *pRange = &pClusters->pLightRanges[i * 6];
+
+    // x, y, slice min then max; lights reaching everything cover the whole grid
+    pRange[0] = 0; pRange[1] = 0; pRange[2] = 0;
+    pRange[3] = TilesX - 1; pRange[4] = TilesY - 1; pRange[5] = Slices - 1;
+
+    if (light.type != vcGLTFLightType_Directional && light.range > 0.f)
+    {
+      float wCentre = udDot3(wRow.toVector3(), light.position) + wRow.w;
+      float wMin = wCentre - light.range * wScale;
+      float wMax = wCentre + light.range * wScale;
+
+      if (wMax < wNear * 0.5f)
+      {
+        pRange[3] = 0; // Behind the camera; empty range
+        pRange[0] = 1;
+        continue;
+      }
+
+      pRange[2] = (wMin <= wNear) ? 0 : (uint32_t)udClamp((int)(logf(wMin / wNear) * sliceScale), 0, Slices - 1);
+      pRange[5] = (uint32_t)udClamp((int)(logf(wMax / wNear) * sliceScale), 0, Slices - 1);
+
+      // Screen extents from the corners of the light's bounding box; anything crossing the camera plane spans the screen
+      udFloat2 ndcMin = udFloat2::create(FLT_MAX, FLT_MAX);
+      udFloat2 ndcMax = udFloat2::create(-FLT_MAX, -FLT_MAX);
+      bool crossesCamera = false;
+
+      for (int corner = 0; corner < 8 && !crossesCamera; ++corner)
+      {
+        udFloat3 offset = udFloat3::create((corner & 1) ? light.range : -light.range, (corner & 2) ? light.range : -light.range, (corner & 4) ? light.range : -light.range);
+        udFloat4 cornerClip = clip * udFloat4::create(light.position + offset, 1.f);
+
+        if (cornerClip.w <= wNear * 0.5f)
+        {
+          crossesCamera = true;
+        }
+        else
+        {
+          udFloat2 ndc = udFloat2::create(cornerClip.x / cornerClip.w, cornerClip.y / cornerClip.w);
+          ndcMin = udFloat2::create(udMin(ndcMin.x, ndc.x), udMin(ndcMin.y, ndc.y));
+          ndcMax = udFloat2::create(udMax(ndcMax.x, ndc.x), udMax(ndcMax.y, ndc.y));
+        }
+      }
+
+      if (!crossesCamera)
+      {
+        if (ndcMax.x < -1.f || ndcMax.y < -1.f || ndcMin.x > 1.f || ndcMin.y > 1.f)
+        {
+          pRange[3] = 0; // Off screen
+          pRange[0] = 1;
+          continue;
+        }
+
+        pRange[0] = (uint32_t)udClamp((int)((ndcMin.x * 0.5f + 0.5f) * TilesX), 0, TilesX - 1);
+        pRange[1] = (uint32_t)udClamp((int)((ndcMin.y * 0.5f + 0.5f) * TilesY), 0, TilesY - 1);
+        pRange[3] = (uint32_t)udClamp((int)((ndcMax.x * 0.5f + 0.5f) * TilesX), 0, TilesX - 1);
+        pRange[4] = (uint32_t)udClamp((int)((ndcMax.y * 0.5f + 0.5f) * TilesY), 0, TilesY - 1);
+      }
+    }
+
+    for (uint32_t z = pRange[2]; z <= pRange[5]; ++z)
+      for (uint32_t y = pRange[1]; y <= pRange[4]; ++y)
+        for (uint32_t x = pRange[0]; x <= pRange[3]; ++x)
+          ++pClusters->clusterCounts[(z * TilesY + y) * TilesX + x];
+  }
+
+  uint32_t totalIndices = 0;
+  for (int cluster = 0; cluster < ClusterCount; ++cluster)
+  {
+    pClusters->gridTexels[cluster] = udFloat4::create((float)totalIndices, (float)pClusters->clusterCounts[cluster], 0.f, 0.f);
+    totalIndices += pClusters->clusterCounts[cluster];
+    pClusters->clusterCounts[cluster] = 0;
+  }
+
+  // Textures only grow; their contents past the used range are never read
+  const uint32_t IndicesPerRow = vcGLTFLimit_ClusterTextureWidth * 4;
+  uint32_t indexRows = udMax(1u, (totalIndices + IndicesPerRow - 1) / IndicesPerRow);
+  if (indexRows * IndicesPerRow > pClusters->indexCapacity)
+  {
+    float *pTexels = udReallocType(pClusters->pIndexTexels, float, indexRows * IndicesPerRow);
+    if (pTexels == nullptr)
+      return false;
+
+    pClusters->pIndexTexels = pTexels;
+    pClusters->indexCapacity = indexRows * IndicesPerRow;
+    vcTexture_Destroy(&pClusters->pIndexTexture);
+    vcTexture_Create(&pClusters->pIndexTexture, vcGLTFLimit_ClusterTextureWidth, indexRows, pClusters->pIndexTexels, vcTextureFormat_RGBA32F, vcTFM_Nearest, vcTCF_Dynamic);
+  }
+
+  uint32_t lightRows = udMax(1u, (uint32_t)(lighting.lightCount + LightsPerRow - 1) / LightsPerRow);
+  if (lightRows > pClusters->lightRowCapacity)
+  {
+    float *pTexels = udReallocType(pClusters->pLightTexels, float, lightRows * vcGLTFLimit_ClusterTextureWidth * 4);
+    if (pTexels == nullptr)
+      return false;
+
+    pClusters->pLightTexels = pTexels;
+    pClusters->lightRowCapacity = lightRows;
+    vcTexture_Destroy(&pClusters->pLightTexture);
+    vcTexture_Create(&pClusters->pLightTexture, vcGLTFLimit_ClusterTextureWidth, lightRows, pClusters->pLightTexels, vcTextureFormat_RGBA32F, vcTFM_Nearest, vcTCF_Dynamic);
+  }
+
+  for (int i = 0; i < lighting.lightCount; ++i)
+  {
+    const uint32_t *pRange = &pClusters->pLightRanges[i * 6];
+
+    for (uint32_t z = pRange[2]; z <= pRange[5]; ++z)
+    {
+      for (uint32_t y = pRange[1]; y <= pRange[4]; ++y)
+      {
+        for (uint32_t x = pRange[0]; x <= pRange[3]; ++x)
+        {
+          int cluster = (z * TilesY + y) * TilesX + x;
+          pClusters->pIndexTexels[(uint32_t)pClusters->gridTexels[cluster].x + pClusters->clusterCounts[cluster]++] = (float)i;
+        }
+      }
+    }
+  }
+
+  // vcGLTFLight is exactly 4 float4s which is the layout the shader reads back
+  UDCOMPILEASSERT(sizeof(vcGLTFLight) == sizeof(float) * 16, "vcGLTFLight must match the cluster light texture layout");
+  if (lighting.lightCount > 0)
+    memcpy(pClusters->pLightTexels, lighting.pLights, sizeof(vcGLTFLight) * lighting.lightCount);
+
+  // The type is stored as a float value rather than its int bits (which would read back as a denormal); it is t3.y in the shader
+  for (int i = 0; i < lighting.lightCount; ++i)
+    pClusters->pLightTexels[i * 16 + 13] = (float)lighting.pLights[i].type;
+
+  if (pClusters->pGridTexture == nullptr)
+    vcTexture_Create(&pClusters->pGridTexture, TilesX * TilesY, Slices, pClusters->gridTexels, vcTextureFormat_RGBA32F, vcTFM_Nearest, vcTCF_Dynamic);
+  else
+    vcTexture_UploadPixels(pClusters->pGridTexture, pClusters->gridTexels, TilesX * TilesY, Slices);
+
+  vcTexture_UploadPixels(pClusters->pLightTexture, pClusters->pLightTexels, vcGLTFLimit_ClusterTextureWidth, pClusters->lightRowCapacity);
+  vcTexture_UploadPixels(pClusters->pIndexTexture, pClusters->pIndexTexels, vcGLTFLimit_ClusterTextureWidth, pClusters->indexCapacity / IndicesPerRow);
+
+  s_gltfClusterInfo.u_ClusterViewProjection = clip;
+  s_gltfClusterInfo.u_ClusterDimensions = udFloat4::create((float)TilesX, (float)TilesY, (float)Slices, (float)LightsPerRow);
+  s_gltfClusterInfo.u_ClusterDepth = udFloat4::create(wNear, sliceScale, (float)IndicesPerRow, 0.f);
+
+  return (pClusters->pGridTexture != nullptr && pClusters->pLightTexture != nullptr && pClusters->pIndexTexture != nullptr);
+}
+
+void vcGLTF_SelectInstanceLights(vcGLTFScene *pScene, const vcGLTFMeshInstance &instance, const udFloat4x4 &sceneToWorld, const vcGLTFLightList &lighting)
+{
+  udFloat3 worldMin;
+  udFloat3 worldMax;
+  vcGLTF_TransformBounds(sceneToWorld, instance.sceneMin, instance.sceneMax, &worldMin, &worldMax);
+
+  vcGLTF_SelectLights(&pScene->lightGrid, lighting, worldMin, worldMax);
+}
+
+// Rasterizes a clip space triangle into the full resolution occlusion level; pixel centres covered keep the nearest 1/w
+void vcGLTF_RasterizeOccluder(vcGLTFOcclusionBuffer *pBuffer, const udFloat4 clip[3], bool doubleSided)
+{
+  const float NearW = 1e-3f; // Clipping away more than the real near plane only removes occluder coverage
+  const int Width = pBuffer->levelWidth[0];
+  const int Height = pBuffer->levelHeight[0];
+
+  // Clip against the w near plane; a triangle becomes at most a quad
+  udFloat4 polygon[4];
+  int polygonCount = 0;
+
+  for (int i = 0; i < 3; ++i)
+  {
+    const udFloat4 &a = clip[i];
+    const udFloat4 &b = clip[(i + 1) % 3];
+
+    if (a.w >= NearW)
+      polygon[polygonCount++] = a;
+
+    if ((a.w >= NearW) != (b.w >= NearW))
+    {
+      float t = (NearW - a.w) / (b.w - a.w);
+      polygon[polygonCount++] = a + (b - a) * t;
+    }
+  }
+
+  if (polygonCount < 3)
+    return;
+
+  // Pixel space position and 1/w of each vertex
+  udFloat3 screen[4];
+  for (int i = 0; i < polygonCount; ++i)
+  {
+    float invW = 1.f / polygon[i].w;
+    screen[i] = udFloat3::create((polygon[i].x * invW * 0.5f + 0.5f) * Width, (polygon[i].y * invW * 0.5f + 0.5f) * Height, invW);
+  }
+
+  for (int tri = 0; tri + 2 < polygonCount; ++tri)
+  {
+    udFloat3 v0 = screen[0];
+    udFloat3 v1 = screen[tri + 1];
+    udFloat3 v2 = screen[tri + 2];
+
+    // Counter clockwise is front facing, matching the culling the real draw uses
+    float area = (v1.x - v0.x) * (v2.y - v0.y) - (v1.y - v0.y) * (v2.x - v0.x);
+    if (area == 0.f || (area < 0.f && !doubleSided))
+      continue;
+
+    if (area < 0.f)
+    {
+      udFloat3 temp = v1;
+      v1 = v2;
+      v2 = temp;
+      area = -area;
+    }
+
+    int minX = udMax(0, (int)udMin(v0.x, udMin(v1.x, v2.x)));
+    int maxX = udMin(Width - 1, (int)udMax(v0.x, udMax(v1.x, v2.x)));
+    int minY = udMax(0, (int)udMin(v0.y, udMin(v1.y, v2.y)));
+    int maxY = udMin(Height - 1, (int)udMax(v0.y, udMax(v1.y, v2.y)));
+    if (minX > maxX || minY > maxY)
+      continue;
+
+    // Edge functions stepped per pixel; edge k is opposite vertex k so they double as barycentrics
+    float invArea = 1.f / area;
+    float stepX0 = (v1.y - v2.y), stepY0 = (v2.x - v1.x);
+    float stepX1 = (v2.y - v0.y), stepY1 = (v0.x - v2.x);
+    float stepX2 = (v0.y - v1.y), stepY2 = (v1.x - v0.x);
+
+    float startX = minX + 0.5f;
+    float startY = minY + 0.5f;
+    float row0 = (v2.x - v1.x) * (startY - v1.y) - (v2.y - v1.y) * (startX - v1.x);
+    float row1 = (v0.x - v2.x) * (startY - v2.y) - (v0.y - v2.y) * (startX - v2.x);
+    float row2 = (v1.x - v0.x) * (startY - v0.y) - (v1.y - v0.y) * (startX - v0.x);
+
+    float depthStepX = (stepX0 * v0.z + stepX1 * v1.z + stepX2 * v2.z) * invArea;
+
+    for (int y = minY; y <= maxY; ++y)
+    {
+      float *pRow = pBuffer->pLevels[0] + y * Width + minX;
+      float depthRow = (row0 * v0.z + row1 * v1.z + row2 * v2.z) * invArea;
+      int spanWidth = maxX - minX + 1;
+
+      // Every value is computed from the pixel offset rather than accumulated so iterations are independent and the
+      // compiler can vectorize the span
+      for (int i = 0; i < spanWidth; ++i)
+      {
+        float dx = (float)i;
+        float e0 = row0 + stepX0 * dx;
+        float e1 = row1 + stepX1 * dx;
+        float e2 = row2 + stepX2 * dx;
+        float depth = depthRow + depthStepX * dx;
+
+        bool inside = (e0 >= 0.f) & (e1 >= 0.f) & (e2 >= 0.f);
+        float nearest = udMax(pRow[i], depth);
+        pRow[i] = inside ? nearest : pRow[i];
+      }
+
+      row0 += stepY0;
+      row1 += stepY1;
+      row2 += stepY2;
+    }
+  }
+}
+
+// Allocates every level of the occlusion buffer in one block the first time it's needed
+bool vcGLTF_AllocateOcclusion(vcGLTFOcclusionBuffer *pBuffer)
+{
+  if (pBuffer->pLevels[0] != nullptr)
+    return true;
+
+  size_t totalTexels = 0;
+  for (int level = 0; level < vcGLTFLimit_OcclusionLevels; ++level)
+  {
+    pBuffer->levelWidth[level] = udMax(1, vcGLTFLimit_OcclusionWidth >> level);
+    pBuffer->levelHeight[level] = udMax(1, vcGLTFLimit_OcclusionHeight >> level);
+    totalTexels += pBuffer->levelWidth[level] * pBuffer->levelHeight[level];
+  }
+
+  pBuffer->pLevels[0] = udAllocType(float, totalTexels, udAF_None);
+  if (pBuffer->pLevels[0] == nullptr)
+    return false;
+
+  for (int level = 1; level < vcGLTFLimit_OcclusionLevels; ++level)
+    pBuffer->pLevels[level] = pBuffer->pLevels[level - 1] + pBuffer->levelWidth[level - 1] * pBuffer->levelHeight[level - 1];
+
+  return true;
+}
+
+// Builds the coarser levels from the full resolution level once every occluder has been rasterized
+void vcGLTF_BuildOcclusionLevels(vcGLTFOcclusionBuffer *pBuffer)
+{
+  for (int level = 1; level < vcGLTFLimit_OcclusionLevels; ++level)
+  {
+    const float *pSource = pBuffer->pLevels[level - 1];
+    int sourceWidth = pBuffer->levelWidth[level - 1];
+
+    for (int y = 0; y < pBuffer->levelHeight[level]; ++y)
+    {
+      for (int x = 0; x < pBuffer->levelWidth[level]; ++x)
+      {
+        const float *pTexel = pSource + (y * 2) * sourceWidth + x * 2;
+        pBuffer->pLevels[level][y * pBuffer->levelWidth[level] + x] = udMin(udMin(pTexel[0], pTexel[1]), udMin(pTexel[sourceWidth], pTexel[sourceWidth + 1]));
+      }
+    }
+  }
+
+  pBuffer->active = true;
+}
+
+// Rasterizes the instances covering the most of the screen and builds the hierarchical levels; returns false if nothing
+// was rasterized, in which case everything should be treated as visible
+bool vcGLTF_BuildOcclusion(vcGLTFScene *pScene, const vcGLTFFrustum &sceneFrustum, const udDouble4x4 &sceneToView, const udDouble4x4 &projectionMatrix)
+{
+  vcGLTFTraceScope traceScope("Build occlusion");
+  vcGLTFOcclusionBuffer *pBuffer = &pScene->occlusion;
+  pBuffer->active = false;
+
+  if (projectionMatrix.a[11] == 0.0) // w is constant in orthographic views so nothing could ever be culled
+    return false;
+
+  if (!vcGLTF_AllocateOcclusion(pBuffer))
+    return false;
+
+  // Pick the rigid instances with the largest screen coverage whose BVH triangles are available and small enough
+  int occluders[vcGLTFLimit_OccluderCount];
+  float occluderCoverage[vcGLTFLimit_OccluderCount];
+  int occluderCount = 0;
+
+  for (size_t i = 0; i < pScene->meshInstances.length; ++i)
+  {
+    const vcGLTFMeshInstance &instance = pScene->meshInstances[i];
+    const vcGLTFMesh &mesh = pScene->pMeshes[instance.meshID];
+
+    if (instance.skinID >= 0 || mesh.bvhReady == 0 || mesh.bvh.triangleCount == 0 || mesh.bvh.triangleCount > vcGLTFLimit_OccluderTriangles)
+      continue;
+
+    if (!vcGLTF_BitsetGet(pScene->visibleInstances, i))
+      continue;
+
+    if (!vcGLTF_FrustumTestBounds(sceneFrustum, instance.sceneMin, instance.sceneMax))
+      continue;
+
+    float coverage = vcGLTF_ScreenCoverage(sceneToView, projectionMatrix, instance.sceneMin, instance.sceneMax);
+    if (occluderCount == vcGLTFLimit_OccluderCount && coverage <= occluderCoverage[occluderCount - 1])
+      continue;
+
+    int slot = udMin(occluderCount, vcGLTFLimit_OccluderCount - 1);
+    while (slot > 0 && occluderCoverage[slot - 1] < coverage)
+    {
+      occluders[slot] = occluders[slot - 1];
+      occluderCoverage[slot] = occluderCoverage[slot - 1];
+      --slot;
+    }
+
+    occluders[slot] = (int)i;
+    occluderCoverage[slot] = coverage;
+    occluderCount = udMin(occluderCount + 1, (int)vcGLTFLimit_OccluderCount);
+  }
+
+  if (occluderCount == 0)
+    return false;
+
+  memset(pBuffer->pLevels[0], 0, sizeof(float) * pBuffer->levelWidth[0] * pBuffer->levelHeight[0]);
+
+  udDouble4x4 sceneToClip = projectionMatrix * sceneToView;
+  for (int i = 0; i < occluderCount; ++i)
+  {
+    const vcGLTFMeshInstance &instance = pScene->meshInstances[occluders[i]];
+    const vcGLTFMesh &mesh = pScene->pMeshes[instance.meshID];
+    udFloat4x4 meshToClip = udFloat4x4::create(sceneToClip * udDouble4x4::create(instance.pNode->GetMat(false)));
+
+    for (int t = 0; t < mesh.bvh.triangleCount; ++t)
+    {
+      const vcGLTFBVHTriangle &triangle = mesh.bvh.pTriangles[t];
+      const vcGLTFMaterial *pMaterial = mesh.pPrimitives[triangle.primitiveID].pMaterial;
+
+      // Alpha tested and blended surfaces can be seen through
+      if (pMaterial->alphaMode != vcGLTFAM_Opaque)
+        continue;
+
+      udFloat4 clip[3];
+      clip[0] = meshToClip * udFloat4::create(triangle.v0, 1.f);
+      clip[1] = meshToClip * udFloat4::create(triangle.v0 + triangle.edge1, 1.f);
+      clip[2] = meshToClip * udFloat4::create(triangle.v0 + triangle.edge2, 1.f);
+
+      vcGLTF_RasterizeOccluder(pBuffer, clip, pMaterial->doubleSided);
+    }
+  }
+
+  vcGLTF_BuildOcclusionLevels(pBuffer);
+  return true;
+}
+
+// Returns true if the bounds are entirely behind the occluders rasterized by vcGLTF_BuildOcclusion
+bool vcGLTF_OcclusionTestBounds(const vcGLTFOcclusionBuffer &buffer, const udFloat4x4 &sceneToClip, const udFloat3 &boundsMin, const udFloat3 &boundsMax)
+{
+  if (!buffer.active || !vcGLTF_BoundsValid(boundsMin, boundsMax))
+    return false;
+
+  float minX = FLT_MAX, minY = FLT_MAX;
+  float maxX = -FLT_MAX, maxY = -FLT_MAX;
+  float nearest = 0.f; // Largest 1/w of any corner
 
-  if (layoutType == vcVLT_ColourBGRA)
+  for (int corner = 0; corner < 8; ++corner)
   {
-    if (udStrEqual(pAccessorType, "VEC3"))
-      count = 3;
-    else
-      count = 4;
-    *pTotalOffset += sizeof(uint32_t);
+    udFloat3 position = udFloat3::create((corner & 1) ? boundsMax.x : boundsMin.x, (corner & 2) ? boundsMax.y : boundsMin.y, (corner & 4) ? boundsMax.z : boundsMin.z);
+    udFloat4 clip = sceneToClip * udFloat4::create(position, 1.f);
+
+    if (clip.w <= 1e-3f)
+      return false; // Crosses the camera plane
+
+    float invW = 1.f / clip.w;
+    minX = udMin(minX, clip.x * invW);
+    maxX = udMax(maxX, clip.x * invW);
+    minY = udMin(minY, clip.y * invW);
+    maxY = udMax(maxY, clip.y * invW);
+    nearest = udMax(nearest, invW);
   }
-  else if (layoutType == vcVLT_BoneIDs)
+
+  int x0 = udClamp((int)((minX * 0.5f + 0.5f) * buffer.levelWidth[0]), 0, buffer.levelWidth[0] - 1);
+  int x1 = udClamp((int)((maxX * 0.5f + 0.5f) * buffer.levelWidth[0]), 0, buffer.levelWidth[0] - 1);
+  int y0 = udClamp((int)((minY * 0.5f + 0.5f) * buffer.levelHeight[0]), 0, buffer.levelHeight[0] - 1);
+  int y1 = udClamp((int)((maxY * 0.5f + 0.5f) * buffer.levelHeight[0]), 0, buffer.levelHeight[0] - 1);
+
+  // Coarsest level needed for the rectangle to span at most 2x2 texels
+  int level = 0;
+  while (level < vcGLTFLimit_OcclusionLevels - 1 && ((x1 >> level) - (x0 >> level) > 1 || (y1 >> level) - (y0 >> level) > 1))
+    ++level;
+
+  const float *pLevel = buffer.pLevels[level];
+  for (int y = (y0 >> level); y <= (y1 >> level); ++y)
   {
-    count = 4;
-    *pTotalOffset += sizeof(uint32_t);
+    for (int x = (x0 >> level); x <= (x1 >> level); ++x)
+    {
+      if (nearest >= pLevel[y * buffer.levelWidth[level] + x])
+        return false;
+    }
   }
-  else if (udStrEqual(pAccessorType, "VEC3"))
+
+  return true;
+}
+
+void vcGLTF_BindShader(vcShader *pShader, vcShader **ppBoundShader)
+{
+  if (*ppBoundShader == pShader)
+    return;
+
+  vcShader_Bind(pShader);
+  *ppBoundShader = pShader;
+  ++s_gltfRenderStats.shaderBinds;
+}
+
+void vcGLTF_BindConstantBuffer(vcShader *pShader, vcShaderConstantBuffer *pBuffer, const void *pData, size_t bufferSize)
+{
+  vcShader_BindConstantBuffer(pShader, pBuffer, pData, bufferSize);
+  s_gltfRenderStats.constantBufferBytes += bufferSize;
+}
+
+void vcGLTF_BindTexture(vcShader *pShader, vcTexture *pTexture, vcShaderSampler *pSampler)
+{
+  vcShader_BindTexture(pShader, pTexture, 0, pSampler);
+  ++s_gltfRenderStats.textureBinds;
+}
+
+void vcGLTF_SetInstanceConstants(vcGLTFScene *pScene, const vcGLTFMeshInstance &instance, const udDouble4x4 &worldMatrix, const udDouble4x4 &viewProjectionMatrix)
+{
+  if (instance.skinID >= 0)
   {
-    count = 3;
-    *pTotalOffset += (count * sizeof(float));
+    vcGLTFSkin *pSkin = &pScene->pSkins[instance.skinID];
+    ++s_gltfRenderStats.skinPalettes;
+
+    for (int j = 0; j < pSkin->jointCount; ++j)
+    {
+      s_gltfVertSkinningInfo.u_jointMatrix[j] = pScene->pNodes[pSkin->pJoints[j]].GetMat(false) * pSkin->pInverseBindMatrices[j];
+      s_gltfVertSkinningInfo.u_jointNormalMatrix[j] = udTranspose(udInverse(s_gltfVertSkinningInfo.u_jointMatrix[j]));
+    }
   }
-  else if (udStrEqual(pAccessorType, "VEC2"))
+
+  s_gltfVertInfo.u_ModelMatrix = udFloat4x4::create(worldMatrix) * vcGLTF_SpaceChange * instance.pNode->GetMat(false);
+  s_gltfVertInfo.u_ViewProjectionMatrix = udFloat4x4::create(viewProjectionMatrix);
+  s_gltfVertInfo.u_NormalMatrix = udTranspose(udInverse(s_gltfVertInfo.u_ModelMatrix));
+}
+
+// Saves the constants vcGLTF_SetInstanceConstants last set for the instance; returns the cache slot or -1 if the cache
+// couldn't grow, in which case they're rebuilt when needed again
+int vcGLTF_CacheInstanceConstants(vcGLTFScene *pScene, const vcGLTFMeshInstance &instance, uint32_t *pCount, uint32_t *pPaletteCount)
+{
+  int jointCount = (instance.skinID >= 0) ? pScene->pSkins[instance.skinID].jointCount : 0;
+
+  if (*pCount == pScene->cachedConstantCapacity)
   {
-    count = 2;
-    *pTotalOffset += (count * sizeof(float));
+    uint32_t newCapacity = udMax(64u, pScene->cachedConstantCapacity * 2);
+    vcGLTFCachedConstants *pConstants = udReallocType(pScene->pCachedConstants, vcGLTFCachedConstants, newCapacity);
+    if (pConstants == nullptr)
+      return -1;
+
+    pScene->pCachedConstants = pConstants;
+    pScene->cachedConstantCapacity = newCapacity;
   }
-  else if (udStrEqual(pAccessorType, "VEC4"))
+
+  if (*pPaletteCount + jointCount * 2 > pScene->cachedPaletteCapacity)
   {
-    count = 4;
-    *pTotalOffset += (count * sizeof(float));
+    uint32_t newCapacity = udMax(*pPaletteCount + jointCount * 2, pScene->cachedPaletteCapacity * 2);
+    udFloat4x4 *pPalette = udReallocType(pScene->pCachedPalette, udFloat4x4, newCapacity);
+    if (pPalette == nullptr)
+      return -1;
+
+    pScene->pCachedPalette = pPalette;
+    pScene->cachedPaletteCapacity = newCapacity;
   }
-  else if (udStrEqual(pAccessorType, "SCALAR"))
+
+  vcGLTFCachedConstants *pCached = &pScene->pCachedConstants[*pCount];
+  pCached->modelMatrix = s_gltfVertInfo.u_ModelMatrix;
+  pCached->normalMatrix = s_gltfVertInfo.u_NormalMatrix;
+  pCached->jointCount = jointCount;
+  pCached->paletteStart = *pPaletteCount;
+
+  if (jointCount > 0)
   {
-    count = 1;
-    *pTotalOffset += (count * sizeof(float));
+    memcpy(&pScene->pCachedPalette[pCached->paletteStart], s_gltfVertSkinningInfo.u_jointMatrix, sizeof(udFloat4x4) * jointCount);
+    memcpy(&pScene->pCachedPalette[pCached->paletteStart + jointCount], s_gltfVertSkinningInfo.u_jointNormalMatrix, sizeof(udFloat4x4) * jointCount);
+    *pPaletteCount += jointCount * 2;
   }
-  else if (udStrEqual(pAccessorType, "MAT4"))
+
+  return (int)(*pCount)++;
+}
+
+void vcGLTF_RestoreInstanceConstants(const vcGLTFScene *pScene, int constantsID)
+{
+  const vcGLTFCachedConstants &cached = pScene->pCachedConstants[constantsID];
+
+  s_gltfVertInfo.u_ModelMatrix = cached.modelMatrix;
+  s_gltfVertInfo.u_NormalMatrix = cached.normalMatrix;
+
+  if (cached.jointCount > 0)
   {
-    count = 16;
-    *pTotalOffset += (count * sizeof(float));
+    memcpy(s_gltfVertSkinningInfo.u_jointMatrix, &pScene->pCachedPalette[cached.paletteStart], sizeof(udFloat4x4) * cached.jointCount);
+    memcpy(s_gltfVertSkinningInfo.u_jointNormalMatrix, &pScene->pCachedPalette[cached.paletteStart + cached.jointCount], sizeof(udFloat4x4) * cached.jointCount);
   }
-  else
+}
+
+void vcGLTF_RenderPrimitiveMesh(vcMesh *pMesh, int indexStart, const vcGLTFMeshPrimitive &prim, int generatedLOD)
+{
+  int start = indexStart;
+  int count = prim.indexCount;
+
+  if (prim.lodCount > 0)
   {
-    __debugbreak();
+    int lod = udMin(generatedLOD, prim.lodCount - 1);
+    start += prim.lodIndexStart[lod];
+    count = prim.lodIndexCount[lod];
   }
 
-  if (bufferID < 0 || bufferID >= pScene->bufferCount)
-    __debugbreak();
-  else if (pScene->pBuffers[bufferID].pBytes == nullptr)
-    vcGLTF_LoadBuffer(pScene, root, bufferID);
+  // vcMesh_Render takes the range in triangles
+  vcMesh_Render(pMesh, count / 3, start / 3);
 
-  if (byteStride == 0)
+  ++s_gltfRenderStats.drawCalls;
+  s_gltfRenderStats.trianglesSubmitted += count / 3;
+  s_gltfRenderStats.verticesSubmitted += count;
+}
+
+// The depth shaders output 0 so vcGLSBM_Additive leaves an existing colour target untouched (see vcGLTF_SetDepthPrepass)
+void vcGLTF_RenderDepthPrimitive(const vcGLTFMeshPrimitive &prim, int generatedLOD, vcGLStateBlendMode blendMode, vcShader **ppBoundShader)
+{
+  bool alphaTest = vcGLTF_DepthNeedsAlphaTest(prim);
+
+  vcMesh *pMesh = prim.pPositionMesh;
+  int indexStart = prim.positionIndexStart;
+  const vcGLTFDepthShader *pShader = &g_depthPositionShader;
+
+  if (pMesh == nullptr)
   {
-    if (accessorComponentType == vcGLTFType_F32)
-      byteStride = count * sizeof(float);
-    else if (accessorComponentType == vcGLTFType_Int16 || accessorComponentType == vcGLTFType_UInt16)
-      byteStride = count * sizeof(uint16_t);
-    else
-      __debugbreak();
+    pMesh = prim.pMesh;
+    indexStart = prim.indexStart;
+    pShader = &vcGLTF_GetDepthShader(prim.features, alphaTest);
   }
 
-  if (stride == 0)
-    stride = (int)byteStride;
+  if (pShader->pShader == nullptr)
+    return;
 
-  if (layoutType == vcVLT_ColourBGRA)
+  vcGLTF_BindShader(pShader->pShader, ppBoundShader);
+
+  vcGLTF_BindConstantBuffer(pShader->pShader, pShader->pVertUniformBuffer, &s_gltfVertInfo, sizeof(s_gltfVertInfo));
+
+  if ((prim.features & vcRSB_Skinned) > 0)
+    vcGLTF_BindConstantBuffer(pShader->pShader, pShader->pSkinningUniformBuffer, &s_gltfVertSkinningInfo, sizeof(s_gltfVertSkinningInfo));
+
+  if (alphaTest)
   {
-    for (int vi = 0; vi < readCount; ++vi)
-    {
-      float *pFloats = (float*)(pScene->pBuffers[bufferID].pBytes + byteOffset + vi * byteStride);
-      int32_t *pVertI32 = (int32_t*)(pPtr + stride * vi + offset);
+    s_gltfDepthFragInfo.u_BaseColorFactor = prim.pMaterial->baseColorFactor;
+    s_gltfDepthFragInfo.u_AlphaCutoff = prim.pMaterial->alphaCutoff;
 
-      uint32_t temp = ((int(udRound(pFloats[0] * 255.f)) & 0xFF) << 0) | ((int(udRound(pFloats[1] * 255.f)) & 0xFF) << 8) | ((int(udRound(pFloats[2] * 255.f)) & 0xFF) << 16);
+    vcGLTF_BindTexture(pShader->pShader, prim.pMaterial->pBaseColorTexture, pShader->pBaseColourSampler);
+    vcGLTF_BindConstantBuffer(pShader->pShader, pShader->pFragUniformBuffer, &s_gltfDepthFragInfo, sizeof(s_gltfDepthFragInfo));
+  }
 
-      if (count == 3)
-        temp |= 0xFF000000;
-      else
-        temp |= (int(pFloats[3] * 255.f) << 24);
+  vcGLState_SetBlendMode(blendMode);
 
-      pVertI32[0] = temp;
-    }
+  if (prim.pMaterial->doubleSided)
+    vcGLState_SetFaceMode(vcGLSFM_Solid, vcGLSCM_None, true, false);
+  else
+    vcGLState_SetFaceMode(vcGLSFM_Solid, vcGLSCM_Back, true, false);
+
+  vcGLTF_RenderPrimitiveMesh(pMesh, indexStart, prim, generatedLOD);
+}
+
+// pClusters is nullptr unless the frame is using clustered lighting
+void vcGLTF_RenderShadedPrimitive(const vcGLTFMeshPrimitive &prim, int generatedLOD, const vcGLTFClusterLighting *pClusters, vcShader **ppBoundShader)
+{
+  int features = prim.features | vcGLTF_GetMaterialFeatures(prim.pMaterial);
+  if (pClusters != nullptr && (features & vcRSB_Unlit) == 0)
+    features |= vcRSB_ClusteredLighting;
+
+  const vcGLTFShader &shader = vcGLTF_GetShader(features);
+  if (shader.pShader == nullptr)
+    return;
+
+  vcGLTF_BindShader(shader.pShader, ppBoundShader);
+
+  vcGLTF_BindConstantBuffer(shader.pShader, shader.pVertUniformBuffer, &s_gltfVertInfo, sizeof(s_gltfVertInfo));
+
+  if ((prim.features & vcRSB_Skinned) > 0)
+    vcGLTF_BindConstantBuffer(shader.pShader, shader.pSkinningUniformBuffer, &s_gltfVertSkinningInfo, sizeof(s_gltfVertSkinningInfo));
+
+  //Material
+  s_gltfFragInfo.u_EmissiveFactor = prim.pMaterial->emissiveFactor;
+  s_gltfFragInfo.u_BaseColorFactor = prim.pMaterial->baseColorFactor;
+  s_gltfFragInfo.u_MetallicFactor = prim.pMaterial->metallicFactor;
+  s_gltfFragInfo.u_RoughnessFactor = prim.pMaterial->roughnessFactor;
+
+  s_gltfFragInfo.u_Exposure = 1.f;
+  s_gltfFragInfo.u_NormalScale = (float)prim.pMaterial->normalScale;
+
+  s_gltfFragInfo.u_alphaMode = prim.pMaterial->alphaMode;
+  s_gltfFragInfo.u_AlphaCutoff = prim.pMaterial->alphaCutoff;
+
+  if (prim.pMaterial->alphaMode == vcGLTFAM_Blend)
+    vcGLState_SetBlendMode(vcGLSBM_Interpolative);
+  else
+    vcGLState_SetBlendMode(vcGLSBM_None);
+
+  if (prim.pMaterial->pBaseColorTexture != nullptr)
+  {
+    s_gltfFragInfo.u_BaseColorUVSet = prim.pMaterial->baseColorUVSet;
+    vcGLTF_BindTexture(shader.pShader, prim.pMaterial->pBaseColorTexture, shader.pBaseColourSampler);
   }
-  else if (layoutType == vcVLT_BoneIDs)
+  else
   {
-    for (int vi = 0; vi < readCount; ++vi)
-    {
-      uint16_t *pIDs = (uint16_t*)(pScene->pBuffers[bufferID].pBytes + byteOffset + vi * byteStride);
-      uint32_t *pVertI32 = (uint32_t*)(pPtr + stride * vi + offset);
+    s_gltfFragInfo.u_BaseColorUVSet = -1;
+  }
 
-      *pVertI32 = ((pIDs[3] & 0xFF) << 24) | ((pIDs[2] & 0xFF) << 16) | ((pIDs[1] & 0xFF) << 8) | ((pIDs[0] & 0xFF) << 0);
-    }
+  if (prim.pMaterial->pMetallicRoughnessTexture != nullptr)
+  {
+    s_gltfFragInfo.u_MetallicRoughnessUVSet = prim.pMaterial->metallicRoughnessUVSet;
+    vcGLTF_BindTexture(shader.pShader, prim.pMaterial->pMetallicRoughnessTexture, shader.pMetallicRoughnessSampler);
   }
   else
   {
-    for (int vi = 0; vi < readCount; ++vi)
-    {
-      float *pFloats = (float*)(pScene->pBuffers[bufferID].pBytes + byteOffset + vi * byteStride);
-      float *pVertFloats = (float*)(pPtr + stride * vi + offset);
+    s_gltfFragInfo.u_MetallicRoughnessUVSet = -1;
+  }
 
-      for (int element = 0; element < count; ++element)
-      {
-        pVertFloats[element] = pFloats[element];
-      }
-    }
+  if (prim.pMaterial->pNormalTexture != nullptr)
+  {
+    s_gltfFragInfo.u_NormalUVSet = prim.pMaterial->normalUVSet;
+    vcGLTF_BindTexture(shader.pShader, prim.pMaterial->pNormalTexture, shader.pNormalMapSampler);
+  }
+  else
+  {
+    s_gltfFragInfo.u_NormalUVSet = -1;
   }
 
-  return result;
+  if (prim.pMaterial->pEmissiveTexture != nullptr)
+  {
+    s_gltfFragInfo.u_EmissiveUVSet = prim.pMaterial->emissiveUVSet;
+    vcGLTF_BindTexture(shader.pShader, prim.pMaterial->pEmissiveTexture, shader.pEmissiveMapSampler);
+  }
+  else
+  {
+    s_gltfFragInfo.u_EmissiveUVSet = -1;
+  }
+
+  if (prim.pMaterial->pOcclusionTexture != nullptr)
+  {
+    s_gltfFragInfo.u_OcclusionUVSet = prim.pMaterial->occlusionUVSet;
+    s_gltfFragInfo.u_OcclusionStrength = 1.f;
+    vcGLTF_BindTexture(shader.pShader, prim.pMaterial->pOcclusionTexture, shader.pOcclusionMapSampler);
+  }
+  else
+  {
+    s_gltfFragInfo.u_OcclusionUVSet = -1;
+  }
+
+  vcGLTF_BindConstantBuffer(shader.pShader, shader.pFragUniformBuffer, &s_gltfFragInfo, sizeof(s_gltfFragInfo));
+
+  if (features & vcRSB_ClusteredLighting)
+  {
+    vcGLTF_BindConstantBuffer(shader.pShader, shader.pClusterUniformBuffer, &s_gltfClusterInfo, sizeof(s_gltfClusterInfo));
+    vcGLTF_BindTexture(shader.pShader, pClusters->pLightTexture, shader.pClusterLightSampler);
+    vcGLTF_BindTexture(shader.pShader, pClusters->pIndexTexture, shader.pClusterIndexSampler);
+    vcGLTF_BindTexture(shader.pShader, pClusters->pGridTexture, shader.pClusterGridSampler);
+  }
+
+  if (prim.pMaterial->doubleSided)
+    vcGLState_SetFaceMode(vcGLSFM_Solid, vcGLSCM_None, true, false);
+  else
+    vcGLState_SetFaceMode(vcGLSFM_Solid, vcGLSCM_Back, true, false);
+
+  vcGLTF_RenderPrimitiveMesh(prim.pMesh, prim.indexStart, prim, generatedLOD);
 }
 
-udResult vcGLTF_LoadMaterial(vcGLTFScene *pScene, const udJSON &root, int material)
+udResult vcGLTF_Render(vcGLTFScene *pScene, udRay<double> camera, udDouble4x4 worldMatrix, udDouble4x4 viewMatrix, udDouble4x4 projectionMatrix, vcGLTFRenderPass pass, const vcGLTFLightSet &lighting)
 {
-  int textureID = 0;
+  vcGLTFLightList lightList = {};
+  lightList.ambientLighting = lighting.ambientLighting;
+  lightList.lightCount = udMin(lighting.lightCount, (int)vcGLTFLimit_LightCount);
+  lightList.pLights = lighting.lights;
 
-  // This check can't be done because the material needs to be setup correctly
-  if (material >= 0 && material < pScene->materialCount)
-  {
-    vcGLTFMaterial *pMat = &pScene->pMaterials[material];
+  return vcGLTF_Render(pScene, camera, worldMatrix, viewMatrix, projectionMatrix, pass, lightList);
+}
 
-    pMat->pName = udStrdup(root.Get("materials[%d].name", material).AsString());
+void vcGLTF_MarkVisibleNodes(vcGLTFScene *pScene, vcGLTFNode *pNode)
+{
+  int nodeID = (int)(pNode - pScene->pNodes);
 
-    pMat->baseColorFactor = root.Get("materials[%d].pbrMetallicRoughness.baseColorFactor", material).AsFloat4(udFloat4::one());
-    textureID = root.Get("materials[%d].pbrMetallicRoughness.baseColorTexture.index", material).AsInt(-1);
-    pMat->baseColorUVSet = root.Get("materials[%d].pbrMetallicRoughness.baseColorTexture.texCoord", material).AsInt(0);
-    if (textureID != -1)
-      vcGLTF_LoadTexture(pScene, root, textureID, &pMat->pBaseColorTexture);
+  // Nothing below a hidden node is visited
+  if (!vcGLTF_BitsetGet(pScene->nodeVisibility, nodeID))
+    return;
 
-    pMat->metallicFactor = root.Get("materials[%d].pbrMetallicRoughness.metallicFactor", material).AsFloat(1.f);
-    pMat->roughnessFactor = root.Get("materials[%d].pbrMetallicRoughness.roughnessFactor", material).AsFloat(1.f);
-    textureID = root.Get("materials[%d].pbrMetallicRoughness.metallicRoughnessTexture.index", material).AsInt(-1);
-    pMat->metallicRoughnessUVSet = root.Get("materials[%d].pbrMetallicRoughness.metallicRoughnessTexture.texCoord", material).AsInt(0);
-    if (textureID != -1)
-      vcGLTF_LoadTexture(pScene, root, textureID, &pMat->pMetallicRoughnessTexture);
+  vcGLTF_BitsetSet(&pScene->visibleNodes, nodeID, true);
 
-    pMat->normalScale = root.Get("materials[%d].normalTexture.scale", material).AsFloat(1.f);
-    textureID = root.Get("materials[%d].normalTexture.index", material).AsInt(-1);
-    pMat->normalUVSet = root.Get("materials[%d].normalTexture.texCoord", material).AsInt(0);
-    if (textureID != -1)
-      vcGLTF_LoadTexture(pScene, root, textureID, &pMat->pNormalTexture);
+  for (int i = 0; i < pNode->childCount; ++i)
+    vcGLTF_MarkVisibleNodes(pScene, pNode->ppChildren[i]);
+}
 
-    pMat->emissiveFactor = root.Get("materials[%d].emissiveFactor", material).AsFloat3();
-    textureID = root.Get("materials[%d].emissiveTexture.index", material).AsInt(-1);
-    pMat->emissiveUVSet = root.Get("materials[%d].emissiveTexture.texCoord", material).AsInt(0);
-    if (textureID != -1)
-      vcGLTF_LoadTexture(pScene, root, textureID, &pMat->pEmissiveTexture);
+// Rebuilds visibleInstances after the mesh or node visibility has changed
+void vcGLTF_UpdateVisibility(vcGLTFScene *pScene)
+{
+  if (!pScene->visibilityDirty)
+    return;
 
-    textureID = root.Get("materials[%d].occlusionTexture.index", material).AsInt(-1);
-    pMat->occlusionUVSet = root.Get("materials[%d].occlusionTexture.texCoord", material).AsInt(0);
-    if (textureID != -1)
-      vcGLTF_LoadTexture(pScene, root, textureID, &pMat->pOcclusionTexture);
+  pScene->visibilityDirty = false;
 
-    const char *pAlphaModeStr = root.Get("materials[%d].alphaMode", material).AsString(nullptr);
-    pMat->alphaMode = vcGLTFAM_Opaque;
-    pMat->alphaCutoff = -1.f;
-    if (udStrEquali(pAlphaModeStr, "MASK"))
-    {
-      pMat->alphaMode = vcGLTFAM_Mask;
-      pMat->alphaCutoff = root.Get("materials[%d].alphaCutoff", material).AsFloat(0.5f);
-    }
-    else if (udStrEquali(pAlphaModeStr, "BLEND"))
+  vcGLTF_BitsetSetAll(&pScene->visibleNodes, false);
+  for (int i = 0; i < pScene->nodeCount; ++i)
+  {
+    if (pScene->pNodes[i].pParent == nullptr)
+      vcGLTF_MarkVisibleNodes(pScene, &pScene->pNodes[i]);
+  }
+
+  vcGLTF_BitsetSetAll(&pScene->visibleInstances, false);
+  pScene->visibleInstanceCount = 0;
+
+  for (size_t i = 0; i < pScene->meshInstances.length; ++i)
+  {
+    const vcGLTFMeshInstance &instance = pScene->meshInstances[i];
+
+    if (vcGLTF_BitsetGet(pScene->visibleNodes, instance.pNode - pScene->pNodes) && vcGLTF_BitsetGet(pScene->meshVisibility, instance.meshID))
     {
-      pMat->alphaMode = vcGLTFAM_Blend;
+      vcGLTF_BitsetSet(&pScene->visibleInstances, i, true);
+      ++pScene->visibleInstanceCount;
     }
+  }
+}
+
+// Adds a deferred mesh to the request queue and returns the instance's most detailed LOD that can be drawn now, if any
+vcGLTFMesh *vcGLTF_RequestMesh(vcGLTFScene *pScene, const vcGLTFMeshInstance &instance, vcGLTFMesh *pMesh)
+{
+  if (pMesh->state == vcGLTFMS_Deferred)
+  {
+    pMesh->state = vcGLTFMS_Requested;
+    pScene->pMeshRequests[pScene->meshRequestCount++] = (int)(pMesh - pScene->pMeshes);
+  }
 
-    pMat->doubleSided = root.Get("materials[%d].doubleSided", material).AsBool(false);
+  if (pMesh->state == vcGLTFMS_Streamed)
+  {
+    pMesh->lastDrawnFrame = pScene->frameIndex;
+    return pMesh;
   }
 
-  return udR_Success;
+  for (int lod = 0; lod < instance.lodMeshCount; ++lod)
+  {
+    vcGLTFMesh *pLODMesh = &pScene->pMeshes[instance.lodMeshIDs[lod]];
+
+    if (pLODMesh->state == vcGLTFMS_Streamed)
+      pLODMesh->lastDrawnFrame = pScene->frameIndex;
+
+    if (pLODMesh->state == vcGLTFMS_Created || pLODMesh->state == vcGLTFMS_Streamed)
+      return pLODMesh;
+  }
+
+  return nullptr;
 }
 
-udResult vcGLTF_CreateMesh(vcGLTFScene *pScene, const udJSON &root, int meshID)
+// Returns a streamed mesh to vcGLTFMS_Deferred; its primitives stay in the arena and are reused if it's requested again
+void vcGLTF_EvictMesh(vcGLTFScene *pScene, vcGLTFMesh *pMesh)
 {
-  const udJSON &mesh = root.Get("meshes[%d]", meshID);
-  
-  int numPrimitives = (int)mesh.Get("primitives").ArrayLength();
-  pScene->pMeshes[meshID].pName = udStrdup(mesh.Get("name").AsString());
-  pScene->pMeshes[meshID].numPrimitives = numPrimitives;
-  pScene->pMeshes[meshID].pPrimitives = udAllocType(vcGLTFMeshPrimitive, numPrimitives, udAF_Zero);
+  for (int j = 0; j < pMesh->numPrimitives; ++j)
+  {
+    vcMesh_Destroy(&pMesh->pPrimitives[j].pMesh);
+    vcMesh_Destroy(&pMesh->pPrimitives[j].pPositionMesh);
+  }
 
-  for (int i = 0; i < numPrimitives; ++i)
+  udFree(pMesh->bvh.pNodes);
+  udFree(pMesh->bvh.pTriangles);
+  memset(&pMesh->bvh, 0, sizeof(pMesh->bvh));
+  pMesh->bvhReady = 0;
+
+  pScene->vertexBytes -= pMesh->vertexBytes;
+  pScene->indexBytes -= pMesh->indexBytes;
+  pMesh->vertexBytes = 0;
+  pMesh->indexBytes = 0;
+
+  pMesh->numPrimitives = 0;
+  pMesh->state = vcGLTFMS_Deferred;
+}
+
+bool vcGLTF_GPUBudgetFull()
+{
+  vcGLTF_LockMemoryBudget();
+  bool full = (s_gltfMemoryBudget.gpuBudget > 0 && s_gltfMemoryBudget.gpuCharged >= s_gltfMemoryBudget.gpuBudget);
+  vcGLTF_UnlockMemoryBudget();
+
+  return full;
+}
+
+// Moves every queued request into a job for the worker pool (or decodes them here without one). Everything that writes to the
+// scene (the arena allocations and the buffer loads) happens here so the decode only reads it
+void vcGLTF_StartStreamingJob(vcGLTFScene *pScene)
+{
+  vcGLTFStreamingJob *pJob = udAllocType(vcGLTFStreamingJob, 1, udAF_Zero);
+  if (pJob == nullptr)
+    return;
+
+  pJob->pMeshes = udAllocType(vcGLTFStreamedMesh, pScene->meshRequestCount, udAF_Zero);
+  if (pJob->pMeshes == nullptr)
   {
-    const udJSON &primitive = mesh.Get("primitives[%d]", i);
+    udFree(pJob);
+    return;
+  }
 
-    vcMeshFlags meshFlags = vcMF_None;
-    vcGLTFFeatureBits featureBits = vcRSB_None;
+  pJob->pScene = pScene;
+  pJob->meshCount = pScene->meshRequestCount;
 
-    int mode = primitive.Get("mode").AsInt(4); // Points, Lines, Triangles
-    if (mode != 4)
-      __debugbreak();
+  for (int i = 0; i < pJob->meshCount; ++i)
+  {
+    vcGLTFStreamedMesh *pStreamed = &pJob->pMeshes[i];
+    pStreamed->meshID = pScene->pMeshRequests[i];
 
-    int material = primitive.Get("material").AsInt(0);
+    vcGLTF_BeginMesh(pScene, pStreamed->meshID);
+    vcGLTF_LoadMeshBuffers(pScene, pStreamed->meshID);
+    pStreamed->primitiveCount = pScene->pMeshes[pStreamed->meshID].numPrimitives;
+    pStreamed->pPrimitives = udAllocType(vcGLTFDecodedPrimitive, pStreamed->primitiveCount, udAF_Zero);
+  }
 
-    if (material < 0 || material >= pScene->materialCount)
-    {
-      __debugbreak();
-      material = 0;
-    }
-    pScene->pMeshes[meshID].pPrimitives[i].pMaterial = &pScene->pMaterials[material];
+  pScene->meshRequestCount = 0;
+  pScene->pStreamingJob = pJob;
 
-    int indexAccessor = primitive.Get("indices").AsInt(-1);
-    void *pIndexBuffer = nullptr;
-    int32_t indexCount = 0;
-    bool indexCopy = false;
+  udInterlockedPreIncrement(&pScene->pendingTasks);
 
-    if (indexAccessor != -1)
-    {
-      const udJSON &accessor = root.Get("accessors[%d]", indexAccessor);
+  if (pScene->pWorkerPool == nullptr || udWorkerPool_AddTask(pScene->pWorkerPool, vcGLTF_DecodeMeshesTask, pJob, false) != udR_Success)
+    vcGLTF_DecodeMeshesTask(pJob);
+}
 
-      if (udStrEqual("SCALAR", accessor.Get("type").AsString()))
-      {
-        indexCount = accessor.Get("count").AsInt();
+// Meshes that fail are never requested again
+void vcGLTF_UploadStreamedMesh(vcGLTFScene *pScene, vcGLTFStreamedMesh *pStreamed)
+{
+  vcGLTFTraceScope traceScope("Upload mesh", pStreamed->meshID);
+  vcGLTFMesh *pMesh = &pScene->pMeshes[pStreamed->meshID];
+  int64_t vertexBytes = pScene->vertexBytes;
+  int64_t indexBytes = pScene->indexBytes;
+  udResult result = pStreamed->result;
 
-        int bufferID = root.Get("bufferViews[%d].buffer", accessor.Get("bufferView").AsInt(-1)).AsInt();
-        if (bufferID <= -1)
-          __debugbreak();
+  for (int i = 0; i < pStreamed->primitiveCount && result == udR_Success; ++i)
+    result = vcGLTF_UploadPrimitive(pScene, pMesh, i, pStreamed->pPrimitives[i]);
 
-        vcGLTFTypes indexType = (vcGLTFTypes)accessor.Get("componentType").AsInt();
-        ptrdiff_t offset = accessor.Get("byteOffset").AsInt64() + root.Get("bufferViews[%d].byteOffset", accessor.Get("bufferView").AsInt(-1)).AsInt();
+  pMesh->vertexBytes = pScene->vertexBytes - vertexBytes;
+  pMesh->indexBytes = pScene->indexBytes - indexBytes;
 
-        if (indexType == vcGLTFType_Int16 || indexType == vcGLTFType_UInt16 || indexType == vcGLTFType_Int8 || indexType == vcGLTFType_UInt8)
-          meshFlags = meshFlags | vcMF_IndexShort;
-        else if (indexType != vcGLTFType_Int32 && indexType != vcGLTFType_Uint32)
-          __debugbreak();
+  if (result == udR_Success)
+  {
+    vcGLTF_FinishMesh(pScene, pMesh);
+    pMesh->lastDrawnFrame = pScene->frameIndex;
+    pMesh->state = vcGLTFMS_Streamed;
+  }
+  else
+  {
+    vcGLTF_LogProgress(pScene, "Unable to stream mesh %d\n", pStreamed->meshID);
+    vcGLTF_EvictMesh(pScene, pMesh);
+    pMesh->state = vcGLTFMS_Failed;
+  }
+
+  vcGLTF_FreeStreamedMesh(pStreamed);
+}
 
-        if (bufferID < pScene->bufferCount && pScene->pBuffers[bufferID].pBytes == nullptr)
-          vcGLTF_LoadBuffer(pScene, root, bufferID);
+// Once per frame: uploads the meshes the worker pool has decoded (at least one) until the streaming budget is spent, starts
+// decoding the next batch of requests once the last has been uploaded, then evicts streamed meshes that haven't been drawn
+// recently. Only the upload needs the GL context so only it runs here
+void vcGLTF_ProcessMeshRequests(vcGLTFScene *pScene)
+{
+  if (pScene->pMeshRequests == nullptr || pScene->streamingFrame == pScene->frameIndex)
+    return;
 
-        if (pScene->pBuffers[bufferID].pBytes != nullptr)
-          pIndexBuffer = (pScene->pBuffers[bufferID].pBytes + offset);
+  pScene->streamingFrame = pScene->frameIndex;
 
-        if (indexType == vcGLTFType_Int8 || indexType == vcGLTFType_UInt8)
-        {
-          uint16_t *pNewIndexBuffer = udAllocType(uint16_t, indexCount, udAF_None);
-          for (int index = 0; index < indexCount; ++index)
-            pNewIndexBuffer[index] = ((uint8_t*)pIndexBuffer)[index];
-          indexCopy = true;
-          pIndexBuffer = pNewIndexBuffer;
-        }
+  bool changed = false;
+  uint64_t start = udPerfCounterStart();
+
+  vcGLTFStreamingJob *pJob = pScene->pStreamingJob;
+  if (pJob != nullptr)
+  {
+    int firstUpload = pJob->uploadedCount;
+
+    while (pJob->uploadedCount < pJob->decodedCount && (pJob->uploadedCount == firstUpload || udPerfCounterMilliseconds(start) < pScene->streamingBudgetMs) && !vcGLTF_GPUBudgetFull())
+    {
+      vcGLTF_UploadStreamedMesh(pScene, &pJob->pMeshes[pJob->uploadedCount]);
+      ++pJob->uploadedCount;
+      changed = true;
+    }
+
+    if (pJob->uploadedCount == pJob->meshCount)
+      vcGLTF_DestroyStreamingJob(&pScene->pStreamingJob);
+  }
+
+  // Requests left waiting on a full budget mean the derived data doesn't fit after all. The flags are only changed between
+  // jobs as the decode reads them
+  if (pScene->pStreamingJob == nullptr && pScene->meshRequestCount > 0)
+  {
+    if (vcGLTF_GPUBudgetFull())
+      vcGLTF_ReduceMemory(pScene);
+    else
+      vcGLTF_StartStreamingJob(pScene);
+  }
+
+  if (pScene->evictFrames > 0)
+  {
+    for (int i = 0; i < pScene->meshCount; ++i)
+    {
+      vcGLTFMesh *pMesh = &pScene->pMeshes[i];
+
+      // The BVH build still references the mesh until it's ready
+      if (pMesh->state == vcGLTFMS_Streamed && pScene->frameIndex - pMesh->lastDrawnFrame > pScene->evictFrames && pMesh->bvhReady != 0)
+      {
+        vcGLTF_EvictMesh(pScene, pMesh);
+        changed = true;
       }
     }
+  }
 
-    const udJSON &attributes = primitive.Get("attributes");
-    int totalAttributes = (int)attributes.MemberCount();
-    vcVertexLayoutTypes *pTypes = udAllocType(vcVertexLayoutTypes, totalAttributes+1, udAF_None); //+1 in case we need to add normals
+  if (changed)
+  {
+    vcGLTFMemoryUsage usage;
+    vcGLTF_GetMemoryUsage(pScene, &usage);
+    vcGLTF_ChargeMemory(pScene, usage.hostTotal, usage.gpuTotal);
+  }
+}
 
-    int maxCount = -1;
-    bool hasNormals = false;
+udResult vcGLTF_Render(vcGLTFScene *pScene, udRay<double> camera, udDouble4x4 worldMatrix, udDouble4x4 viewMatrix, udDouble4x4 projectionMatrix, vcGLTFRenderPass pass, const vcGLTFLightList &lighting)
+{
+  vcGLTFTraceScope traceScope("vcGLTF_Render", pass);
+  vcShader *pBoundShader = nullptr;
+  uint32_t transparentCount = 0;
+  uint32_t cachedCount = 0;
+  uint32_t cachedPaletteCount = 0;
+  memset(&s_gltfRenderStats, 0, sizeof(s_gltfRenderStats));
+  udDouble4x4 viewProjectionMatrix = projectionMatrix * viewMatrix;
+  udFloat4x4 sceneToWorld = udFloat4x4::create(worldMatrix) * vcGLTF_SpaceChange;
 
-    struct
-    {
-      const char *pAttrName;
-      const char *pAccessorType;
-      vcVertexLayoutTypes type;
-      vcGLTFFeatureBits featureBits;
-    } supportedTypes[] = {
-      { "POSITION", "VEC3", vcVLT_Position3, vcRSB_None },
-      { "NORMAL", "VEC3", vcVLT_Normal3, vcRSB_None },
-      { "TANGENT", "VEC4", vcVLT_Tangent4, vcRSB_Tangents },
-      { "TEXCOORD_0", "VEC2", vcVLT_TextureCoords2_0, vcRSB_UVSet0 },
-      { "TEXCOORD_1", "VEC2", vcVLT_TextureCoords2_1, vcRSB_UVSet1 },
-      { "COLOR_0", "VEC3", vcVLT_ColourBGRA, vcRSB_Colour },
-      { "COLOR_0", "VEC4", vcVLT_ColourBGRA, vcRSB_Colour },
-      { "JOINTS_0", "VEC4", vcVLT_BoneIDs, vcRSB_Skinned },
-      { "WEIGHTS_0", "VEC4", vcVLT_BoneWeights, vcRSB_Skinned },
-    };
+  s_gltfFragInfo.u_Camera = udFloat3::create(camera.position);
+  s_gltfFragInfo.u_ambience = udFloat4::create(vcGLTF_sRGBToLinear(lighting.ambientLighting), 0.f);
 
-    for (size_t j = 0; j < totalAttributes; ++j)
-    {
-      const char *pAttributeName = attributes.GetMemberName(j);
-      int attributeAccessorIndex = attributes.GetMember(j)->AsInt(0);
+  vcGLTF_ProcessMeshRequests(pScene);
+  vcGLTF_UpdateVisibility(pScene);
 
-      const udJSON &accessor = root.Get("accessors[%d]", attributeAccessorIndex);
+  // Clustered lighting bins every light once per frame; otherwise each instance picks its own most influential lights
+  const vcGLTFClusterLighting *pClusters = nullptr;
+  bool selectLights = false;
+  if (pass != vcGLTFRP_Shadows)
+  {
+    if (lighting.mode == vcGLTFLM_Clustered && vcGLTF_BuildClusters(&pScene->clusters, viewProjectionMatrix, lighting))
+      pClusters = &pScene->clusters;
+    else
+      selectLights = true;
+  }
 
-      const char *pAccessorType = accessor.Get("type").AsString();
-      int attributeType = accessor.Get("componentType").AsInt(0);
-      int attributeCount = accessor.Get("count").AsInt();
+  if (selectLights)
+    vcGLTF_BuildLightGrid(&pScene->lightGrid, lighting.pLights, lighting.lightCount);
 
-      int bufferID = root.Get("bufferViews[%d].buffer", accessor.Get("bufferView").AsInt(-1)).AsInt();
-      if (bufferID <= -1)
-        __debugbreak();
+  // Frustum in GLTF scene space so instance bounds can be tested without transforming them
+  udDouble4x4 sceneToView = viewMatrix * worldMatrix * udDouble4x4::create(vcGLTF_SpaceChange);
+  vcGLTFFrustum sceneFrustum;
+  vcGLTF_ExtractFrustum(projectionMatrix * sceneToView, &sceneFrustum);
 
-      if (bufferID < pScene->bufferCount && pScene->pBuffers[bufferID].pBytes == nullptr)
-        vcGLTF_LoadBuffer(pScene, root, bufferID);
+  // Shadow views are usually orthographic and would never cull anything
+  udFloat4x4 sceneToClip = udFloat4x4::create(projectionMatrix * sceneToView);
+  bool testOcclusion = ((pScene->loadFlags & vcGLTFLF_OcclusionCulling) && pass != vcGLTFRP_Shadows && vcGLTF_BuildOcclusion(pScene, sceneFrustum, sceneToView, projectionMatrix));
 
-      if (maxCount == -1)
-        maxCount = attributeCount;
-      else if (maxCount != attributeCount)
-        __debugbreak();
+  // The pre-pass lays down depth as primitives are visited and queues them to be shaded afterwards with an equal depth test.
+  // Primitives the depth shaders can't cut out correctly are shaded as they're visited instead
+  bool depthPrepass = (pass == vcGLTFRP_Opaque && pScene->depthPrepass);
+  if (depthPrepass)
+    vcGLState_SetDepthStencilMode(vcGLSDM_LessOrEqual, true);
 
-      pTypes[j] = vcVLT_Unsupported;
+  // Culling and submission are interleaved per instance
+  uint64_t traceStart = vcGLTF_TraceStart();
 
-      for (size_t stIter = 0; stIter < udLengthOf(supportedTypes); ++stIter)
-      {
-        if (udStrEqual(pAttributeName, supportedTypes[stIter].pAttrName) && udStrEqual(pAccessorType, supportedTypes[stIter].pAccessorType))
-        {
-          pTypes[j] = supportedTypes[stIter].type;
-          featureBits = (vcGLTFFeatureBits)(featureBits | supportedTypes[stIter].featureBits);
-          break;
-        }
-      }
+  size_t instanceCount = pScene->meshInstances.length;
+  s_gltfRenderStats.instancesTested = (int)instanceCount;
+  s_gltfRenderStats.instancesCulledMask = (int)(instanceCount - pScene->visibleInstanceCount);
 
-      if ((pTypes[j] == vcVLT_BoneIDs && attributeType != vcGLTFType_UInt16) || (pTypes[j] != vcVLT_BoneIDs && attributeType != vcGLTFType_F32))
-        __debugbreak();
+  // Instances are in node order so a hidden subtree is a run of clear bits, skipped without visiting its instances
+  for (size_t i = vcGLTF_BitsetNext(pScene->visibleInstances, 0); i < instanceCount; i = vcGLTF_BitsetNext(pScene->visibleInstances, i + 1))
+  {
+    int meshID = pScene->meshInstances[i].meshID;
+    vcGLTFMesh *pMesh = &pScene->pMeshes[meshID];
 
-      if (pTypes[j] == vcVLT_Normal3)
-        hasNormals = true;
-      else if (pTypes[j] == vcVLT_Unsupported)
-        __debugbreak();
+    if (!vcGLTF_FrustumTestBounds(sceneFrustum, pScene->meshInstances[i].sceneMin, pScene->meshInstances[i].sceneMax))
+    {
+      ++s_gltfRenderStats.instancesCulledFrustum;
+      continue;
     }
 
-    if (!hasNormals)
+    if (testOcclusion && vcGLTF_OcclusionTestBounds(pScene->occlusion, sceneToClip, pScene->meshInstances[i].sceneMin, pScene->meshInstances[i].sceneMax))
     {
-      pTypes[totalAttributes] = vcVLT_Normal3;
-      ++totalAttributes;
+      ++s_gltfRenderStats.instancesCulledOcclusion;
+      continue;
     }
 
-    vcLayout_Sort(pTypes, totalAttributes);
+    int generatedLOD = 0;
+    if (pScene->meshInstances[i].lodMeshCount > 1 || (pScene->loadFlags & vcGLTFLF_GenerateLODs))
+    {
+      int meshLOD = 0;
+      float coverage = vcGLTF_ScreenCoverage(sceneToView, projectionMatrix, pScene->meshInstances[i].sceneMin, pScene->meshInstances[i].sceneMax);
 
-    uint32_t vertexStride = vcLayout_GetSize(pTypes, totalAttributes);
-    uint8_t *pVertData = udAllocType(uint8_t, vertexStride * maxCount, udAF_Zero);
+      if (!vcGLTF_SelectLOD(pScene->meshInstances[i], coverage, &meshLOD, &generatedLOD))
+      {
+        ++s_gltfRenderStats.instancesCulledLOD;
+        continue;
+      }
 
-    // Decode the buffers
-    int totalOffset = 0;
+      pMesh = &pScene->pMeshes[pScene->meshInstances[i].lodMeshIDs[meshLOD]];
+    }
 
-    for (int ai = 0; ai < totalAttributes; ++ai)
+    if (pMesh->state != vcGLTFMS_Created)
     {
-      if (pTypes[ai] == vcVLT_Normal3 && !hasNormals)
+      pMesh = vcGLTF_RequestMesh(pScene, pScene->meshInstances[i], pMesh);
+      if (pMesh == nullptr)
       {
-        int count = 3;
-        int offset = totalOffset;
-        totalOffset += count * sizeof(float);
-
-        int posAI = -1;
-        for (int pai = 0; pai < totalAttributes; ++pai)
-        {
-          if (pTypes[pai] == vcVLT_Position3)
-          {
-            posAI = pai;
-            break;
-          }
-        }
+        ++s_gltfRenderStats.instancesPending;
+        continue;
+      }
+    }
 
-        if (posAI == -1)
-          __debugbreak(); // No position found?
+    // Skinned primitives only have a per-instance bound; rigid meshes with multiple primitives can be tested individually
+    bool testPrimitives = (pScene->meshInstances[i].skinID < 0 && pMesh->numPrimitives > 1);
+    vcGLTFFrustum localFrustum;
+    if (testPrimitives)
+      vcGLTF_TransformFrustum(sceneFrustum, udDouble4x4::create(pScene->meshInstances[i].pNode->GetMat(false)), &localFrustum);
 
-        int attributeAccessorIndex = attributes.GetMember(posAI)->AsInt(0);
-        const udJSON& accessor = root.Get("accessors[%d]", attributeAccessorIndex);
+    // Transparent primitives are deferred until they're sorted, so the constants are set when they're drawn
+    udDouble4x4 modelMatrix;
+    if (pass == vcGLTFRP_Transparent)
+      modelMatrix = worldMatrix * udDouble4x4::create(vcGLTF_SpaceChange) * udDouble4x4::create(pScene->meshInstances[i].pNode->GetMat(false));
+    else
+      vcGLTF_SetInstanceConstants(pScene, pScene->meshInstances[i], worldMatrix, viewProjectionMatrix);
 
-        int bufferViewID = accessor.Get("bufferView").AsInt(-1);
-        int bufferID = root.Get("bufferViews[%d].buffer", bufferViewID).AsInt();
-        if (bufferID <= -1)
-          __debugbreak();
+    bool lightsSelected = false;
+    if (selectLights && pass != vcGLTFRP_Transparent && !depthPrepass)
+    {
+      vcGLTF_SelectInstanceLights(pScene, pScene->meshInstances[i], sceneToWorld, lighting);
+      lightsSelected = true;
+    }
 
-        ptrdiff_t byteOffset = accessor.Get("byteOffset").AsInt64() + root.Get("bufferViews[%d].byteOffset", accessor.Get("bufferView").AsInt(-1)).AsInt64();
-        ptrdiff_t byteStride = accessor.Get("byteStride").AsInt64() + root.Get("bufferViews[%d].byteStride", accessor.Get("bufferView").AsInt(-1)).AsInt64();
+    int constantsID = -1;
 
-        for (int vi = 0; vi < maxCount; ++vi)
-        {
-          float *pVertFloats = (float*)(pVertData + vertexStride * vi + offset);
+    for (int j = 0; j < pMesh->numPrimitives; ++j)
+    {
+      const vcGLTFMeshPrimitive &prim = pMesh->pPrimitives[j];
 
-          udFloat3 normal = { 0.f, 0.f, 1.f };
+      if ((prim.pMaterial->alphaMode == vcGLTFAM_Blend && pass != vcGLTFRP_Transparent) || (prim.pMaterial->alphaMode != vcGLTFAM_Blend && pass == vcGLTFRP_Transparent))
+      {
+        ++s_gltfRenderStats.primitivesSkippedPass;
+        continue;
+      }
 
-          if (pIndexBuffer == nullptr)
-          {
-            int triangleStart = (vi / 3);
-            normal = GetNormal(triangleStart, triangleStart + 1, triangleStart + 2, pScene->pBuffers[bufferID].pBytes + byteOffset, byteStride);
-          }
-          else
-          {
-            if (meshFlags & vcMF_IndexShort)
-            {
-              uint16_t *pIndices = (uint16_t*)pIndexBuffer;
-              for (int indexIter = 0; indexIter < indexCount; ++indexIter)
-              {
-                if (pIndices[indexIter] == vi)
-                {
-                  int triangleStart = (indexIter / 3) * 3;
-                  normal = GetNormal(pIndices[triangleStart], pIndices[triangleStart + 1], pIndices[triangleStart + 2], pScene->pBuffers[bufferID].pBytes + byteOffset, byteStride);
-                }
-              }
-            }
-            else
-            {
-              int32_t *pIndices = (int32_t*)pIndexBuffer;
-              for (int indexIter = 0; indexIter < indexCount; ++indexIter)
-              {
-                if (pIndices[indexIter] == vi)
-                {
-                  int triangleStart = (indexIter / 3) * 3;
-                  normal = GetNormal(pIndices[triangleStart], pIndices[triangleStart + 1], pIndices[triangleStart + 2], pScene->pBuffers[bufferID].pBytes + byteOffset, byteStride);
-                }
-              }
-            }
-          }
+      if (testPrimitives && !vcGLTF_FrustumTestBounds(localFrustum, prim.localMin, prim.localMax))
+      {
+        ++s_gltfRenderStats.primitivesCulledFrustum;
+        continue;
+      }
 
-          for (int element = 0; element < count; ++element)
-          {
-            pVertFloats[element] = normal[element];
-          }
-        }
+      if (pass == vcGLTFRP_Shadows)
+      {
+        vcGLTF_RenderDepthPrimitive(prim, generatedLOD, vcGLSBM_None, &pBoundShader);
+        continue;
       }
-      else
+
+      if (depthPrepass && !vcGLTF_DepthMatchesShading(prim))
       {
-        int attributeAccessorIndex = -1;
-        
-        for (size_t atIter = 0; atIter < attributes.MemberCount() && attributeAccessorIndex == -1; ++atIter)
+        if (selectLights && !lightsSelected)
         {
-          for (size_t stIter = 0; stIter < udLengthOf(supportedTypes); ++stIter)
-          {
-            if (supportedTypes[stIter].type == pTypes[ai] && udStrEqual(attributes.GetMemberName(atIter), supportedTypes[stIter].pAttrName))
-            {
-              attributeAccessorIndex = attributes.GetMember(atIter)->AsInt();
-              break;
-            }
-          }
+          vcGLTF_SelectInstanceLights(pScene, pScene->meshInstances[i], sceneToWorld, lighting);
+          lightsSelected = true;
         }
 
-        vcGLTF_ReadAccessor(pScene, root, attributeAccessorIndex, &totalOffset, maxCount, pVertData, vertexStride, pTypes[ai]);
+        vcGLTF_RenderShadedPrimitive(prim, generatedLOD, pClusters, &pBoundShader);
+        continue;
       }
-    }
-
-    // Bind the correct shader
-    pScene->pMeshes[meshID].pPrimitives[i].features = featureBits;
-
-    vcShader_Bind(g_shaderTypes[featureBits].pShader);
-
-    if (pIndexBuffer == nullptr)
-      vcMesh_Create(&pScene->pMeshes[meshID].pPrimitives[i].pMesh, pTypes, totalAttributes, pVertData, maxCount, nullptr, 0, vcMF_NoIndexBuffer | meshFlags);
-    else
-      vcMesh_Create(&pScene->pMeshes[meshID].pPrimitives[i].pMesh, pTypes, totalAttributes, pVertData, maxCount, pIndexBuffer, indexCount, meshFlags);
-  
-    udFree(pTypes);
-    udFree(pVertData);
-
-    if (indexCopy)
-      udFree(pIndexBuffer);
-  }
 
+      if (depthPrepass)
+      {
+        vcGLTF_RenderDepthPrimitive(prim, generatedLOD, vcGLSBM_Additive, &pBoundShader);
 
-  return udR_Success;
-}
+        if (constantsID < 0)
+          constantsID = vcGLTF_CacheInstanceConstants(pScene, pScene->meshInstances[i], &cachedCount, &cachedPaletteCount);
 
-udResult vcGLTF_ProcessChildNode(vcGLTFScene *pScene, const udJSON &root, int nodeIndex, udFloat4x4 parentMatrix, vcGLTFNode *pParentNode)
-{
-  const udJSON &child = root.Get("nodes[%d]", nodeIndex);
-  vcGLTFNode *pNode = &pScene->pNodes[nodeIndex];
+        vcGLTFTransparentItem item = { (int)i, pMesh, j, generatedLOD, constantsID };
+        vcGLTF_PushTransparentItem(pScene, &transparentCount, item, 0);
+        continue;
+      }
 
-  if (pNode->pParent != nullptr && pNode->pParent != pParentNode)
-    __debugbreak(); // This means this node has multiple parents
+      if (pass == vcGLTFRP_Transparent)
+      {
+        // Sort key is the distance from the camera to the bound centre, furthest first
+        udDouble3 centre;
+        if (pScene->meshInstances[i].skinID < 0 && vcGLTF_BoundsValid(prim.localMin, prim.localMax))
+          centre = (modelMatrix * udDouble4::create(udDouble3::create(prim.localMin + prim.localMax) * 0.5, 1.0)).toVector3();
+        else
+          centre = (worldMatrix * udDouble4x4::create(vcGLTF_SpaceChange) * udDouble4::create(udDouble3::create(pScene->meshInstances[i].sceneMin + pScene->meshInstances[i].sceneMax) * 0.5, 1.0)).toVector3();
 
-  pNode->pParent = pParentNode;
-  pNode->dirty = true;
+        vcGLTFTransparentItem item = { (int)i, pMesh, j, generatedLOD, -1 };
+        vcGLTF_PushTransparentItem(pScene, &transparentCount, item, ~vcGLTF_FloatSortKey((float)udMagSq3(centre - camera.position)));
+        continue;
+      }
 
-  udFloat4x4 childMatrix = udFloat4x4::identity();
-  
-  if (child.Get("matrix").IsArray())
-  {
-    childMatrix = udFloat4x4::create(child.Get("matrix").AsDouble4x4());
-    childMatrix.extractTransforms(pNode->translation, pNode->scale, pNode->rotation);
-  }
-  else
-  {
-    pNode->translation = child.Get("translation").AsFloat3();
-    pNode->rotation = udFloatQuat::create(child.Get("rotation").AsQuaternion());
-    pNode->scale = child.Get("scale").AsFloat3(udFloat3::one());
-    
-    childMatrix = udFloat4x4::rotationQuat(pNode->rotation, pNode->translation) * udFloat4x4::scaleNonUniform(pNode->scale);
+      vcGLTF_RenderShadedPrimitive(prim, generatedLOD, pClusters, &pBoundShader);
+    }
   }
 
-  udFloat4x4 chainedMatrix = parentMatrix * childMatrix;
+  uint64_t traceEnd = udPerfCounterStart();
+  vcGLTF_TraceEvent("Cull and submit", traceStart, traceEnd);
+  traceStart = traceEnd;
 
-  if (!child.Get("mesh").IsVoid())
+  if (transparentCount > 0)
   {
-    vcGLTFMeshInstance *pMesh = pScene->meshInstances.PushBack();
-
-    pMesh->pNode = pNode;
-    pMesh->meshID = child.Get("mesh").AsInt();
-    pMesh->skinID = child.Get("skin").AsInt(0);
-
-    if (pMesh->skinID >= (int)root.Get("skins").ArrayLength())
-      pMesh->skinID = -1;
+    // Pre-pass items are shaded in the order they were visited, transparent items back to front
+    uint32_t *pOrder = nullptr;
+    if (depthPrepass)
+    {
+      vcGLState_SetDepthStencilMode(vcGLSDM_Equal, false);
+    }
+    else
+    {
+      pOrder = vcGLTF_RadixSort(pScene->pTransparentKeys, pScene->pTransparentOrder, transparentCount);
 
-    if (pMesh->meshID >= pScene->meshCount)
-      pMesh->meshID = 0;
+      traceEnd = udPerfCounterStart();
+      vcGLTF_TraceEvent("Sort", traceStart, traceEnd, transparentCount);
+      traceStart = traceEnd;
+    }
 
-    if (pScene->pMeshes[pMesh->meshID].pPrimitives == nullptr)
-      vcGLTF_CreateMesh(pScene, root, pMesh->meshID);
-  }
-  else if (!child.Get("camera").IsVoid() || !child.Get("light").IsVoid())
-  {
-    // We don't care about these
-  }
-  else
-  {
-    // We support "animation heirachy" nodes which have these types
-    const char *allowedTypes[] =
-    {
-      "name",
-      "translation",
-      "rotation",
-      "scale",
-      "children",
-      "matrix"
-    };
+    int boundInstance = -1;
 
-    for (size_t memberIndex = 0; memberIndex < child.MemberCount(); ++memberIndex)
+    for (uint32_t k = 0; k < transparentCount; ++k)
     {
-      size_t allowedTypeIndex = 0;
+      const vcGLTFTransparentItem &item = pScene->pTransparentItems[pOrder != nullptr ? pOrder[k] : k];
 
-      for (allowedTypeIndex = 0; allowedTypeIndex < udLengthOf(allowedTypes); ++allowedTypeIndex)
+      if (item.instanceID != boundInstance)
       {
-        if (udStrEqual(allowedTypes[allowedTypeIndex], child.GetMemberName(memberIndex)))
-          break;
+        if (item.constantsID >= 0)
+          vcGLTF_RestoreInstanceConstants(pScene, item.constantsID);
+        else
+          vcGLTF_SetInstanceConstants(pScene, pScene->meshInstances[item.instanceID], worldMatrix, viewProjectionMatrix);
+        if (selectLights)
+          vcGLTF_SelectInstanceLights(pScene, pScene->meshInstances[item.instanceID], sceneToWorld, lighting);
+        boundInstance = item.instanceID;
       }
 
-      if (allowedTypeIndex == udLengthOf(allowedTypes))
-      {
-        __debugbreak(); // New node type
-      }
+      vcGLTF_RenderShadedPrimitive(item.pMesh->pPrimitives[item.primitiveID], item.generatedLOD, pClusters, &pBoundShader);
     }
+
+    vcGLTF_TraceEvent("Submit deferred", traceStart, udPerfCounterStart(), transparentCount);
   }
 
-  if (!child.Get("children").IsVoid())
-  {
-    pNode->childCount = (int)child.Get("children").ArrayLength();
-    pNode->ppChildren = udAllocType(vcGLTFNode*, pNode->childCount, udAF_Zero);
+  if (depthPrepass)
+    vcGLState_SetDepthStencilMode(vcGLSDM_LessOrEqual, true);
 
-    for (int i = 0; i < child.Get("children").ArrayLength(); ++i)
-    {
-      int childIndex = child.Get("children[%zu]", i).AsInt();
-      vcGLTF_ProcessChildNode(pScene, root, childIndex, chainedMatrix, pNode);
-      pNode->ppChildren[i] = &pScene->pNodes[childIndex];
-    }
-  }
+  if (pass >= 0 && pass < vcGLTFRP_Count)
+    pScene->renderStats[pass] = s_gltfRenderStats;
 
   return udR_Success;
 }
 
-udResult vcGLTF_LoadAnimations(vcGLTFScene *pScene, const udJSON &root)
+
+udResult vcGLTF_GetBounds(vcGLTFScene *pScene, udDouble4x4 worldMatrix, udDouble3 *pMin, udDouble3 *pMax)
 {
-  udResult result = udR_Success;
+  if (pScene == nullptr || pMin == nullptr || pMax == nullptr)
+    return udR_InvalidParameter_;
 
-  for (int i = 0; i < pScene->animationCount; ++i)
+  udFloat3 sceneMin = udFloat3::create(FLT_MAX);
+  udFloat3 sceneMax = udFloat3::create(-FLT_MAX);
+
+  for (size_t i = 0; i < pScene->meshInstances.length; ++i)
   {
-    printf("\t\tLoading Animation %d\n", i);
+    if (vcGLTF_BoundsValid(pScene->meshInstances[i].sceneMin, pScene->meshInstances[i].sceneMax))
+      vcGLTF_ExpandBounds(&sceneMin, &sceneMax, pScene->meshInstances[i].sceneMin, pScene->meshInstances[i].sceneMax);
+  }
 
-    vcGLTFAnimation *pAnim = &pScene->pAnimations[i];
+  if (!vcGLTF_BoundsValid(sceneMin, sceneMax))
+    return udR_NothingToDo;
 
-    pAnim->numSamplers = (int)root.Get("animations[%d].samplers", i).ArrayLength();
-    pAnim->pSamplers = udAllocType(vcGLTFAnimationSampler, pAnim->numSamplers, udAF_Zero);
+  udDouble4x4 sceneToWorld = worldMatrix * udDouble4x4::create(vcGLTF_SpaceChange);
+  *pMin = udDouble3::create(DBL_MAX);
+  *pMax = udDouble3::create(-DBL_MAX);
 
-    for (int samplerIndex = 0; samplerIndex < pAnim->numSamplers; ++samplerIndex)
-    {
-      int totalOffset = 0;
+  for (int corner = 0; corner < 8; ++corner)
+  {
+    udDouble3 position = udDouble3::create((corner & 1) ? sceneMax.x : sceneMin.x, (corner & 2) ? sceneMax.y : sceneMin.y, (corner & 4) ? sceneMax.z : sceneMin.z);
+    udDouble3 world = (sceneToWorld * udDouble4::create(position, 1.0)).toVector3();
 
-      int inputAccessor = root.Get("animations[%d].samplers[%d].input", i, samplerIndex).AsInt();
-      int inputCount = root.Get("accessors[%d].count", inputAccessor).AsInt();
+    *pMin = udMin(*pMin, world);
+    *pMax = udMax(*pMax, world);
+  }
 
-      pAnim->pSamplers[samplerIndex].steps = inputCount;
-      pAnim->pSamplers[samplerIndex].pTime = udAllocType(float, inputCount, udAF_None);
-      vcGLTF_ReadAccessor(pScene, root, inputAccessor, &totalOffset, inputCount, (uint8_t*)pAnim->pSamplers[samplerIndex].pTime, 0);
+  return udR_Success;
+}
 
-      int outputAccessor = root.Get("animations[%d].samplers[%d].output", i, samplerIndex).AsInt();
-      int outputCount = root.Get("accessors[%d].count", outputAccessor).AsInt();
-      int outputType = root.Get("accessors[%d].componentType", outputAccessor).AsInt();
+udResult vcGLTF_Raycast(vcGLTFScene *pScene, udRay<double> ray, udDouble4x4 worldMatrix, vcGLTFRaycastResult *pResult)
+{
+  if (pScene == nullptr || pResult == nullptr)
+    return udR_InvalidParameter_;
 
-      const char *pOutputType = root.Get("accessors[%d].type", outputAccessor).AsString();
+  pResult->meshID = -1;
+  pResult->primitiveID = -1;
+  pResult->triangleID = -1;
+  pResult->nodeID = -1;
 
-      const char *interpolationNames[] = { "LINEAR", "STEP", "CUBICSPLINE" };
-      UDCOMPILEASSERT(udLengthOf(interpolationNames) == vcGLTFInterpolation_Count, "Array out of date!");
+  if (pScene->instanceNodeCount == 0)
+    return udR_ObjectNotFound;
 
-      const char *pInterpolationName = root.Get("animations[%d].samplers[%d].interpolation", i, samplerIndex).AsString("LINEAR");
+  vcGLTF_UpdateVisibility(pScene);
 
-      int j = 0;
-      for (j = 0; j < vcGLTFInterpolation_Count; ++j)
-      {
-        if (udStrEqual(interpolationNames[j], pInterpolationName))
-        {
-          pAnim->pSamplers[samplerIndex].interpolationMethod = (vcGLTFInterpolation)j;
-          break;
-        }
-      }
+  // Affine transforms keep the ray parameter intact so distances can be compared across spaces
+  udDouble4x4 worldToScene = udInverse(worldMatrix * udDouble4x4::create(vcGLTF_SpaceChange));
+  udDouble3 sceneOrigin = (worldToScene * udDouble4::create(ray.position, 1.0)).toVector3();
+  udDouble3 sceneDirection = (worldToScene * udDouble4::create(ray.direction, 0.0)).toVector3();
 
-      if (j == vcGLTFInterpolation_Count)
-        __debugbreak();
+  udFloat3 origin = udFloat3::create(sceneOrigin);
+  udFloat3 direction = udFloat3::create(sceneDirection);
+  udFloat3 invDirection = vcGLTF_SafeInverseDirection(direction);
 
-      if (pAnim->pSamplers[samplerIndex].interpolationMethod != vcGLTFInterpolation_CublicSpline && inputCount != outputCount)
-        __debugbreak();
+  float closestT = FLT_MAX;
+  int closestInstance = -1;
+  int closestTriangle = -1;
 
-      if (pAnim->pSamplers[samplerIndex].interpolationMethod == vcGLTFInterpolation_CublicSpline && inputCount != (outputCount/3))
-        __debugbreak();
+  int localStack[128];
+  int *pStack = localStack;
+  if (pScene->instanceMaxDepth + 1 > (int)udLengthOf(localStack))
+    pStack = udAllocType(int, pScene->instanceMaxDepth + 1, udAF_None);
 
-      totalOffset = 0;
+  int stackSize = 0;
 
-      if (outputType == vcGLTFType_F32)
-      {
-        if (udStrEqual(pOutputType, "VEC4"))
-        {
-          pAnim->pSamplers[samplerIndex].pOutputFloatQuat = udAllocType(udFloatQuat, outputCount, udAF_None);
-          vcGLTF_ReadAccessor(pScene, root, outputAccessor, &totalOffset, outputCount, (uint8_t*)pAnim->pSamplers[samplerIndex].pOutputFloatQuat, 0);
-        }
-        else if(udStrEqual(pOutputType, "VEC3"))
-        {
-          pAnim->pSamplers[samplerIndex].pOutputFloat3 = udAllocType(udFloat3, outputCount, udAF_None);
-          vcGLTF_ReadAccessor(pScene, root, outputAccessor, &totalOffset, outputCount, (uint8_t*)pAnim->pSamplers[samplerIndex].pOutputFloat3, 0);
-        }
-        else
-        {
-          __debugbreak();
-        }
-      }
-      else
+  if (pStack != nullptr && vcGLTF_RayBoundsDistance(origin, invDirection, pScene->pInstanceNodes[0].boundsMin, pScene->pInstanceNodes[0].boundsMax, closestT) != FLT_MAX)
+    pStack[stackSize++] = 0;
+
+  while (stackSize > 0)
+  {
+    const vcGLTFBVHNode &node = pScene->pInstanceNodes[pStack[--stackSize]];
+
+    if (node.itemCount == 0)
+    {
+      for (int c = 0; c < 2; ++c)
       {
-        __debugbreak();
+        const vcGLTFBVHNode &child = pScene->pInstanceNodes[node.leftFirst + c];
+        if (vcGLTF_RayBoundsDistance(origin, invDirection, child.boundsMin, child.boundsMax, closestT) != FLT_MAX)
+          pStack[stackSize++] = node.leftFirst + c;
       }
+      continue;
     }
 
-    pAnim->numChannels = (int)root.Get("animations[%d].channels", i).ArrayLength();
-    pAnim->pChannels = udAllocType(vcGLTFAnimationChannel, pAnim->numChannels, udAF_Zero);
-
-    for (int channelIndex = 0; channelIndex < pAnim->numChannels; ++channelIndex)
+    for (int i = node.leftFirst; i < node.leftFirst + node.itemCount; ++i)
     {
-      int nodeIndex = root.Get("animations[%d].channels[%d].target.node", i, channelIndex).AsInt();
-      int samplerIndex = root.Get("animations[%d].channels[%d].sampler", i, channelIndex).AsInt();
-      const char *pTargetPath = root.Get("animations[%d].channels[%d].target.path", i, channelIndex).AsString();
-
-      if (nodeIndex < 0 || nodeIndex > pScene->nodeCount)
-        __debugbreak();
-
-      if (samplerIndex < 0 || samplerIndex > pAnim->numSamplers)
-        __debugbreak();
-
-      pAnim->pChannels[channelIndex].nodeIndex = nodeIndex;
-      pAnim->pChannels[channelIndex].pSampler = &pAnim->pSamplers[samplerIndex];
-
-      pAnim->totalTime = udMax(pAnim->totalTime, pAnim->pChannels[channelIndex].pSampler->pTime[pAnim->pChannels[channelIndex].pSampler->steps - 1]);
+      int instanceIndex = pScene->pInstanceOrder[i];
+      const vcGLTFMeshInstance &instance = pScene->meshInstances[instanceIndex];
+      const vcGLTFMesh &mesh = pScene->pMeshes[instance.meshID];
 
-      const char *supportedPaths[] = { "translation", "rotation", "scale", "weights" };
-      UDCOMPILEASSERT(udLengthOf(supportedPaths) == vcGLTFChannelTarget_Count, "Array out of date!");
+      if (!vcGLTF_BitsetGet(pScene->visibleInstances, instanceIndex))
+        continue;
 
-      int j = 0;
-      for (j = 0; j < vcGLTFChannelTarget_Count; ++j)
+      // Meshes without triangles in memory (deferred, evicted or still building their BVH) are hit at their bounds
+      if (mesh.bvhReady == 0)
       {
-        if (udStrEqual(supportedPaths[j], pTargetPath))
+        float boundsT = vcGLTF_RayBoundsDistance(origin, invDirection, instance.sceneMin, instance.sceneMax, closestT);
+        if (boundsT < closestT)
         {
-          pAnim->pChannels[channelIndex].target = (vcGLTFChannelTarget)j;
-          break;
+          closestT = boundsT;
+          closestInstance = instanceIndex;
+          closestTriangle = -1;
         }
+        continue;
       }
 
-      if (j == vcGLTFChannelTarget_Count)
-        __debugbreak();
+      // Skinned instances are tested against their bind pose
+      udDouble4x4 sceneToNode = udInverse(udDouble4x4::create(instance.pNode->GetMat(false)));
+      udFloat3 nodeOrigin = udFloat3::create((sceneToNode * udDouble4::create(sceneOrigin, 1.0)).toVector3());
+      udFloat3 nodeDirection = udFloat3::create((sceneToNode * udDouble4::create(sceneDirection, 0.0)).toVector3());
+
+      if (vcGLTF_RaycastBVH(mesh.bvh, nodeOrigin, nodeDirection, &closestT, &closestTriangle))
+        closestInstance = instanceIndex;
     }
   }
 
-  return result;
-}
-
-udResult vcGLTF_LoadSkins(vcGLTFScene *pScene, const udJSON &gltfData)
-{
-  pScene->skinCount = (int)gltfData.Get("skins").ArrayLength();
-  pScene->pSkins = udAllocType(vcGLTFSkin, pScene->skinCount, udAF_Zero);
+  if (pStack != localStack)
+    udFree(pStack);
 
-  for (int i = 0; i < pScene->skinCount; ++i)
-  {
-    if (gltfData.Get("skins[%d].name", i).IsString())
-      pScene->pSkins[i].pName = udStrdup(gltfData.Get("skins[%d].name", i).AsString());
+  if (closestInstance == -1)
+    return udR_ObjectNotFound;
 
-    pScene->pSkins[i].baseJoint = gltfData.Get("skins[%d].skeleton", i).AsInt();
+  const vcGLTFMeshInstance &instance = pScene->meshInstances[closestInstance];
 
-    pScene->pSkins[i].jointCount = (int)gltfData.Get("skins[%d].joints", i).ArrayLength();
-    pScene->pSkins[i].pJoints = udAllocType(int, pScene->pSkins[i].jointCount, udAF_Zero);
+  pResult->meshID = instance.meshID;
+  if (closestTriangle != -1)
+  {
+    const vcGLTFBVHTriangle &triangle = pScene->pMeshes[instance.meshID].bvh.pTriangles[closestTriangle];
+    pResult->primitiveID = triangle.primitiveID;
+    pResult->triangleID = triangle.triangleID;
+  }
+  pResult->nodeID = (int)(instance.pNode - pScene->pNodes);
+  pResult->distance = closestT * udMag3(ray.direction);
+  pResult->position = ray.position + ray.direction * (double)closestT;
 
-    if (pScene->pSkins[i].jointCount > vcGLTFLimit_JointCount)
-      __debugbreak();
+  return udR_Success;
+}
 
-    if (gltfData.Get("skins[%d].inverseBindMatrices", i).IsIntegral())
-    {
-      pScene->pSkins[i].pInverseBindMatrices = udAllocType(udFloat4x4, pScene->pSkins[i].jointCount, udAF_Zero);
+int vcGLTF_GetMeshCount(vcGLTFScene *pScene)
+{
+  if (pScene == nullptr)
+    return 0;
 
-      int offset = 0;
-      int inverseBinds = gltfData.Get("skins[%d].inverseBindMatrices", i).AsInt();
-      vcGLTF_ReadAccessor(pScene, gltfData, inverseBinds, &offset, pScene->pSkins[i].jointCount, (uint8_t*)pScene->pSkins[i].pInverseBindMatrices, 0);
-    }
+  return pScene->meshCount;
+}
 
-    for (int j = 0; j < pScene->pSkins[i].jointCount; ++j)
-      pScene->pSkins[i].pJoints[j] = gltfData.Get("skins[%d].joints[%d]", i, j).AsInt();
-  }
+int vcGLTF_GetNodeCount(vcGLTFScene *pScene)
+{
+  if (pScene == nullptr)
+    return 0;
 
-  return udR_Success;
+  return pScene->nodeCount;
 }
 
-udResult vcGLTF_Load(vcGLTFScene **ppScene, const char *pFilename, udWorkerPool *pWorkerPool)
+const char *vcGLTF_GetMeshName(vcGLTFScene *pScene, int id)
 {
-  udResult result = udR_Failure_;
-  
-  vcGLTFScene *pScene = udAllocType(vcGLTFScene, 1, udAF_Zero);
+  if (pScene == nullptr || pScene->meshCount <= id || id < 0)
+    return nullptr;
 
-  pScene->pWorkerPool = pWorkerPool;
-  pScene->meshInstances.Init(8);
+  return pScene->pMeshes[id].pName;
+}
 
-  char *pData = nullptr;
-  udJSON gltfData = {};
-  const udJSONArray *pSceneNodes = nullptr;
+int vcGLTF_GetMaterialCount(vcGLTFScene *pScene)
+{
+  if (pScene == nullptr)
+    return 0;
 
-  udFilename path(pFilename);
-  int pathLen = 0;
-  int baseScene = 0;
+  return pScene->materialCount;
+}
 
-  printf("Loading %s\n", pFilename);
-  UD_ERROR_CHECK(udFile_Load(pFilename, &pData));
-  UD_ERROR_CHECK(gltfData.Parse(pData));
-  udFree(pData);
+vcGLTFMaterial* vcGLTF_GetMaterial(vcGLTFScene *pScene, int id)
+{
+  if (pScene == nullptr || id < 0 || id >= pScene->materialCount)
+    return nullptr;
 
-  pathLen = path.ExtractFolder(nullptr, 0);
-  pScene->pPath = udAllocType(char, pathLen + 1, udAF_Zero);
-  path.ExtractFolder(pScene->pPath, pathLen + 1);
+  return &pScene->pMaterials[id];
+}
 
-  if (gltfData.Get("extensionsRequired").IsArray())
-    __debugbreak();
+udResult vcGLTF_GetRenderStats(vcGLTFScene *pScene, vcGLTFRenderPass pass, vcGLTFRenderStats *pStats)
+{
+  if (pScene == nullptr || pStats == nullptr || pass < 0 || pass >= vcGLTFRP_Count)
+    return udR_InvalidParameter_;
 
-  if (gltfData.Get("extensionsUsed").IsArray())
-    __debugbreak();
+  *pStats = pScene->renderStats[pass];
+  return udR_Success;
+}
 
-  pScene->nodeCount = (int)gltfData.Get("nodes").ArrayLength();
-  if (pScene->nodeCount > 0)
-    pScene->pNodes = udAllocType(vcGLTFNode, pScene->nodeCount, udAF_Zero);
-  printf("\t%d nodes\n", pScene->nodeCount);
+udResult vcGLTF_GetLoadStats(vcGLTFScene *pScene, vcGLTFLoadStats *pStats)
+{
+  if (pScene == nullptr || pStats == nullptr)
+    return udR_InvalidParameter_;
 
-  pScene->bufferCount = (int)gltfData.Get("buffers").ArrayLength();
-  if (pScene->bufferCount > 0)
-    pScene->pBuffers = udAllocType(vcGLTFBuffer, pScene->bufferCount, udAF_Zero);
-  printf("\t%d buffers\n", pScene->bufferCount);
+  *pStats = pScene->loadStats;
+  return udR_Success;
+}
 
-  pScene->meshCount = (int)gltfData.Get("meshes").ArrayLength();
-  if (pScene->meshCount > 0)
-    pScene->pMeshes = udAllocType(vcGLTFMesh, pScene->meshCount, udAF_Zero);
-  printf("\t%d meshes\n", pScene->meshCount);
+int64_t vcGLTF_StringBytes(const char *pString)
+{
+  return (pString == nullptr) ? 0 : (int64_t)udStrlen(pString) + 1;
+}
 
-  pScene->meshMask = -1; // All bits are set
-  if (pScene->meshCount > vcGLTFLimit_MeshMask)
-    __debugbreak(); // This isn't really a problem; it just means this model can only have the first 64 items masked out
+int64_t vcGLTF_TextureBytes(vcTexture *pTexture, int64_t bytesPerTexel)
+{
+  int width = 0;
+  int height = 0;
 
-  pScene->materialCount = udMax(1, (int)gltfData.Get("materials").ArrayLength()); // Need at least the "default" material
-  pScene->pMaterials = udAllocType(vcGLTFMaterial, pScene->materialCount, udAF_Zero);
-  printf("\t%d materials\n", pScene->meshCount);
+  if (pTexture == nullptr || vcTexture_GetSize(pTexture, &width, &height) != udR_Success)
+    return 0;
 
-  pScene->animationCount = (int)gltfData.Get("animations").ArrayLength();
-  if (pScene->animationCount > 0)
-    pScene->pAnimations = udAllocType(vcGLTFAnimation, pScene->animationCount, udAF_Zero);
+  return bytesPerTexel * width * height;
+}
 
-  baseScene = gltfData.Get("scene").AsInt();
-  pSceneNodes = gltfData.Get("scenes[%d].nodes", baseScene).AsArray();
+udResult vcGLTF_GetMemoryUsage(vcGLTFScene *pScene, vcGLTFMemoryUsage *pUsage)
+{
+  if (pScene == nullptr || pUsage == nullptr)
+    return udR_InvalidParameter_;
 
-  // Load Scene, Nodes & Meshes
-  for (int i = 0; i < pScene->materialCount; ++i)
-    vcGLTF_LoadMaterial(pScene, gltfData, i);
+  vcGLTFMemoryUsage usage = {};
 
-  for (size_t i = 0; i < pSceneNodes->length; ++i)
+  usage.bufferBytes = pScene->bufferCount * sizeof(vcGLTFBuffer);
+  for (int i = 0; i < pScene->bufferCount; ++i)
   {
-    int nodeID = pSceneNodes->GetElement(i)->AsInt();
-    printf("\tLoading scene node %zu (nodeID: %d)\n", i+1, nodeID);
-    vcGLTF_ProcessChildNode(pScene, gltfData, nodeID, udFloat4x4::identity(), nullptr);
+    if (pScene->pBuffers[i].pBytes != nullptr)
+      usage.bufferBytes += pScene->pBuffers[i].byteLength;
+
+    usage.stringBytes += vcGLTF_StringBytes(pScene->pBuffers[i].pURI);
   }
 
-  printf("\tLoading animations\n");
-  vcGLTF_LoadAnimations(pScene, gltfData);
+  usage.nodeBytes = pScene->nodeCount * sizeof(vcGLTFNode) + pScene->meshInstances.length * (sizeof(vcGLTFMeshInstance) + sizeof(int)) + pScene->instanceNodeCount * sizeof(vcGLTFBVHNode);
+  for (int i = 0; i < pScene->nodeCount; ++i)
+    usage.nodeBytes += pScene->pNodes[i].childCount * sizeof(vcGLTFNode*);
 
-  if (gltfData.Get("skins").ArrayLength() > 0)
+  usage.meshBytes = pScene->meshCount * sizeof(vcGLTFMesh) + pScene->packCount * sizeof(vcGLTFMeshPack);
+  usage.meshBytes += pScene->accessorCount * sizeof(vcGLTFAccessor) + pScene->bufferViewCount * sizeof(vcGLTFBufferView);
+  for (int i = 0; i < pScene->meshCount; ++i)
   {
-    printf("\tLoading skins\n");
-    vcGLTF_LoadSkins(pScene, gltfData);
-  }
+    const vcGLTFMesh &mesh = pScene->pMeshes[i];
 
-  result = udR_Success;
-  *ppScene = pScene;
-  pScene = nullptr;
+    usage.meshBytes += mesh.numPrimitives * sizeof(vcGLTFMeshPrimitive) + mesh.bvh.nodeCount * sizeof(vcGLTFBVHNode) + mesh.bvh.triangleCount * sizeof(vcGLTFBVHTriangle);
+    usage.meshBytes += mesh.primitiveDescCount * sizeof(vcGLTFPrimitiveDesc);
+    for (int j = 0; j < mesh.primitiveDescCount; ++j)
+      usage.meshBytes += mesh.pPrimitiveDescs[j].attributeCount * sizeof(vcGLTFAttributeDesc);
+    for (int j = 0; j < mesh.numPrimitives; ++j)
+      usage.meshBytes += mesh.pPrimitives[j].jointBoundCount * 2 * sizeof(udFloat3);
 
-epilogue:
-  printf("\tLoading complete. Status: %s\n", udResultAsString(result));
+    usage.stringBytes += vcGLTF_StringBytes(mesh.pName);
+  }
 
-  if (pScene != nullptr)
-    vcGLTF_Destroy(&pScene);
+  usage.materialBytes = pScene->materialCount * sizeof(vcGLTFMaterial);
+  for (int i = 0; i < pScene->materialCount; ++i)
+    usage.stringBytes += vcGLTF_StringBytes(pScene->pMaterials[i].pName);
 
-  udFree(pData);
+  // Textures used by several materials are only counted once
+  vcTexture **ppTextures = udAllocType(vcTexture*, pScene->materialCount * 5, udAF_None);
+  int textureCount = 0;
 
-  return result;
-}
+  for (int i = 0; i < pScene->materialCount && ppTextures != nullptr; ++i)
+  {
+    const vcGLTFMaterial &material = pScene->pMaterials[i];
+    vcTexture *textures[] = { material.pBaseColorTexture, material.pMetallicRoughnessTexture, material.pNormalTexture, material.pEmissiveTexture, material.pOcclusionTexture };
 
-void vcGLTF_Destroy(vcGLTFScene **ppScene)
-{
-  if (ppScene == nullptr || *ppScene == nullptr)
-    return;
+    for (size_t t = 0; t < udLengthOf(textures); ++t)
+    {
+      int counted = 0;
+      while (counted < textureCount && ppTextures[counted] != textures[t])
+        ++counted;
 
-  vcGLTFScene *pScene = *ppScene;
-  *ppScene = nullptr;
+      if (counted == textureCount && textures[t] != nullptr)
+      {
+        ppTextures[textureCount++] = textures[t];
+        usage.textureBytes += vcGLTF_TextureBytes(textures[t], 4);
+      }
+    }
+  }
 
-  for (int i = 0; i < pScene->meshCount; ++i)
+  udFree(ppTextures);
+
+  usage.animationBytes = pScene->animationCount * sizeof(vcGLTFAnimation);
+  for (int i = 0; i < pScene->animationCount; ++i)
   {
-    for (int j = 0; j < pScene->pMeshes[i].numPrimitives; ++j)
-    {
-      vcMesh_Destroy(&pScene->pMeshes[i].pPrimitives[j].pMesh);
-    }
+    const vcGLTFAnimation &animation = pScene->pAnimations[i];
 
-    udFree(pScene->pMeshes[i].pName);
-    udFree(pScene->pMeshes[i].pPrimitives);
+    usage.animationBytes += animation.numChannels * sizeof(vcGLTFAnimationChannel) + animation.numSamplers * sizeof(vcGLTFAnimationSampler);
+    for (int j = 0; j < animation.numSamplers; ++j)
+      usage.animationBytes += animation.pSamplers[j].steps * sizeof(float) + animation.pSamplers[j].outputBytes;
   }
-  udFree(pScene->pMeshes);
 
-  for (int i = 0; i < pScene->materialCount; ++i)
+  usage.skinBytes = pScene->skinCount * sizeof(vcGLTFSkin);
+  for (int i = 0; i < pScene->skinCount; ++i)
   {
-    udFree(pScene->pMaterials[i].pName);
-    ttTextureCache_Release(&pScene->pMaterials[i].pBaseColorTexture);
-    ttTextureCache_Release(&pScene->pMaterials[i].pEmissiveTexture);
-    ttTextureCache_Release(&pScene->pMaterials[i].pMetallicRoughnessTexture);
-    ttTextureCache_Release(&pScene->pMaterials[i].pNormalTexture);
-    ttTextureCache_Release(&pScene->pMaterials[i].pOcclusionTexture);
-  }
+    const vcGLTFSkin &skin = pScene->pSkins[i];
 
-  udFree(pScene->pMaterials);
+    usage.skinBytes += skin.jointCount * sizeof(int);
+    if (skin.pInverseBindMatrices != nullptr)
+      usage.skinBytes += skin.jointCount * sizeof(udFloat4x4);
 
-  for (int i = 0; i < pScene->bufferCount; ++i)
-    udFree(pScene->pBuffers[i].pBytes);
-  udFree(pScene->pBuffers);
+    usage.stringBytes += vcGLTF_StringBytes(skin.pName);
+  }
 
-  pScene->meshInstances.Deinit();
+  usage.stringBytes += vcGLTF_StringBytes(pScene->pPath);
 
-  for (int i = 0; i < pScene->nodeCount; ++i)
-    udFree(pScene->pNodes[i].ppChildren);
+  const vcGLTFLightGrid &grid = pScene->lightGrid;
+  const vcGLTFClusterLighting &clusters = pScene->clusters;
+  const vcGLTFOcclusionBuffer &occlusion = pScene->occlusion;
 
-  udFree(pScene->pNodes);
+  usage.scratchBytes = pScene->transparentCapacity * (sizeof(vcGLTFTransparentItem) + 4 * sizeof(uint32_t));
+  usage.scratchBytes += pScene->cachedConstantCapacity * sizeof(vcGLTFCachedConstants) + pScene->cachedPaletteCapacity * sizeof(udFloat4x4);
+  usage.scratchBytes += ((int64_t)grid.cellCapacity + grid.entryCapacity + grid.globalCapacity + grid.stampCapacity) * sizeof(uint32_t);
+  usage.scratchBytes += ((int64_t)clusters.lightRowCapacity * vcGLTFLimit_ClusterTextureWidth * 4 + clusters.indexCapacity) * sizeof(float) + clusters.rangeCapacity * sizeof(uint32_t);
 
-  if (pScene->pSkins != nullptr)
+  if (occlusion.pLevels[0] != nullptr)
   {
-    for (int i = 0; i < pScene->skinCount; ++i)
-    {
-      udFree(pScene->pSkins[i].pJoints);
-      udFree(pScene->pSkins[i].pName);
-      udFree(pScene->pSkins[i].pInverseBindMatrices);
-    }
-    udFree(pScene->pSkins);
+    for (int level = 0; level < vcGLTFLimit_OcclusionLevels; ++level)
+      usage.scratchBytes += occlusion.levelWidth[level] * occlusion.levelHeight[level] * sizeof(float);
   }
 
-  if (pScene->pAnimations != nullptr)
-  {
-    for (int i = 0; i < pScene->animationCount; ++i)
-    {
-      for (int j = 0; j < pScene->pAnimations[i].numSamplers; ++j)
-      {
-        udFree(pScene->pAnimations[i].pSamplers[j].pOutputFloat3);
-        udFree(pScene->pAnimations[i].pSamplers[j].pTime);
-      }
-
-      udFree(pScene->pAnimations[i].pSamplers);
-      udFree(pScene->pAnimations[i].pChannels);
-    }
-
-    udFree(pScene->pAnimations);
-  }
+  usage.textureBytes += vcGLTF_TextureBytes(clusters.pGridTexture, sizeof(udFloat4)) + vcGLTF_TextureBytes(clusters.pLightTexture, sizeof(udFloat4)) + vcGLTF_TextureBytes(clusters.pIndexTexture, sizeof(udFloat4));
+  usage.vertexBytes = pScene->vertexBytes;
+  usage.indexBytes = pScene->indexBytes;
 
-  udFree(pScene->pPath);
+  usage.hostTotal = sizeof(vcGLTFScene) + usage.bufferBytes + usage.nodeBytes + usage.meshBytes + usage.materialBytes + usage.animationBytes + usage.skinBytes + usage.stringBytes + usage.scratchBytes;
+  usage.gpuTotal = usage.vertexBytes + usage.indexBytes + usage.textureBytes;
 
-  udFree(pScene);
+  *pUsage = usage;
+  return udR_Success;
 }
 
-template<typename T>
-T vcGLTF_CubicSpline(T previousPoint, T previousTangent, T nextPoint, T nextTangent, float interpolationValue)
+void vcGLTF_SetMemoryBudget(int64_t hostBytes, int64_t gpuBytes)
 {
-  float t = interpolationValue;
-  float t2 = t * t;
-  float t3 = t2 * t;
-
-  return (2.f * t3 - 3.f * t2 + 1.f) * previousPoint + (t3 - 2.f * t2 + t) * previousTangent + (-2.f * t3 + 3.f * t2) * nextPoint + (t3 - t2) * nextTangent;
+  vcGLTF_LockMemoryBudget();
+  s_gltfMemoryBudget.hostBudget = udMax(hostBytes, (int64_t)0);
+  s_gltfMemoryBudget.gpuBudget = udMax(gpuBytes, (int64_t)0);
+  vcGLTF_UnlockMemoryBudget();
 }
 
-udResult vcGLTF_Update(vcGLTFScene *pScene, double dt)
+void vcGLTF_GetTotalMemoryUsage(int64_t *pHostBytes, int64_t *pGPUBytes)
 {
-  if (pScene->pCurrentAnimation == nullptr && pScene->pAnimations != nullptr)
-    pScene->pCurrentAnimation = &pScene->pAnimations[0];
-
-  if (pScene->pCurrentAnimation != nullptr)
-  {
-    pScene->currentTime += (float)dt;
+  vcGLTF_LockMemoryBudget();
 
-    vcGLTFAnimation *pAnim = pScene->pCurrentAnimation;
+  if (pHostBytes != nullptr)
+    *pHostBytes = s_gltfMemoryBudget.hostCharged;
+  if (pGPUBytes != nullptr)
+    *pGPUBytes = s_gltfMemoryBudget.gpuCharged;
 
-    while (pScene->currentTime > pAnim->totalTime)
-      pScene->currentTime -= pAnim->totalTime;
+  vcGLTF_UnlockMemoryBudget();
+}
 
-    for (int i = 0; i < pAnim->numChannels; ++i)
-    {
-      vcGLTFAnimationChannel *pChnl = &pAnim->pChannels[i];
-      vcGLTFNode *pNode = &pScene->pNodes[pChnl->nodeIndex];
+void vcGLTF_SetTracing(bool enabled)
+{
+  if (enabled && s_gltfTrace.epoch == 0)
+    s_gltfTrace.epoch = udPerfCounterStart();
 
-      pNode->dirty = true;
+  udInterlockedExchange(&s_gltfTrace.enabled, enabled ? 1 : 0);
+}
 
-      for (int j = 0; j < pChnl->pSampler->steps - 1; ++j)
-      {
-        if (pChnl->pSampler->pTime[j] < pScene->currentTime && pChnl->pSampler->pTime[j + 1] > pScene->currentTime)
-        {
-          float tdelta = (pChnl->pSampler->pTime[j + 1] - pChnl->pSampler->pTime[j]);
-          float ratio = (pScene->currentTime - pChnl->pSampler->pTime[j]) / tdelta;
+void vcGLTF_ResetTracing()
+{
+  for (int thread = 0; thread < vcGLTFLimit_TraceThreads; ++thread)
+  {
+    if (s_gltfTrace.pRings[thread] != nullptr)
+      s_gltfTrace.pRings[thread]->written = 0;
+  }
 
-          switch (pChnl->target)
-          {
-          case vcGLTFChannelTarget_Translation:
-            if (pChnl->pSampler->interpolationMethod == vcGLTFInterpolation_Linear)
-              pNode->translation = udLerp(pChnl->pSampler->pOutputFloat3[j], pChnl->pSampler->pOutputFloat3[j + 1], ratio);
-            else if (pChnl->pSampler->interpolationMethod == vcGLTFInterpolation_Step)
-              pNode->translation = pChnl->pSampler->pOutputFloat3[j];
-            else if (pChnl->pSampler->interpolationMethod == vcGLTFInterpolation_CublicSpline)
-              pNode->translation = vcGLTF_CubicSpline(pChnl->pSampler->pOutputFloat3[j * 3 + 1], tdelta * pChnl->pSampler->pOutputFloat3[j * 3 + 2], pChnl->pSampler->pOutputFloat3[(j + 1) * 3 + 1], tdelta * pChnl->pSampler->pOutputFloat3[(j + 1) * 3 + 0], ratio);
-            break;
-          case vcGLTFChannelTarget_Rotation:
-            if (pChnl->pSampler->interpolationMethod == vcGLTFInterpolation_Linear)
-              pNode->rotation = udSlerp(pChnl->pSampler->pOutputFloatQuat[j], pChnl->pSampler->pOutputFloatQuat[j + 1], (double)ratio);
-            else if (pChnl->pSampler->interpolationMethod == vcGLTFInterpolation_Step)
-              pNode->rotation = pChnl->pSampler->pOutputFloatQuat[j];
-            else if (pChnl->pSampler->interpolationMethod == vcGLTFInterpolation_CublicSpline)
-              pNode->rotation = vcGLTF_CubicSpline(pChnl->pSampler->pOutputFloatQuat[j * 3 + 1], tdelta * pChnl->pSampler->pOutputFloatQuat[j * 3 + 2], pChnl->pSampler->pOutputFloatQuat[(j + 1) * 3 + 1], tdelta * pChnl->pSampler->pOutputFloatQuat[(j + 1) * 3 + 0], ratio);
-            break;
-          case vcGLTFChannelTarget_Scale:
-            if (pChnl->pSampler->interpolationMethod == vcGLTFInterpolation_Linear)
-              pNode->scale = udLerp(pChnl->pSampler->pOutputFloat3[j], pChnl->pSampler->pOutputFloat3[j + 1], ratio);
-            else if (pChnl->pSampler->interpolationMethod == vcGLTFInterpolation_Step)
-              pNode->scale = pChnl->pSampler->pOutputFloat3[j];
-            else if (pChnl->pSampler->interpolationMethod == vcGLTFInterpolation_CublicSpline)
-              pNode->scale = vcGLTF_CubicSpline(pChnl->pSampler->pOutputFloat3[j * 3 + 1], tdelta * pChnl->pSampler->pOutputFloat3[j * 3 + 2], pChnl->pSampler->pOutputFloat3[(j + 1) * 3 + 1], tdelta * pChnl->pSampler->pOutputFloat3[(j + 1) * 3 + 0], ratio);
-            break;
-          case vcGLTFChannelTarget_Weights:
-            __debugbreak();
-            break;
-          }
+  s_gltfTrace.epoch = udPerfCounterStart();
+}
 
-          break;
-        }
-      }
-    }
+void vcGLTF_ShutdownTracing()
+{
+  udInterlockedExchange(&s_gltfTrace.enabled, 0);
 
-    for (int i = 0; i < pScene->nodeCount; ++i)
-    {
-      pScene->pNodes[i].GetMat(false);
-    }
-  }
+  // Threads keep their ring index; they allocate a new ring if tracing is enabled again
+  for (int thread = 0; thread < vcGLTFLimit_TraceThreads; ++thread)
+    udFree(s_gltfTrace.pRings[thread]);
 
-  return udR_Success;
+  s_gltfTrace.epoch = 0;
 }
 
-udResult vcGLTF_Render(vcGLTFScene *pScene, udRay<double> camera, udDouble4x4 worldMatrix, udDouble4x4 viewMatrix, udDouble4x4 projectionMatrix, vcGLTFRenderPass pass, const vcGLTFLightSet &lighting)
+udResult vcGLTF_WriteTrace(const char *pFilename)
 {
-  int bound = -1;
-
-  const udFloat4x4 SpaceChange = { 1, 0, 0, 0, 0, 0, 1, 0, 0, -1, 0, 0, 0, 0, 0, 1 };
+  udResult result = udR_Failure_;
+  udFile *pFile = nullptr;
+  char line[256];
+  const char *pSeparator = "";
 
-  s_gltfFragInfo.u_Camera = udFloat3::create(camera.position);
+  // udPerfCounterMilliseconds returns a float so the scale is taken over a large tick count to keep its precision
+  double microsecondsPerTick = udPerfCounterMilliseconds(0, 1000000000) * 1e-6;
+  int threadCount = udMin((int)s_gltfTrace.threadCount, (int)vcGLTFLimit_TraceThreads);
 
-  s_gltfFragInfo.u_ambience = udFloat4::create(lighting.ambientLighting, 0.f);
-  s_gltfFragInfo.u_lightCount = lighting.lightCount;
-  memcpy(s_gltfFragInfo.u_Lights, lighting.lights, sizeof(vcGLTFLight) * lighting.lightCount);
+  UD_ERROR_NULL(pFilename, udR_InvalidParameter_);
+  UD_ERROR_CHECK(udFile_Open(&pFile, pFilename, (udFileOpenFlags)(udFOF_Write | udFOF_Create)));
+  UD_ERROR_CHECK(udFile_Write(pFile, "{\"traceEvents\":[\n", 17));
 
-  for (size_t i = 0; i < pScene->meshInstances.length; ++i)
+  for (int thread = 0; thread < threadCount; ++thread)
   {
-    int meshID = pScene->meshInstances[i].meshID;
-    vcGLTFMesh *pMesh = &pScene->pMeshes[meshID];
-
-    if (pScene->meshMask != -1 && meshID < 64 && ((pScene->meshMask & (int64_t(1) << meshID)) == 0))
+    const vcGLTFTraceRing *pRing = s_gltfTrace.pRings[thread];
+    if (pRing == nullptr)
       continue;
 
-    if (pScene->meshInstances[i].skinID >= 0)
-    {
-      vcGLTFSkin *pSkin = &pScene->pSkins[pScene->meshInstances[i].skinID];
-
-      for (int j = 0; j < pSkin->jointCount; ++j)
-      {
-        s_gltfVertSkinningInfo.u_jointMatrix[j] = pScene->pNodes[pSkin->pJoints[j]].GetMat(false) * pSkin->pInverseBindMatrices[j];
-        s_gltfVertSkinningInfo.u_jointNormalMatrix[j] = udTranspose(udInverse(s_gltfVertSkinningInfo.u_jointMatrix[j]));
-      }
-    }
+    udSprintf(line, sizeof(line), "%s{\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"name\":\"thread_name\",\"args\":{\"name\":\"vcGLTF thread %d\"}}", pSeparator, thread, thread);
+    UD_ERROR_CHECK(udFile_Write(pFile, line, udStrlen(line)));
+    pSeparator = ",\n";
 
-    s_gltfVertInfo.u_ModelMatrix = udFloat4x4::create(worldMatrix) * SpaceChange * pScene->meshInstances[i].pNode->GetMat(false);
-    s_gltfVertInfo.u_ViewProjectionMatrix = udFloat4x4::create(projectionMatrix * viewMatrix);
-    s_gltfVertInfo.u_NormalMatrix = udTranspose(udInverse(s_gltfVertInfo.u_ModelMatrix));
-    
-    for (int j = 0; j < pMesh->numPrimitives; ++j)
+    uint32_t written = pRing->written;
+    uint32_t count = udMin(written, (uint32_t)vcGLTFLimit_TraceEvents);
+    for (uint32_t e = written - count; e != written; ++e)
     {
-      const vcGLTFMeshPrimitive &prim = pMesh->pPrimitives[j];
-      const vcGLTFShader &shader = g_shaderTypes[prim.features];
-
-      if ((prim.pMaterial->alphaMode == vcGLTFAM_Blend && pass != vcGLTFRP_Transparent) || (prim.pMaterial->alphaMode != vcGLTFAM_Blend && pass == vcGLTFRP_Transparent))
+      const vcGLTFTraceEvent &event = pRing->events[e & (vcGLTFLimit_TraceEvents - 1)];
+      if (event.start < s_gltfTrace.epoch || event.end < event.start)
         continue;
 
-      if (bound != prim.features)
-      {
-        vcShader_Bind(shader.pShader);
-        bound = prim.features;
-      }
+      double timestamp = (event.start - s_gltfTrace.epoch) * microsecondsPerTick;
+      double duration = (event.end - event.start) * microsecondsPerTick;
 
-      vcShader_BindConstantBuffer(shader.pShader, shader.pVertUniformBuffer, &s_gltfVertInfo, sizeof(s_gltfVertInfo));
+      if (event.arg >= 0)
+        udSprintf(line, sizeof(line), ",\n{\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,\"name\":\"%s\",\"args\":{\"id\":%d}}", thread, timestamp, duration, event.pName, event.arg);
+      else
+        udSprintf(line, sizeof(line), ",\n{\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,\"name\":\"%s\"}", thread, timestamp, duration, event.pName);
 
-      if ((prim.features & vcRSB_Skinned) > 0)
-        vcShader_BindConstantBuffer(shader.pShader, shader.pSkinningUniformBuffer, &s_gltfVertSkinningInfo, sizeof(s_gltfVertSkinningInfo));
+      UD_ERROR_CHECK(udFile_Write(pFile, line, udStrlen(line)));
+    }
+  }
 
-      //Material
-      s_gltfFragInfo.u_EmissiveFactor = prim.pMaterial->emissiveFactor;
-      s_gltfFragInfo.u_BaseColorFactor = prim.pMaterial->baseColorFactor;
-      s_gltfFragInfo.u_MetallicFactor = prim.pMaterial->metallicFactor;
-      s_gltfFragInfo.u_RoughnessFactor = prim.pMaterial->roughnessFactor;
+  UD_ERROR_CHECK(udFile_Write(pFile, "\n]}\n", 4));
+  result = udR_Success;
 
-      s_gltfFragInfo.u_Exposure = 1.f;
-      s_gltfFragInfo.u_NormalScale = (float)prim.pMaterial->normalScale;
+epilogue:
+  if (pFile != nullptr)
+    udFile_Close(&pFile);
 
-      s_gltfFragInfo.u_alphaMode = prim.pMaterial->alphaMode;
-      s_gltfFragInfo.u_AlphaCutoff = prim.pMaterial->alphaCutoff;
+  return result;
+}
 
-      if (prim.pMaterial->alphaMode == vcGLTFAM_Blend)
-        vcGLState_SetBlendMode(vcGLSBM_Interpolative);
-      else
-        vcGLState_SetBlendMode(vcGLSBM_None);
+int64_t vcGLTF_GetMeshMask(vcGLTFScene *pScene)
+{
+  if (pScene == nullptr)
+    return int64_t(-1);
 
-      if (prim.pMaterial->pBaseColorTexture != nullptr)
-      {
-        s_gltfFragInfo.u_BaseColorUVSet = prim.pMaterial->baseColorUVSet;
-        vcShader_BindTexture(shader.pShader, prim.pMaterial->pBaseColorTexture, 0, shader.pBaseColourSampler);
-      }
-      else
-      {
-        s_gltfFragInfo.u_BaseColorUVSet = -1;
-      }
+  int64_t meshMask = -1;
+  for (int i = 0; i < pScene->meshCount && i < 64; ++i)
+  {
+    if (!vcGLTF_BitsetGet(pScene->meshVisibility, i))
+      meshMask &= ~(int64_t(1) << i);
+  }
 
-      if (prim.pMaterial->pMetallicRoughnessTexture != nullptr)
-      {
-        s_gltfFragInfo.u_MetallicRoughnessUVSet = prim.pMaterial->metallicRoughnessUVSet;
-        vcShader_BindTexture(shader.pShader, prim.pMaterial->pMetallicRoughnessTexture, 0, shader.pMetallicRoughnessSampler);
-      }
-      else
-      {
-        s_gltfFragInfo.u_MetallicRoughnessUVSet = -1;
-      }
+  return meshMask;
+}
 
-      if (prim.pMaterial->pNormalTexture != nullptr)
-      {
-        s_gltfFragInfo.u_NormalUVSet = prim.pMaterial->normalUVSet;
-        vcShader_BindTexture(shader.pShader, prim.pMaterial->pNormalTexture, 0, shader.pNormalMapSampler);
-      }
-      else
-      {
-        s_gltfFragInfo.u_NormalUVSet = -1;
-      }
+void vcGLTF_SetMeshMask(vcGLTFScene *pScene, int64_t meshMask)
+{
+  if (pScene == nullptr)
+    return;
 
-      if (prim.pMaterial->pEmissiveTexture != nullptr)
-      {
-        s_gltfFragInfo.u_EmissiveUVSet = prim.pMaterial->emissiveUVSet;
-        vcShader_BindTexture(shader.pShader, prim.pMaterial->pEmissiveTexture, 0, shader.pEmissiveMapSampler);
-      }
-      else
-      {
-        s_gltfFragInfo.u_EmissiveUVSet = -1;
-      }
+  for (int i = 0; i < pScene->meshCount && i < 64; ++i)
+    vcGLTF_BitsetSet(&pScene->meshVisibility, i, (meshMask & (int64_t(1) << i)) != 0);
 
-      if (prim.pMaterial->pOcclusionTexture != nullptr)
-      {
-        s_gltfFragInfo.u_OcclusionUVSet = prim.pMaterial->occlusionUVSet;
-        s_gltfFragInfo.u_OcclusionStrength = 1.f;
-        vcShader_BindTexture(shader.pShader, prim.pMaterial->pOcclusionTexture, 0, shader.pOcclusionMapSampler);
-      }
-      else
-      {
-        s_gltfFragInfo.u_OcclusionUVSet = -1;
-      }
+  pScene->visibilityDirty = true;
+}
 
-      vcShader_BindConstantBuffer(shader.pShader, shader.pFragUniformBuffer, &s_gltfFragInfo, sizeof(s_gltfFragInfo));
+bool vcGLTF_GetMeshVisible(vcGLTFScene *pScene, int meshID)
+{
+  if (pScene == nullptr || meshID < 0)
+    return false;
 
-      if (prim.pMaterial->doubleSided)
-        vcGLState_SetFaceMode(vcGLSFM_Solid, vcGLSCM_None, true, false);
-      else
-        vcGLState_SetFaceMode(vcGLSFM_Solid, vcGLSCM_Back, true, false);
+  return vcGLTF_BitsetGet(pScene->meshVisibility, meshID);
+}
 
-      vcMesh_Render(prim.pMesh);
-    }
+void vcGLTF_SetMeshVisible(vcGLTFScene *pScene, int meshID, bool visible)
+{
+  vcGLTF_SetMeshesVisible(pScene, &meshID, 1, visible);
+}
+
+void vcGLTF_SetMeshesVisible(vcGLTFScene *pScene, const int *pMeshIDs, int count, bool visible)
+{
+  if (pScene == nullptr || pMeshIDs == nullptr)
+    return;
+
+  for (int i = 0; i < count; ++i)
+  {
+    if (pMeshIDs[i] >= 0)
+      vcGLTF_BitsetSet(&pScene->meshVisibility, pMeshIDs[i], visible);
   }
 
-  return udR_Success;
+  pScene->visibilityDirty = true;
 }
 
-
-int vcGLTF_GetMeshCount(vcGLTFScene *pScene)
+void vcGLTF_SetAllMeshesVisible(vcGLTFScene *pScene, bool visible)
 {
   if (pScene == nullptr)
-    return 0;
+    return;
 
-  return pScene->meshCount;
+  vcGLTF_BitsetSetAll(&pScene->meshVisibility, visible);
+  pScene->visibilityDirty = true;
 }
 
-const char *vcGLTF_GetMeshName(vcGLTFScene *pScene, int id)
+bool vcGLTF_GetNodeVisible(vcGLTFScene *pScene, int nodeID)
 {
-  if (pScene == nullptr || pScene->meshCount <= id || id < 0)
-    return nullptr;
+  if (pScene == nullptr || nodeID < 0)
+    return false;
 
-  return pScene->pMeshes[id].pName;
+  return vcGLTF_BitsetGet(pScene->nodeVisibility, nodeID);
 }
 
-int vcGLTF_GetMaterialCount(vcGLTFScene *pScene)
+void vcGLTF_SetNodeVisible(vcGLTFScene *pScene, int nodeID, bool visible)
+{
+  vcGLTF_SetNodesVisible(pScene, &nodeID, 1, visible);
+}
+
+void vcGLTF_SetNodesVisible(vcGLTFScene *pScene, const int *pNodeIDs, int count, bool visible)
+{
+  if (pScene == nullptr || pNodeIDs == nullptr)
+    return;
+
+  for (int i = 0; i < count; ++i)
+  {
+    if (pNodeIDs[i] >= 0)
+      vcGLTF_BitsetSet(&pScene->nodeVisibility, pNodeIDs[i], visible);
+  }
+
+  pScene->visibilityDirty = true;
+}
+
+void vcGLTF_SetAllNodesVisible(vcGLTFScene *pScene, bool visible)
 {
   if (pScene == nullptr)
-    return 0;
+    return;
 
-  return pScene->materialCount;
+  vcGLTF_BitsetSetAll(&pScene->nodeVisibility, visible);
+  pScene->visibilityDirty = true;
 }
 
-vcGLTFMaterial* vcGLTF_GetMaterial(vcGLTFScene *pScene, int id)
+bool vcGLTF_GetDepthPrepass(vcGLTFScene *pScene)
 {
-  if (pScene == nullptr || id < 0 || id >= pScene->materialCount)
-    return nullptr;
+  if (pScene == nullptr)
+    return false;
 
-  return &pScene->pMaterials[id];
+  return pScene->depthPrepass;
 }
 
-int64_t vcGLTF_GetMeshMask(vcGLTFScene *pScene)
+void vcGLTF_SetDepthPrepass(vcGLTFScene *pScene, bool enabled)
 {
   if (pScene == nullptr)
-    return int64_t(-1);
+    return;
 
-  return pScene->meshMask;
+  pScene->depthPrepass = enabled;
 }
 
-void vcGLTF_SetMeshMask(vcGLTFScene *pScene, int64_t meshMask)
+void vcGLTF_SetMeshStreaming(vcGLTFScene *pScene, float budgetMilliseconds, int evictFrames)
 {
   if (pScene == nullptr)
     return;
 
-  pScene->meshMask = meshMask;
+  pScene->streamingBudgetMs = budgetMilliseconds;
+  pScene->evictFrames = udMax(evictFrames, 0);
 }
 
 int vcGLTFAnim_GetNumberOfAnimations(vcGLTFScene *pScene)
@@ -14,6 +14,8 @@ enum vcGLTFRenderPass
   vcGLTFRP_Transparent,
 
   vcGLTFRP_Shadows,
+
+  vcGLTFRP_Count
 };
 
 enum vcGLTF_AlphaMode
@@ -48,6 +50,7 @@ struct vcGLTFMaterial
   int occlusionUVSet;
 
   bool doubleSided;
+  bool unlit; // KHR_materials_unlit
   vcGLTF_AlphaMode alphaMode;
   float alphaCutoff;
 };
@@ -83,26 +86,199 @@ struct vcGLTFLightSet
   vcGLTFLight lights[8];
 };
 
+enum vcGLTFLightingMode
+{
+  vcGLTFLM_PerInstance, // Each mesh instance uses its most influential vcGLTFLimit_LightCount lights
+  vcGLTFLM_Clustered, // Lights are binned into a view frustum grid each frame; suited to thousands of lights
+};
+
+// Any number of lights; each mesh instance is lit by the (up to) 8 that influence its bounds the most
+struct vcGLTFLightList
+{
+  vcGLTFLightingMode mode;
+  udFloat3 ambientLighting;
+  int lightCount;
+  const vcGLTFLight *pLights;
+};
+
+enum vcGLTFLoadFlags
+{
+  vcGLTFLF_None = 0,
+
+  vcGLTFLF_GenerateLODs = 1 << 0, // Builds a simplified LOD chain for indexed primitives; MSFT_lod chains are always used
+  vcGLTFLF_OptimizeIndices = 1 << 1, // Reorders indexed primitives for the post-transform cache, overdraw and vertex fetch
+  vcGLTFLF_WeldVertices = 1 << 2, // Merges identical vertices and indexes every primitive, using 16-bit indices where they fit. Primitives given generated tangents are always welded (on their own) as MikkTSpace writes a vertex per triangle corner
+  vcGLTFLF_OcclusionCulling = 1 << 3, // Skips instances hidden behind the largest on screen meshes using a CPU depth buffer
+  vcGLTFLF_LogProgress = 1 << 4, // Prints loading progress and the load stats to stdout
+  vcGLTFLF_DeferMeshes = 1 << 5, // Meshes are decoded and uploaded when vcGLTF_Render first needs them instead of while loading
+};
+
+inline vcGLTFLoadFlags operator|(const vcGLTFLoadFlags a, const vcGLTFLoadFlags b) { return (vcGLTFLoadFlags)(int(a) | int(b)); }
+
+enum vcGLTFLoadPhase
+{
+  vcGLTFLP_Parse, // Reading and parsing the .gltf JSON
+  vcGLTFLP_BufferIO, // Reading .bin buffers
+  vcGLTFLP_Materials, // Material and texture setup
+  vcGLTFLP_Nodes, // Node hierarchy
+  vcGLTFLP_MeshDecode, // Accessors to vertex and index data
+  vcGLTFLP_NormalGeneration,
+  vcGLTFLP_TangentGeneration,
+  vcGLTFLP_MeshProcessing, // Welding, LOD generation and index optimization
+  vcGLTFLP_Upload, // Creating the GPU meshes
+  vcGLTFLP_Animations,
+  vcGLTFLP_Skins,
+  vcGLTFLP_Finalize, // Instance bounds and BVH
+
+  vcGLTFLP_Count
+};
+
+struct vcGLTFLoadStats
+{
+  double phaseMilliseconds[vcGLTFLP_Count]; // Exclusive wall time; phases nested in others (like buffer reads) aren't double counted
+  double totalMilliseconds;
+
+  int64_t fileBytesRead; // .gltf and .bin files
+  int64_t accessorBytesDecoded;
+  int64_t verticesUploaded;
+  int64_t indicesUploaded;
+  int texturesRequested;
+};
+
+// Counters for the most recent vcGLTF_Render call of each pass
+struct vcGLTFRenderStats
+{
+  int instancesTested;
+  int instancesCulledMask;
+  int instancesCulledFrustum;
+  int instancesCulledOcclusion;
+  int instancesCulledLOD; // Beyond the last MSFT_screencoverage threshold
+  int instancesPending; // vcGLTFLF_DeferMeshes; visible but none of its LODs have been created yet
+
+  int primitivesSkippedPass; // Alpha mode not drawn in this pass
+  int primitivesCulledFrustum;
+
+  int drawCalls;
+  int64_t trianglesSubmitted;
+  int64_t verticesSubmitted; // Indices processed; each is one vertex shader invocation before the post-transform cache
+
+  int shaderBinds;
+  int textureBinds;
+  int64_t constantBufferBytes;
+  int skinPalettes;
+};
+
+// Memory held by a loaded scene
+struct vcGLTFMemoryUsage
+{
+  // Host
+  int64_t bufferBytes; // .bin buffers, kept for the life of the scene
+  int64_t nodeBytes; // Nodes and mesh instances
+  int64_t meshBytes; // Primitives, joint bounds and BVHs
+  int64_t materialBytes;
+  int64_t animationBytes; // Channels, samplers and keyframes
+  int64_t skinBytes;
+  int64_t stringBytes;
+  int64_t scratchBytes; // Render scratch (sort buffers, light grid, clusters, occlusion buffer); grows with use
+  int64_t hostTotal;
+
+  // GPU
+  int64_t vertexBytes;
+  int64_t indexBytes;
+  int64_t textureBytes; // Material textures at 4 bytes per texel plus the cluster textures; cached textures may be shared with other scenes
+  int64_t gpuTotal;
+};
+
+struct vcGLTFRaycastResult
+{
+  int meshID;
+  int primitiveID;
+  int triangleID; // Within the primitive
+  int nodeID;
+
+  double distance; // World space distance from the ray origin
+  udDouble3 position; // World space
+};
+
 // Read the OBJ, optionally only reading a specific count of vertices (to test for valid format for example)
-udResult vcGLTF_Load(vcGLTFScene **ppScene, const char *pFilename, udWorkerPool *pWorkerPool);
+udResult vcGLTF_Load(vcGLTFScene **ppScene, const char *pFilename, udWorkerPool *pWorkerPool, vcGLTFLoadFlags flags = vcGLTFLF_None);
 void vcGLTF_Destroy(vcGLTFScene **ppScene);
 
+udResult vcGLTF_GetLoadStats(vcGLTFScene *pScene, vcGLTFLoadStats *pStats);
+
 void vcGLTF_GenerateGlobalShaders();
 void vcGLTF_DestroyGlobalShaders();
 
 udResult vcGLTF_Update(vcGLTFScene *pScene, double dt);
 udResult vcGLTF_Render(vcGLTFScene *ppScene, udRay<double> camera, udDouble4x4 worldMatrix, udDouble4x4 viewMatrix, udDouble4x4 projectionMatrix, vcGLTFRenderPass pass, const vcGLTFLightSet &lighting);
+udResult vcGLTF_Render(vcGLTFScene *pScene, udRay<double> camera, udDouble4x4 worldMatrix, udDouble4x4 viewMatrix, udDouble4x4 projectionMatrix, vcGLTFRenderPass pass, const vcGLTFLightList &lighting);
+
+// Bounds of every mesh instance in its current pose; udR_NothingToDo if the scene has no meshes
+udResult vcGLTF_GetBounds(vcGLTFScene *pScene, udDouble4x4 worldMatrix, udDouble3 *pMin, udDouble3 *pMax);
+
+udResult vcGLTF_GetRenderStats(vcGLTFScene *pScene, vcGLTFRenderPass pass, vcGLTFRenderStats *pStats);
+udResult vcGLTF_GetMemoryUsage(vcGLTFScene *pScene, vcGLTFMemoryUsage *pUsage);
+
+// Budgets shared by every loaded scene, 0 (the default) is unlimited. A load that doesn't fit first drops derived data
+// (generated LODs and tangents, depth only position streams) and fails with udR_MemoryAllocationFailure if that isn't enough.
+// The GPU estimate includes the textures, sized from the image headers. Scenes loaded with vcGLTFLF_DeferMeshes also drop
+// the derived data once their mesh requests start waiting on a full GPU budget
+void vcGLTF_SetMemoryBudget(int64_t hostBytes, int64_t gpuBytes);
+
+// Combined usage of every loaded scene as measured when each finished loading, and the estimates of those still loading
+void vcGLTF_GetTotalMemoryUsage(int64_t *pHostBytes, int64_t *pGPUBytes);
+
+// Chrome trace events (chrome://tracing or ui.perfetto.dev) for loading, updates and rendering. Each thread keeps its most
+// recent events in its own ring buffer. vcGLTF_WriteTrace, vcGLTF_ResetTracing (clears the rings) and vcGLTF_ShutdownTracing
+// (disables tracing and frees the rings) must only be called while no thread is tracing: the worker pool is idle and no
+// vcGLTF_Load, vcGLTF_Update or vcGLTF_Render is running
+void vcGLTF_SetTracing(bool enabled);
+void vcGLTF_ResetTracing();
+void vcGLTF_ShutdownTracing();
+udResult vcGLTF_WriteTrace(const char *pFilename);
+
+// Returns udR_ObjectNotFound if nothing was hit; worldMatrix matches the one passed to vcGLTF_Render. Meshes that aren't in
+// memory (vcGLTFLF_DeferMeshes before they're streamed or after eviction) are hit at their instance bounds, leaving
+// primitiveID and triangleID at -1
+udResult vcGLTF_Raycast(vcGLTFScene *pScene, udRay<double> ray, udDouble4x4 worldMatrix, vcGLTFRaycastResult *pResult);
 
 // Some material stuff
 int vcGLTF_GetMeshCount(vcGLTFScene *pScene);
+int vcGLTF_GetNodeCount(vcGLTFScene *pScene);
 const char *vcGLTF_GetMeshName(vcGLTFScene *pScene, int id);
 
 int vcGLTF_GetMaterialCount(vcGLTFScene *pScene);
+
+// Edits that change the textures, alpha mode or unlit flag need another shader variant, which compiles on the next draw
 vcGLTFMaterial* vcGLTF_GetMaterial(vcGLTFScene *pScene, int id);
 
+// Hidden meshes, and every mesh below a hidden node, aren't drawn, used as occluders or hit by raycasts. Everything starts
+// visible; IDs are the mesh and node indices in the GLTF file
+bool vcGLTF_GetMeshVisible(vcGLTFScene *pScene, int meshID);
+void vcGLTF_SetMeshVisible(vcGLTFScene *pScene, int meshID, bool visible);
+void vcGLTF_SetMeshesVisible(vcGLTFScene *pScene, const int *pMeshIDs, int count, bool visible);
+void vcGLTF_SetAllMeshesVisible(vcGLTFScene *pScene, bool visible);
+
+bool vcGLTF_GetNodeVisible(vcGLTFScene *pScene, int nodeID);
+void vcGLTF_SetNodeVisible(vcGLTFScene *pScene, int nodeID, bool visible);
+void vcGLTF_SetNodesVisible(vcGLTFScene *pScene, const int *pNodeIDs, int count, bool visible);
+void vcGLTF_SetAllNodesVisible(vcGLTFScene *pScene, bool visible);
+
+// Visibility of the first 64 meshes as a bit mask; meshes past that are left as they are
 int64_t vcGLTF_GetMeshMask(vcGLTFScene *pScene);
 void vcGLTF_SetMeshMask(vcGLTFScene *pScene, int64_t meshMask);
 
+// Opaque passes first lay down depth with position only shaders, then shade with an equal depth test. Alpha masked primitives
+// whose cut out the depth shaders can't reproduce are shaded during the first pass instead. Only pays off for scenes with
+// heavy overdraw; the caller's depth state is left as LessOrEqual with writes enabled
+bool vcGLTF_GetDepthPrepass(vcGLTFScene *pScene);
+void vcGLTF_SetDepthPrepass(vcGLTFScene *pScene, bool enabled);
+
+// Scenes loaded with vcGLTFLF_DeferMeshes create the meshes vcGLTF_Render has requested at the start of each vcGLTF_Render,
+// for up to budgetMilliseconds (4ms by default) but always at least one. Meshes created this way are destroyed again once
+// they haven't been drawn for evictFrames calls to vcGLTF_Update; 0 (the default) keeps them
+void vcGLTF_SetMeshStreaming(vcGLTFScene *pScene, float budgetMilliseconds, int evictFrames);
+
 // Some animation extraction helpers
 int vcGLTFAnim_GetNumberOfAnimations(vcGLTFScene *pScene);
 vcGLTFAnimation* vcGLTFAnim_GetAnimation(vcGLTFScene *pScene, int index);